@@ -34,6 +34,7 @@
 #include "algorithms/alignment/QualityValueScoreFunction.h"
 #include "algorithms/alignment/IDSScoreFunction.h"
 #include "algorithms/alignment/DistanceMatrixScoreFunction.h"
+#include "algorithms/alignment/QueryProfileScoreFunction.h"
 #include "algorithms/alignment/StringToScoreMatrix.h"
 #include "algorithms/alignment/AlignmentFormats.h"
 #include "algorithms/anchoring/LISPValue.h"
@@ -42,6 +43,8 @@
 #include "algorithms/anchoring/LISQValueWeightor.h"
 #include "algorithms/anchoring/FindMaxInterval.h"
 #include "algorithms/anchoring/MapBySuffixArray.h"
+#include "algorithms/anchoring/AdaptiveSeeding.h"
+#include "algorithms/anchoring/SketchPrefilter.h"
 #include "datastructures/anchoring/ClusterList.h"
 #include "algorithms/anchoring/ClusterProbability.h"
 #include "algorithms/anchoring/BWTSearch.h"
@@ -66,6 +69,7 @@
 #include "data/hdf/HDFRegionTableReader.h"
 #include "datastructures/bwt/BWT.h"
 #include "datastructures/sequence/PackedDNASequence.h"
+#include "datastructures/sequence/PackedReferenceSequence.h"
 #include "CommandLineParser.h"
 #include "qvs/QualityValue.h"
 #include "statistics/VarianceAccumulator.h"
@@ -95,7 +99,16 @@ ostream *outFilePtr;
 HDFRegionTableReader *regionTableReader;
 
 typedef SMRTSequence T_Sequence;
+//
+// Built with -DUSE_PACKED_REFERENCE (make blasrPacked), the reference
+// is kept at two bits per base while mapping, and windows of it are
+// decoded only when they are aligned to.
+//
+#ifdef USE_PACKED_REFERENCE
+typedef PackedReferenceSequence T_GenomeSequence;
+#else
 typedef FASTASequence T_GenomeSequence;
+#endif
 typedef DNASuffixArray T_SuffixArray;
 typedef DNATuple T_Tuple;
 
@@ -310,14 +323,17 @@ public:
   vector<Arrow> affinePathMat;
   vector<ChainedMatchPos> matchPosList;
   vector<ChainedMatchPos> rcMatchPosList;
+  vector<ChainedMatchPos> hpcMatchPosList;
+  vector<Nucleotide> hpcRead, hpcReadRC;
+  vector<DNALength>  hpcReadRunStart, hpcReadRCRunStart;
   vector<BasicEndpoint<ChainedMatchPos> > globalChainEndpointBuffer;
   vector<Fragment> sdpFragmentSet, sdpPrefixFragmentSet, sdpSuffixFragmentSet;
   TupleList<PositionDNATuple> sdpCachedTargetTupleList;
   TupleList<PositionDNATuple> sdpCachedTargetPrefixTupleList;
   TupleList<PositionDNATuple> sdpCachedTargetSuffixTupleList;
   std::vector<int> sdpCachedMaxFragmentChain;
-  vector<double> probMat;
-  vector<double> optPathProbMat;
+  vector<float>  probMat;
+  vector<float>  optPathProbMat;
   vector<float>  lnSubPValueMat;
   vector<float>  lnInsPValueMat;
   vector<float>  lnDelPValueMat;
@@ -325,6 +341,10 @@ public:
   vector<int>    clusterNumBases;
   ClusterList    clusterList;
   ClusterList    revStrandClusterList;
+  QueryScoreProfile queryProfile;
+  vector<int>    tupleCounts;
+  vector<Minimizer> sketchMinimizers;
+  vector<SketchHit> sketchHits;
 
   void Reset() {
     vector<int>().swap(hpInsScoreMat);
@@ -337,6 +357,11 @@ public:
     vector<Arrow>().swap(pathMat);
     vector<ChainedMatchPos>().swap(matchPosList);
     vector<ChainedMatchPos>().swap(rcMatchPosList);
+    vector<ChainedMatchPos>().swap(hpcMatchPosList);
+    vector<Nucleotide>().swap(hpcRead);
+    vector<Nucleotide>().swap(hpcReadRC);
+    vector<DNALength>().swap(hpcReadRunStart);
+    vector<DNALength>().swap(hpcReadRCRunStart);
     vector<BasicEndpoint<ChainedMatchPos> >().swap(globalChainEndpointBuffer);
     vector<Fragment>().swap(sdpFragmentSet);
     vector<Fragment>().swap(sdpPrefixFragmentSet);
@@ -345,13 +370,14 @@ public:
     sdpCachedTargetPrefixTupleList.Reset();
     sdpCachedTargetSuffixTupleList.Reset();
     vector<int>().swap(sdpCachedMaxFragmentChain);
-    vector<double>().swap(probMat);
-    vector<double>().swap(optPathProbMat);
+    vector<float>().swap(probMat);
+    vector<float>().swap(optPathProbMat);
     vector<float>().swap(lnSubPValueMat);
     vector<float>().swap(lnInsPValueMat);
     vector<float>().swap(lnDelPValueMat);
     vector<float>().swap(lnMatchPValueMat);
     vector<int>().swap(clusterNumBases);
+    queryProfile.Free();
   }
 };
 
@@ -363,7 +389,9 @@ void SetHelp(string &str) {
              << " Input Files." << endl
              << "   reads.fasta is a multi-fasta file of reads.  While any fasta file is valid input, " <<endl
              << "               it is preferable to use pls.h5 or bas.h5 files because they contain" << endl
-             << "               more rich quality value information." << endl << endl
+             << "               more rich quality value information." << endl
+             << "               FASTA and FASTQ reads may be gzip compressed (reads.fastq.gz), or read" << endl
+             << "               from standard input by giving '-' as the reads file." << endl << endl
              << "   reads.bas.h5|reads.pls.h5 Is the native output format in Hierarchical Data Format of " <<endl
              << "               SMRT reads. This is the preferred input to blasr because rich quality" << endl
              << "               value (insertion,deletion, and substitution quality values) information is " << endl
@@ -423,6 +451,16 @@ void SetHelp(string &str) {
              << "               Write output to 'out'" << endl
              << "   -unaligned file" << endl
              << "               Output reads that are not aligned to 'file'" << endl
+             << "   -checkpoint n (0)" << endl
+             << "               Every n reads, sync the output to disk and record the reads that are done" << endl
+             << "               in a checkpoint file, so that the run may be resumed if it is stopped." << endl
+             << "               Requires -out, and bas.h5 or pls.h5 input (ccs.h5 files cannot skip reads)." << endl
+             << "               The -unaligned and -clusters output is checkpointed with -out; -metrics," << endl
+             << "               -fullMetrics, -metricsJson and -trace describe only the reads mapped after a resume." << endl
+             << "   -checkpointFile file (out.ckpt)" << endl
+             << "               The checkpoint file." << endl
+             << "   -resume" << endl
+             << "               Continue a run from its checkpoint file, appending to the output of the run." << endl
              << "   -m t           " << endl
              << "               If not printing SAM, modify the output of the alignment." << endl
              << "                t=" << StickPrint <<   " Print blast like output with |'s connecting " << endl
@@ -432,6 +470,10 @@ void SetHelp(string &str) {
              << "                  " << Vulgar <<       " Print in vulgar format (deprecated)." << endl
              << "                  " << Interval <<     " Print a longer tabular version of the alignment." << endl 
              << "                  " << CompareSequencesParsable  << " Print in a machine-parsable format that is read by compareSequences.py." << endl
+             << "                  " << CompactBinary << " Print compact binary records (coordinates, scores, and alignment blocks)" << endl
+             << "                    that are read in place by BinaryAlignmentReader." << endl
+             << "   -binaryQV (false)" << endl
+             << "               With -m " << CompactBinary << ", also store the quality values of the aligned part of each read." << endl
              << "   -noSortRefinedAlignments (false) " << endl
              << "               Once candidate alignments are generated and scored via sparse dynamic "<< endl
              << "               programming, they are rescored using local alignment that accounts " << endl
@@ -471,6 +513,40 @@ void SetHelp(string &str) {
              << "               constructing pairwise alignments for de novo assembly."<<endl
              << "   -maxAnchorsPerPosition m (inf) " << endl
              << "               Do not add anchors from a position if it matches to more than 'm' locations in the target" << endl
+             << "   -mapability file" << endl
+             << "               A track of the reference written by 'mapability'.  Anchors that place the read" << endl
+             << "               where the reference has no unique substring of the read length are ignored," << endl
+             << "               unless no anchor of the read is unique, in which case all are kept." << endl
+             << "   -mapabilityMaxLength l (0)" << endl
+             << "               Use l rather than the read length when looking up uniqueness in the -mapability track." << endl
+             << "   -repeatMask file" << endl
+             << "               A mask of high copy k-mers written by sawriter -maskRepeats along with the index." << endl
+             << "               Read positions that start with a masked k-mer are not searched for anchors." << endl
+             << "               The k-mers must be at least -minMatch long." << endl
+             << "   -hpc (false)" << endl
+             << "               Seed with homopolymers condensed to one base in the read and reference, so that" << endl
+             << "               indels in homopolymers do not break seeds.  -minMatch is then counted in condensed" << endl
+             << "               bases.  A -sa or -bwt must be built over the reference written by compressseq." << endl
+             << "   -hpcIndexBinSize b (64)" << endl
+             << "               With -hpc, store the reference position of every b'th homopolymer run to map" << endl
+             << "               condensed positions back to the reference.  Smaller values use more memory and" << endl
+             << "               map anchors back faster." << endl
+             << "   -adaptiveSeeding (false)" << endl
+             << "               Choose -minMatch, -maxAnchorsPerPosition, and the expand of each read from how" << endl
+             << "               often its k-mers occur in the genome (-ctab), and search for anchors once." << endl
+             << "               Repetitive reads are seeded with longer matches, fewer anchors per position," << endl
+             << "               and -maxExpand.  Unique reads are seeded as given with -minExpand." << endl
+             << "   -sketchPrefilter (false)" << endl
+             << "               Look up the minimizers of the read in a minimizer index of the reference, and" << endl
+             << "               when a locus has enough matches, extend every minimizer match (at every locus and" << endl
+             << "               on both strands) into an anchor instead of searching the -sa or -bwt.  Other" << endl
+             << "               reads are searched as usual.  -metrics reports the fraction of reads mapped so." << endl
+             << "   -sketchK k (15) -sketchWindow w (10)" << endl
+             << "               Use the minimum (hashed) k-mer of every w consecutive k-mers.  k is at most 16." << endl
+             << "   -sketchMinHits n (5)" << endl
+             << "               Require n minimizer matches at a locus to use it." << endl
+             << "   -sketchMaxOccurrences n (100)" << endl
+             << "               Ignore minimizers that occur more than n times in the reference." << endl
              << "   -advanceHalf (false) " << endl
              << "               A trick for speeding up alignments at the cost of sensitivity.  If " << endl
              << "               a cluster of anchors of size n, (a1,...,an) is found, normally anchors " << endl
@@ -486,6 +562,17 @@ void SetHelp(string &str) {
              << "               Keep up to 'n' candidates for the best alignment.  A large value of n will slow mapping" << endl
              << "               because the slower dynamic programming steps are applied to more clusters of anchors" <<endl
              << "               which can be a rate limiting step when reads are very long."<<endl
+             << "   -pruneByScoreEstimate (false)" << endl
+             << "               Align candidates in order of the number of bases covered by anchors, and skip" << endl
+             << "               candidates that, if every base outside the anchors aligned as well as in the" << endl
+             << "               best alignment so far, would score worse than the bestn'th alignment." << endl
+             << "               This is a heuristic, not a bound: a candidate whose unanchored bases align" << endl
+             << "               better than those of the best alignment so far may be skipped even though it" << endl
+             << "               would have scored best.  It is most effective with -bestn 1.  The number of" << endl
+             << "               candidates that are skipped is reported with the mapping metrics." << endl
+             << "   -scoreEstimateSlack s (100)" << endl
+             << "               Only skip candidates whose score estimate is more than s worse than the bestn'th" << endl
+             << "               alignment, so that close alternative alignments still contribute to the mapqv." << endl
 //			 << "   -placeRandomly (false)" << endl
 //           << "               When there are multiple positions to map a read with equal alignment scores, place the" << endl
 //			 << "               read randomly at one of them.  The default is to place the read at the first." <<endl
@@ -497,6 +584,11 @@ void SetHelp(string &str) {
              << "               Use matches of length K to speed dynamic programming alignments.  This controls" <<endl
              << "               accuracy of assigning gaps in pairwise alignments once a mapping has been found,"<<endl
              << "               rather than mapping sensitivity itself."<<endl<< endl
+             << "   -sdpBand b (0)" << endl
+             << "               When b > 0, only use matches that are within b diagonals of the anchors that" << endl
+             << "               placed the read when refining an alignment, and merge runs of matches on the same" << endl
+             << "               diagonal before chaining them.  This bounds the time spent refining long windows" << endl
+             << "               of low-complexity sequence." << endl << endl
              << "   -scoreMatrix \"score matrix string\" " << endl
              << "               Specify an alternative score matrix for scoring fasta reads.  The matrix is " << endl
              << "               in the format " << endl
@@ -532,6 +624,12 @@ void SetHelp(string &str) {
              << "   -nproc N (1)" << endl
              << "               Align using N processes.  All large data structures such as the suffix array and " << endl
              << "               tuple count table are shared."<<endl
+             << "   -intraReadTasks (false)" << endl
+             << "               Split the work on a single long read (anchoring the reverse strand, and refining " << endl
+             << "               each candidate alignment) into tasks that idle processes may pick up.  This helps " << endl
+             << "               when a few very long reads would otherwise keep most processes waiting." << endl
+             << "   -minTaskReadLength l (20000)" << endl
+             << "               Only split reads of length at least l into tasks." << endl
              << "   -start S (0)" << endl
              << "               Index of the first read to begin aligning. This is useful when multiple instances " << endl
              << "               are running on the same data, for example when on a multi-rack cluster."<<endl << endl
@@ -545,6 +643,24 @@ void SetHelp(string &str) {
 //             << "   -ignoreQuality" << endl
 //             << "                 Ignore quality values when computing alignments (they still may be used." << endl 
 //             << "                 when mapping)." << endl << endl
+             << " Options for performance metrics." << endl
+             << "   -metrics file" << endl
+             << "               Print a summary of mapping time per stage and anchor counts to 'file'." << endl
+             << "   -metricsJson file" << endl
+             << "               Write per-read latency histograms of each mapping stage, counts of anchors," << endl
+             << "               candidates, dynamic programming cells and bytes read/written, and the time" << endl
+             << "               each thread waited on the reader and writer, as one line of JSON per snapshot." << endl
+             << "   -metricsInterval s (0)" << endl
+             << "               Append a snapshot to the -metricsJson file every 's' seconds.  When 0, only" << endl
+             << "               the final snapshot is written." << endl
+             << "   -traceFile file" << endl
+             << "               Write the wall-clock spans of mapping stages for a sample of reads in " << endl
+             << "               Chrome trace format (viewable in chrome://tracing)." << endl
+             << "   -traceSample n (100)" << endl
+             << "               Trace every n'th read of each thread." << endl
+             << "   -traceMinMsec t (0)" << endl
+             << "               Additionally trace every read that takes longer than t msec to map." << endl
+             << endl
              << " -v            Print some verbose information." << endl 
              << " -V 2          Make verbosity more verbose.  Probably only useful for development." << endl
              << " -h            Print this help file." << endl << endl
@@ -688,8 +804,48 @@ void StoreRankingStats( vector<T_AlignmentCandidate*> &alignments,
 
 
 
+//
+// An estimate of the score an interval will align with.  The anchored
+// bases of an interval are exact matches, and the rest of the read is
+// assumed to align as well as the unanchored part of the best
+// alignment found so far for the read.  This is used to align the
+// most promising intervals first, and to skip the ones that are
+// unlikely to make it into the output.
+//
+// This is not a bound.  Only when every unanchored base is assumed to
+// match is the estimate a true lower bound on the score, and then
+// it is the same for every interval of a read and nothing is skipped.
+// Using the observed score of the unanchored bases instead may skip an
+// interval whose unanchored bases align better than those of the best
+// alignment so far.
+//
+class IntervalScoreEstimate {
+ public:
+  WeightedIntervalSet::iterator intvIt;
+  int alignmentIndex;
+  int anchoredBases;
+  int unanchoredBases;
+  int Estimate(int matchScore, float unanchoredBaseScore) {
+    return matchScore * anchoredBases + (int) (unanchoredBaseScore * unanchoredBases);
+  }
+};
+
+class CompareIntervalScoreEstimateByAnchoredBases {
+ public:
+  int operator()(const IntervalScoreEstimate &a, const IntervalScoreEstimate &b) const {
+    return a.anchoredBases > b.anchoredBases;
+  }
+};
+
+//
+// Align each interval, storing the result in the corresponding
+// alignment.  When params.pruneByScoreEstimate is set, intervals whose
+// score estimate is worse than the nBest'th best score found so far
+// (plus params.scoreEstimateSlack) are not aligned, and are removed from
+// 'alignments'.  Returns the number of intervals that were pruned.
+//
 template<typename T_TargetSequence, typename T_QuerySequence, typename TDBSequence>
-void AlignIntervals(T_TargetSequence &genome, T_QuerySequence &read, T_QuerySequence &rcRead,
+int AlignIntervals(T_TargetSequence &genome, T_QuerySequence &read, T_QuerySequence &rcRead,
                     WeightedIntervalSet &weightedIntervals,
                     int mutationCostMatrix[][5], 
                     int ins, int del, int sdpTupleSize,
@@ -717,25 +873,59 @@ void AlignIntervals(T_TargetSequence &genome, T_QuerySequence &read, T_QuerySequ
   // Assume there is at least one interval.
   //
   if (weightedIntervals.size() == 0) 
-    return;
+    return 0;
 
-  WeightedIntervalSet::iterator intvIt = weightedIntervals.begin();
+  vector<IntervalScoreEstimate> intervalOrder;
+  WeightedIntervalSet::iterator intvIt;
   int alignmentIndex = 0;
-  
+  for (intvIt = weightedIntervals.begin(); intvIt != weightedIntervals.end(); ++intvIt, ++alignmentIndex) {
+    IntervalScoreEstimate intvEstimate;
+    intvEstimate.intvIt         = intvIt;
+    intvEstimate.alignmentIndex = alignmentIndex;
+    intvEstimate.anchoredBases  = 0;
+    int m;
+    for (m = 0; m < intvIt->matches.size(); m++) { intvEstimate.anchoredBases += intvIt->matches[m].l; }
+    T_QuerySequence *strand   = forrev[(*intvIt).GetStrandIndex()];
+    intvEstimate.unanchoredBases = max(0, ((int) (strand->subreadEnd - strand->subreadStart)) - intvEstimate.anchoredBases);
+    intervalOrder.push_back(intvEstimate);
+  }
 
-  do {
+  //
+  // For a fixed read length, more anchored bases means a better
+  // estimate, so align intervals in order of decreasing anchored bases.
+  // Ties are kept in p-value order.
+  //
+  int matchScore = mutationCostMatrix[0][0];
+  float unanchoredBaseScore = matchScore;
+  vector<int> alignedScores;
+  int nPruned = 0;
+  if (params.pruneByScoreEstimate) {
+    std::stable_sort(intervalOrder.begin(), intervalOrder.end(), CompareIntervalScoreEstimateByAnchoredBases());
+  }
+
+  int intervalIndex;
+  for (intervalIndex = 0; intervalIndex < intervalOrder.size(); intervalIndex++) {
+    intvIt = intervalOrder[intervalIndex].intvIt;
+    alignmentIndex = intervalOrder[intervalIndex].alignmentIndex;
+
+    if (params.pruneByScoreEstimate and alignedScores.size() >= params.nBest) {
+      int scoreEstimate = intervalOrder[intervalIndex].Estimate(matchScore, unanchoredBaseScore);
+      if (scoreEstimate > alignedScores[params.nBest-1] + params.scoreEstimateSlack) {
+        if (params.verbosity > 0) {
+          cout << "pruning interval " << (*intvIt).start << " " << (*intvIt).end << " with score estimate " 
+               << scoreEstimate << endl;
+        }
+        delete alignments[alignmentIndex];
+        alignments[alignmentIndex] = NULL;
+        ++nPruned;
+        continue;
+      }
+    }
 
     T_AlignmentCandidate *alignment = alignments[alignmentIndex];
     alignment->clusterWeight= (*intvIt).size;
     alignment->clusterScore = (*intvIt).pValue;
 
-    //
-    // Advance references.  Intervals are stored in reverse order, so
-    // go backwards in the list, and alignments are in forward order.
-    // That should probably be changed.
-    //
-    ++alignmentIndex;
-
     // 
     // Try aligning the read to the genome.
     //
@@ -860,7 +1050,7 @@ void AlignIntervals(T_TargetSequence &genome, T_QuerySequence &read, T_QuerySequ
     alignment->tAlignedSeqPos     = matchIntervalStart;
     alignment->tAlignedSeqLength  = matchIntervalEnd - matchIntervalStart;
     if ((*intvIt).GetStrandIndex() == Forward) {
-      alignment->tAlignedSeq.Copy(genome, alignment->tAlignedSeqPos, alignment->tAlignedSeqLength);
+      CopyReferenceWindow(genome, alignment->tAlignedSeq, alignment->tAlignedSeqPos, alignment->tAlignedSeqLength);
       alignment->tStrand = Forward;
     }
     else {
@@ -1061,12 +1251,34 @@ void AlignIntervals(T_TargetSequence &genome, T_QuerySequence &read, T_QuerySequ
                               SMRTDistanceMatrix, params.insertion, params.deletion);
       }
       else {
+        //
+        // Optionally restrict the sdp fragments to a band around the
+        // anchors of the interval, in the coordinates of the aligned
+        // substrings.
+        //
+        SDPBand sdpBand, *sdpBandPtr = NULL;
+        if (params.sdpBand > 0 and (*intvIt).matches.size() > 0) {
+          sdpBand.Initialize(params.sdpBand);
+          int nMatches = (*intvIt).matches.size();
+          for (m = 0; m < nMatches; m++) {
+            if (alignment->tStrand == Forward) {
+              sdpBand.AddAnchor((*intvIt).matches[m].q - alignment->qAlignedSeqPos,
+                                (*intvIt).matches[m].t - alignment->tAlignedSeqPos);
+            }
+            else {
+              int revCompIndex = nMatches - m - 1;
+              sdpBand.AddAnchor(read.MakeRCCoordinate((*intvIt).matches[revCompIndex].q + (*intvIt).matches[revCompIndex].l - 1) - alignment->qAlignedSeqPos,
+                                genome.MakeRCCoordinate((*intvIt).matches[revCompIndex].t + (*intvIt).matches[revCompIndex].l - 1) - alignment->tAlignedSeqPos);
+            }
+          }
+          sdpBandPtr = &sdpBand;
+        }
         alignScore = SDPAlign(alignment->qAlignedSeq, alignment->tAlignedSeq, distScoreFn, 
                               sdpTupleSize, params.sdpIns, params.sdpDel, params.indelRate*3, 
                               *alignment, mappingBuffers, 
                               Local, 
                               params.detailedSDPAlignment, 
-                              params.extendFrontAlignment);
+                              params.extendFrontAlignment, 10000, sdpBandPtr);
         ComputeAlignmentStats(*alignment, alignment->qAlignedSeq.seq, alignment->tAlignedSeq.seq,
                               SMRTDistanceMatrix, params.insertion, params.deletion);
       }
@@ -1155,10 +1367,10 @@ void AlignIntervals(T_TargetSequence &genome, T_QuerySequence &read, T_QuerySequ
         genomeSuffixLength = min(intervalContigEndPos - lastAlignedTPos, maximumExtendLength);
         if (genomeSuffixLength > 0) {
           if (alignment->tStrand == Forward) {
-            genomeSuffix.Copy(genome, lastAlignedTPos, genomeSuffixLength);
+            CopyReferenceWindow(genome, genomeSuffix, lastAlignedTPos, genomeSuffixLength);
           }
           else {
-            ((DNASequence)genome).CopyAsRC(genomeSuffix, lastAlignedTPos, genomeSuffixLength);
+            genome.CopyAsRC(genomeSuffix, lastAlignedTPos, genomeSuffixLength);
           }
         }
         else {
@@ -1218,10 +1430,10 @@ void AlignIntervals(T_TargetSequence &genome, T_QuerySequence &read, T_QuerySequ
         genomePrefixLength = min(firstAlignedTPos - intervalContigStartPos, maximumExtendLength);
         if (genomePrefixLength > 0) {
           if (alignment->tStrand == 0) {
-            genomePrefix.Copy(genome, firstAlignedTPos - genomePrefixLength, genomePrefixLength);
+            CopyReferenceWindow(genome, genomePrefix, firstAlignedTPos - genomePrefixLength, genomePrefixLength);
           }
           else {
-            ((DNASequence)genome).MakeRC(genomePrefix, firstAlignedTPos - genomePrefixLength, genomePrefixLength);
+            MakeReferenceWindowRC(genome, genomePrefix, firstAlignedTPos - genomePrefixLength, genomePrefixLength);
           }
         }
         reverseScore = 0;
@@ -1299,9 +1511,35 @@ void AlignIntervals(T_TargetSequence &genome, T_QuerySequence &read, T_QuerySequ
                           alignment->qAlignedSeq.seq,
                           alignment->tAlignedSeq.seq, SMRTDistanceMatrix, ins, del );
 
+    if (params.pruneByScoreEstimate and alignment->blocks.size() > 0) {
+      //
+      // Keep the scores sorted so the nBest'th is at hand, and
+      // update the estimate of how well unanchored bases align from the
+      // best alignment so far (see IntervalScoreEstimate).
+      //
+      alignedScores.insert(std::upper_bound(alignedScores.begin(), alignedScores.end(), alignment->score), 
+                           alignment->score);
+      int unanchoredBases = intervalOrder[intervalIndex].unanchoredBases;
+      if (unanchoredBases > 0) {
+        float observedScore = ((float) (alignment->score - matchScore * intervalOrder[intervalIndex].anchoredBases)) / unanchoredBases;
+        if (alignedScores[0] == alignment->score) {
+          unanchoredBaseScore = max((float) matchScore, observedScore);
+        }
+      }
+    }
+  }
 
-    intvIt++;
-  } while (intvIt != weightedIntervals.end());
+  if (nPruned > 0) {
+    int packedIndex = 0;
+    for (alignmentIndex = 0; alignmentIndex < alignments.size(); alignmentIndex++) {
+      if (alignments[alignmentIndex] != NULL) {
+        alignments[packedIndex] = alignments[alignmentIndex];
+        ++packedIndex;
+      }
+    }
+    alignments.resize(packedIndex);
+  }
+  return nPruned;
 }
 
 
@@ -1480,15 +1718,100 @@ int RemoveOverlappingAlignments(vector<T_AlignmentCandidate*> &alignmentPtrs, Ma
   return alignmentPtrs.size();
 }
 
+//
+// Reads that are long enough are split into tasks that may be picked
+// up by idle mapping threads.
+//
+bool SplitReadIntoTasks(MappingIPC *mapData, MappingParameters &params, DNALength readLength) {
+  return (mapData != NULL and mapData->schedulerPtr != NULL and
+          params.intraReadTasks and readLength >= params.minTaskReadLength);
+}
+
+typedef QueryProfileScoreFunction<DNASequence, FASTQSequence,
+                                  IDSScoreFunction<DNASequence, FASTQSequence> > IDSProfileScoreFunction;
+
+void InitializeIDSScoreFunction(IDSScoreFunction<DNASequence, FASTQSequence> &idsScoreFn, MappingParameters &params) {
+  idsScoreFn.InitializeScoreMatrix(SMRTDistanceMatrix);
+  idsScoreFn.ins = params.insertion;
+  idsScoreFn.del = params.deletion;
+  idsScoreFn.affineExtend = params.affineExtend;
+  idsScoreFn.substitutionPrior = params.substitutionPrior;
+  idsScoreFn.globalDeletionPrior = params.globalDeletionPrior;
+}
+
+//
+// Refinement scores the read with the quality values when it is
+// globally aligned, or guided aligned with meaningful quality values.
+// Reads without substitution tags are scored by the IDS function
+// directly, as before.
+//
+bool UseQueryScoreProfile(FASTQSequence &read, MappingParameters &params) {
+  if (params.ignoreQualities or read.substitutionTag == NULL or 
+      read.insertionQV.Empty() or read.deletionQV.Empty()) {
+    return false;
+  }
+  return (params.doGlobalAlignment or 
+          (params.useGuidedAlign and ReadHasMeaningfulQualityValues(read)));
+}
+
+//
+// Refine one candidate alignment.  The task runs with the buffers of
+// whichever thread picks it up, and only uses their alignment
+// matrices, never the anchor lists, so it is safe to run while the
+// thread is waiting on tasks of its own read.
+//
+template<typename T_RefSequence, typename T_Sequence>
+class RefineAlignmentTask : public SchedulerTask {
+ public:
+  vector<T_Sequence*> *bothQueryStrands;
+  T_RefSequence *genome;
+  T_AlignmentCandidate *alignment;
+  MappingParameters *params;
+  QueryScoreProfile *queryProfile;
+  void Run(void *workerContext) {
+    RefineAlignment(*bothQueryStrands, *genome, *alignment, *params, *((MappingBuffers*) workerContext), queryProfile);
+  }
+};
+
 template<typename T_RefSequence, typename T_Sequence>
 void RefineAlignments(vector<T_Sequence*> &bothQueryStrands,
                       T_RefSequence &genome,
-                      vector<T_AlignmentCandidate*> &alignmentPtrs, MappingParameters &params, MappingBuffers &mappingBuffers) {
+                      vector<T_AlignmentCandidate*> &alignmentPtrs, MappingParameters &params, MappingBuffers &mappingBuffers,
+                      MappingIPC *mapData=NULL) {
 
   
   UInt i;
-  for (i = 0; i < alignmentPtrs.size(); i++ ) {
-    RefineAlignment(bothQueryStrands, genome, *alignmentPtrs[i], params, mappingBuffers);
+  //
+  // Every candidate is refined against the forward strand of the
+  // read, so the costs of aligning it are computed once here rather
+  // than in every cell of every alignment.  The profile is only read
+  // by the refinement tasks.
+  //
+  QueryScoreProfile *queryProfile = NULL;
+  if (alignmentPtrs.size() > 0 and UseQueryScoreProfile(*bothQueryStrands[0], params)) {
+    IDSScoreFunction<DNASequence, FASTQSequence> idsScoreFn;
+    InitializeIDSScoreFunction(idsScoreFn, params);
+    mappingBuffers.queryProfile.Build(idsScoreFn, *bothQueryStrands[0]);
+    queryProfile = &mappingBuffers.queryProfile;
+  }
+  if (alignmentPtrs.size() > 1 and 
+      SplitReadIntoTasks(mapData, params, bothQueryStrands[0]->length)) {
+    vector<RefineAlignmentTask<T_RefSequence, T_Sequence> > tasks(alignmentPtrs.size());
+    TaskGroup group;
+    for (i = 0; i < alignmentPtrs.size(); i++ ) {
+      tasks[i].bothQueryStrands = &bothQueryStrands;
+      tasks[i].genome           = &genome;
+      tasks[i].alignment        = alignmentPtrs[i];
+      tasks[i].params           = &params;
+      tasks[i].queryProfile     = queryProfile;
+      mapData->schedulerPtr->Submit(mapData->threadIndex, group, &tasks[i]);
+    }
+    mapData->schedulerPtr->Wait(mapData->threadIndex, group);
+  }
+  else {
+    for (i = 0; i < alignmentPtrs.size(); i++ ) {
+      RefineAlignment(bothQueryStrands, genome, *alignmentPtrs[i], params, mappingBuffers, queryProfile);
+    }
   }
   //
   // It's possible the alignment references change their order after running
@@ -1587,7 +1910,8 @@ template<typename T_RefSequence, typename T_Sequence>
 void RefineAlignment(vector<T_Sequence*> &bothQueryStrands,
                      T_RefSequence &genome,
                      T_AlignmentCandidate  &alignmentCandidate, MappingParameters &params,
-                     MappingBuffers &mappingBuffers) {
+                     MappingBuffers &mappingBuffers,
+                     QueryScoreProfile *queryProfile=NULL) {
 
 
   FASTQSequence qSeq;
@@ -1598,14 +1922,9 @@ void RefineAlignment(vector<T_Sequence*> &bothQueryStrands,
   distScoreFn.InitializeScoreMatrix(SMRTDistanceMatrix);
   QualityValueScoreFunction<DNASequence, FASTQSequence> scoreFn;
   IDSScoreFunction<DNASequence, FASTQSequence> idsScoreFn;
-  idsScoreFn.InitializeScoreMatrix(SMRTDistanceMatrix);
   scoreFn.del = params.indel;
   scoreFn.ins = params.indel;
-  idsScoreFn.ins = params.insertion;
-  idsScoreFn.del = params.deletion;
-  idsScoreFn.affineExtend = params.affineExtend;
-  idsScoreFn.substitutionPrior = params.substitutionPrior;
-  idsScoreFn.globalDeletionPrior = params.globalDeletionPrior;
+  InitializeIDSScoreFunction(idsScoreFn, params);
   if (params.doGlobalAlignment) {
     SMRTSequence subread;
     subread.ReferenceSubstring(*bothQueryStrands[0], 
@@ -1616,11 +1935,21 @@ void RefineAlignment(vector<T_Sequence*> &bothQueryStrands,
     int drift = ComputeDrift(alignmentCandidate);
     T_AlignmentCandidate refinedAlignment;
 
-    KBandAlign(subread, alignmentCandidate.tAlignedSeq, SMRTDistanceMatrix, 
-               params.insertion, params.deletion,
-                              drift,
-                              mappingBuffers.scoreMat, mappingBuffers.pathMat,
-                              refinedAlignment, idsScoreFn, Global);
+    if (queryProfile != NULL) {
+      IDSProfileScoreFunction profileScoreFn(idsScoreFn, *queryProfile, bothQueryStrands[0]->subreadStart);
+      KBandAlign(subread, alignmentCandidate.tAlignedSeq, SMRTDistanceMatrix, 
+                 params.insertion, params.deletion,
+                 drift,
+                 mappingBuffers.scoreMat, mappingBuffers.pathMat,
+                 refinedAlignment, profileScoreFn, Global);
+    }
+    else {
+      KBandAlign(subread, alignmentCandidate.tAlignedSeq, SMRTDistanceMatrix, 
+                 params.insertion, params.deletion,
+                 drift,
+                 mappingBuffers.scoreMat, mappingBuffers.pathMat,
+                 refinedAlignment, idsScoreFn, Global);
+    }
     refinedAlignment.RemoveEndGaps();
     ComputeAlignmentStats(refinedAlignment, 
                           subread.seq, 
@@ -1664,7 +1993,23 @@ void RefineAlignment(vector<T_Sequence*> &bothQueryStrands,
 
 
       if (!params.ignoreQualities && ReadHasMeaningfulQualityValues(alignmentCandidate.qAlignedSeq)) {
-        if (params.affineAlign) {
+        if (queryProfile != NULL) {
+          IDSProfileScoreFunction profileScoreFn(idsScoreFn, *queryProfile,
+                                                 alignmentCandidate.qAlignedSeqPos + alignmentCandidate.qPos);
+          if (params.affineAlign) {
+            AffineGuidedAlign(qSeq, tSeq, alignmentCandidate, 
+                              profileScoreFn, params.bandSize,
+                              mappingBuffers, 
+                              refinedAlignment, Global, false);
+          }
+          else {
+            GuidedAlign(qSeq, tSeq, alignmentCandidate, 
+                        profileScoreFn, params.bandSize,
+                        mappingBuffers, 
+                        refinedAlignment, Global, false);
+          }
+        }
+        else if (params.affineAlign) {
             AffineGuidedAlign(qSeq, tSeq, alignmentCandidate, 
                             idsScoreFn, params.bandSize,
                             mappingBuffers, 
@@ -1864,7 +2209,8 @@ void RefineAlignment(vector<T_Sequence*> &bothQueryStrands,
   }
 }
 
-void AssignRefContigLocation(T_AlignmentCandidate &alignment, SequenceIndexDatabase<FASTQSequence> &seqdb, DNASequence &genome) {
+template<typename T_RefSequence>
+void AssignRefContigLocation(T_AlignmentCandidate &alignment, SequenceIndexDatabase<FASTQSequence> &seqdb, T_RefSequence &genome) {
     //
     // If the sequence database is used, the start position of
     // the alignment is relative to the start of the chromosome,
@@ -1902,7 +2248,8 @@ void AssignRefContigLocation(T_AlignmentCandidate &alignment, SequenceIndexDatab
   }
 }
 
-void AssignRefContigLocations(vector<T_AlignmentCandidate*> &alignmentPtrs, SequenceIndexDatabase<FASTQSequence> &seqdb, DNASequence &genome) {
+template<typename T_RefSequence>
+void AssignRefContigLocations(vector<T_AlignmentCandidate*> &alignmentPtrs, SequenceIndexDatabase<FASTQSequence> &seqdb, T_RefSequence &genome) {
   
   UInt i;
   for (i = 0; i < alignmentPtrs.size(); i++) {
@@ -1922,6 +2269,149 @@ void AssignGenericRefContigName(vector<T_AlignmentCandidate*> &alignmentPtrs, T_
 }
 
 
+//
+// Remove anchors that imply the read starts where the genome is not
+// unique for 'length' bases, i.e. inside a repeat that is longer than
+// the read.  When no anchor on either strand lies in a unique region
+// the read is wholly inside a repeat; then every anchor is kept, so
+// that the read is still mapped and its placements among the copies
+// are reflected in the mapqv.  Returns the number of anchors removed.
+//
+bool IsAnchorInUniqueRegion(ChainedMatchPos &matchPos, MapabilityTrack &mapability, int length) {
+  DNALength readStart = (matchPos.t > matchPos.q ? matchPos.t - matchPos.q : 0);
+  return (readStart < mapability.size() and mapability.IsUnique(readStart, length));
+}
+
+int RemoveAnchorsInNonUniqueRegions(vector<ChainedMatchPos> &matchPosList, MapabilityTrack &mapability, int length) {
+  int i, nKept = 0;
+  for (i = 0; i < matchPosList.size(); i++) {
+    if (IsAnchorInUniqueRegion(matchPosList[i], mapability, length)) {
+      matchPosList[nKept] = matchPosList[i];
+      ++nKept;
+    }
+  }
+  int nRemoved = matchPosList.size() - nKept;
+  matchPosList.resize(nKept);
+  return nRemoved;
+}
+
+int RemoveAnchorsInNonUniqueRegions(vector<ChainedMatchPos> &matchPosList, vector<ChainedMatchPos> &rcMatchPosList,
+                                    MapabilityTrack &mapability, int length) {
+  bool anyUnique = false;
+  int i;
+  for (i = 0; i < matchPosList.size() and anyUnique == false; i++) {
+    anyUnique = IsAnchorInUniqueRegion(matchPosList[i], mapability, length);
+  }
+  for (i = 0; i < rcMatchPosList.size() and anyUnique == false; i++) {
+    anyUnique = IsAnchorInUniqueRegion(rcMatchPosList[i], mapability, length);
+  }
+  if (anyUnique == false) {
+    return 0;
+  }
+  return RemoveAnchorsInNonUniqueRegions(matchPosList, mapability, length) + 
+    RemoveAnchorsInNonUniqueRegions(rcMatchPosList, mapability, length);
+}
+
+//
+// Condense the homopolymers of a read for seeding against the
+// condensed reference.  hpcRead refers to 'buffer', and its subread
+// bounds are those of 'read' in condensed coordinates.
+//
+template<typename T_Sequence>
+void MakeHPCRead(T_Sequence &read, vector<Nucleotide> &buffer, vector<DNALength> &runStart, T_Sequence &hpcRead) {
+  buffer.resize(read.length + 1);
+  hpcRead.seq          = &buffer[0];
+  hpcRead.length       = CondenseHomopolymers(read.seq, read.length, &buffer[0], &runStart);
+  hpcRead.deleteOnExit = false;
+  hpcRead.subreadStart = lower_bound(runStart.begin(), runStart.end(), (DNALength) read.subreadStart) - runStart.begin();
+  hpcRead.subreadEnd   = lower_bound(runStart.begin(), runStart.end(), (DNALength) read.subreadEnd) - runStart.begin();
+}
+
+//
+// Map anchors found between the condensed read and reference back to
+// the full sequences.  The runs spanned by an anchor may have
+// different lengths in the read and the reference, so each anchor is
+// split into the exact matches between runs of equal length.
+//
+template<typename T_RefSequence, typename T_Sequence>
+void MapHPCAnchorsToFullSequences(vector<ChainedMatchPos> &matchPosList,
+                                  vector<ChainedMatchPos> &fullMatchPosList,
+                                  T_RefSequence &genome, 
+                                  ReverseCompressIndex &genomeIndex, 
+                                  DNALength hpcGenomeLength,
+                                  T_Sequence &read,
+                                  vector<DNALength> &readRunStart) {
+  fullMatchPosList.clear();
+  int i;
+  for (i = 0; i < matchPosList.size(); i++) {
+    ChainedMatchPos &anchor = matchPosList[i];
+    if (anchor.t >= hpcGenomeLength or anchor.q >= readRunStart.size()) {
+      continue;
+    }
+    DNALength tPos = genomeIndex.Lookup(genome.seq, genome.length, anchor.t);
+    DNALength qPos = readRunStart[anchor.q];
+    DNALength pieceT = tPos, pieceQ = qPos, pieceLength = 0;
+    DNALength k;
+    for (k = anchor.q; k < anchor.q + anchor.l and tPos < genome.length and qPos < read.subreadEnd; k++) {
+      DNALength tRun = 1;
+      while (tPos + tRun < genome.length and ThreeBit[genome.seq[tPos + tRun]] == ThreeBit[genome.seq[tPos]]) {
+        tRun++;
+      }
+      DNALength qRunEnd = (k + 1 < readRunStart.size() ? readRunStart[k + 1] : read.length);
+      DNALength qRun    = min(qRunEnd, (DNALength) read.subreadEnd) - qPos;
+      if (tRun == qRun) {
+        pieceLength += tRun;
+      }
+      else {
+        pieceLength += min(tRun, qRun);
+        fullMatchPosList.push_back(ChainedMatchPos(pieceT, pieceQ, pieceLength, anchor.m));
+        pieceT = tPos + tRun;
+        pieceQ = qPos + qRun;
+        pieceLength = 0;
+      }
+      tPos += tRun;
+      qPos += qRun;
+    }
+    if (pieceLength > 0) {
+      fullMatchPosList.push_back(ChainedMatchPos(pieceT, pieceQ, pieceLength, anchor.m));
+    }
+  }
+  matchPosList.swap(fullMatchPosList);
+}
+
+//
+// Anchor one strand of a read.  Only the match list passed in is
+// written, so this may run on any thread.
+//
+template<typename T_RefSequence, typename T_SuffixArray, typename T_Sequence>
+class MapReadToGenomeTask : public SchedulerTask {
+ public:
+  T_RefSequence *genome;
+  T_SuffixArray *sarray;
+  BWT *bwt;
+  T_Sequence *read;
+  MappingParameters *params;
+  vector<ChainedMatchPos> *matchPosList;
+  int numKeysMatched;
+  int numBasesMatched;
+
+  MapReadToGenomeTask() {
+    numKeysMatched  = 0;
+    numBasesMatched = 0;
+  }
+
+  void Run(void *workerContext) {
+    if (params->useSuffixArray) {
+      numKeysMatched = MapReadToGenome(*genome, *sarray, *read, params->lookupTableLength, *matchPosList,
+                                       params->anchorParameters);
+    }
+    else if (params->useBwt) {
+      numKeysMatched = MapReadToGenome(*bwt, *read, read->subreadStart, read->subreadEnd,
+                                       *matchPosList, params->anchorParameters, numBasesMatched);
+    }
+  }
+};
+
 template<typename T_Sequence, typename T_RefSequence, typename T_SuffixArray, typename T_TupleCountTable>
 void MapRead(T_Sequence &read, T_Sequence &readRC, T_RefSequence &genome, 
              T_SuffixArray &sarray, 
@@ -1939,9 +2429,38 @@ void MapRead(T_Sequence &read, T_Sequence &readRC, T_RefSequence &genome,
   WeightedIntervalSet topIntervals(params.nCandidates);
   int numKeysMatched=0, rcNumKeysMatched=0;
   int expand = params.minExpand;
+  int lastExpand = params.maxExpand;
   metrics.clocks.total.Tick();
   int nTotalCells = 0;
   int forwardNumBasesMatched = 0, reverseNumBasesMatched = 0;
+
+  //
+  // With adaptive seeding the seed length, repeat cap, and expand of
+  // the read are chosen from the tuple count table before searching,
+  // and the read is searched only once.
+  //
+  AnchorParameters defaultAnchorParameters = params.anchorParameters;
+  if (params.adaptiveSeeding) {
+    float copyNumber = MedianTupleCopyNumber(read, 0, read.length, ct, mappingBuffers.tupleCounts);
+    SelectSeedParameters(copyNumber, read.length, defaultAnchorParameters, 
+                         params.minExpand, params.maxExpand, params.anchorParameters, expand);
+    lastExpand = expand;
+  }
+
+  //
+  // Look up the read in the sketch index once.  When it has a locus,
+  // the anchors are made from its minimizer matches, and the suffix
+  // array or BWT is not searched.  Otherwise the read is searched as
+  // usual.
+  //
+  bool useSketch = false;
+  if (mapData->sketchIndexPtr != NULL) {
+    ++metrics.sketchQueries;
+    useSketch = SketchShortlist(*mapData->sketchIndexPtr, read, readRC, params.forwardOnly,
+                                params.sketchMaxOccurrences, params.sketchMinHits,
+                                mappingBuffers.sketchMinimizers, mappingBuffers.sketchHits);
+  }
+
   do {
     matchFound = false;
     mappingBuffers.matchPosList.clear();
@@ -1951,33 +2470,102 @@ void MapRead(T_Sequence &read, T_Sequence &readRC, T_RefSequence &genome,
     params.anchorParameters.expand = expand;
 
     metrics.clocks.mapToGenome.Tick();
-    
-    if (params.useSuffixArray) {
+
+    //
+    // For long reads, anchor the reverse strand as a separate task
+    // so that an idle thread may do it while this thread anchors the
+    // forward strand.  This is skipped when printing lcp bounds,
+    // since those are written while searching.
+    //
+    bool anchorReverseAsTask = (!params.forwardOnly and 
+                                !useSketch and
+                                mapData->lcpBoundsOutPtr == NULL and
+                                SplitReadIntoTasks(mapData, params, read.length));
+
+    //
+    // With homopolymer compressed seeding, anchor the condensed read
+    // against the condensed reference, and map the anchors back once
+    // both strands are done.
+    //
+    T_Sequence hpcRead, hpcReadRC;
+    T_Sequence *seedRead   = &read;
+    T_Sequence *seedReadRC = &readRC;
+    T_RefSequence *seedGenome = &genome;
+    if (params.hpcSeeding) {
+      MakeHPCRead(read,   mappingBuffers.hpcRead,   mappingBuffers.hpcReadRunStart,   hpcRead);
+      MakeHPCRead(readRC, mappingBuffers.hpcReadRC, mappingBuffers.hpcReadRCRunStart, hpcReadRC);
+      seedRead   = &hpcRead;
+      seedReadRC = &hpcReadRC;
+      seedGenome = mapData->hpcReferenceSeqPtr;
+    }
+
+    MapReadToGenomeTask<T_RefSequence, T_SuffixArray, T_Sequence> reverseAnchorTask;
+    TaskGroup reverseAnchorGroup;
+    if (anchorReverseAsTask) {
+      reverseAnchorTask.genome       = seedGenome;
+      reverseAnchorTask.sarray       = &sarray;
+      reverseAnchorTask.bwt          = &bwt;
+      reverseAnchorTask.read         = seedReadRC;
+      reverseAnchorTask.params       = &params;
+      reverseAnchorTask.matchPosList = &mappingBuffers.rcMatchPosList;
+      mapData->schedulerPtr->Submit(mapData->threadIndex, reverseAnchorGroup, &reverseAnchorTask);
+    }
+  
+    if (useSketch) {
+      SketchAnchors(genome, read, readRC, mappingBuffers.sketchHits,
+                    mapData->sketchIndexPtr->tm.tupleSize, params.anchorParameters.minMatchLength,
+                    mappingBuffers.matchPosList, mappingBuffers.rcMatchPosList);
+    }
+    else if (params.useSuffixArray) {
       params.anchorParameters.lcpBoundsOutPtr = mapData->lcpBoundsOutPtr;
       numKeysMatched   = 
-        MapReadToGenome(genome, sarray, read,   params.lookupTableLength, mappingBuffers.matchPosList,   
+        MapReadToGenome(*seedGenome, sarray, *seedRead,   params.lookupTableLength, mappingBuffers.matchPosList,   
                         params.anchorParameters);
-      
+    
       //
       // Only print values for the read in forward direction (and only
       // the first read). 
       //
       mapData->lcpBoundsOutPtr = NULL;
-      if (!params.forwardOnly) {
+      if (!params.forwardOnly and !anchorReverseAsTask) {
         rcNumKeysMatched = 
-          MapReadToGenome(genome, sarray, readRC, params.lookupTableLength, mappingBuffers.rcMatchPosList, 
+          MapReadToGenome(*seedGenome, sarray, *seedReadRC, params.lookupTableLength, mappingBuffers.rcMatchPosList, 
                           params.anchorParameters);
       }
     }
     else if (params.useBwt){ 
-      numKeysMatched   = MapReadToGenome(bwt, read, read.subreadStart, read.subreadEnd, 
+      numKeysMatched   = MapReadToGenome(bwt, *seedRead, seedRead->subreadStart, seedRead->subreadEnd, 
                                          mappingBuffers.matchPosList, params.anchorParameters, forwardNumBasesMatched);
-      if (!params.forwardOnly) {
-        rcNumKeysMatched = MapReadToGenome(bwt, readRC, readRC.subreadStart, readRC.subreadEnd, 
+      if (!params.forwardOnly and !anchorReverseAsTask) {
+        rcNumKeysMatched = MapReadToGenome(bwt, *seedReadRC, seedReadRC->subreadStart, seedReadRC->subreadEnd, 
                                            mappingBuffers.rcMatchPosList, params.anchorParameters, reverseNumBasesMatched); 
       }
     }
 
+    if (anchorReverseAsTask) {
+      mapData->schedulerPtr->Wait(mapData->threadIndex, reverseAnchorGroup);
+      rcNumKeysMatched       = reverseAnchorTask.numKeysMatched;
+      reverseNumBasesMatched = reverseAnchorTask.numBasesMatched;
+    }
+
+    if (params.hpcSeeding and !useSketch) {
+      MapHPCAnchorsToFullSequences(mappingBuffers.matchPosList, mappingBuffers.hpcMatchPosList,
+                                   genome, *mapData->reverseCompressIndexPtr, seedGenome->length,
+                                   read, mappingBuffers.hpcReadRunStart);
+      MapHPCAnchorsToFullSequences(mappingBuffers.rcMatchPosList, mappingBuffers.hpcMatchPosList,
+                                   genome, *mapData->reverseCompressIndexPtr, seedGenome->length,
+                                   readRC, mappingBuffers.hpcReadRCRunStart);
+    }
+
+    if (mapData->mapabilityPtr != NULL) {
+      int uniqueLength = params.mapabilityMaxLength;
+      if (uniqueLength == 0) {
+        uniqueLength = read.subreadEnd - read.subreadStart;
+      }
+      RemoveAnchorsInNonUniqueRegions(mappingBuffers.matchPosList, mappingBuffers.rcMatchPosList, 
+                                      *mapData->mapabilityPtr, uniqueLength);
+    }
+
     //
     // Look to see if only the anchors are printed.
     if (params.anchorFileName != "") {
@@ -2207,22 +2795,24 @@ void MapRead(T_Sequence &read, T_Sequence &readRC, T_RefSequence &genome,
     // Allocate candidate alignments on the stack.  Each interval is aligned.
     //
     alignmentPtrs.resize(topIntervals.size());
+    metrics.totalCandidates += topIntervals.size();
     UInt i;
     for (i = 0; i < alignmentPtrs.size(); i++ ) {
       alignmentPtrs[i] = new T_AlignmentCandidate;
     }
     metrics.clocks.alignIntervals.Tick();
-    AlignIntervals( genome, read, readRC,
-                    topIntervals,
-                    SMRTDistanceMatrix,
-                    params.indel, params.indel, 
-                    params.sdpTupleSize, 
-                    params.useSeqDB, seqdb,
-                    alignmentPtrs,
-                    params,
-                    params.useScoreCutoff, params.maxScore,
-                    mappingBuffers,
-                    params.startRead );
+    int nPrunedCandidates = AlignIntervals( genome, read, readRC,
+                                            topIntervals,
+                                            SMRTDistanceMatrix,
+                                            params.indel, params.indel, 
+                                            params.sdpTupleSize, 
+                                            params.useSeqDB, seqdb,
+                                            alignmentPtrs,
+                                            params,
+                                            params.useScoreCutoff, params.maxScore,
+                                            mappingBuffers,
+                                            params.startRead );
+    metrics.prunedCandidates += nPrunedCandidates;
 
     /*    cout << read.title << endl;
     for (i = 0; i < alignmentPtrs.size(); i++) {
@@ -2239,12 +2829,21 @@ void MapRead(T_Sequence &read, T_Sequence &readRC, T_RefSequence &genome,
     //
       
     matchFound = CheckForSufficientMatch(read, alignmentPtrs, params);
+
+    //
+    // The anchors of the sketch do not depend on expand, so a read
+    // with a locus is mapped once.
+    //
+    if (useSketch) {
+      ++metrics.sketchShortCircuits;
+      expand = lastExpand;
+    }
       
     //
     // When no proper alignments are found, the loop will resume.
     // Delete all alignments because they are bad.
     // 
-    if (expand < params.maxExpand and matchFound == false) {
+    if (expand < lastExpand and matchFound == false) {
       DeleteAlignments(alignmentPtrs, 0);
     }
 
@@ -2259,10 +2858,14 @@ void MapRead(T_Sequence &read, T_Sequence &readRC, T_RefSequence &genome,
     }
 
     if (matchFound == true) {
+      metrics.numMappedReads++;
       metrics.totalAnchorsForMappedReads += mappingBuffers.matchPosList.size() + mappingBuffers.rcMatchPosList.size();
     }
     ++expand;
-  } while ( expand <= params.maxExpand and matchFound == false);
+  } while ( expand <= lastExpand and matchFound == false);
+  if (params.adaptiveSeeding) {
+    params.anchorParameters = defaultAnchorParameters;
+  }
   metrics.clocks.total.Tock();
   UInt i;
   int totalCells = 0;
@@ -2306,7 +2909,10 @@ void MapRead(T_Sequence &read, T_Sequence &readRC, T_RefSequence &genome,
   // of an alignment and the alignment score.
   //
   if (params.refineAlignments) {
-    RefineAlignments(bothQueryStrands, genome, alignmentPtrs, params, mappingBuffers);
+    RefineAlignments(bothQueryStrands, genome, alignmentPtrs, params, mappingBuffers, mapData);
+    for (i = 0; i < alignmentPtrs.size(); i++) {
+      metrics.totalCells += alignmentPtrs[i]->nCells;
+    }
     RemoveLowQualityAlignments(read,alignmentPtrs,params);
     RemoveOverlappingAlignments(alignmentPtrs, params);
   }
@@ -2807,6 +3413,11 @@ void PrintAlignment(T_AlignmentCandidate &alignment, SMRTSequence &fullRead, Map
         SummaryAlignmentPrinter::Print(alignment, outFile);
       }
     }
+    else if (params.printFormat == CompactBinary) {
+      if (alignment.blocks.size() > 0) {
+        BinaryAlignmentPrinter::Print(alignment, outFile, params.printBinaryQV);
+      }
+    }
   }
   catch (ostream::failure f) {
     cout << "ERROR writing to output file. The output drive may be full, or you  " << endl;
@@ -2820,7 +3431,8 @@ void PrintAlignment(T_AlignmentCandidate &alignment, SMRTSequence &fullRead, Map
 void PrintAlignments(vector<T_AlignmentCandidate*> alignmentPtrs,
                      SMRTSequence &read,
                      MappingParameters &params, ostream &outFile, 
-                     AlignmentContext alignmentContext) {
+                     AlignmentContext alignmentContext,
+                     MappingMetrics &metrics) {
   //
   // Print all alignments, unless the parameter placeRandomly is set.
   // In this case only one read is printed and it is selected from all
@@ -2849,14 +3461,6 @@ void PrintAlignments(vector<T_AlignmentCandidate*> alignmentPtrs,
     }
   }
   
-  if (params.nProc > 1) {
-#ifdef __APPLE__
-    sem_wait(semaphores.writer);
-#else
-    sem_wait(&semaphores.writer);
-#endif
-  }
-
   int optIndex = 0;
   int startIndex = 0;
   int endIndex = 0;
@@ -2869,6 +3473,12 @@ void PrintAlignments(vector<T_AlignmentCandidate*> alignmentPtrs,
     startIndex = 0;
     endIndex   = MIN(params.nBest, alignmentPtrs.size());
   }
+  //
+  // Format all alignments of this read before taking the writer
+  // semaphore so that other threads are only blocked while the text
+  // is written, and so that the number of bytes written is known.
+  //
+  stringstream alignmentsOut;
   for (i = startIndex; i < endIndex; i++) { 
     T_AlignmentCandidate *aref = alignmentPtrs[i];      
       
@@ -2895,9 +3505,34 @@ void PrintAlignments(vector<T_AlignmentCandidate*> alignmentPtrs,
       alignmentContext.isPrimary = true;
     }
     
-    PrintAlignment(*alignmentPtrs[i], read, params, alignmentContext, outFile);
+    PrintAlignment(*alignmentPtrs[i], read, params, alignmentContext, alignmentsOut);
   }
 
+  string alignmentsText = alignmentsOut.str();
+  if (alignmentsText.size() == 0) {
+    return;
+  }
+
+  if (params.nProc > 1) {
+    long long waitStart = WallClockUsec();
+#ifdef __APPLE__
+    sem_wait(semaphores.writer);
+#else
+    sem_wait(&semaphores.writer);
+#endif
+    metrics.AddWriterWait(WallClockUsec() - waitStart);
+  }
+
+  try {
+    outFile.write(alignmentsText.c_str(), alignmentsText.size());
+  }
+  catch (ostream::failure f) {
+    cout << "ERROR writing to output file. The output drive may be full, or you  " << endl;
+    cout << "may not have proper write permissions." << endl;
+    exit(1);
+  }
+  metrics.bytesWritten += alignmentsText.size();
+
   if (params.nProc > 1) {
 #ifdef __APPLE__
     sem_post(semaphores.writer);
@@ -2909,7 +3544,8 @@ void PrintAlignments(vector<T_AlignmentCandidate*> alignmentPtrs,
 }
 
 template<typename T_Sequence>
-bool GetNextReadThroughSemaphore(ReaderAgglomerate &reader, MappingParameters &params, T_Sequence &read, AlignmentContext &context) {
+bool GetNextReadThroughSemaphore(ReaderAgglomerate &reader, MappingParameters &params, T_Sequence &read, AlignmentContext &context,
+                                 MappingMetrics &metrics, CheckpointJournal *checkpoint=NULL, long *checkpointTicket=NULL) {
 
   //
   // Grab the value of the semaphore for debugging purposes.
@@ -2923,14 +3559,25 @@ bool GetNextReadThroughSemaphore(ReaderAgglomerate &reader, MappingParameters &p
   //
   // Wait on a semaphore
   if (params.nProc > 1) {
+    long long waitStart = WallClockUsec();
 #ifdef __APPLE__
     sem_wait(semaphores.reader);
 #else
     sem_wait(&semaphores.reader);
 #endif
+    metrics.AddReaderWait(WallClockUsec() - waitStart);
   }
 
   bool returnValue = true;
+  //
+  // The position of the read is taken before it is read, since the
+  // reader does not stride past the last reads of a file.
+  //
+  int readPosition = 0;
+  if (checkpoint != NULL) {
+    readPosition = reader.GetReadPosition();
+  }
+
   //
   // CCS Reads are read differently from other reads.  Do static casting here
   // of this.
@@ -2944,6 +3591,14 @@ bool GetNextReadThroughSemaphore(ReaderAgglomerate &reader, MappingParameters &p
   // threads may change the reader object to a new read group before
   // sending this alignment out to printing. 
   context.readGroupId = reader.readGroupId;
+
+  //
+  // Tickets are issued in the order reads leave the reader, and a run
+  // continues from the next read of its -start/-stride partition.
+  //
+  if (returnValue and checkpoint != NULL) {
+    *checkpointTicket = checkpoint->Issue(readPosition + max(params.stride, 1));
+  }
   
   if (params.nProc > 1) {
 #ifdef __APPLE__
@@ -3017,8 +3672,41 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
   // fragmentation.
   //
   MappingBuffers mappingBuffers;
+  if (mapData->schedulerPtr != NULL) {
+    mapData->schedulerPtr->SetWorkerContext(mapData->threadIndex, &mappingBuffers);
+  }
+
+  //
+  // When checkpointing, the output of a read is buffered until the
+  // read is done, and then handed to the journal, which writes the
+  // output of reads in the order they were read.  A read is done when
+  // the next one is requested, since reads that are filtered skip the
+  // rest of the loop.  The cluster lines written by MapRead are
+  // buffered the same way.
+  //
+  ostream *outFilePtr       = mapData->outFilePtr;
+  ostream *unalignedFilePtr = mapData->unalignedFilePtr;
+  stringstream readOutput, readUnalignedOutput, readClusterOutput;
+  long checkpointTicket = -1;
+  if (mapData->checkpointPtr != NULL) {
+    outFilePtr       = &readOutput;
+    unalignedFilePtr = &readUnalignedOutput;
+    if (mapData->clusterFilePtr != NULL) {
+      mapData->clusterFilePtr = &readClusterOutput;
+    }
+  }
+
   while (true) {
 
+    if (checkpointTicket >= 0) {
+      mapData->checkpointPtr->Complete(checkpointTicket, readOutput.str(), readUnalignedOutput.str(),
+                                       readClusterOutput.str());
+      readOutput.str("");
+      readUnalignedOutput.str("");
+      readClusterOutput.str("");
+      checkpointTicket = -1;
+    }
+
     //
     // Scan the next read from input.  This may either be a CCS read,
     // or regular read (though this may be aligned in whole, or by
@@ -3027,7 +3715,8 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
 
     AlignmentContext alignmentContext;
     if (mapData->reader->GetFileType() == HDFCCS) {
-      if (GetNextReadThroughSemaphore(*mapData->reader, params, ccsRead, alignmentContext) == false) {
+      if (GetNextReadThroughSemaphore(*mapData->reader, params, ccsRead, alignmentContext, mapData->metrics,
+                                      mapData->checkpointPtr, &checkpointTicket) == false) {
         break;
       }
       else {
@@ -3044,7 +3733,8 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
       }
     }
     else {
-      if (GetNextReadThroughSemaphore(*mapData->reader, params, smrtRead, alignmentContext) == false) {
+      if (GetNextReadThroughSemaphore(*mapData->reader, params, smrtRead, alignmentContext, mapData->metrics,
+                                      mapData->checkpointPtr, &checkpointTicket) == false) {
         break;
       }
       else {
@@ -3052,6 +3742,12 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
         smrtRead.SetQVScale(params.qvScaleType);
       }
     }
+    if (readIsCCS) {
+      mapData->metrics.bytesRead += ccsRead.GetStorageSize() + ccsRead.unrolledRead.GetStorageSize();
+    }
+    else {
+      mapData->metrics.bytesRead += smrtRead.GetStorageSize();
+    }
 
     //
     // Only normal (non-CCS) reads should be masked.  Since CCS reads store the raw read, that is masked.
@@ -3133,6 +3829,8 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
       smrtRead.PrintSeq(cout);
     }
 
+    mapData->metrics.StartRead(smrtRead.title);
+
     smrtRead.MakeRC(smrtReadRC);
     
     if (readIsCCS) {
@@ -3639,8 +4337,8 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
 //                        smrtRead, // the source read
                         allReadAlignments.subreads[subreadIndex], // the source read
                         // for these alignments
-                        params, *mapData->outFilePtr,
-                        alignmentContext);   
+                        params, *outFilePtr,
+                        alignmentContext, mapData->metrics);   
       }
       else {
         //
@@ -3648,7 +4346,7 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
         //
         if (params.printUnaligned == true) {
           if (params.nProc == 1) {
-            allReadAlignments.subreads[subreadIndex].PrintSeq(*mapData->unalignedFilePtr);
+            allReadAlignments.subreads[subreadIndex].PrintSeq(*unalignedFilePtr);
           }
           else {
 #ifdef __APPLE__
@@ -3656,7 +4354,7 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
 #else
             sem_wait(&semaphores.unaligned);
 #endif
-            allReadAlignments.subreads[subreadIndex].PrintSeq(*mapData->unalignedFilePtr);
+            allReadAlignments.subreads[subreadIndex].PrintSeq(*unalignedFilePtr);
 #ifdef __APPLE__
             sem_post(semaphores.unaligned);
 #else
@@ -3668,6 +4366,14 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
 
     }
     
+    //
+    // Publish the timings and counters of this read.  The metrics lock
+    // is only contended when the progress reporter takes a snapshot.
+    //
+    pthread_mutex_lock(&mapData->metricsLock);
+    mapData->metrics.RecordRead(&mapData->publishedMetrics);
+    pthread_mutex_unlock(&mapData->metricsLock);
+
     allReadAlignments.Clear();
 		smrtReadRC.Free();
 		smrtRead.Free();
@@ -3681,6 +4387,24 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
       mappingBuffers.Reset();
     }
 	}
+  //
+  // A read that stopped the loop (past -maxReadIndex) is done too.
+  //
+  if (checkpointTicket >= 0) {
+    mapData->checkpointPtr->Complete(checkpointTicket, readOutput.str(), readUnalignedOutput.str(),
+                                     readClusterOutput.str());
+  }
+  if (mapData->clusterFilePtr == &readClusterOutput) {
+    mapData->clusterFilePtr = NULL;
+  }
+  //
+  // Keep helping with tasks split off of reads still being mapped by
+  // other threads.  The buffers registered with the scheduler are
+  // local to this function, so this must happen before returning.
+  //
+  if (mapData->schedulerPtr != NULL) {
+    mapData->schedulerPtr->Retire(mapData->threadIndex);
+  }
 	if (params.nProc > 1) {
 #ifdef __APPLE__
 		sem_wait(semaphores.reader);
@@ -3695,6 +4419,107 @@ void MapReads(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapData) {
 	}
 }
 
+//
+// Periodically write a snapshot of the per-thread metrics as one line
+// of JSON.  Each worker copies its counters and the latencies of a
+// read to publishedMetrics under its own metricsLock after every read,
+// and the snapshot reads only those, so a snapshot only briefly blocks
+// a worker.
+//
+class MetricsReporter {
+public:
+  MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapdb;
+  int nProc;
+  int interval;
+  ostream *out;
+  bool done;
+  int snapshotIndex;
+  long long startUsec;
+  pthread_mutex_t lock;
+  pthread_cond_t  wakeup;
+
+  MetricsReporter() {
+    mapdb = NULL;
+    nProc = 0;
+    interval = 0;
+    out = NULL;
+    done = false;
+    snapshotIndex = 0;
+    startUsec = WallClockUsec();
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&wakeup, NULL);
+  }
+
+  ~MetricsReporter() {
+    pthread_mutex_destroy(&lock);
+    pthread_cond_destroy(&wakeup);
+  }
+
+  void WriteSnapshot(bool isFinal) {
+    MappingMetrics aggregate;
+    vector<MappingMetrics> perThread(nProc);
+    int t;
+    for (t = 0; t < nProc; t++) {
+      pthread_mutex_lock(&mapdb[t].metricsLock);
+      perThread[t].CollectHistograms(mapdb[t].publishedMetrics);
+      pthread_mutex_unlock(&mapdb[t].metricsLock);
+      aggregate.CollectHistograms(perThread[t]);
+    }
+    *out << "{\"snapshot\": " << snapshotIndex++
+         << ", \"elapsedSec\": " << (WallClockUsec() - startUsec) / 1000000.0
+         << ", \"final\": " << (isFinal ? "true" : "false")
+         << ", \"aggregate\": ";
+    aggregate.PrintJSON(*out);
+    *out << ", \"threads\": [";
+    for (t = 0; t < nProc; t++) {
+      if (t > 0) { *out << ", "; }
+      *out << "{\"thread\": " << t << ", \"reads\": " << perThread[t].numReads << ", \"queueWaits\": ";
+      perThread[t].PrintWaitsJSON(*out);
+      *out << "}";
+    }
+    *out << "]}" << endl;
+  }
+
+  void Stop() {
+    pthread_mutex_lock(&lock);
+    done = true;
+    pthread_cond_signal(&wakeup);
+    pthread_mutex_unlock(&lock);
+  }
+};
+
+void *ReportMetricsPeriodically(void *reporterPtr) {
+  MetricsReporter *reporter = (MetricsReporter*) reporterPtr;
+  pthread_mutex_lock(&reporter->lock);
+  while (reporter->done == false) {
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += reporter->interval;
+    pthread_cond_timedwait(&reporter->wakeup, &reporter->lock, &deadline);
+    if (reporter->done == false) {
+      reporter->WriteSnapshot(false);
+    }
+  }
+  pthread_mutex_unlock(&reporter->lock);
+  return NULL;
+}
+
+void PrintChromeTrace(MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapdb, int nProc, ostream &out) {
+  out << "{\"traceEvents\": [";
+  bool first = true;
+  int t;
+  for (t = 0; t < nProc; t++) {
+    vector<TraceEvent> &events = mapdb[t].metrics.trace.events;
+    VectorIndex e;
+    for (e = 0; e < events.size(); e++) {
+      out << (first ? "" : ",") << endl;
+      events[e].PrintChromeTraceEvent(out);
+      first = false;
+    }
+  }
+  out << endl << "], \"displayTimeUnit\": \"ms\"}" << endl;
+}
+
 float ComputePMatch(float accuracy, int anchorLength) {
   assert(anchorLength >= 0);
   if (anchorLength == 0) { 
@@ -3776,6 +4601,8 @@ int main(int argc, char* argv[]) {
 	clp.RegisterStringOption("ctab", &params.countTableName, "" );
 	clp.RegisterStringOption("regionTable", &params.regionTableFileName, "");
 	clp.RegisterIntOption("bestn", (int*) &params.nBest, "", CommandLineParser::PositiveInteger);
+  clp.RegisterFlagOption("pruneByScoreEstimate", &params.pruneByScoreEstimate, "");
+  clp.RegisterIntOption("scoreEstimateSlack", &params.scoreEstimateSlack, "", CommandLineParser::NonNegativeInteger);
   clp.RegisterIntOption("limsAlign", &params.limsAlign, "", CommandLineParser::PositiveInteger);
   clp.RegisterFlagOption("printOnlyBest", &params.printOnlyBest, "");
 	clp.RegisterFlagOption("outputByThread", &params.outputByThread, "");
@@ -3802,6 +4629,7 @@ int main(int argc, char* argv[]) {
   clp.RegisterFlagOption("useGuidedAlign", (bool*)&trashbinBool, "");
   clp.RegisterFlagOption("noUseGuidedAlign", (bool*)&params.useGuidedAlign, "");
   clp.RegisterFlagOption("header", (bool*)&params.printHeader, "");
+  clp.RegisterFlagOption("binaryQV", &params.printBinaryQV, "");
   clp.RegisterIntOption("subreadImplType", &params.subreadMapType, "", CommandLineParser::PositiveInteger);
 	clp.RegisterIntOption("bandSize", &params.bandSize, "", CommandLineParser::PositiveInteger);	
 	clp.RegisterIntOption("extendBandSize", &params.extendBandSize, "", CommandLineParser::PositiveInteger);	
@@ -3827,6 +4655,17 @@ int main(int argc, char* argv[]) {
 	clp.RegisterFloatOption("minFrac", &trashbinFloat, "", CommandLineParser::NonNegativeFloat);
 	clp.RegisterIntOption("maxScore", &params.maxScore, "", CommandLineParser::Integer);
 	clp.RegisterStringOption("bwt", &params.bwtFileName, "");
+  clp.RegisterStringOption("mapability", &params.mapabilityFileName, "");
+  clp.RegisterStringOption("repeatMask", &params.repeatMaskFileName, "");
+  clp.RegisterIntOption("mapabilityMaxLength", &params.mapabilityMaxLength, "", CommandLineParser::NonNegativeInteger);
+  clp.RegisterFlagOption("hpc", &params.hpcSeeding, "");
+  clp.RegisterIntOption("hpcIndexBinSize", &params.hpcIndexBinSize, "", CommandLineParser::PositiveInteger);
+  clp.RegisterFlagOption("adaptiveSeeding", &params.adaptiveSeeding, "");
+  clp.RegisterFlagOption("sketchPrefilter", &params.sketchPrefilter, "");
+  clp.RegisterIntOption("sketchK", &params.sketchK, "", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("sketchWindow", &params.sketchWindow, "", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("sketchMinHits", &params.sketchMinHits, "", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("sketchMaxOccurrences", &params.sketchMaxOccurrences, "", CommandLineParser::PositiveInteger);
 	clp.RegisterIntOption("m", &params.printFormat, "", CommandLineParser::NonNegativeInteger);
   clp.RegisterFlagOption("sam", &params.printSAM, "");
   clp.RegisterStringOption("clipping", &params.clippingString, "");
@@ -3836,6 +4675,8 @@ int main(int argc, char* argv[]) {
 	clp.RegisterIntOption("stride", &params.stride, "", CommandLineParser::NonNegativeInteger);
 	clp.RegisterFloatOption("subsample", &params.subsample, "", CommandLineParser::PositiveFloat);
 	clp.RegisterIntOption("nproc", &params.nProc, "", CommandLineParser::PositiveInteger);
+  clp.RegisterFlagOption("intraReadTasks", &params.intraReadTasks, "");
+  clp.RegisterIntOption("minTaskReadLength", &params.minTaskReadLength, "", CommandLineParser::PositiveInteger);
 	clp.RegisterFlagOption("sortRefinedAlignments",(bool*) &params.sortRefinedAlignments, "");
 	clp.RegisterIntOption("quallc", &params.qualityLowerCaseThreshold, "", CommandLineParser::Integer);
 	clp.RegisterFlagOption("v", (bool*) &params.verbosity, "");
@@ -3845,6 +4686,11 @@ int main(int argc, char* argv[]) {
 	clp.RegisterStringOption("metrics", &params.metricsFileName, "");
 	clp.RegisterStringOption("lcpBounds", &params.lcpBoundsFileName, "");
   clp.RegisterStringOption("fullMetrics", &params.fullMetricsFileName, "");
+  clp.RegisterStringOption("metricsJson", &params.metricsJsonFileName, "");
+  clp.RegisterIntOption("metricsInterval", &params.metricsInterval, "", CommandLineParser::NonNegativeInteger);
+  clp.RegisterStringOption("traceFile", &params.traceFileName, "");
+  clp.RegisterIntOption("traceSample", &params.traceSampleEvery, "", CommandLineParser::NonNegativeInteger);
+  clp.RegisterIntOption("traceMinMsec", &params.traceMinMsec, "", CommandLineParser::NonNegativeInteger);
 	clp.RegisterIntOption("nbranch", &params.anchorParameters.numBranches, "", CommandLineParser::NonNegativeInteger);
 	clp.RegisterFlagOption("divideByAdapter", &params.byAdapter, "");
 	clp.RegisterFlagOption("useQuality", &params.ignoreQualities, "");
@@ -3874,6 +4720,9 @@ int main(int argc, char* argv[]) {
 	clp.RegisterFlagOption("ignoreHQRegions", &params.useHQRegionTable, "");
   clp.RegisterFlagOption("computeAlignProbability", &params.computeAlignProbability, "");
 	clp.RegisterStringOption("unaligned", &params.unalignedFileName, "");
+  clp.RegisterIntOption("checkpoint", &params.checkpointInterval, "", CommandLineParser::NonNegativeInteger);
+  clp.RegisterStringOption("checkpointFile", &params.checkpointFileName, "");
+  clp.RegisterFlagOption("resume", &params.resume, "");
   clp.RegisterFlagOption("global", &params.doGlobalAlignment, "");
 	clp.RegisterIntOption("globalChainType", &params.globalChainType, "", CommandLineParser::NonNegativeInteger);
 	clp.RegisterFlagOption("noPrintSubreadTitle", (bool*) &params.printSubreadTitle, "");
@@ -3891,6 +4740,7 @@ int main(int argc, char* argv[]) {
   clp.RegisterIntOption("substitutionPrior",  &params.substitutionPrior, "", CommandLineParser::NonNegativeInteger);
   clp.RegisterIntOption("deletionPrior",  &params.globalDeletionPrior, "", CommandLineParser::NonNegativeInteger);
   clp.RegisterIntOption("recurseOver", &params.recurseOver, "", CommandLineParser::NonNegativeInteger);
+  clp.RegisterIntOption("sdpBand", &params.sdpBand, "", CommandLineParser::NonNegativeInteger);
   clp.RegisterStringOption("scoreMatrix", &params.scoreMatrixString, "");
   clp.RegisterFlagOption("printDotPlots", &params.printDotPlots, "");
   clp.RegisterFlagOption("preserveReadTitle", &params.preserveReadTitle,"");
@@ -3988,6 +4838,13 @@ int main(int argc, char* argv[]) {
     CrucialOpen(params.fullMetricsFileName, fullMetricsFile, std::ios::out);
     metrics.SetStoreList();
   }
+  ofstream metricsJsonFile, traceFile;
+  if (params.metricsJsonFileName != "") {
+    CrucialOpen(params.metricsJsonFileName, metricsJsonFile, std::ios::out);
+  }
+  if (params.traceFileName != "") {
+    CrucialOpen(params.traceFileName, traceFile, std::ios::out);
+  }
 
 	/*
 	 * If reading a separate region table, there is a 1-1 correspondence
@@ -4014,10 +4871,11 @@ int main(int argc, char* argv[]) {
 		exit(1);
 	}
 
-	//  The input reads files must have file extensions.
+	//  The input reads files must have file extensions, other than
+	//  reads from standard input ("-").
 	for (int i = 0; i < params.readsFileNames.size()-1; i++) {
 		size_t dotPos = params.readsFileNames[i].find_last_of('.');
-		if (dotPos == string::npos) {
+		if (dotPos == string::npos and params.readsFileNames[i] != "-") {
 			cout<<"ERROR, the input reads files must include file extensions."<<endl;
 			exit(1);
 		}
@@ -4027,8 +4885,17 @@ int main(int argc, char* argv[]) {
 	if (!params.ignoreQualities) {
 		for (int i = 0; i < params.readsFileNames.size()-1; i++) {
 			size_t dotPos = params.readsFileNames[i].find_last_of('.');
-			assert (dotPos != string::npos); //dotPos should have been checked above
+			if (dotPos == string::npos) {
+				// Standard input, the format is not known until it is read.
+				continue;
+			}
 			string suffix = params.readsFileNames[i].substr(dotPos+1);
+			if (suffix == "gz" and dotPos > 0) {
+				size_t gzDotPos = params.readsFileNames[i].find_last_of('.', dotPos-1);
+				if (gzDotPos != string::npos) {
+					suffix = params.readsFileNames[i].substr(gzDotPos+1, dotPos - (gzDotPos+1));
+				}
+			}
 			if (suffix == "fasta") {
 				cout<<"ERROR, you can not use -useQuality option when any of the input reads files are in multi-fasta format."<<endl; 
 				exit(1);
@@ -4120,7 +4987,42 @@ int main(int argc, char* argv[]) {
   outFile.exceptions(ostream::failbit);
 	ofstream unalignedOutFile;
 	BWT bwt;
+	MapabilityTrack mapability;
+	if (params.mapabilityFileName != "") {
+		if (mapability.Read(params.mapabilityFileName) == false) {
+			cout << "ERROR! Could not read the mapability file " << params.mapabilityFileName << endl;
+			exit(1);
+		}
+		if (mapability.size() != genome.length) {
+			cout << "ERROR! The mapability file " << params.mapabilityFileName << " is not of the reference." << endl;
+			exit(1);
+		}
+	}
+	TupleRepeatMask repeatMask;
+	if (params.repeatMaskFileName != "") {
+		if (repeatMask.Read(params.repeatMaskFileName) == false) {
+			cout << "ERROR! Could not read the repeat mask " << params.repeatMaskFileName << endl;
+			exit(1);
+		}
+		params.anchorParameters.repeatMaskPtr = &repeatMask;
+	}
 	
+	//
+	// When seeding in homopolymer compressed space, the index is of
+	// the reference with every homopolymer condensed to one base
+	// (e.g. written by compressseq), and the reverse compress index
+	// maps positions in it back to the reference.
+	//
+	FASTASequence hpcGenome;
+	FASTASequence *seedGenome = &genome;
+	if (params.hpcSeeding) {
+		hpcGenome.seq    = new Nucleotide[genome.length + 1];
+		hpcGenome.deleteOnExit = true;
+		hpcGenome.length = CondenseHomopolymers(genome.seq, genome.length, hpcGenome.seq);
+		index.Build(genome.seq, genome.length, params.hpcIndexBinSize);
+		seedGenome = &hpcGenome;
+	}
+
 	if (params.useBwt) {
 		if (bwt.Read(params.bwtFileName) == 0) {
 			cout << "ERROR! Could not read the BWT file. " << params.bwtFileName << endl;
@@ -4133,23 +5035,29 @@ int main(int argc, char* argv[]) {
 			// There was no explicit specification of a suffix
 			// array on the command line, so build it on the fly here.
 			//
-			genome.ToThreeBit();		
+			seedGenome->ToThreeBit();		
 			vector<int> alphabet;
 			sarray.InitThreeBitDNAAlphabet(alphabet);
-			sarray.LarssonBuildSuffixArray(genome.seq, genome.length, alphabet);
+			sarray.LarssonBuildSuffixArray(seedGenome->seq, seedGenome->length, alphabet);
 			if (params.minMatchLength > 0) {
 				if (params.anchorParameters.useLookupTable == true) {
           if (params.lookupTableLength > params.minMatchLength) {
             params.lookupTableLength = params.minMatchLength;
           }
-					sarray.BuildLookupTable(genome.seq, genome.length, params.lookupTableLength);
+					sarray.BuildLookupTable(seedGenome->seq, seedGenome->length, params.lookupTableLength);
 				}
 			}
-			genome.ConvertThreeBitToAscii();
+			seedGenome->ConvertThreeBitToAscii();
 			params.useSuffixArray = 1;
     }
 		else if (params.useSuffixArray) {
 			if (sarray.Read(params.suffixArrayFileName)) {
+        if (params.hpcSeeding and sarray.length != hpcGenome.length) {
+          cout << "ERROR. With -hpc the suffix array must be built over the homopolymer " << endl
+               << "compressed reference, e.g. compressseq genome.fasta genome.hpc.fasta; " << endl
+               << "sawriter genome.hpc.fasta.sa genome.hpc.fasta" << endl;
+          exit(1);
+        }
         if (params.minMatchLength != 0) {
           params.listTupleSize = min(8, params.minMatchLength);
         }
@@ -4174,6 +5082,17 @@ int main(int argc, char* argv[]) {
     params.minMatchLength = sarray.lookupPrefixLength;
   }
 
+  //
+  // A masked k-mer only says the anchors from its position are high
+  // copy when the shortest anchors are no longer than the k-mer.
+  //
+  if (params.repeatMaskFileName != "" and repeatMask.tupleSize < params.minMatchLength) {
+    cout << "ERROR! The repeat mask " << params.repeatMaskFileName << " is of " << repeatMask.tupleSize 
+         << "-mers, shorter than -minMatch " << params.minMatchLength << "." << endl
+         << "Build the mask with sawriter -maskRepeats k n for k at least -minMatch." << endl;
+    exit(1);
+  }
+
 	//
 	// It is required to have a tuple count table
 	// for estimating the background frequencies
@@ -4193,7 +5112,7 @@ int main(int argc, char* argv[]) {
 	} else {
 		saLookupTupleMetrics.Initialize(params.lookupTableLength);
 		ct.InitCountTable(saLookupTupleMetrics);
-		ct.AddSequenceTupleCountsLR(genome);
+		ct.AddSequenceTupleCountsLR(genome, params.nProc);
 	}
 	TitleTable titleTable;
 
@@ -4244,21 +5163,41 @@ int main(int argc, char* argv[]) {
     CrucialOpen(params.anchorFileName, anchorFileStrm, std::ios::out);
   }
 
-  if (params.clusterFileName != "") {
-    CrucialOpen(params.clusterFileName, clusterOut, std::ios::out);
-    clusterOutPtr = &clusterOut;
-    clusterOut << "total_size p_value n_anchors read_length align_score read_accuracy anchor_probability min_exp_anchors seq_length" << endl;
+  //
+  // A resumed run drops any output written after the last checkpoint
+  // and appends to the rest.  The summaries of the run (-metrics,
+  // -fullMetrics, -metricsJson, -trace) are rewritten, and describe
+  // only the reads mapped after the resume.
+  //
+  CheckpointJournal checkpoint;
+  std::ios::openmode outFileMode = std::ios::out;
+  if (params.checkpointInterval > 0) {
+    checkpoint.Initialize(params.checkpointFileName, params.checkpointInterval,
+                          params.readsFileNames, params.readsFileNames.size() - 1);
   }
-  else {
-    clusterOutPtr = NULL;
+  if (params.resume) {
+    if (checkpoint.Read() == false) {
+      cout << "ERROR, could not read the checkpoint " << params.checkpointFileName 
+           << " of a run on the same reads files." << endl;
+      exit(1);
+    }
+    if (checkpoint.TruncateOutput(params.outFileName, checkpoint.outFileSize) == false or
+        (params.printUnaligned and 
+         checkpoint.TruncateOutput(params.unalignedFileName, checkpoint.unalignedFileSize) == false) or
+        (params.clusterFileName != "" and
+         checkpoint.TruncateOutput(params.clusterFileName, checkpoint.clusterFileSize) == false)) {
+      cout << "ERROR, could not truncate the output to the last checkpoint." << endl;
+      exit(1);
+    }
+    outFileMode = std::ios::out | std::ios::app;
   }
 
 	if (params.outFileName != "") {
-		CrucialOpen(params.outFileName, outFileStrm, std::ios::out);
+		CrucialOpen(params.outFileName, outFileStrm, outFileMode);
 		outFilePtr = &outFileStrm;
 	}
 
-  if (params.printHeader) {
+  if (params.printHeader and params.resume == false) {
     switch(params.printFormat) {
     case(SummaryPrint):
       SummaryAlignmentPrinter::PrintHeader(*outFilePtr);
@@ -4269,10 +5208,34 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  //
+  // The binary format always starts with its header, so that readers
+  // can check the file.
+  //
+  if (params.printFormat == CompactBinary and params.resume == false) {
+    BinaryAlignmentPrinter::PrintHeader(*outFilePtr);
+  }
+
 	if (params.printUnaligned == true) {
-		CrucialOpen(params.unalignedFileName, unalignedFile, std::ios::out);
+		CrucialOpen(params.unalignedFileName, unalignedFile, outFileMode);
 		unalignedFilePtr = &unalignedFile;
 	}
+
+  if (params.clusterFileName != "") {
+    CrucialOpen(params.clusterFileName, clusterOut, outFileMode);
+    clusterOutPtr = &clusterOut;
+    if (params.resume == false) {
+      clusterOut << "total_size p_value n_anchors read_length align_score read_accuracy anchor_probability min_exp_anchors seq_length" << endl;
+    }
+  }
+  else {
+    clusterOutPtr = NULL;
+  }
+
+  if (params.checkpointInterval > 0) {
+    checkpoint.SetOutput(params.outFileName, outFilePtr, params.unalignedFileName, unalignedFilePtr,
+                         params.clusterFileName, clusterOutPtr);
+  }
 	
 	if (params.metricsFileName != "") {
 		CrucialOpen(params.metricsFileName, metricsOut);
@@ -4283,11 +5246,40 @@ int main(int argc, char* argv[]) {
     //    lcpBoundsOut << "pos depth width lnwidth" << endl;
   }
 	
+	//
+	// The minimizers of the reference for the sketch prefilter.
+	//
+	MinimizerIndex sketchIndex;
+	if (params.sketchPrefilter) {
+		sketchIndex.Build(genome, params.sketchK, params.sketchWindow);
+	}
+
+	//
+	// The reference is indexed, so when mapping to a packed reference
+	// it is packed here and the byte per base copy is freed.  The
+	// title is referenced from fastaGenome, which keeps it.
+	//
+#ifdef USE_PACKED_REFERENCE
+	T_GenomeSequence mappedGenome, mappedHPCGenome;
+	mappedGenome.Create(genome);
+	if (params.hpcSeeding) {
+		mappedHPCGenome.Create(hpcGenome);
+		delete[] hpcGenome.seq;
+		hpcGenome.seq = NULL;
+	}
+	fastaGenome.DNASequence::Free();
+	genome.seq = NULL;
+#else
+	T_GenomeSequence &mappedGenome    = genome;
+	T_GenomeSequence &mappedHPCGenome = hpcGenome;
+#endif
+
 	//
 	// Configure the mapping database.
 	//
 
 	MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple> *mapdb = new MappingData<T_SuffixArray, T_GenomeSequence, T_Tuple>[params.nProc];
+  WorkStealingScheduler scheduler;
 
 	int procIndex;
 	pthread_attr_t *threadAttr = new pthread_attr_t[params.nProc];
@@ -4302,8 +5294,22 @@ int main(int argc, char* argv[]) {
 	}
 	for (procIndex = 0; procIndex < params.nProc; procIndex++ ){
 		pthread_attr_init(&threadAttr[procIndex]);
+    mapdb[procIndex].metrics.trace.enabled     = (params.traceFileName != "");
+    mapdb[procIndex].metrics.trace.threadIndex = procIndex;
+    mapdb[procIndex].metrics.trace.sampleEvery = params.traceSampleEvery;
+    mapdb[procIndex].metrics.trace.minReadUsec = ((long long) params.traceMinMsec) * 1000;
 	}
 
+  MetricsReporter metricsReporter;
+  pthread_t metricsReporterThread;
+  metricsReporter.mapdb    = mapdb;
+  metricsReporter.nProc    = params.nProc;
+  metricsReporter.interval = params.metricsInterval;
+  metricsReporter.out      = &metricsJsonFile;
+  if (params.metricsJsonFileName != "" and params.metricsInterval > 0) {
+    pthread_create(&metricsReporterThread, NULL, ReportMetricsPeriodically, &metricsReporter);
+  }
+
 	//
 	// Start the mapping jobs.
 	//
@@ -4330,7 +5336,7 @@ int main(int argc, char* argv[]) {
 	}
 
   
-  if (params.printSAM) {
+  if (params.printSAM and params.resume == false) {
     string hdString, sqString, rgString, pgString;
     MakeSAMHDString(hdString);
     *outFilePtr << hdString << endl;
@@ -4357,6 +5363,10 @@ int main(int argc, char* argv[]) {
 	for (readsFileIndex = 0; readsFileIndex < params.readsFileNames.size()-1; readsFileIndex++ ){ 
 		params.readsFileIndex = readsFileIndex;
 
+		if (params.checkpointInterval > 0 and checkpoint.files[readsFileIndex].done) {
+			continue;
+		}
+
 		//
 		// Configure the reader to use the correct read and region
 		// file names.
@@ -4409,6 +5419,21 @@ int main(int argc, char* argv[]) {
 			regionTable.SortTableByHoleNumber();
 		}
 
+		//
+		// Bases outside the HQ region are masked after they are read,
+		// so let the reader load only the HQ bases.  Quality values are
+		// still read in full, since -minAvgQual and the QV output use
+		// the whole read.  The table is set for every file, so that a
+		// file without a region table does not use the one of a
+		// previous file.
+		//
+		if (params.useRegionTable and params.useHQRegionTable) {
+			reader->UseHQRegionTable(&regionTable);
+		}
+		else {
+			reader->UseHQRegionTable(NULL);
+		}
+
 #ifdef USE_GOOGLE_PROFILER
     char *profileFileName = getenv("CPUPROFILE");
     if (profileFileName != NULL) {
@@ -4419,11 +5444,34 @@ int main(int argc, char* argv[]) {
     }
 #endif
 
+		//
+		// Move past the reads that were done before the checkpoint.
+		//
+		if (initReturnValue > 0 and params.checkpointInterval > 0) {
+			if (reader->HasReadPosition() == false) {
+				cout << "ERROR, cannot checkpoint " << params.readsFileNames[readsFileIndex] << ". A resumed run must move" << endl
+						 << "to a read without reading the ones before it, which only the bas.h5 and pls.h5 base call" << endl
+						 << "reader can do; the ccs.h5 reader cannot skip reads, and fasta/fastq files are read in order." << endl;
+				exit(1);
+			}
+			if (params.resume and checkpoint.files[readsFileIndex].position > reader->GetReadPosition() and
+					reader->SkipToReadPosition(checkpoint.files[readsFileIndex].position) == 0) {
+				cout << "ERROR, could not resume " << params.readsFileNames[readsFileIndex] << " at read " 
+						 << checkpoint.files[readsFileIndex].position << endl;
+				exit(1);
+			}
+			checkpoint.StartFile(readsFileIndex, reader->GetReadPosition());
+		}
+
 		if (initReturnValue > 0) {
 			if (params.nProc == 1) {
-				mapdb[0].Initialize(&sarray, &genome, &seqdb, &ct, &index, params, reader, &regionTable, 
+				mapdb[0].Initialize(&sarray, &mappedGenome, &seqdb, &ct, &index, params, reader, &regionTable, 
                             outFilePtr, unalignedFilePtr, &anchorFileStrm, clusterOutPtr);
 				mapdb[0].bwtPtr = &bwt;
+        mapdb[0].mapabilityPtr = (params.mapabilityFileName != "" ? &mapability : NULL);
+        mapdb[0].hpcReferenceSeqPtr = &mappedHPCGenome;
+        mapdb[0].sketchIndexPtr = (params.sketchPrefilter ? &sketchIndex : NULL);
+        mapdb[0].checkpointPtr = (params.checkpointInterval > 0 ? &checkpoint : NULL);
         if (params.fullMetricsFileName != "") {
           mapdb[0].metrics.SetStoreList(true);
         }
@@ -4439,14 +5487,23 @@ int main(int argc, char* argv[]) {
 			}
 			else {
 				pthread_t *threads = new pthread_t[params.nProc];
+        if (params.intraReadTasks) {
+          scheduler.Initialize(params.nProc);
+        }
 				for (procIndex = 0; procIndex < params.nProc; procIndex++ ){ 
 					//
 					// Initialize thread-specific parameters.
 					//
             
-					mapdb[procIndex].Initialize(&sarray, &genome, &seqdb, &ct, &index, params, reader, &regionTable, 
+					mapdb[procIndex].Initialize(&sarray, &mappedGenome, &seqdb, &ct, &index, params, reader, &regionTable, 
                                       outFilePtr, unalignedFilePtr, &anchorFileStrm, clusterOutPtr);
 					mapdb[procIndex].bwtPtr      = &bwt;
+          mapdb[procIndex].mapabilityPtr = (params.mapabilityFileName != "" ? &mapability : NULL);
+          mapdb[procIndex].hpcReferenceSeqPtr = &mappedHPCGenome;
+          mapdb[procIndex].sketchIndexPtr = (params.sketchPrefilter ? &sketchIndex : NULL);
+          mapdb[procIndex].schedulerPtr = (params.intraReadTasks ? &scheduler : NULL);
+          mapdb[procIndex].threadIndex  = procIndex;
+          mapdb[procIndex].checkpointPtr = (params.checkpointInterval > 0 ? &checkpoint : NULL);
           if (params.fullMetricsFileName != "") {
             mapdb[procIndex].metrics.SetStoreList(true);
           }
@@ -4464,6 +5521,9 @@ int main(int argc, char* argv[]) {
             outNameStream << params.outFileName << "." << procIndex;
             mapdb[procIndex].params.outFileName = outNameStream.str();
             CrucialOpen(mapdb[procIndex].params.outFileName, *outPtr, std::ios::out);
+            if (params.printFormat == CompactBinary) {
+              BinaryAlignmentPrinter::PrintHeader(*outPtr);
+            }
           }
 					pthread_create(&threads[procIndex], &threadAttr[procIndex], (void* (*)(void*))MapReads, &mapdb[procIndex]);
 				}
@@ -4477,13 +5537,33 @@ int main(int argc, char* argv[]) {
           }
 				}
 			}
+			if (params.checkpointInterval > 0) {
+				checkpoint.FinishFile();
+			}
 		}
 		reader->Close();
 	}
   
+  if (params.metricsJsonFileName != "") {
+    if (params.metricsInterval > 0) {
+      metricsReporter.Stop();
+      pthread_join(metricsReporterThread, NULL);
+    }
+    metricsReporter.WriteSnapshot(true);
+    metricsJsonFile.close();
+  }
+  if (params.traceFileName != "") {
+    PrintChromeTrace(mapdb, params.nProc, traceFile);
+    traceFile.close();
+  }
+  if (params.intraReadTasks and params.verbosity > 0) {
+    scheduler.PrintStats(cerr);
+  }
+
   delete reader;
 
 	fastaGenome.Free();
+	hpcGenome.Free();
 #ifdef USE_GOOGLE_PROFILER
   ProfilerStop();
 #endif
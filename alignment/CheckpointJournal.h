@@ -0,0 +1,277 @@
+#ifndef ALIGNMENT_CHECKPOINT_JOURNAL_H_
+#define ALIGNMENT_CHECKPOINT_JOURNAL_H_
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+using namespace std;
+
+//
+// The record of how far a run of blasr got, so that a run that was
+// killed may be restarted with -resume and pick up where it left off.
+//
+// Reads of a bas/pls file are handed to the mapping threads in order,
+// and each read is given a ticket as it is taken from the reader,
+// along with the position of the next read of this run (the read
+// after it, or -stride reads after it).  The position is that of the
+// read that was taken, not of the reader after the read, since the
+// reader may not move past the last reads of a file when it strides.
+// The alignments and cluster lines of a read are buffered until it is
+// done, and then written out in ticket order, so the output files
+// always hold the output of every read up to some position in the
+// reads file and nothing else.  Every 'interval' reads the output is
+// flushed and synced to disk, and the position, along with the size
+// of the output files, is written to the journal.  The journal is written to a
+// temporary file that is renamed over the last one, so a crash leaves
+// either the old or the new checkpoint, never a partial one.
+//
+// A run is resumed by truncating the output files to the sizes in the
+// journal, and moving each reads file to its checkpointed position
+// without reading the reads (ZMWs) before it.  Summaries of a run
+// (-metrics, -fullMetrics, -metricsJson, -trace) and debugging output
+// (-anchors, -lcpBounds) are not journaled; a resumed run rewrites
+// them with the reads it maps itself.
+//
+
+class CheckpointFileState {
+ public:
+  string readsFileName;
+  int    position;
+  bool   done;
+  CheckpointFileState() {
+    position = 0;
+    done     = false;
+  }
+};
+
+class CheckpointJournal {
+ public:
+  string fileName;
+  int    interval;
+  string outFileName, unalignedFileName, clusterFileName;
+  ostream *outFilePtr, *unalignedFilePtr, *clusterFilePtr;
+  long   outFileSize, unalignedFileSize, clusterFileSize;
+  vector<CheckpointFileState> files;
+  int    curFile;
+  //
+  // Reads that have been taken from the reader but not yet written,
+  // oldest first.  The front has ticket 'firstTicket'.
+  //
+  long          firstTicket;
+  deque<int>    positions;
+  deque<bool>   done;
+  deque<string> output, unalignedOutput, clusterOutput;
+  int           nSinceCheckpoint;
+  pthread_mutex_t lock;
+
+  CheckpointJournal() {
+    interval          = 0;
+    outFilePtr        = unalignedFilePtr = clusterFilePtr = NULL;
+    outFileSize       = unalignedFileSize = clusterFileSize = 0;
+    curFile           = -1;
+    firstTicket       = 0;
+    nSinceCheckpoint  = 0;
+    pthread_mutex_init(&lock, NULL);
+  }
+
+  ~CheckpointJournal() {
+    pthread_mutex_destroy(&lock);
+  }
+
+  void Initialize(string &fileNameP, int intervalP, vector<string> &readsFileNames, int nReadsFiles) {
+    fileName = fileNameP;
+    interval = intervalP;
+    files.resize(nReadsFiles);
+    int i;
+    for (i = 0; i < nReadsFiles; i++) {
+      files[i].readsFileName = readsFileNames[i];
+    }
+  }
+
+  void SetOutput(string &outFileNameP, ostream *outFilePtrP,
+                 string &unalignedFileNameP, ostream *unalignedFilePtrP,
+                 string &clusterFileNameP, ostream *clusterFilePtrP) {
+    outFileName       = outFileNameP;
+    outFilePtr        = outFilePtrP;
+    unalignedFileName = unalignedFileNameP;
+    unalignedFilePtr  = unalignedFilePtrP;
+    clusterFileName   = clusterFileNameP;
+    clusterFilePtr    = clusterFilePtrP;
+  }
+
+  //
+  // Read the journal of a previous run of the same reads files.
+  //
+  bool Read() {
+    ifstream in(fileName.c_str());
+    if (in.good() == false) {
+      return false;
+    }
+    string tag;
+    int version, nFiles;
+    if (!(in >> tag >> version) or tag != "blasr_checkpoint" or version != 1) {
+      return false;
+    }
+    if (!(in >> tag >> outFileSize) or tag != "out") {
+      return false;
+    }
+    if (!(in >> tag >> unalignedFileSize) or tag != "unaligned") {
+      return false;
+    }
+    if (!(in >> tag >> clusterFileSize) or tag != "clusters") {
+      return false;
+    }
+    if (!(in >> tag >> nFiles) or tag != "files" or nFiles != files.size()) {
+      return false;
+    }
+    int i;
+    for (i = 0; i < nFiles; i++) {
+      int index, isDone;
+      string readsFileName;
+      if (!(in >> index >> files[i].position >> isDone >> readsFileName) or
+          index != i or readsFileName != files[i].readsFileName) {
+        return false;
+      }
+      files[i].done = isDone;
+    }
+    return true;
+  }
+
+  void StartFile(int fileIndex, int position) {
+    curFile = fileIndex;
+    files[curFile].position = position;
+    files[curFile].done     = false;
+    firstTicket = 0;
+    positions.clear();
+    done.clear();
+    output.clear();
+    unalignedOutput.clear();
+    clusterOutput.clear();
+  }
+
+  //
+  // Called in the order reads are taken from the reader, with the
+  // position the run continues from once the read is done.
+  //
+  long Issue(int position) {
+    pthread_mutex_lock(&lock);
+    long ticket = firstTicket + positions.size();
+    positions.push_back(position);
+    done.push_back(false);
+    output.push_back("");
+    unalignedOutput.push_back("");
+    clusterOutput.push_back("");
+    pthread_mutex_unlock(&lock);
+    return ticket;
+  }
+
+  //
+  // Hand over the output of a read that is done, and write out every
+  // read that is done up to the oldest one that is not.
+  //
+  void Complete(long ticket, const string &readOutput, const string &readUnalignedOutput,
+                const string &readClusterOutput) {
+    pthread_mutex_lock(&lock);
+    long slot = ticket - firstTicket;
+    done[slot]            = true;
+    output[slot]          = readOutput;
+    unalignedOutput[slot] = readUnalignedOutput;
+    clusterOutput[slot]   = readClusterOutput;
+    while (done.size() > 0 and done.front()) {
+      *outFilePtr << output.front();
+      if (unalignedFilePtr != NULL) {
+        *unalignedFilePtr << unalignedOutput.front();
+      }
+      if (clusterFilePtr != NULL) {
+        *clusterFilePtr << clusterOutput.front();
+      }
+      files[curFile].position = positions.front();
+      positions.pop_front();
+      done.pop_front();
+      output.pop_front();
+      unalignedOutput.pop_front();
+      clusterOutput.pop_front();
+      ++firstTicket;
+      ++nSinceCheckpoint;
+    }
+    if (nSinceCheckpoint >= interval) {
+      Checkpoint();
+    }
+    pthread_mutex_unlock(&lock);
+  }
+
+  void FinishFile() {
+    pthread_mutex_lock(&lock);
+    files[curFile].done = true;
+    Checkpoint();
+    pthread_mutex_unlock(&lock);
+  }
+
+  //
+  // Truncate output files that were written past the last checkpoint.
+  //
+  bool TruncateOutput(string &outputFileName, long size) {
+    return (truncate(outputFileName.c_str(), size) == 0);
+  }
+
+ private:
+  static long SyncFile(string &syncFileName) {
+    int fd = open(syncFileName.c_str(), O_WRONLY);
+    if (fd < 0) {
+      cout << "ERROR, could not open " << syncFileName << " to checkpoint it." << endl;
+      exit(1);
+    }
+    fsync(fd);
+    struct stat fileStat;
+    fstat(fd, &fileStat);
+    close(fd);
+    return fileStat.st_size;
+  }
+
+  void Checkpoint() {
+    outFilePtr->flush();
+    outFileSize = SyncFile(outFileName);
+    if (unalignedFilePtr != NULL) {
+      unalignedFilePtr->flush();
+      unalignedFileSize = SyncFile(unalignedFileName);
+    }
+    if (clusterFilePtr != NULL) {
+      clusterFilePtr->flush();
+      clusterFileSize = SyncFile(clusterFileName);
+    }
+    string tmpFileName = fileName + ".tmp";
+    ofstream out(tmpFileName.c_str());
+    out << "blasr_checkpoint 1" << endl
+        << "out " << outFileSize << endl
+        << "unaligned " << unalignedFileSize << endl
+        << "clusters " << clusterFileSize << endl
+        << "files " << files.size() << endl;
+    int i;
+    for (i = 0; i < files.size(); i++) {
+      out << i << " " << files[i].position << " " << files[i].done << " " << files[i].readsFileName << endl;
+    }
+    out.close();
+    if (out.fail()) {
+      cout << "ERROR, could not write the checkpoint " << tmpFileName << endl;
+      exit(1);
+    }
+    SyncFile(tmpFileName);
+    if (rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+      cout << "ERROR, could not rename " << tmpFileName << " to " << fileName << endl;
+      exit(1);
+    }
+    nSinceCheckpoint = 0;
+  }
+};
+
+#endif
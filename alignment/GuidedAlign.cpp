@@ -58,7 +58,7 @@ int main(int argc, char* argv[]) {
 
 	vector<int> scoreMat;
 	vector<Arrow> pathMat;
-	vector<double> probMat, optPathProbMat;
+	vector<float> probMat, optPathProbMat;
   vector<float> lnSubVect, lnInsVect, lnDelVect, lnMatchVect;
   //	AlignmentCandidate<FASTASequence, FASTASequence> alignment;
   Alignment alignment;
@@ -0,0 +1,98 @@
+#include "../common/datastructures/suffixarray/SuffixArray.h"
+#include "../common/datastructures/suffixarray/SuffixArrayTypes.h"
+#include "../common/datastructures/suffixarray/MapabilityTrack.h"
+#include "../common/datastructures/metagenome/SequenceIndexDatabase.h"
+#include "../common/FASTASequence.h"
+#include "../common/FASTAReader.h"
+#include "../common/CommandLineParser.h"
+#include "../common/utils.h"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+
+using namespace std;
+
+//
+// Compute the mapability track of a genome: for every position, the
+// length of the shortest substring starting there that is unique in
+// the genome.  The binary track may be given to blasr with
+// -mapability to ignore anchors in regions that are not unique at the
+// length of a read.
+//
+int main(int argc, char* argv[]) {
+	string genomeFileName;
+	string suffixArrayFileName = "";
+	string trackFileName       = "";
+	string bedGraphFileName    = "";
+	int nProc = 1;
+	vector<int> kmerLengths;
+
+	CommandLineParser clp;
+	clp.SetProgramName("mapability");
+	clp.SetProgramSummary("Compute the length of the shortest unique substring starting at every position of a genome.");
+	clp.RegisterStringOption("genome", &genomeFileName, "FASTA file of the genome, read in the same way as blasr reads it.", true);
+	clp.RegisterPreviousFlagsAsHidden();
+	clp.RegisterStringOption("sa", &suffixArrayFileName, "Suffix array of the genome written by sawriter.  If not given, one is built.");
+	clp.RegisterStringOption("out", &trackFileName, "Write the binary track that blasr reads with -mapability.");
+	clp.RegisterStringOption("bedGraph", &bedGraphFileName, "Write runs of equal shortest unique length as a bedGraph (0 = not unique).");
+	clp.RegisterIntOption("nproc", &nProc, "Number of threads to use.", CommandLineParser::PositiveInteger);
+	clp.RegisterIntListOption("k", &kmerLengths, "Print the fraction of k-mers that are unique for each length given.");
+	vector<string> opts;
+	clp.ParseCommandLine(argc, argv, opts);
+
+	if (trackFileName == "" and bedGraphFileName == "" and kmerLengths.size() == 0) {
+		cout << "ERROR, specify at least one of -out, -bedGraph, or -k." << endl;
+		exit(1);
+	}
+
+	FASTAReader reader;
+	reader.Initialize(genomeFileName);
+	FASTASequence genome;
+	SequenceIndexDatabase<FASTASequence> seqdb;
+	reader.ReadAllSequencesIntoOne(genome, &seqdb);
+	reader.Close();
+	genome.ToUpper();
+
+	DNASuffixArray sarray;
+	if (suffixArrayFileName != "") {
+		if (sarray.Read(suffixArrayFileName) == false) {
+			cout << "ERROR, " << suffixArrayFileName << " is not a suffix array." << endl;
+			exit(1);
+		}
+		if (sarray.length != genome.length) {
+			cout << "ERROR, the suffix array " << suffixArrayFileName << " is not of the genome " << genomeFileName << endl;
+			exit(1);
+		}
+	}
+	else {
+		vector<int> alphabet;
+		sarray.InitThreeBitDNAAlphabet(alphabet);
+		sarray.LarssonBuildSuffixArray(genome.seq, genome.length, alphabet);
+	}
+
+	MapabilityTrack track;
+	track.Compute(genome, sarray.index, nProc);
+
+	if (trackFileName != "") {
+		if (track.Write(trackFileName) == false) {
+			cout << "ERROR! Could not write the mapability track " << trackFileName << endl;
+			exit(1);
+		}
+	}
+	if (bedGraphFileName != "") {
+		ofstream bedGraphOut;
+		CrucialOpen(bedGraphFileName, bedGraphOut, std::ios::out);
+		bool written = track.WriteBedGraph(bedGraphOut, seqdb);
+		bedGraphOut.close();
+		if (written == false or bedGraphOut.fail()) {
+			cout << "ERROR! Could not write the bedGraph " << bedGraphFileName << endl;
+			exit(1);
+		}
+	}
+	int ki;
+	for (ki = 0; ki < kmerLengths.size(); ki++) {
+		cout << kmerLengths[ki] << " " << track.FractionUnique(genome, kmerLengths[ki]) << endl;
+	}
+	return 0;
+}
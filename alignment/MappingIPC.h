@@ -4,6 +4,8 @@
 #include <pthread.h>
 
 #include "MappingParameters.h"
+#include "MappingScheduler.h"
+#include "CheckpointJournal.h"
 
 #include "../common/FASTASequence.h"
 #include "../common/FASTQSequence.h"
@@ -13,9 +15,11 @@
 #include "../common/datastructures/mapping/MappingMetrics.h"
 #include "../common/datastructures/tuplelists/TupleCountTable.h"
 #include "../common/datastructures/suffixarray/SuffixArrayTypes.h"
+#include "../common/datastructures/suffixarray/MapabilityTrack.h"
 #include "../common/datastructures/metagenome/SequenceIndexDatabase.h"
 #include "../common/datastructures/reads/RegionTable.h"
 #include "../common/datastructures/bwt/BWT.h"
+#include "../common/datastructures/anchoring/MinimizerIndex.h"
 /*
  * This structure contains pointers to all required data structures
  * for mapping reads to a suffix array and evaluating the significance
@@ -27,7 +31,20 @@ class MappingData {
  public:
 	T_SuffixArray        *suffixArrayPtr;
 	BWT                  *bwtPtr;
+	MapabilityTrack      *mapabilityPtr;
 	T_GenomeSequence     *referenceSeqPtr;
+	//
+	// For homopolymer compressed seeding, the condensed reference that
+	// the suffix array or BWT indexes, and the index that maps its
+	// positions back to the reference.
+	//
+	T_GenomeSequence     *hpcReferenceSeqPtr;
+	ReverseCompressIndex *reverseCompressIndexPtr;
+	//
+	// The minimizers of the reference, when reads are first mapped
+	// with the sketch prefilter.
+	//
+	MinimizerIndex       *sketchIndexPtr;
 	SequenceIndexDatabase<FASTASequence> *seqDBPtr;
 	TupleCountTable<T_GenomeSequence, T_Tuple> *ctabPtr;
 	MappingParameters     params;
@@ -39,9 +56,43 @@ class MappingData {
   ostream *anchorFilePtr;
   ostream *clusterFilePtr;
   ostream *lcpBoundsOutPtr;
+  //
+  // The counters and histograms of metrics as of the last finished
+  // read, guarded by metricsLock so that they may be snapshotted by
+  // the progress reporter while mapping.  metrics itself is only used
+  // by the mapping thread.
+  //
+  MappingMetrics publishedMetrics;
+  pthread_mutex_t metricsLock;
+  //
+  // When splitting reads into tasks, the scheduler shared by all
+  // mapping threads, and the index of this thread in it.
+  //
+  WorkStealingScheduler *schedulerPtr;
+  int threadIndex;
+  //
+  // When checkpointing, the journal that the output of each read is
+  // handed to once the read is done.
+  //
+  CheckpointJournal *checkpointPtr;
   
   // Declare a semaphore for blocking on reading from the same hdhf file.
 	
+  MappingData() {
+    pthread_mutex_init(&metricsLock, NULL);
+    schedulerPtr = NULL;
+    threadIndex  = 0;
+    checkpointPtr = NULL;
+    mapabilityPtr = NULL;
+    hpcReferenceSeqPtr = NULL;
+    reverseCompressIndexPtr = NULL;
+    sketchIndexPtr = NULL;
+  }
+
+  ~MappingData() {
+    pthread_mutex_destroy(&metricsLock);
+  }
+
   void ShallowCopySuffixArray(T_SuffixArray &dest) {
 		dest.index              = suffixArrayPtr->index;
 		dest.length             = suffixArrayPtr->length;
@@ -91,6 +142,7 @@ class MappingData {
 		referenceSeqPtr    = refP;
 		seqDBPtr           = seqDBP;
 		ctabPtr            = ctabP;
+		reverseCompressIndexPtr = rciP;
 		regionTablePtr     = regionTableP;
 		params             = paramsP;
 		reader             = readerP;
@@ -4,6 +4,7 @@
 
 #include "tuples/TupleMetrics.h"
 #include "datastructures/anchoring/AnchorParameters.h"
+#include "datastructures/anchoring/MinimizerIndex.h"
 #include "qvs/QualityValue.h"
 #include "algorithms/alignment/printers/SAMPrinter.h"
 #include "algorithms/alignment/AlignmentFormats.h"
@@ -76,6 +77,7 @@ class MappingParameters {
   int  randomSeed;
   bool placeRandomly;
   bool printHeader;
+  bool printBinaryQV;
   bool samplePaths;
   bool warp, nowarp;
 	bool usePrefixLookupTable;
@@ -124,6 +126,29 @@ class MappingParameters {
 	string metricsFileName;
   string lcpBoundsFileName;
   string fullMetricsFileName;
+  string metricsJsonFileName;
+  int    metricsInterval;
+  string checkpointFileName;
+  int    checkpointInterval;
+  bool   resume;
+  string traceFileName;
+  int    traceSampleEvery;
+  int    traceMinMsec;
+  bool   intraReadTasks;
+  int    minTaskReadLength;
+  bool   pruneByScoreEstimate;
+  int    scoreEstimateSlack;
+  string mapabilityFileName;
+  int    mapabilityMaxLength;
+  string repeatMaskFileName;
+  bool   hpcSeeding;
+  int    hpcIndexBinSize;
+  bool   adaptiveSeeding;
+  bool   sketchPrefilter;
+  int    sketchK;
+  int    sketchWindow;
+  int    sketchMinHits;
+  int    sketchMaxOccurrences;
 	bool printSubreadTitle;
 	bool unrollCcs;
 	bool useCcs;
@@ -153,6 +178,7 @@ class MappingParameters {
   bool  outputByThread;
   int   maxReadIndex;
   int   recurseOver;
+  int   sdpBand;
   bool  forPicard;
   bool  separateGaps;
   string scoreMatrixString;
@@ -269,6 +295,29 @@ class MappingParameters {
 		globalChainType = 0;
 		metricsFileName = "";
     fullMetricsFileName = "";
+    metricsJsonFileName = "";
+    metricsInterval = 0;
+    checkpointFileName = "";
+    checkpointInterval = 0;
+    resume = false;
+    traceFileName = "";
+    traceSampleEvery = 100;
+    traceMinMsec = 0;
+    intraReadTasks = false;
+    minTaskReadLength = 20000;
+    pruneByScoreEstimate = false;
+    scoreEstimateSlack = 100;
+    mapabilityFileName = "";
+    mapabilityMaxLength = 0;
+    repeatMaskFileName = "";
+    hpcSeeding = false;
+    hpcIndexBinSize = 64;
+    adaptiveSeeding = false;
+    sketchPrefilter = false;
+    sketchK = 15;
+    sketchWindow = 10;
+    sketchMinHits = 5;
+    sketchMaxOccurrences = 100;
 		doSensitiveSearch = false;
 		emulateNucmer = false;
 		refineBetweenAnchorsOnly = false;
@@ -294,6 +343,7 @@ class MappingParameters {
 		byAdapter = false;
     qvScaleType = PHRED;
     printHeader = false;
+    printBinaryQV = false;
     computeAlignProbability = false;    
     readAccuracyPrior = 0.85;
     printVersion = false;
@@ -303,6 +353,7 @@ class MappingParameters {
     globalDeletionPrior = 13;
     outputByThread = false;
     recurseOver = 10000;
+    sdpBand = 0;
     forPicard = false;
     separateGaps = false;
     scoreMatrixString = "";
@@ -371,9 +422,28 @@ class MappingParameters {
 		if (countTableName != "") {
 			useCountTable = true;
 		}
-		if (metricsFileName != "" or fullMetricsFileName != "") {
+		if (metricsFileName != "" or fullMetricsFileName != "" or metricsJsonFileName != "") {
 			storeMetrics = true;
 		}
+		if (nProc == 1) {
+			intraReadTasks = false;
+		}
+		if (sketchPrefilter and (sketchK < 1 or sketchK > Minimizer::MaxTupleSize)) {
+			cout << "ERROR, the sketch k-mer size must be between 1 and " << Minimizer::MaxTupleSize << "." << endl;
+			exit(1);
+		}
+		if ((resume or checkpointFileName != "") and checkpointInterval == 0) {
+			checkpointInterval = 1000;
+		}
+		if (checkpointInterval > 0) {
+			if (outFileName == "" or outputByThread) {
+				cout << "ERROR, checkpointing requires a single output file given with -out." << endl;
+				exit(1);
+			}
+			if (checkpointFileName == "") {
+				checkpointFileName = outFileName + ".ckpt";
+			}
+		}
 		if (useCcsOnly) {
 			useCcs = true;
 		}
@@ -0,0 +1,236 @@
+#ifndef ALIGNMENT_MAPPING_SCHEDULER_H_
+#define ALIGNMENT_MAPPING_SCHEDULER_H_
+
+#include <deque>
+#include <vector>
+#include <iostream>
+#include <pthread.h>
+
+using namespace std;
+
+//
+// A work stealing scheduler that sits under the mapping threads.
+// Each mapping thread is a worker with its own task queue.  When a
+// single read has enough work to be worth splitting (for instance
+// refining many candidate alignments of a 100kb read), the thread
+// that owns the read pushes the work on to its queue as tasks, and
+// then waits for the tasks to finish.  While waiting it runs tasks
+// off the back of its own queue, and once that is empty, it steals
+// from the front of the queues of other workers.  Threads that have
+// run out of reads to map do not exit until every other thread is
+// done, and steal tasks in the meantime, so that a few long reads at
+// the end of a file do not leave most threads idle.
+//
+
+class TaskGroup {
+ public:
+  int nPending;
+  TaskGroup() {
+    nPending = 0;
+  }
+};
+
+class SchedulerTask {
+ public:
+  TaskGroup *group;
+  SchedulerTask() {
+    group = NULL;
+  }
+  virtual ~SchedulerTask() {}
+  //
+  // 'workerContext' is the context registered by the thread that
+  // runs the task, which is not necessarily the thread that
+  // submitted it.
+  //
+  virtual void Run(void *workerContext) = 0;
+};
+
+class WorkStealingScheduler {
+ public:
+  int nWorkers;
+  int nActive;
+  int nQueued;
+  long long nSubmitted;
+  long long nStolen;
+  vector<deque<SchedulerTask*> > queues;
+  vector<void*> workerContexts;
+  pthread_mutex_t *queueLocks;
+  //
+  // Guards nActive, nQueued, the counters, and the pending counts of
+  // the task groups.  Waiting workers sleep on 'wake'.
+  //
+  pthread_mutex_t lock;
+  pthread_cond_t  wake;
+
+  WorkStealingScheduler() {
+    nWorkers   = 0;
+    nActive    = 0;
+    nQueued    = 0;
+    nSubmitted = 0;
+    nStolen    = 0;
+    queueLocks = NULL;
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&wake, NULL);
+  }
+
+  ~WorkStealingScheduler() {
+    Free();
+    pthread_mutex_destroy(&lock);
+    pthread_cond_destroy(&wake);
+  }
+
+  void Free() {
+    int w;
+    if (queueLocks != NULL) {
+      for (w = 0; w < nWorkers; w++) {
+        pthread_mutex_destroy(&queueLocks[w]);
+      }
+      delete[] queueLocks;
+      queueLocks = NULL;
+    }
+    queues.clear();
+    workerContexts.clear();
+  }
+
+  //
+  // Prepare for a new set of worker threads.  This must be called
+  // before the workers are started, e.g. once per input file.
+  //
+  void Initialize(int nWorkersP) {
+    Free();
+    nWorkers = nWorkersP;
+    nActive  = nWorkers;
+    nQueued  = 0;
+    queues.resize(nWorkers);
+    workerContexts.resize(nWorkers, NULL);
+    queueLocks = new pthread_mutex_t[nWorkers];
+    int w;
+    for (w = 0; w < nWorkers; w++) {
+      pthread_mutex_init(&queueLocks[w], NULL);
+    }
+  }
+
+  void SetWorkerContext(int worker, void *context) {
+    workerContexts[worker] = context;
+  }
+
+  void Submit(int worker, TaskGroup &group, SchedulerTask *task) {
+    task->group = &group;
+    pthread_mutex_lock(&lock);
+    group.nPending++;
+    nQueued++;
+    nSubmitted++;
+    pthread_mutex_unlock(&lock);
+
+    pthread_mutex_lock(&queueLocks[worker]);
+    queues[worker].push_back(task);
+    pthread_mutex_unlock(&queueLocks[worker]);
+
+    pthread_cond_broadcast(&wake);
+  }
+
+  //
+  // Run one task, preferring the most recently pushed task of this
+  // worker (it is most likely to have its data in cache), otherwise
+  // stealing the oldest task of some other worker.  Returns false if
+  // there was nothing to run.
+  //
+  bool RunOne(int worker) {
+    SchedulerTask *task = NULL;
+    bool stolen = false;
+    pthread_mutex_lock(&queueLocks[worker]);
+    if (queues[worker].size() > 0) {
+      task = queues[worker].back();
+      queues[worker].pop_back();
+    }
+    pthread_mutex_unlock(&queueLocks[worker]);
+
+    int v;
+    for (v = 1; task == NULL and v < nWorkers; v++) {
+      int victim = (worker + v) % nWorkers;
+      pthread_mutex_lock(&queueLocks[victim]);
+      if (queues[victim].size() > 0) {
+        task = queues[victim].front();
+        queues[victim].pop_front();
+        stolen = true;
+      }
+      pthread_mutex_unlock(&queueLocks[victim]);
+    }
+    if (task == NULL) {
+      return false;
+    }
+
+    pthread_mutex_lock(&lock);
+    nQueued--;
+    if (stolen) {
+      nStolen++;
+    }
+    pthread_mutex_unlock(&lock);
+
+    task->Run(workerContexts[worker]);
+
+    pthread_mutex_lock(&lock);
+    task->group->nPending--;
+    bool groupDone = (task->group->nPending == 0);
+    pthread_mutex_unlock(&lock);
+    if (groupDone) {
+      pthread_cond_broadcast(&wake);
+    }
+    return true;
+  }
+
+  //
+  // Block until all tasks in 'group' have run, helping out with any
+  // queued work in the meantime.
+  //
+  void Wait(int worker, TaskGroup &group) {
+    while (true) {
+      pthread_mutex_lock(&lock);
+      if (group.nPending == 0) {
+        pthread_mutex_unlock(&lock);
+        return;
+      }
+      pthread_mutex_unlock(&lock);
+
+      if (RunOne(worker) == false) {
+        pthread_mutex_lock(&lock);
+        while (group.nPending > 0 and nQueued == 0) {
+          pthread_cond_wait(&wake, &lock);
+        }
+        pthread_mutex_unlock(&lock);
+      }
+    }
+  }
+
+  //
+  // Called by a worker that has no more reads to map.  Steal work
+  // until every worker has retired and all queues are empty.
+  //
+  void Retire(int worker) {
+    pthread_mutex_lock(&lock);
+    nActive--;
+    pthread_mutex_unlock(&lock);
+    pthread_cond_broadcast(&wake);
+
+    while (true) {
+      if (RunOne(worker)) {
+        continue;
+      }
+      pthread_mutex_lock(&lock);
+      while (nActive > 0 and nQueued == 0) {
+        pthread_cond_wait(&wake, &lock);
+      }
+      bool done = (nActive == 0 and nQueued == 0);
+      pthread_mutex_unlock(&lock);
+      if (done) {
+        return;
+      }
+    }
+  }
+
+  void PrintStats(ostream &out) {
+    out << "Intra-read tasks: " << nSubmitted << " submitted, " << nStolen << " stolen." << endl;
+  }
+};
+
+#endif
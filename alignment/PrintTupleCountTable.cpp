@@ -26,12 +26,15 @@ int main(int argc, char* argv[]) {
 	vector<string> sequenceFiles;
 	TupleMetrics tm;
   tm.tupleSize = 8;
+  int nProc = 1;
 	clp.SetProgramName("printTupleCountTable");
 	clp.SetProgramSummary("Count the number of occurrences of every k-mer in a file.");
 	clp.RegisterStringOption("table", &tableFileName, "Output table name.", true);
 	clp.RegisterIntOption("wordsize", &tm.tupleSize, "Size of words to count", 
 												CommandLineParser::NonNegativeInteger, false);
 	clp.RegisterStringListOption("reads", &sequenceFiles, "All sequences.", false);
+	clp.RegisterIntOption("nproc", &nProc, "Number of threads to count with.", 
+												CommandLineParser::PositiveInteger, false);
 	clp.RegisterPreviousFlagsAsHidden();
 	vector<string> opts;
   if (argc == 2) {
@@ -51,14 +54,42 @@ int main(int argc, char* argv[]) {
 	table.InitCountTable(tm);
 	int i;
   FASTASequence seq;
+#ifndef COMPRESSED
+  //
+  // Reads are joined into blocks separated by an N, so that no tuple
+  // spans two reads, and each block is counted on nProc threads.
+  //
+  vector<Nucleotide> blockBuffer;
+  FASTASequence block;
+  DNALength maxBlockLength = 1 << 22;
+  blockBuffer.reserve(maxBlockLength);
+#endif
 	for (i = 0; i < sequenceFiles.size(); i++ ){ 
 		FASTAReader reader;
 		reader.Init(sequenceFiles[i]);
 		while (reader.GetNext(seq)) {
 			seq.ToUpper();
+#ifdef COMPRESSED
 			table.AddSequenceTupleCountsLR(seq);
+#else
+      blockBuffer.insert(blockBuffer.end(), &seq.seq[0], &seq.seq[seq.length]);
+      blockBuffer.push_back('N');
+      if (blockBuffer.size() >= maxBlockLength) {
+        block.seq    = &blockBuffer[0];
+        block.length = blockBuffer.size();
+        table.AddSequenceTupleCountsLR(block, nProc);
+        blockBuffer.clear();
+      }
+#endif
 		}
   }	
+#ifndef COMPRESSED
+  if (blockBuffer.size() > 0) {
+    block.seq    = &blockBuffer[0];
+    block.length = blockBuffer.size();
+    table.AddSequenceTupleCountsLR(block, nProc);
+  }
+#endif
 	table.Write(tableOut);
 	
 	return 0;
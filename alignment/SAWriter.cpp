@@ -1,6 +1,7 @@
 #include <vector>
 #include <string>
 #include "../common/datastructures/suffixarray/SuffixArray.h"
+#include "../common/datastructures/suffixarray/TupleRepeatMask.h"
 #include "../common/FASTASequence.h"
 #include "../common/FASTAReader.h"
 #include "../common/NucConversion.h"
@@ -12,7 +13,7 @@
 
 
 void PrintUsage() {
-	cout << "usage: sawriter saOut fastaIn [fastaIn2 fastaIn3 ...] [-blt p] [-larsson] [-4bit] [-manmy] [-kar]" << endl;
+	cout << "usage: sawriter saOut fastaIn [fastaIn2 fastaIn3 ...] [-blt p] [-larsson] [-4bit] [-manmy] [-kar] [-maskRepeats k n]" << endl;
   cout << "   or  sawriter fastaIn  (writes to fastIn.sa)." << endl;
 	cout << "       -blt p      Build a lookup table on prefixes of length 'p'. This speeds " << endl
 			 << "                   up lookups considerably (more than the LCP table), but misses matches " << endl
@@ -27,7 +28,11 @@ void PrintUsage() {
 			 << "       -mafe       (disabled for now!) Use the lightweight construction algorithm from Manzini and Ferragina" << endl
 			 << "       -welter     Use lightweight (sort of light) suffix array construction.  This is a bit more slow than" << endl
 			 << "                   normal larsson." << endl
-			 << "       -welterweight N use a difference cover of size N for building the suffix array.  Valid values are 7,32,64,111, and 2281." << endl;
+			 << "       -welterweight N use a difference cover of size N for building the suffix array.  Valid values are 7,32,64,111, and 2281." << endl
+			 << "       -maskRepeats k n  Also write saOut.rpt, a mask of the k-mers that occur more than n times" << endl
+			 << "                   in the genome.  blasr -repeatMask skips read positions that start with" << endl
+			 << "                   these k-mers, and needs k to be at least its -minMatch.  The mask takes" << endl
+			 << "                   4^k bits, and k may be at most " << TupleRepeatMask::MaxTupleSize << "." << endl;
 
 
 }
@@ -48,6 +53,8 @@ int main(int argc, char* argv[]) {
 	SAType saBuildType = larsson;
 	int read4BitCompressed  = 0;
 	int diffCoverSize = 0;
+	int repeatMaskTupleSize = 0;
+	int repeatMaskMaxCount  = 0;
 	while (argi < argc) {
 		if (strlen(argv[argi]) > 0 and
 				argv[argi][0] == '-'){ 
@@ -113,6 +120,17 @@ int main(int argc, char* argv[]) {
 			else if (strcmp(argv[argi], "-4bit") == 0) {
 				read4BitCompressed = 1;
 			}
+			else if (strcmp(argv[argi], "-maskRepeats") == 0) {
+				if (argi < argc - 2) {
+					repeatMaskTupleSize = atoi(argv[++argi]);
+					repeatMaskMaxCount  = atoi(argv[++argi]);
+				}
+				if (repeatMaskTupleSize < 1 or repeatMaskTupleSize > TupleRepeatMask::MaxTupleSize or repeatMaskMaxCount < 1) {
+					cout << "Please specify a k-mer length of at most " << TupleRepeatMask::MaxTupleSize 
+							 << " and a count for -maskRepeats." << endl;
+					exit(1);
+				}
+			}
 			else {
 				PrintUsage();
 				cout << "ERROR, bad option: " << argv[argi] << endl;
@@ -122,6 +140,11 @@ int main(int argc, char* argv[]) {
 		++argi;
 	}
   
+  if (repeatMaskTupleSize > 0 and read4BitCompressed) {
+    cout << "ERROR, -maskRepeats is not supported with -4bit." << endl;
+    exit(1);
+  }
+
   if (inFiles.size() == 0) {
     //
     // Special use case: the input file is a fasta file.  Write to that file + .sa
@@ -226,6 +249,20 @@ int main(int argc, char* argv[]) {
 	}
 	sa.Write(saFile);
 
+	if (repeatMaskTupleSize > 0) {
+		if (saBuildType == kark) {
+			DNALength p;
+			for (p = 0; p < seq.length; p++ ){ seq.seq[p]--; }
+		}
+		seq.ConvertThreeBitToAscii();
+		TupleRepeatMask repeatMask;
+		repeatMask.Compute(seq, sa.index, repeatMaskTupleSize, repeatMaskMaxCount);
+		string repeatMaskFile = saFile + ".rpt";
+		repeatMask.Write(repeatMaskFile);
+		cout << "masked " << repeatMask.NumMasked() << " " << repeatMaskTupleSize << "-mers that occur more than " 
+				 << repeatMaskMaxCount << " times." << endl;
+	}
+
 	return 0;
 
 }
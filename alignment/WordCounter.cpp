@@ -10,14 +10,71 @@
 #include "../common/DNASequence.h"
 #include "../common/tuples/DNATuple.h"
 #include "../common/tuples/TupleMetrics.h"
+#include "../common/datastructures/tuplelists/PartitionedTupleCounter.h"
 #include "../common/Types.h"
 
 using namespace std;
 
+//
+// Write the counts and positions of each partition of sorted tuples,
+// in the order of the partitions.
+//
+class WordCountWriter {
+ public:
+  vector<vector<CountedDNATuple> > partitionCounts;
+  vector<vector<int> > partitionPositions;
+  ofstream *countedTupleListOut, *posOut;
+  int numUnique, numMultOne;
+
+  WordCountWriter(int nPartitions, ofstream &_countedTupleListOut, ofstream &_posOut) {
+    partitionCounts.resize(nPartitions);
+    partitionPositions.resize(nPartitions);
+    countedTupleListOut = &_countedTupleListOut;
+    posOut = &_posOut;
+    numUnique = numMultOne = 0;
+  }
+
+  void ProcessPartition(int p, vector<TuplePosRecord> &tupleList) {
+    int t, t2, tc;
+    int numTuples = tupleList.size();
+    CountedDNATuple countedTuple;
+    countedTuple.pos = 0;
+    t = 0;
+    while (t < numTuples) {
+      t2 = t + 1;
+      while (t2 < numTuples and tupleList[t].tuple == tupleList[t2].tuple) {
+        t2++;
+      }
+      countedTuple.tuple = tupleList[t].tuple;
+      countedTuple.count = t2 - t;
+      partitionCounts[p].push_back(countedTuple);
+      partitionPositions[p].push_back(countedTuple.count);
+      for (tc = t; tc < t2; tc++) {
+        partitionPositions[p].push_back(tupleList[tc].pos);
+      }
+      t = t2;
+    }
+  }
+
+  void FinishPartition(int p) {
+    VectorIndex i;
+    for (i = 0; i < partitionCounts[p].size(); i++) {
+      if (partitionCounts[p][i].count == 1) ++numMultOne;
+    }
+    numUnique += partitionCounts[p].size();
+    if (partitionCounts[p].size() > 0) {
+      countedTupleListOut->write((const char*) &partitionCounts[p][0], sizeof(CountedDNATuple) * partitionCounts[p].size());
+      posOut->write((const char*) &partitionPositions[p][0], sizeof(int) * partitionPositions[p].size());
+    }
+    vector<CountedDNATuple>().swap(partitionCounts[p]);
+    vector<int>().swap(partitionPositions[p]);
+  }
+};
+
 int main(int argc, char* argv[]) {
   FASTAReader reader;
   if (argc < 5) {
-	cout << "usage: wordCounter seqFile tupleSize tupleOutputFile posOutputFile" << endl;
+	cout << "usage: wordCounter seqFile tupleSize tupleOutputFile posOutputFile [nproc]" << endl;
 	exit(1);
   }
 
@@ -25,6 +82,10 @@ int main(int argc, char* argv[]) {
   int    tupleSize = atoi(argv[2]);
   string tupleListName = argv[3];
 	string posOutName    = argv[4];
+  int    nProc = 1;
+  if (argc > 5) {
+    nProc = atoi(argv[5]);
+  }
   
 	TupleMetrics tm;
   tm.Initialize(tupleSize);
@@ -33,32 +94,14 @@ int main(int argc, char* argv[]) {
   FASTASequence seq;
   reader.GetNext(seq);
 
-  vector<CountedDNATuple> tupleList;
-  CountedDNATuple tuple;
-  DNALength i;
-  for (i = 0; i < seq.length - tm.tupleSize + 1; i++ ) {
-		if (tuple.FromStringRL((Nucleotide*) (seq.seq + i), tm)) {
-			tuple.count = i;
-			tupleList.push_back(tuple);
-		}
-  }
-
-  std::sort(tupleList.begin(), tupleList.end());
-
-  int t;
-  int t2;
-  int numTuples = tupleList.size();
-  t = t2 = 0;
-  int numUnique = 0;
-  while (t < numTuples) {
-	t2 = t;
-	t2++;
-	while (t2 < numTuples and tupleList[t] == tupleList[t2]) {
-	  t2++;
-	}
-	++numUnique;
-	t = t2;
-  }
+  //
+  // Count the tuples of the sequence in sorted partitions, spilling
+  // them to disk next to the output when there are too many to hold
+  // in memory.
+  //
+  PartitionedTupleCounter<TuplePosRecord> counter;
+  counter.Initialize(tm, false, nProc, 8, 1 << 26, tupleListName + ".tmp");
+  counter.AddSequence(seq);
 
   ofstream countedTupleListOut;
   countedTupleListOut.open(tupleListName.c_str(), ios_base::binary);
@@ -66,46 +109,32 @@ int main(int argc, char* argv[]) {
 	ofstream posOut;
 	posOut.open(posOutName.c_str(), ios_base::binary);
 
+  //
+  // The number of unique tuples is only known once they are all
+  // written, so write a placeholder and fill it in at the end.
+  //
+  int numUnique = 0;
   countedTupleListOut.write((const char*) &numUnique, sizeof(int));
   countedTupleListOut.write((const char*) &tm.tupleSize, sizeof(int));
 
   posOut.write((const char*) &numUnique, sizeof(int));
 
 	//
-	// Write out the tuple+counts to a file.
+	// Write out the tuple+counts and the positions of the tuples.
 	//
-  t = t2 = 0;
-  CountedDNATuple countedTuple;
-	int numMultOne = 0;
-  while (t < numTuples) {
-		t2 = t;
-		t2++;
-		while (t2 < numTuples and tupleList[t] == tupleList[t2]) {
-			t2++;
-		}
-		countedTuple.tuple = tupleList[t].tuple;
-		countedTuple.count = t2 - t;
-		if (countedTuple.count == 1) ++numMultOne;
-		countedTupleListOut.write((const char*) &countedTuple,sizeof(CountedDNATuple));
-		
-		posOut.write((char*)&countedTuple.count, sizeof(int));
-		
-		int tc;
-		for (tc = t; tc < t2; tc++) {
-			posOut.write((char*) &tupleList[tc].count, sizeof(int));
-		}
-		t = t2;
-  }
+  WordCountWriter writer(counter.nPartitions, countedTupleListOut, posOut);
+  counter.ProcessPartitions(writer);
+  numUnique = writer.numUnique;
 
-	//
-	// Write out the positions of the tuples to a file.
-	//
+  countedTupleListOut.seekp(0);
+  countedTupleListOut.write((const char*) &numUnique, sizeof(int));
+  posOut.seekp(0);
+  posOut.write((const char*) &numUnique, sizeof(int));
 	
 	posOut.close();
 	countedTupleListOut.close();
 
 	//  cout << "found " << numUnique << " distinct " << DNATuple::TupleSize << "-mers." << endl;
-	cout << numMultOne << endl;
+	cout << writer.numMultOne << endl;
   return 0;
 }
-
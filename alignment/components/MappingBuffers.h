@@ -27,8 +27,8 @@ public:
   TupleList<PositionDNATuple> sdpCachedTargetPrefixTupleList;
   TupleList<PositionDNATuple> sdpCachedTargetSuffixTupleList;
   std::vector<int> sdpCachedMaxFragmentChain;
-  vector<double> probMat;
-  vector<double> optPathProbMat;
+  vector<float>  probMat;
+  vector<float>  optPathProbMat;
   vector<float>  lnSubPValueMat;
   vector<float>  lnInsPValueMat;
   vector<float>  lnDelPValueMat;
@@ -1,29 +1,34 @@
-#include "RGraph.h"
-#include "ReadNode.h"
+#include "CompactRGraph.h"
 #include <string>
 
 using namespace std;
 
 int main(int argc, char* argv[]) {
-  if (argc != 2) {
-    cout << "usage: testRGraph file.rm4 " << endl;
+  if (argc < 2 or argc > 3) {
+    cout << "usage: buildRGraph file.rm4 [nproc]" << endl;
     exit(1);
   }
   string rm4FileName = argv[1];
-  RGraph rGraph;
-  rGraph.BuildFromRM4(rm4FileName);
-
-  //  rGraph.PrintPossibleChimeras(2);
-  //  rGraph.PrintLowCoverageReads(1000000);
+  int nProc = 1;
+  if (argc == 3) {
+    nProc = atoi(argv[2]);
+  }
+  CompactRGraph rGraph;
+  rGraph.BuildFromRM4(rm4FileName, nProc);
 
-  cout << "There are " << ReadNode::counter << " nodes and " << ReadNodeSuperset::counter << " supernodes." << endl;
+  cout << "There are " << rGraph.NumReads() << " reads, " << rGraph.overlaps.size() << " overlaps and "
+       << rGraph.NumNodes() << " nodes." << endl;
   rGraph.RemoveLowCoverage(5);
-  cout << "Removed " <<         ReadNodeSuperset::countDeleted << " out of " << ReadNodeSuperset::counter << endl;
+  UInt r, nRemoved = 0;
+  for (r = 0; r < rGraph.NumReads(); r++) {
+    if (rGraph.readRemoved[r]) { nRemoved++; }
+  }
+  cout << "Removed " << nRemoved << " out of " << rGraph.NumReads() << " reads." << endl;
   
   rGraph.MergeOverlaps();
 
   int nConsistent = rGraph.CountConsistentSupernodes();
-  cout << nConsistent << " out of " <<  ReadNodeSuperset::counter - ReadNodeSuperset::countDeleted << endl;
+  cout << nConsistent << " out of " << rGraph.CountSupernodes() << " supernodes are consistent." << endl;
   
   return 0;
 }
@@ -0,0 +1,678 @@
+#ifndef COMPACT_RGRAPH_H_
+#define COMPACT_RGRAPH_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "Types.h"
+#include "Enumerations.h"
+#include "PBReadNameParser.h"
+#include "UnionFind.h"
+
+using namespace std;
+
+//
+// The fields of an rm4 line that the graph uses.  Read names are
+// not copied; they are offsets into the buffer holding the file.
+//
+class RM4Record {
+ public:
+  size_t qNamePos, tNamePos;
+  UInt   qNameLength, tNameLength;
+  UInt   qStrand, qBegin, qEnd, qLength;
+  UInt   tStrand, tBegin, tEnd, tLength;
+};
+
+class RM4ParseBlock {
+ public:
+  const char *buffer;
+  size_t start, end;
+  vector<RM4Record> records;
+  size_t badLinePos;
+  bool   ok;
+};
+
+//
+// Read the next whitespace separated field of the line starting at
+// pos, and advance pos past it.
+//
+inline bool NextRM4Field(const char *buffer, size_t &pos, size_t lineEnd, size_t &fieldPos, UInt &fieldLength) {
+  while (pos < lineEnd and (buffer[pos] == ' ' or buffer[pos] == '\t')) {
+    ++pos;
+  }
+  fieldPos = pos;
+  while (pos < lineEnd and buffer[pos] != ' ' and buffer[pos] != '\t') {
+    ++pos;
+  }
+  fieldLength = pos - fieldPos;
+  return fieldLength > 0;
+}
+
+inline bool NextRM4UInt(const char *buffer, size_t &pos, size_t lineEnd, UInt &value) {
+  size_t fieldPos;
+  UInt   fieldLength;
+  if (NextRM4Field(buffer, pos, lineEnd, fieldPos, fieldLength) == false) {
+    return false;
+  }
+  char *fieldEnd;
+  value = strtoul(&buffer[fieldPos], &fieldEnd, 10);
+  return fieldEnd == &buffer[pos];
+}
+
+//
+// Parse the lines that begin in [start, end) of the buffer.  The
+// buffer is terminated by a '\0' or newline after the last line.
+//
+void* ParseRM4Block(void *blockPtr) {
+  RM4ParseBlock *block = (RM4ParseBlock*) blockPtr;
+  const char *buffer = block->buffer;
+  size_t pos = block->start;
+  block->ok  = true;
+  while (pos < block->end) {
+    size_t lineEnd = pos;
+    while (buffer[lineEnd] != '\n' and buffer[lineEnd] != '\0') {
+      ++lineEnd;
+    }
+    size_t lineStart = pos;
+    size_t fieldPos;
+    UInt   fieldLength;
+    RM4Record record;
+    bool lineOk = true;
+    if (NextRM4Field(buffer, pos, lineEnd, record.qNamePos, record.qNameLength) == false) {
+      //
+      // Blank line.
+      //
+      pos = lineEnd + 1;
+      continue;
+    }
+    lineOk = (NextRM4Field(buffer, pos, lineEnd, record.tNamePos, record.tNameLength) and
+              // alignment score and percent identity are not used
+              NextRM4Field(buffer, pos, lineEnd, fieldPos, fieldLength) and
+              NextRM4Field(buffer, pos, lineEnd, fieldPos, fieldLength) and
+              NextRM4UInt(buffer, pos, lineEnd, record.qStrand) and
+              NextRM4UInt(buffer, pos, lineEnd, record.qBegin) and
+              NextRM4UInt(buffer, pos, lineEnd, record.qEnd) and
+              NextRM4UInt(buffer, pos, lineEnd, record.qLength) and
+              NextRM4UInt(buffer, pos, lineEnd, record.tStrand) and
+              NextRM4UInt(buffer, pos, lineEnd, record.tBegin) and
+              NextRM4UInt(buffer, pos, lineEnd, record.tEnd) and
+              NextRM4UInt(buffer, pos, lineEnd, record.tLength));
+    if (lineOk == false) {
+      block->ok = false;
+      block->badLinePos = lineStart;
+      return NULL;
+    }
+    block->records.push_back(record);
+    pos = lineEnd + 1;
+  }
+  return NULL;
+}
+
+//
+// Orders read names that are stored as offsets into a buffer.
+//
+class RM4NameRef {
+ public:
+  size_t pos;
+  UInt   length;
+};
+
+class CompareRM4Names {
+ public:
+  const char *buffer;
+  CompareRM4Names(const char *bufferP) : buffer(bufferP) {}
+  int Compare(const RM4NameRef &lhs, const RM4NameRef &rhs) const {
+    int res = memcmp(&buffer[lhs.pos], &buffer[rhs.pos], min(lhs.length, rhs.length));
+    if (res != 0) {
+      return res;
+    }
+    return (int) lhs.length - (int) rhs.length;
+  }
+  bool operator()(const RM4NameRef &lhs, const RM4NameRef &rhs) const {
+    return Compare(lhs, rhs) < 0;
+  }
+};
+
+class EqualRM4Names {
+ public:
+  CompareRM4Names compare;
+  EqualRM4Names(const char *bufferP) : compare(bufferP) {}
+  bool operator()(const RM4NameRef &lhs, const RM4NameRef &rhs) const {
+    return compare.Compare(lhs, rhs) == 0;
+  }
+};
+
+//
+// An overlap between two reads, in forward coordinates of each (as in
+// RGraph::StoreOverlapPair), with the graph nodes at its ends.  q is
+// the read with the lower id, which need not be the query of the rm4
+// line.
+//
+class CompactOverlap {
+ public:
+  UInt q, t;
+  UInt qAlnBegin, qAlnEnd, tAlnBegin, tAlnEnd;
+  UInt qBeginNode, qEndNode, tBeginNode, tEndNode;
+  bool sameStrand;
+  bool removed;
+  //
+  // The two lines of an overlap in an all against all rm4 file have
+  // the reads swapped, but are equal once stored with q < t.  Other
+  // alignments between the same two reads, on the other strand or at
+  // another place, are distinct overlaps.
+  //
+  int operator<(const CompactOverlap &rhs) const {
+    if (q != rhs.q) {
+      return q < rhs.q;
+    }
+    if (t != rhs.t) {
+      return t < rhs.t;
+    }
+    if (sameStrand != rhs.sameStrand) {
+      return sameStrand < rhs.sameStrand;
+    }
+    if (qAlnBegin != rhs.qAlnBegin) {
+      return qAlnBegin < rhs.qAlnBegin;
+    }
+    if (qAlnEnd != rhs.qAlnEnd) {
+      return qAlnEnd < rhs.qAlnEnd;
+    }
+    if (tAlnBegin != rhs.tAlnBegin) {
+      return tAlnBegin < rhs.tAlnBegin;
+    }
+    return tAlnEnd < rhs.tAlnEnd;
+  }
+  int operator==(const CompactOverlap &rhs) const {
+    return (q == rhs.q and t == rhs.t and sameStrand == rhs.sameStrand and
+            qAlnBegin == rhs.qAlnBegin and qAlnEnd == rhs.qAlnEnd and
+            tAlnBegin == rhs.tAlnBegin and tAlnEnd == rhs.tAlnEnd);
+  }
+};
+
+//
+// The overlap graph of RGraph in flat arrays.  Reads are interned to
+// integer ids (in order of name), overlaps are sorted by (query,
+// target) with an adjacency list per read in CSR form, a read's nodes
+// are the sorted positions of its overlap ends, and supernodes are
+// the sets of a union-find over nodes.  Nodes are not added after
+// the graph is built, so MergeOverlaps joins the nodes that
+// already correspond across an overlap rather than splitting reads
+// to make new ones.
+//
+class CompactRGraph {
+ public:
+  vector<string> readNames;
+  vector<UInt> subreadBegin, readLength, fullReadLength;
+  vector<bool> readRemoved;
+
+  vector<CompactOverlap> overlaps;
+  // overlaps of read r are adjacency[adjOffsets[r] .. adjOffsets[r+1])
+  vector<UInt> adjOffsets, adjacency;
+
+  // nodes of read r are nodePos[nodeOffsets[r] .. nodeOffsets[r+1])
+  vector<UInt> nodeOffsets, nodePos, nodeCoverage;
+  vector<UInt> nodeRead;
+
+  UnionFind supernodes;
+
+  UInt NumReads() {
+    return readNames.size();
+  }
+
+  UInt NumNodes() {
+    return nodePos.size();
+  }
+
+  UInt ReadNodesBegin(UInt r) {
+    return nodeOffsets[r];
+  }
+  UInt ReadNodesEnd(UInt r) {
+    return nodeOffsets[r+1];
+  }
+
+  UInt FindNode(UInt r, UInt pos) {
+    return lower_bound(nodePos.begin() + nodeOffsets[r], nodePos.begin() + nodeOffsets[r+1], pos) - nodePos.begin();
+  }
+
+  void BuildFromRM4(string &rm4FileName, int nProc=1) {
+    ifstream in;
+    in.open(rm4FileName.c_str(), ios::in | ios::binary);
+    if (! in ) {
+      cout << "Cannot open " << rm4FileName << endl;
+      exit(1);
+    }
+    in.seekg(0, ios::end);
+    size_t fileSize = in.tellg();
+    in.seekg(0, ios::beg);
+    vector<char> buffer(fileSize + 1);
+    if (fileSize > 0) {
+      in.read(&buffer[0], fileSize);
+    }
+    buffer[fileSize] = '\0';
+    in.close();
+
+    //
+    // Parse blocks of lines in parallel; each block starts at the
+    // beginning of a line.
+    //
+    if (nProc < 1) {
+      nProc = 1;
+    }
+    vector<RM4ParseBlock> blocks(nProc);
+    vector<pthread_t> threads(nProc);
+    int b;
+    for (b = 0; b < nProc; b++) {
+      size_t start = (fileSize / nProc) * b;
+      if (b > 0) {
+        while (start < fileSize and buffer[start-1] != '\n') {
+          ++start;
+        }
+      }
+      blocks[b].buffer = &buffer[0];
+      blocks[b].start  = start;
+      if (b > 0) {
+        blocks[b-1].end = start;
+      }
+    }
+    blocks[nProc-1].end = fileSize;
+    if (nProc == 1) {
+      ParseRM4Block(&blocks[0]);
+    }
+    else {
+      for (b = 0; b < nProc; b++) {
+        pthread_create(&threads[b], NULL, ParseRM4Block, &blocks[b]);
+      }
+      for (b = 0; b < nProc; b++) {
+        pthread_join(threads[b], NULL);
+      }
+    }
+    size_t nRecords = 0;
+    for (b = 0; b < nProc; b++) {
+      if (blocks[b].ok == false) {
+        size_t lineEnd = blocks[b].badLinePos;
+        while (buffer[lineEnd] != '\n' and buffer[lineEnd] != '\0') {
+          ++lineEnd;
+        }
+        cout << "Malformatted rm4 line: " << endl;
+        cout << string(&buffer[blocks[b].badLinePos], lineEnd - blocks[b].badLinePos) << endl;
+        exit(1);
+      }
+      nRecords += blocks[b].records.size();
+    }
+
+    //
+    // Intern the read names.
+    //
+    vector<RM4NameRef> names(2*nRecords);
+    size_t r = 0, i;
+    for (b = 0; b < nProc; b++) {
+      for (i = 0; i < blocks[b].records.size(); i++, r+=2) {
+        names[r].pos      = blocks[b].records[i].qNamePos;
+        names[r].length   = blocks[b].records[i].qNameLength;
+        names[r+1].pos    = blocks[b].records[i].tNamePos;
+        names[r+1].length = blocks[b].records[i].tNameLength;
+      }
+    }
+    CompareRM4Names compareNames(&buffer[0]);
+    sort(names.begin(), names.end(), compareNames);
+    names.erase(unique(names.begin(), names.end(), EqualRM4Names(&buffer[0])), names.end());
+
+    UInt nReads = names.size();
+    readNames.resize(nReads);
+    subreadBegin.resize(nReads);
+    readLength.resize(nReads);
+    fullReadLength.resize(nReads, 0);
+    readRemoved.resize(nReads, false);
+    for (r = 0; r < nReads; r++) {
+      readNames[r].assign(&buffer[names[r].pos], names[r].length);
+      UInt subreadEnd;
+      if (PBReadNameParser::GetReadCoordinatesFromReadName(readNames[r], subreadBegin[r], subreadEnd) == false) {
+        cout << "Malformatted subread name " << readNames[r] << endl;
+        exit(1);
+      }
+      readLength[r] = subreadEnd - subreadBegin[r];
+    }
+
+    //
+    // Store the overlaps in the order of the file, then sort them
+    // keeping the first of any repeated pair of reads.  An rm4 file of
+    // all against all alignments has each pair twice, once with each
+    // read as the query, and both describe the same overlap, so an
+    // overlap is stored with the lower read id as q whichever read was
+    // the query, and a pair is stored once.
+    //
+    overlaps.reserve(nRecords);
+    for (b = 0; b < nProc; b++) {
+      for (i = 0; i < blocks[b].records.size(); i++) {
+        RM4Record &rec = blocks[b].records[i];
+        RM4NameRef qRef, tRef;
+        qRef.pos = rec.qNamePos; qRef.length = rec.qNameLength;
+        tRef.pos = rec.tNamePos; tRef.length = rec.tNameLength;
+        UInt q = lower_bound(names.begin(), names.end(), qRef, compareNames) - names.begin();
+        UInt t = lower_bound(names.begin(), names.end(), tRef, compareNames) - names.begin();
+        if (fullReadLength[q] == 0) {
+          fullReadLength[q] = rec.qLength;
+        }
+        if (fullReadLength[t] == 0) {
+          fullReadLength[t] = rec.tLength;
+        }
+        if (q == t) {
+          //
+          // This is a self-alignment.  Don't try and assemble the read.
+          //
+          continue;
+        }
+        CompactOverlap ovp;
+        ovp.q = q;
+        ovp.t = t;
+        ovp.removed = false;
+        ovp.sameStrand = (rec.qStrand == rec.tStrand);
+        SetForwardPositionsRelativeToSubread(q, rec.qBegin, rec.qEnd, (Strand) rec.qStrand, ovp.qAlnBegin, ovp.qAlnEnd);
+        SetForwardPositionsRelativeToFullread(t, rec.tBegin, rec.tEnd, (Strand) rec.tStrand, ovp.tAlnBegin, ovp.tAlnEnd);
+        if (ovp.q > ovp.t) {
+          swap(ovp.q, ovp.t);
+          swap(ovp.qAlnBegin, ovp.tAlnBegin);
+          swap(ovp.qAlnEnd, ovp.tAlnEnd);
+        }
+        overlaps.push_back(ovp);
+      }
+      vector<RM4Record>().swap(blocks[b].records);
+    }
+    stable_sort(overlaps.begin(), overlaps.end());
+    overlaps.erase(unique(overlaps.begin(), overlaps.end()), overlaps.end());
+
+    BuildAdjacency();
+    BuildNodes();
+    for (r = 0; r < nReads; r++) {
+      ComputeCoverage(r);
+    }
+  }
+
+  void SetForwardPositionsRelativeToSubread(UInt r, UInt fullReadAlnBegin, UInt fullReadAlnEnd, Strand alnStrand,
+                                            UInt &alnBegin, UInt &alnEnd) {
+    if (alnStrand == Forward) {
+      alnBegin = fullReadAlnBegin - subreadBegin[r];
+      alnEnd   = fullReadAlnEnd - subreadBegin[r];
+    }
+    else {
+      alnEnd   = fullReadLength[r] - fullReadAlnBegin - 1 - subreadBegin[r];
+      alnBegin = fullReadLength[r] - fullReadAlnEnd - 1 - subreadBegin[r];
+    }
+  }
+
+  void SetForwardPositionsRelativeToFullread(UInt r, UInt fullReadAlnBegin, UInt fullReadAlnEnd, Strand alnStrand,
+                                             UInt &alnBegin, UInt &alnEnd) {
+    if (alnStrand == Forward) {
+      alnBegin = fullReadAlnBegin;
+      alnEnd   = fullReadAlnEnd;
+    }
+    else {
+      alnBegin = readLength[r] - fullReadAlnEnd;
+      alnEnd   = readLength[r] - fullReadAlnBegin;
+    }
+  }
+
+  void BuildAdjacency() {
+    UInt nReads = NumReads();
+    UInt o, r;
+    adjOffsets.assign(nReads + 1, 0);
+    for (o = 0; o < overlaps.size(); o++) {
+      adjOffsets[overlaps[o].q + 1]++;
+      adjOffsets[overlaps[o].t + 1]++;
+    }
+    for (r = 0; r < nReads; r++) {
+      adjOffsets[r+1] += adjOffsets[r];
+    }
+    adjacency.resize(adjOffsets[nReads]);
+    vector<UInt> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+    for (o = 0; o < overlaps.size(); o++) {
+      adjacency[fill[overlaps[o].q]++] = o;
+      adjacency[fill[overlaps[o].t]++] = o;
+    }
+  }
+
+  //
+  // A read has nodes at its ends and at the ends of each of its
+  // overlaps.
+  //
+  void BuildNodes() {
+    UInt nReads = NumReads();
+    UInt r, a;
+    nodeOffsets.resize(nReads + 1);
+    nodePos.clear();
+    nodePos.reserve(2*nReads + 2*adjacency.size());
+    nodeRead.clear();
+    for (r = 0; r < nReads; r++) {
+      nodeOffsets[r] = nodePos.size();
+      if (readLength[r] > 0) {
+        nodePos.push_back(0);
+        nodePos.push_back(readLength[r]);
+      }
+      for (a = adjOffsets[r]; a < adjOffsets[r+1]; a++) {
+        CompactOverlap &ovp = overlaps[adjacency[a]];
+        if (ovp.q == r) {
+          nodePos.push_back(ovp.qAlnBegin);
+          nodePos.push_back(ovp.qAlnEnd);
+        }
+        else {
+          nodePos.push_back(ovp.tAlnBegin);
+          nodePos.push_back(ovp.tAlnEnd);
+        }
+      }
+      sort(nodePos.begin() + nodeOffsets[r], nodePos.end());
+      nodePos.erase(unique(nodePos.begin() + nodeOffsets[r], nodePos.end()), nodePos.end());
+      nodeRead.resize(nodePos.size(), r);
+    }
+    nodeOffsets[nReads] = nodePos.size();
+    nodeCoverage.resize(nodePos.size());
+
+    UInt o;
+    for (o = 0; o < overlaps.size(); o++) {
+      CompactOverlap &ovp = overlaps[o];
+      ovp.qBeginNode = FindNode(ovp.q, ovp.qAlnBegin);
+      ovp.qEndNode   = FindNode(ovp.q, ovp.qAlnEnd);
+      ovp.tBeginNode = FindNode(ovp.t, ovp.tAlnBegin);
+      ovp.tEndNode   = FindNode(ovp.t, ovp.tAlnEnd);
+    }
+  }
+
+  //
+  // The coverage of a node is that of the interval from it to the
+  // next node: one for the read itself, plus one for each overlap
+  // that has not been removed and spans the interval.
+  //
+  void ComputeCoverage(UInt r) {
+    UInt nodesBegin = nodeOffsets[r], nodesEnd = nodeOffsets[r+1];
+    UInt n, a;
+    for (n = nodesBegin; n < nodesEnd; n++) {
+      nodeCoverage[n] = 0;
+    }
+    if (nodesBegin == nodesEnd) {
+      return;
+    }
+    nodeCoverage[nodesBegin] = 1;
+    for (a = adjOffsets[r]; a < adjOffsets[r+1]; a++) {
+      CompactOverlap &ovp = overlaps[adjacency[a]];
+      if (ovp.removed) {
+        continue;
+      }
+      UInt beginNode = (ovp.q == r ? ovp.qBeginNode : ovp.tBeginNode);
+      UInt endNode   = (ovp.q == r ? ovp.qEndNode : ovp.tEndNode);
+      if (beginNode < endNode) {
+        nodeCoverage[beginNode]++;
+        nodeCoverage[endNode]--;
+      }
+    }
+    for (n = nodesBegin + 1; n < nodesEnd; n++) {
+      nodeCoverage[n] += nodeCoverage[n-1];
+    }
+  }
+
+  bool IsLowCoverage(UInt r, UInt minCoverage) {
+    UInt n;
+    if (nodeOffsets[r+1] - nodeOffsets[r] <= 1) {
+      //
+      // Do not do anything with singleton reads.
+      //
+      return false;
+    }
+    for (n = nodeOffsets[r]; n < nodeOffsets[r+1]; n++) {
+      if (nodeCoverage[n] >= minCoverage) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //
+  // Repeatedly remove reads that have low coverage everywhere, along
+  // with their overlaps, until no more are removed.  Reads found in
+  // one pass are removed together.
+  //
+  void RemoveLowCoverage(int minCoverage) {
+    UInt nReads = NumReads();
+    UInt r, a;
+    bool graphIsModified = true;
+    int iter = 1;
+    vector<UInt> removedReads, changedReads;
+    vector<bool> changed(nReads, false);
+    while (graphIsModified) {
+      removedReads.clear();
+      for (r = 0; r < nReads; r++) {
+        if (readRemoved[r] == false and IsLowCoverage(r, minCoverage)) {
+          removedReads.push_back(r);
+        }
+      }
+      changedReads.clear();
+      for (r = 0; r < removedReads.size(); r++) {
+        UInt read = removedReads[r];
+        readRemoved[read] = true;
+        for (a = adjOffsets[read]; a < adjOffsets[read+1]; a++) {
+          CompactOverlap &ovp = overlaps[adjacency[a]];
+          if (ovp.removed) {
+            continue;
+          }
+          ovp.removed = true;
+          UInt other = (ovp.q == read ? ovp.t : ovp.q);
+          if (changed[other] == false) {
+            changed[other] = true;
+            changedReads.push_back(other);
+          }
+        }
+      }
+      for (r = 0; r < changedReads.size(); r++) {
+        ComputeCoverage(changedReads[r]);
+        changed[changedReads[r]] = false;
+      }
+      graphIsModified = (removedReads.size() > 0);
+      cout << "iter " << iter << " removed " << removedReads.size() << endl;
+      ++iter;
+    }
+  }
+
+  //
+  // Join the nodes at corresponding positions of each remaining
+  // overlap into supernodes: the ends of the overlap, and the nodes
+  // inside it that are the same distance from its start in both
+  // reads.  When the reads align on opposite strands, the start of
+  // the query corresponds to the end of the target.
+  //
+  void MergeOverlaps() {
+    supernodes.Initialize(NumNodes());
+    UInt o;
+    for (o = 0; o < overlaps.size(); o++) {
+      CompactOverlap &ovp = overlaps[o];
+      if (ovp.removed) {
+        continue;
+      }
+      UInt qn = ovp.qBeginNode, qEnd = ovp.qEndNode;
+      if (ovp.sameStrand) {
+        UInt tn = ovp.tBeginNode, tEnd = ovp.tEndNode;
+        while (qn <= qEnd and tn <= tEnd) {
+          UInt qOffset = nodePos[qn] - ovp.qAlnBegin;
+          UInt tOffset = nodePos[tn] - ovp.tAlnBegin;
+          if (qOffset == tOffset) {
+            supernodes.Union(qn, tn);
+            ++qn; ++tn;
+          }
+          else if (qOffset < tOffset) {
+            ++qn;
+          }
+          else {
+            ++tn;
+          }
+        }
+      }
+      else {
+        //
+        // Walk the target from its end.
+        //
+        UInt tn = ovp.tEndNode + 1, tBegin = ovp.tBeginNode;
+        while (qn <= qEnd and tn > tBegin) {
+          UInt qOffset = nodePos[qn] - ovp.qAlnBegin;
+          UInt tOffset = ovp.tAlnEnd - nodePos[tn-1];
+          if (qOffset == tOffset) {
+            supernodes.Union(qn, tn-1);
+            ++qn; --tn;
+          }
+          else if (qOffset < tOffset) {
+            ++qn;
+          }
+          else {
+            --tn;
+          }
+        }
+      }
+    }
+  }
+
+  bool IsSupernode(UInt n) {
+    return readRemoved[nodeRead[n]] == false and supernodes.SetSize(n) > 1;
+  }
+
+  UInt CountSupernodes() {
+    UInt n, nSupernodes = 0;
+    for (n = 0; n < NumNodes(); n++) {
+      if (IsSupernode(n) and supernodes.Find(n) == n) {
+        nSupernodes++;
+      }
+    }
+    return nSupernodes;
+  }
+
+  //
+  // A supernode is consistent if the nodes that follow its nodes in
+  // their reads all belong to one supernode.
+  //
+  UInt CountConsistentSupernodes() {
+    vector<pair<UInt, UInt> > nextSuper;
+    UInt r, n;
+    for (r = 0; r < NumReads(); r++) {
+      if (readRemoved[r]) {
+        continue;
+      }
+      for (n = nodeOffsets[r]; n + 1 < nodeOffsets[r+1]; n++) {
+        if (IsSupernode(n) and IsSupernode(n+1)) {
+          nextSuper.push_back(pair<UInt, UInt>(supernodes.Find(n), supernodes.Find(n+1)));
+        }
+      }
+    }
+    sort(nextSuper.begin(), nextSuper.end());
+    nextSuper.erase(unique(nextSuper.begin(), nextSuper.end()), nextSuper.end());
+    UInt i, numConsistent = 0;
+    for (i = 0; i < nextSuper.size(); i++) {
+      if ((i == 0 or nextSuper[i-1].first != nextSuper[i].first) and
+          (i + 1 == nextSuper.size() or nextSuper[i+1].first != nextSuper[i].first)) {
+        numConsistent++;
+      }
+    }
+    return numConsistent;
+  }
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "CompactRGraph.h"
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+//
+// An all against all rm4 file has every overlap twice, once with each
+// read as the query.  The graph must store each pair once, the same
+// with any number of parsing threads, and count each overlap once in
+// the coverage of a read.  Two reads may have several distinct
+// alignments, which are all kept.
+//
+
+int nFailed = 0;
+
+void Check(bool condition, const char *message) {
+  if (condition == false) {
+    cout << "FAILED: " << message << endl;
+    ++nFailed;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  string rm4FileName = "bin/testCompactRGraph.rm4";
+  ofstream rm4(rm4FileName.c_str());
+  rm4 << "m/1/0_1000 m/2/0_1000 -2000 99.0 0 500 1000 1000 0 0 500 1000" << endl
+      << "m/3/0_1000 m/1/0_1000 -2000 99.0 0 0 500 1000 0 500 1000 1000" << endl
+      << "m/2/0_1000 m/1/0_1000 -2000 99.0 0 0 500 1000 0 500 1000 1000" << endl
+      << "m/1/0_1000 m/3/0_1000 -2000 99.0 0 500 1000 1000 0 0 500 1000" << endl
+      << "m/1/0_1000 m/1/0_1000 -5000 100.0 0 0 1000 1000 0 0 1000 1000" << endl
+      << "m/1/0_1000 m/4/0_1000 -1500 99.0 0 0 300 1000 0 700 1000 1000" << endl
+      << "m/1/0_1000 m/4/0_1000 -1000 99.0 0 0 200 1000 1 100 300 1000" << endl
+      << "m/4/0_1000 m/1/0_1000 -1000 99.0 0 700 900 1000 1 800 1000 1000" << endl
+      << "m/4/0_1000 m/1/0_1000 -1500 99.0 0 700 1000 1000 0 0 300 1000" << endl;
+  rm4.close();
+
+  int nProc;
+  for (nProc = 1; nProc <= 3; nProc++) {
+    CompactRGraph rGraph;
+    rGraph.BuildFromRM4(rm4FileName, nProc);
+    Check(rGraph.NumReads() == 4, "four reads");
+    Check(rGraph.overlaps.size() == 4, "each alignment of a pair of reads is stored once");
+    if (rGraph.overlaps.size() != 4) {
+      continue;
+    }
+    CompactOverlap &ab = rGraph.overlaps[0], &ac = rGraph.overlaps[1];
+    Check(ab.q == 0 and ab.t == 1 and ac.q == 0 and ac.t == 2, "overlaps are stored with the lower read id first");
+    Check(ab.qAlnBegin == 500 and ab.qAlnEnd == 1000 and ab.tAlnBegin == 0 and ab.tAlnEnd == 500,
+          "the first line of a pair is kept");
+    Check(ac.qAlnBegin == 500 and ac.qAlnEnd == 1000 and ac.tAlnBegin == 0 and ac.tAlnEnd == 500,
+          "a pair whose first line has the higher id as query keeps its coordinates with its reads");
+    CompactOverlap &adReverse = rGraph.overlaps[2], &adForward = rGraph.overlaps[3];
+    Check(adReverse.q == 0 and adReverse.t == 3 and adForward.q == 0 and adForward.t == 3,
+          "both alignments of the same two reads are kept");
+    Check(adReverse.sameStrand == false and
+          adReverse.qAlnBegin == 0 and adReverse.qAlnEnd == 200 and
+          adReverse.tAlnBegin == 700 and adReverse.tAlnEnd == 900,
+          "the alignment on the other strand is kept with its own coordinates");
+    Check(adForward.sameStrand == true and
+          adForward.qAlnBegin == 0 and adForward.qAlnEnd == 300 and
+          adForward.tAlnBegin == 700 and adForward.tAlnEnd == 1000,
+          "the alignment on the same strand is kept with its own coordinates");
+    //
+    // Read 1 has nodes at 0, 200, 300, 500 and 1000; from 500 it is
+    // covered by itself and the two reads that overlap it there.
+    //
+    UInt node = rGraph.FindNode(0, 500);
+    Check(rGraph.nodeCoverage[node - 1] == 1 and rGraph.nodeCoverage[node] == 3,
+          "an overlap is counted once in the coverage");
+  }
+  remove(rm4FileName.c_str());
+
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
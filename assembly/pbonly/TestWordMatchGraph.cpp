@@ -0,0 +1,210 @@
+#include "ebruijn/WordMatchGraph.h"
+#include "DNASequence.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <pthread.h>
+
+using namespace std;
+
+//
+// The sets of a ConcurrentUnionFind do not depend on the order in
+// which threads join them, and every set has its smallest element as
+// its parent.  So the graph joined from a SAM file split into ranges
+// for any number of threads must have the same parents as the graph
+// joined by one thread.
+//
+
+int nFailed = 0;
+
+void Check(bool condition, const char *message) {
+  if (condition == false) {
+    cout << "FAILED: " << message << endl;
+    ++nFailed;
+  }
+}
+
+class UnionThreadData {
+ public:
+  ConcurrentUnionFind *sets;
+  vector<UInt> *a, *b;
+  UInt start, end;
+};
+
+void* UnionPairs(void *data) {
+  UnionThreadData *threadData = (UnionThreadData*) data;
+  UInt i;
+  for (i = threadData->start; i < threadData->end; i++) {
+    threadData->sets->Union((*threadData->a)[i], (*threadData->b)[i]);
+  }
+  return NULL;
+}
+
+void TestConcurrentUnionFind() {
+  UInt nElements = 100000, nPairs = 60000;
+  vector<UInt> a(nPairs), b(nPairs);
+  UInt i;
+  for (i = 0; i < nPairs; i++) {
+    a[i] = rand() % nElements;
+    b[i] = rand() % nElements;
+  }
+  ConcurrentUnionFind serial, threaded;
+  serial.Initialize(nElements);
+  for (i = 0; i < nPairs; i++) {
+    serial.Union(a[i], b[i]);
+  }
+  threaded.Initialize(nElements);
+  int nProc = 4, t;
+  vector<UnionThreadData> threadData(nProc);
+  vector<pthread_t> threads(nProc);
+  for (t = 0; t < nProc; t++) {
+    threadData[t].sets  = &threaded;
+    threadData[t].a     = &a;
+    threadData[t].b     = &b;
+    threadData[t].start = (nPairs / nProc) * t;
+    threadData[t].end   = (t == nProc - 1 ? nPairs : (nPairs / nProc) * (t + 1));
+    pthread_create(&threads[t], NULL, UnionPairs, &threadData[t]);
+  }
+  for (t = 0; t < nProc; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  serial.Flatten();
+  threaded.Flatten();
+  Check(serial.parent == threaded.parent, "threaded unions give the same parents as serial unions");
+  bool parentsAreSmallest = true;
+  for (i = 0; i < nElements; i++) {
+    if (serial.parent[i] > i or serial.parent[serial.parent[i]] != serial.parent[i]) {
+      parentsAreSmallest = false;
+    }
+  }
+  Check(parentsAreSmallest, "every set has its smallest element as its parent");
+}
+
+//
+// Sample reads from a genome, some from the reverse strand, and
+// write a SAM line for each pair of overlapping reads with a
+// forward target.  The SAM sequence is the query on the genome
+// strand, so queries from the reverse strand are flagged 16.
+//
+void WriteReadsAndAlignments(vector<FASTASequence> &reads, string samFileName) {
+  const char nucs[] = "ACGT";
+  DNALength genomeLength = 30000;
+  string genome(genomeLength, 'A');
+  DNALength i;
+  for (i = 0; i < genomeLength; i++) {
+    genome[i] = nucs[rand() % 4];
+  }
+  int nReads = 60, r, s;
+  vector<DNALength> readStart(nReads), readEnd(nReads);
+  vector<int> readStrand(nReads);
+  reads.resize(nReads);
+  for (r = 0; r < nReads; r++) {
+    DNALength length = 800 + rand() % 1200;
+    readStart[r]  = rand() % (genomeLength - length);
+    readEnd[r]    = readStart[r] + length;
+    readStrand[r] = rand() % 2;
+    DNASequence segment;
+    segment.seq    = (Nucleotide*) &genome[readStart[r]];
+    segment.length = length;
+    if (readStrand[r] == 0) {
+      ((DNASequence*) &reads[r])->Copy(segment);
+    }
+    else {
+      segment.MakeRC(reads[r]);
+    }
+    stringstream title;
+    title << "m/" << r << "/0_" << length;
+    reads[r].CopyTitle(title.str());
+  }
+
+  ofstream samFile(samFileName.c_str());
+  samFile << "@HD\tVN:1.0\tSO:unsorted" << endl;
+  for (r = 0; r < nReads; r++) {
+    samFile << "@SQ\tSN:" << reads[r].title << "\tLN:" << reads[r].length << endl;
+  }
+  for (r = 0; r < nReads; r++) {
+    for (s = 0; s < nReads; s++) {
+      DNALength start = max(readStart[r], readStart[s]);
+      DNALength end   = min(readEnd[r], readEnd[s]);
+      if (readStrand[s] != 0 or start + 200 > end) {
+        continue;
+      }
+      //
+      // A read aligned to itself, or to a read that is not in the list,
+      // is skipped.
+      //
+      string tName = reads[s].title;
+      if (r % 7 == 0 and s % 5 == 0) {
+        tName = "not/a/read";
+      }
+      DNALength overlap = end - start, left = start - readStart[r], right = readEnd[r] - end;
+      DNALength m1 = overlap / 3;
+      stringstream cigar;
+      if (left > 0) {
+        cigar << left << "S";
+      }
+      cigar << m1 << "M3I3D" << overlap - m1 - 3 << "M";
+      if (right > 0) {
+        cigar << right << "S";
+      }
+      samFile << reads[r].title << "\t" << (readStrand[r] == 0 ? 0 : 16) << "\t" << tName << "\t"
+              << start - readStart[s] + 1 << "\t254\t" << cigar.str() << "\t*\t0\t0\t"
+              << genome.substr(readStart[r], readEnd[r] - readStart[r]) << "\t*" << endl;
+    }
+  }
+  samFile << "m/0/0_0\t4\t*\t0\t0\t*\t*\t0\t0\tACGT\t*" << endl;
+  samFile.close();
+}
+
+int main(int argc, char* argv[]) {
+  srand(11);
+  TestConcurrentUnionFind();
+
+  vector<FASTASequence> reads;
+  string samFileName = "bin/testWordMatchGraph.sam";
+  WriteReadsAndAlignments(reads, samFileName);
+
+  WordMatchGraph serial;
+  serial.Initialize(reads, 12);
+  long serialAlignments, serialJoined;
+  JoinAlignments(serial, samFileName, 1, serialAlignments, serialJoined);
+  serial.vertices.Flatten();
+  Check(serialJoined > 0 and serialJoined < serialAlignments, "some but not all alignments are joined");
+  UInt v, nJoined = 0;
+  for (v = 0; v < serial.vertices.Size(); v++) {
+    if (serial.vertices.parent[v] != v) {
+      ++nJoined;
+    }
+  }
+  Check(nJoined > 0, "positions are joined");
+
+  int nProcs[] = {2, 4, 7};
+  int p;
+  for (p = 0; p < 3; p++) {
+    WordMatchGraph threaded;
+    threaded.Initialize(reads, 12);
+    long numAlignments, numJoined;
+    JoinAlignments(threaded, samFileName, nProcs[p], numAlignments, numJoined);
+    threaded.vertices.Flatten();
+    if (numAlignments != serialAlignments or numJoined != serialJoined) {
+      cout << "FAILED: nproc=" << nProcs[p] << " read " << numAlignments << " alignments and joined "
+           << numJoined << " instead of " << serialAlignments << " and " << serialJoined << endl;
+      ++nFailed;
+    }
+    if (threaded.vertices.parent != serial.vertices.parent) {
+      cout << "FAILED: nproc=" << nProcs[p] << " gives different parents than nproc=1" << endl;
+      ++nFailed;
+    }
+  }
+  remove(samFileName.c_str());
+
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
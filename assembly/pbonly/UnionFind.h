@@ -0,0 +1,59 @@
+#ifndef UNION_FIND_H_
+#define UNION_FIND_H_
+
+#include <vector>
+#include <algorithm>
+#include "Types.h"
+
+using namespace std;
+
+//
+// Disjoint sets over the integers 0..n-1, with union by size and path
+// halving.
+//
+class UnionFind {
+ public:
+  vector<UInt> parent;
+  vector<UInt> setSize;
+
+  void Initialize(UInt n) {
+    parent.resize(n);
+    setSize.resize(n);
+    UInt i;
+    for (i = 0; i < n; i++) {
+      parent[i]  = i;
+      setSize[i] = 1;
+    }
+  }
+
+  UInt Find(UInt x) {
+    while (parent[x] != x) {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+    return x;
+  }
+
+  //
+  // Returns true if a and b were in different sets.
+  //
+  bool Union(UInt a, UInt b) {
+    a = Find(a);
+    b = Find(b);
+    if (a == b) {
+      return false;
+    }
+    if (setSize[a] < setSize[b]) {
+      swap(a, b);
+    }
+    parent[b] = a;
+    setSize[a] += setSize[b];
+    return true;
+  }
+
+  UInt SetSize(UInt x) {
+    return setSize[Find(x)];
+  }
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef EBRUIJN_CONCURRENT_UNION_FIND_H_
+#define EBRUIJN_CONCURRENT_UNION_FIND_H_
+
+#include <vector>
+#include "Types.h"
+
+using namespace std;
+
+//
+// A union-find over 0..n-1 that any number of threads may update at
+// once without locks.  A root is only ever linked below a root with a
+// smaller index, by compare-and-swap, so the parent pointers never
+// form a cycle, and Find shortens paths with compare-and-swap as well
+// so that a lost race only leaves a path longer than it could be.
+//
+class ConcurrentUnionFind {
+ public:
+  vector<UInt> parent;
+
+  void Initialize(UInt n) {
+    parent.resize(n);
+    UInt i;
+    for (i = 0; i < n; i++) {
+      parent[i] = i;
+    }
+  }
+
+  UInt Size() {
+    return parent.size();
+  }
+
+  UInt Parent(UInt x) {
+    return *((volatile UInt*) &parent[x]);
+  }
+
+  UInt Find(UInt x) {
+    UInt p;
+    while ((p = Parent(x)) != x) {
+      UInt gp = Parent(p);
+      if (gp != p) {
+        __sync_bool_compare_and_swap(&parent[x], p, gp);
+      }
+      x = p;
+    }
+    return x;
+  }
+
+  //
+  // Returns true if a and b were in different sets.
+  //
+  bool Union(UInt a, UInt b) {
+    while (true) {
+      a = Find(a);
+      b = Find(b);
+      if (a == b) {
+        return false;
+      }
+      if (a < b) {
+        UInt t = a; a = b; b = t;
+      }
+      if (__sync_bool_compare_and_swap(&parent[a], a, b)) {
+        return true;
+      }
+    }
+  }
+
+  //
+  // Point every element directly at its root.  An element is always
+  // below a smaller index, so one pass in order suffices.  This is not
+  // safe to call while other threads are joining sets.
+  //
+  void Flatten() {
+    UInt i;
+    for (i = 0; i < parent.size(); i++) {
+      parent[i] = parent[parent[i]];
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef EBRUIJN_READ_NAME_TABLE_H_
+#define EBRUIJN_READ_NAME_TABLE_H_
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "FASTASequence.h"
+
+using namespace std;
+
+//
+// An open addressing hash table from read title to index in the list
+// of reads.  Titles are not copied, so the reads must outlive the
+// table.  Lookups do not modify the table, so any number of threads
+// may look up names at once.
+//
+class ReadNameTable {
+ public:
+  vector<const char*> names;
+  vector<int> nameLengths;
+  vector<int> slots;
+  unsigned int mask;
+
+  static unsigned int Hash(const char *name, int length) {
+    unsigned int h = 2166136261U;
+    int i;
+    for (i = 0; i < length; i++) {
+      h = (h ^ (unsigned char) name[i]) * 16777619U;
+    }
+    return h;
+  }
+
+  //
+  // If a title appears more than once, the last read with it is used.
+  //
+  void Initialize(vector<FASTASequence> &reads) {
+    unsigned int nSlots = 16;
+    while (nSlots < 2*reads.size()) {
+      nSlots *= 2;
+    }
+    mask = nSlots - 1;
+    slots.assign(nSlots, -1);
+    names.resize(reads.size());
+    nameLengths.resize(reads.size());
+    int r;
+    for (r = 0; r < reads.size(); r++) {
+      names[r]       = reads[r].title;
+      nameLengths[r] = (reads[r].title == NULL ? 0 : strlen(reads[r].title));
+      unsigned int s = Hash(names[r], nameLengths[r]) & mask;
+      while (slots[s] != -1 and
+             (nameLengths[slots[s]] != nameLengths[r] or
+              memcmp(names[slots[s]], names[r], nameLengths[r]) != 0)) {
+        s = (s + 1) & mask;
+      }
+      slots[s] = r;
+    }
+  }
+
+  //
+  // Returns the index of the read, or -1 if there is none by this name.
+  //
+  int Lookup(const char *name, int length) const {
+    unsigned int s = Hash(name, length) & mask;
+    while (slots[s] != -1) {
+      int r = slots[s];
+      if (nameLengths[r] == length and memcmp(names[r], name, length) == 0) {
+        return r;
+      }
+      s = (s + 1) & mask;
+    }
+    return -1;
+  }
+
+  int Lookup(const string &name) const {
+    return Lookup(name.c_str(), name.size());
+  }
+};
+
+#endif
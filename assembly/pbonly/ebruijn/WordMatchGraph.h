@@ -0,0 +1,272 @@
+#ifndef EBRUIJN_WORD_MATCH_GRAPH_H_
+#define EBRUIJN_WORD_MATCH_GRAPH_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include "FASTASequence.h"
+#include "utils.h"
+#include "algorithms/alignment/readers/BinaryAlignmentReader.h"
+#include "datastructures/alignmentset/SAMAlignment.h"
+#include "datastructures/alignmentset/SAMToAlignmentCandidateAdapter.h"
+#include "datastructures/alignment/AlignmentCandidate.h"
+#include "ReadNameTable.h"
+#include "ConcurrentUnionFind.h"
+
+using namespace std;
+
+//
+// Vertices of the graph are read positions: position p of read r is
+// vertex readStart[r] + p.  Positions that are in matching blocks of
+// at least vertexSize bases are joined across each alignment.
+//
+class WordMatchGraph {
+ public:
+  vector<FASTASequence> *reads;
+  vector<UInt> readStart;
+  ReadNameTable readNames;
+  ConcurrentUnionFind vertices;
+  int vertexSize;
+
+  void Initialize(vector<FASTASequence> &readsP, int vertexSizeP) {
+    reads = &readsP;
+    vertexSize = vertexSizeP;
+    readNames.Initialize(readsP);
+    readStart.resize(readsP.size() + 1);
+    readStart[0] = 0;
+    int r;
+    for (r = 0; r < readsP.size(); r++) {
+      if (readStart[r] + (unsigned long) readsP[r].length > (UInt) -1) {
+        cout << "ERROR. There are too many bases in the reads to build a graph." << endl;
+        exit(1);
+      }
+      readStart[r+1] = readStart[r] + readsP[r].length;
+    }
+    vertices.Initialize(readStart[readsP.size()]);
+  }
+
+  //
+  // Join the positions of each block of vertexSize or more matches.
+  // Block positions are relative to qAlnStart and tAlnStart, which
+  // are on the reverse complement of a read with strand 1.  Returns
+  // false if a block runs off the end of a read, in which case the
+  // rest of the alignment is skipped.
+  //
+  bool JoinVertices(int qIndex, DNALength qAlnStart, int qStrand,
+                    int tIndex, DNALength tAlnStart, int tStrand,
+                    Block *blocks, int nBlocks) {
+    DNALength qLength = (*reads)[qIndex].length;
+    DNALength tLength = (*reads)[tIndex].length;
+    int b;
+    for (b = 0; b < nBlocks; b++) {
+      if (blocks[b].length < vertexSize) {
+        continue;
+      }
+      DNALength qPos = qAlnStart + blocks[b].qPos;
+      DNALength tPos = tAlnStart + blocks[b].tPos;
+      if (qPos + blocks[b].length > qLength or tPos + blocks[b].length > tLength) {
+        return false;
+      }
+      UInt qVertex, tVertex;
+      int  qStep, tStep;
+      if (qStrand == 0) {
+        qVertex = readStart[qIndex] + qPos; qStep = 1;
+      }
+      else {
+        qVertex = readStart[qIndex] + qLength - qPos - 1; qStep = -1;
+      }
+      if (tStrand == 0) {
+        tVertex = readStart[tIndex] + tPos; tStep = 1;
+      }
+      else {
+        tVertex = readStart[tIndex] + tLength - tPos - 1; tStep = -1;
+      }
+      DNALength bi;
+      for (bi = 0; bi < blocks[b].length; bi++, qVertex += qStep, tVertex += tStep) {
+        vertices.Union(qVertex, tVertex);
+      }
+    }
+    return true;
+  }
+
+  //
+  // Alignments of a read to itself (or to a read that is not in the
+  // list) are not used.
+  //
+  bool JoinVertices(const char *qName, int qNameLength, DNALength qAlnStart, int qStrand,
+                    const char *tName, int tNameLength, DNALength tAlnStart, int tStrand,
+                    Block *blocks, int nBlocks) {
+    int qIndex = readNames.Lookup(qName, qNameLength);
+    int tIndex = readNames.Lookup(tName, tNameLength);
+    if (qIndex == -1 or tIndex == -1 or qIndex == tIndex) {
+      return false;
+    }
+    return JoinVertices(qIndex, qAlnStart, qStrand, tIndex, tAlnStart, tStrand, blocks, nBlocks);
+  }
+};
+
+//
+// Alignments are read by nproc threads.  A SAM file is split into
+// byte ranges, and each thread reads the lines that start in its
+// range with its own stream.  A binary (blasr -m 7) file is mapped
+// once, and threads take batches of records from the shared reader.
+//
+class JoinThreadData {
+ public:
+  WordMatchGraph *graph;
+  string alignmentsFileName;
+  long start, end;
+  BinaryAlignmentReader *binaryReader;
+  pthread_mutex_t *readerMutex;
+  long numAlignments, numJoined;
+};
+
+void* JoinSAMAlignments(void *data) {
+  JoinThreadData *threadData = (JoinThreadData*) data;
+  WordMatchGraph &graph = *threadData->graph;
+  ifstream samFile;
+  CrucialOpen(threadData->alignmentsFileName, samFile, std::ios::in);
+  samFile.seekg(threadData->start);
+  string line;
+  if (threadData->start > 0) {
+    //
+    // Skip the line that began in the previous range, unless this
+    // range begins with a line.
+    //
+    samFile.seekg(threadData->start - 1);
+    getline(samFile, line);
+  }
+  SAMAlignment samAlignment;
+  vector<AlignmentCandidate<> > alignments;
+  while (samFile.tellg() < threadData->end and getline(samFile, line)) {
+    if (line.size() == 0 or line[0] == '@') {
+      continue;
+    }
+    samAlignment.StoreValues(line);
+    //
+    // The reads are looked up once per line, and the target read is
+    // also the reference of the candidates.
+    //
+    int qIndex = graph.readNames.Lookup(samAlignment.qName);
+    int tIndex = graph.readNames.Lookup(samAlignment.rName);
+    if (qIndex == -1 or tIndex == -1 or qIndex == tIndex) {
+      ++threadData->numAlignments;
+      continue;
+    }
+    alignments.clear();
+    SAMAlignmentsToCandidates(samAlignment,
+                              (*graph.reads)[tIndex],
+                              alignments, false, true);
+    int a;
+    for (a = 0; a < alignments.size(); a++) {
+      ++threadData->numAlignments;
+      if (alignments[a].blocks.size() > 0 and
+          graph.JoinVertices(qIndex, alignments[a].qAlignedSeqPos + alignments[a].qPos, alignments[a].qStrand,
+                             tIndex, alignments[a].tAlignedSeqPos + alignments[a].tPos, alignments[a].tStrand,
+                             &alignments[a].blocks[0], alignments[a].blocks.size())) {
+        ++threadData->numJoined;
+      }
+    }
+  }
+  return NULL;
+}
+
+void* JoinBinaryAlignments(void *data) {
+  JoinThreadData *threadData = (JoinThreadData*) data;
+  WordMatchGraph &graph = *threadData->graph;
+  const int batchSize = 1024;
+  vector<BinaryAlignmentRecord> records(batchSize);
+  while (true) {
+    int nRecords = 0;
+    pthread_mutex_lock(threadData->readerMutex);
+    while (nRecords < batchSize and threadData->binaryReader->GetNext(records[nRecords])) {
+      ++nRecords;
+    }
+    pthread_mutex_unlock(threadData->readerMutex);
+    if (nRecords == 0) {
+      break;
+    }
+    int r;
+    for (r = 0; r < nRecords; r++) {
+      BinaryAlignmentRecordHeader *h = records[r].header;
+      ++threadData->numAlignments;
+      if (graph.JoinVertices(records[r].qName, h->qNameLength, h->qAlignedSeqPos + h->qPos, h->qStrand,
+                             records[r].tName, h->tNameLength, h->tAlignedSeqPos + h->tPos, h->tStrand,
+                             records[r].blocks, h->nBlocks)) {
+        ++threadData->numJoined;
+      }
+    }
+  }
+  return NULL;
+}
+
+bool IsBinaryAlignmentFile(string &fileName) {
+  ifstream in;
+  CrucialOpen(fileName, in, std::ios::in | std::ios::binary);
+  BinaryAlignmentFileHeader header;
+  if (in.read((char*) &header, sizeof(header)) and header.IsValid()) {
+    return true;
+  }
+  return false;
+}
+
+//
+// Join the matching positions of every alignment in
+// alignmentsFileName, SAM or binary, on nProc threads.
+//
+void JoinAlignments(WordMatchGraph &graph, string &alignmentsFileName, int nProc,
+                    long &numAlignments, long &numJoined) {
+  vector<JoinThreadData> threadData(nProc);
+  vector<pthread_t> threads(nProc);
+  BinaryAlignmentReader binaryReader;
+  pthread_mutex_t readerMutex;
+  pthread_mutex_init(&readerMutex, NULL);
+  bool isBinary = IsBinaryAlignmentFile(alignmentsFileName);
+  long fileSize = 0;
+  if (isBinary) {
+    if (binaryReader.Initialize(alignmentsFileName) == 0) {
+      exit(1);
+    }
+  }
+  else {
+    ifstream samFile;
+    CrucialOpen(alignmentsFileName, samFile, std::ios::in);
+    samFile.seekg(0, std::ios::end);
+    fileSize = samFile.tellg();
+  }
+  int t;
+  for (t = 0; t < nProc; t++) {
+    threadData[t].graph              = &graph;
+    threadData[t].alignmentsFileName = alignmentsFileName;
+    threadData[t].start              = (fileSize / nProc) * t;
+    threadData[t].end                = (t == nProc - 1 ? fileSize : (fileSize / nProc) * (t + 1));
+    threadData[t].binaryReader       = &binaryReader;
+    threadData[t].readerMutex        = &readerMutex;
+    threadData[t].numAlignments      = threadData[t].numJoined = 0;
+  }
+  if (nProc == 1) {
+    if (isBinary) {
+      JoinBinaryAlignments(&threadData[0]);
+    }
+    else {
+      JoinSAMAlignments(&threadData[0]);
+    }
+  }
+  else {
+    for (t = 0; t < nProc; t++) {
+      pthread_create(&threads[t], NULL, (isBinary ? JoinBinaryAlignments : JoinSAMAlignments), &threadData[t]);
+    }
+    for (t = 0; t < nProc; t++) {
+      pthread_join(threads[t], NULL);
+    }
+  }
+  numAlignments = numJoined = 0;
+  for (t = 0; t < nProc; t++) {
+    numAlignments += threadData[t].numAlignments;
+    numJoined     += threadData[t].numJoined;
+  }
+  pthread_mutex_destroy(&readerMutex);
+}
+
+#endif
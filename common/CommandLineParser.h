@@ -179,7 +179,8 @@ class CommandLineParser {
 			return 0;
 		}
 		else {
-			return str[0] == '-';
+			// A lone '-' is standard input, not an option.
+			return str[0] == '-' and len > 1;
 		}
 	}
 
@@ -0,0 +1,465 @@
+#ifndef FASTX_STREAM_READER_H_
+#define FASTX_STREAM_READER_H_
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <zlib.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <iostream>
+
+#include "FASTASequence.h"
+#include "FASTQSequence.h"
+#include "NucConversion.h"
+
+using namespace std;
+
+//
+// Reads FASTA or FASTQ records from a stream rather than from a
+// memory mapped file, so that reads may come from a pipe ("-" is
+// standard input) or from a gzip or BGZF compressed file.  A helper
+// thread reads and inflates the input into large blocks while the
+// records of the previous blocks are parsed, and record boundaries are
+// found with memchr over the blocks.  Input that is not compressed is
+// passed through by zlib unchanged.
+//
+// The format is taken from the first record ('>' or '@'), and FASTQ
+// records are expected to have one line of sequence and one line of
+// quality values, as for FASTQReader.  The helper thread is not started
+// until the first record is read, so the reader may be opened and
+// closed without consuming standard input (as when writing headers).
+//
+class FASTXStreamReader {
+ public:
+	enum { BlockSize = 4*1024*1024, NumBlocks = 4 };
+
+ private:
+	string fileName;
+	int    fileDes;
+	gzFile gzIn;
+	bool   started;
+
+	//
+	// Blocks shared with the inflate thread.
+	//
+	pthread_t       inflateThread;
+	pthread_mutex_t blockMutex;
+	pthread_cond_t  blockReady;
+	deque<vector<char>*> filledBlocks, emptyBlocks;
+	bool endOfInput, inputError, stopInflating;
+
+	//
+	// The unparsed input, buffer[bufStart, bufEnd).
+	//
+	vector<char> buffer;
+	long bufStart, bufEnd;
+	bool bufferHasAllInput;
+	char recordStart;
+	char *convMat;
+
+	static void* InflateBlocks(void *readerPtr) {
+		FASTXStreamReader *reader = (FASTXStreamReader*) readerPtr;
+		while (true) {
+			vector<char> *block;
+			pthread_mutex_lock(&reader->blockMutex);
+			while (reader->emptyBlocks.size() == 0 and reader->stopInflating == false) {
+				pthread_cond_wait(&reader->blockReady, &reader->blockMutex);
+			}
+			if (reader->stopInflating) {
+				pthread_mutex_unlock(&reader->blockMutex);
+				return NULL;
+			}
+			block = reader->emptyBlocks.front();
+			reader->emptyBlocks.pop_front();
+			pthread_mutex_unlock(&reader->blockMutex);
+
+			block->resize(BlockSize);
+			int nRead = gzread(reader->gzIn, &(*block)[0], BlockSize);
+			block->resize(nRead > 0 ? nRead : 0);
+
+			pthread_mutex_lock(&reader->blockMutex);
+			if (nRead > 0) {
+				reader->filledBlocks.push_back(block);
+			}
+			else {
+				reader->emptyBlocks.push_back(block);
+				reader->endOfInput = true;
+				reader->inputError = (nRead < 0);
+			}
+			pthread_cond_broadcast(&reader->blockReady);
+			pthread_mutex_unlock(&reader->blockMutex);
+			if (nRead <= 0) {
+				return NULL;
+			}
+		}
+	}
+
+	void Start() {
+		int i;
+		for (i = 0; i < NumBlocks; i++) {
+			emptyBlocks.push_back(new vector<char>);
+		}
+		gzIn = gzdopen(fileDes, "rb");
+		if (gzIn == NULL) {
+			cout << "ERROR, could not read " << fileName << endl;
+			exit(1);
+		}
+		gzbuffer(gzIn, 1024*1024);
+		endOfInput = inputError = stopInflating = false;
+		pthread_create(&inflateThread, NULL, InflateBlocks, this);
+		started = true;
+	}
+
+	//
+	// Move the unparsed input to the start of the buffer and append the
+	// next block of input.  Returns false when all input is buffered.
+	//
+	bool Refill() {
+		if (bufferHasAllInput) {
+			return false;
+		}
+		if (started == false) {
+			Start();
+		}
+		vector<char> *block = NULL;
+		pthread_mutex_lock(&blockMutex);
+		while (filledBlocks.size() == 0 and endOfInput == false) {
+			pthread_cond_wait(&blockReady, &blockMutex);
+		}
+		if (filledBlocks.size() > 0) {
+			block = filledBlocks.front();
+			filledBlocks.pop_front();
+		}
+		pthread_mutex_unlock(&blockMutex);
+
+		if (block == NULL) {
+			if (inputError) {
+				cout << "ERROR, could not decompress " << fileName << endl;
+				exit(1);
+			}
+			bufferHasAllInput = true;
+			return false;
+		}
+		long nUnparsed = bufEnd - bufStart;
+		if (nUnparsed > 0 and bufStart > 0) {
+			memmove(&buffer[0], &buffer[bufStart], nUnparsed);
+		}
+		if (buffer.size() < nUnparsed + block->size()) {
+			buffer.resize(nUnparsed + block->size());
+		}
+		memcpy(&buffer[nUnparsed], &(*block)[0], block->size());
+		bufStart = 0;
+		bufEnd   = nUnparsed + block->size();
+
+		pthread_mutex_lock(&blockMutex);
+		emptyBlocks.push_back(block);
+		pthread_cond_broadcast(&blockReady);
+		pthread_mutex_unlock(&blockMutex);
+		return true;
+	}
+
+	static bool IsSpace(char c) {
+		return (c == ' ' or c == '\t' or c == '\n' or c == '\r');
+	}
+
+	//
+	// Move to the start of the next record.  Returns false at the end
+	// of the input.
+	//
+	bool SkipToRecord() {
+		while (true) {
+			while (bufStart < bufEnd and IsSpace(buffer[bufStart])) {
+				bufStart++;
+			}
+			if (bufStart < bufEnd) {
+				break;
+			}
+			if (Refill() == false) {
+				return false;
+			}
+		}
+		if (recordStart == 0) {
+			recordStart = buffer[bufStart];
+		}
+		if (buffer[bufStart] != recordStart or (recordStart != '>' and recordStart != '@')) {
+			cout << "ERROR, " << fileName << " is not a FASTA or FASTQ file, a record "
+					 << "begins with \"" << buffer[bufStart] << "\"" << endl;
+			exit(1);
+		}
+		return true;
+	}
+
+	//
+	// Find the end of the record that starts at bufStart, refilling the
+	// buffer until the record is complete.  The offsets of the newlines
+	// that end the lines of a FASTQ record are stored in lineEnds.
+	//
+	long FindRecordEnd(vector<long> &lineEnds) {
+		long scanned = 0;
+		int nLines = 0;
+		while (true) {
+			long p = bufStart + scanned;
+			if (recordStart == '@') {
+				while (nLines < 4 and p < bufEnd) {
+					char *nl = (char*) memchr(&buffer[p], '\n', bufEnd - p);
+					if (nl == NULL) {
+						p = bufEnd;
+						break;
+					}
+					p = nl - &buffer[0];
+					lineEnds[nLines] = p - bufStart;
+					nLines++;
+					p++;
+				}
+				if (nLines == 4) {
+					return bufStart + lineEnds[3];
+				}
+			}
+			else {
+				//
+				// A FASTA record ends where a line starts with '>'.
+				//
+				if (scanned == 0) {
+					p = bufStart + 1;
+				}
+				while (p < bufEnd) {
+					char *gt = (char*) memchr(&buffer[p], '>', bufEnd - p);
+					if (gt == NULL) {
+						p = bufEnd;
+						break;
+					}
+					p = gt - &buffer[0];
+					if (buffer[p-1] == '\n') {
+						return p;
+					}
+					p++;
+				}
+			}
+			//
+			// Refill keeps the unparsed input, so offsets from bufStart are
+			// unchanged.
+			//
+			scanned = p - bufStart;
+			if (Refill() == false) {
+				if (recordStart == '@' and nLines == 3) {
+					lineEnds[3] = bufEnd - bufStart;
+					return bufEnd;
+				}
+				if (recordStart == '@') {
+					cout << "ERROR, " << fileName << " ends in the middle of a FASTQ record." << endl;
+					exit(1);
+				}
+				return bufEnd;
+			}
+		}
+	}
+
+	void CopyTitle(long start, long end, char *&title, int &titleLength) {
+		while (end > start and buffer[end-1] == '\r') {
+			end--;
+		}
+		titleLength = end - start;
+		if (titleLength > 0) {
+			title = new char[titleLength+1];
+			memcpy(title, &buffer[start], titleLength);
+			title[titleLength] = '\0';
+		}
+		else {
+			title = NULL;
+			titleLength = 0;
+		}
+	}
+
+	void CopySequence(long start, long end, FASTASequence &seq) {
+		long p, seqLength = 0;
+		for (p = start; p < end; p++) {
+			if (IsSpace(buffer[p]) == false) {
+				seqLength++;
+			}
+		}
+		if (seqLength > UINT_MAX) {
+			cout << "ERROR! Reading sequences stored in more than 4Gbytes of space is not supported." << endl;
+			exit(1);
+		}
+		seq.length = seqLength;
+		seq.seq    = NULL;
+		if (seqLength > 0) {
+			seq.seq = new Nucleotide[seqLength];
+			seq.deleteOnExit = true;
+			long s = 0;
+			for (p = start; p < end; p++) {
+				if (IsSpace(buffer[p]) == false) {
+					seq.seq[s] = convMat[buffer[p]];
+					s++;
+				}
+			}
+		}
+	}
+
+	//
+	// Parse the next record.  The quality values of a FASTQ record are
+	// stored only if qualSeq is not NULL.
+	//
+	int ParseNext(FASTASequence &seq, FASTQSequence *qualSeq) {
+		if (SkipToRecord() == false) {
+			return 0;
+		}
+		vector<long> lineEnds(4, 0);
+		long recordEnd = FindRecordEnd(lineEnds);
+		if (recordStart == '>') {
+			char *nl = (char*) memchr(&buffer[bufStart], '\n', recordEnd - bufStart);
+			long titleEnd = (nl == NULL ? recordEnd : nl - &buffer[0]);
+			CopyTitle(bufStart + 1, titleEnd, seq.title, seq.titleLength);
+			CopySequence(titleEnd, recordEnd, seq);
+		}
+		else {
+			long seqStart  = bufStart + lineEnds[0] + 1;
+			long plusStart = bufStart + lineEnds[1] + 1;
+			long qualStart = bufStart + lineEnds[2] + 1;
+			long qualEnd   = bufStart + lineEnds[3];
+			if (buffer[plusStart] != '+') {
+				cout << "ERROR, FASTQ entry must have a \"+\" line after the sequence in " << fileName << endl;
+				exit(1);
+			}
+			CopyTitle(bufStart + 1, seqStart - 1, seq.title, seq.titleLength);
+			CopySequence(seqStart, plusStart - 1, seq);
+			if (qualSeq != NULL) {
+				while (qualEnd > qualStart and buffer[qualEnd-1] == '\r') {
+					qualEnd--;
+				}
+				if (seq.length > 0) {
+					qualSeq->qual.Allocate(seq.length);
+					DNALength q;
+					for (q = 0; q < seq.length and qualStart + q < qualEnd; q++) {
+						qualSeq->qual[q] = buffer[qualStart + q] - FASTQSequence::charToQuality;
+					}
+					for (; q < seq.length; q++) {
+						qualSeq->qual[q] = 0;
+					}
+				}
+				else {
+					qualSeq->qual.data = NULL;
+				}
+			}
+		}
+		bufStart = recordEnd;
+		return 1;
+	}
+
+ public:
+	FASTXStreamReader() {
+		fileDes = -1;
+		gzIn    = NULL;
+		started = false;
+		convMat = PreserveCase;
+		pthread_mutex_init(&blockMutex, NULL);
+		pthread_cond_init(&blockReady, NULL);
+		bufStart = bufEnd = 0;
+		bufferHasAllInput = false;
+		recordStart = 0;
+	}
+
+	~FASTXStreamReader() {
+		if (fileDes != -1) {
+			Close();
+		}
+		pthread_mutex_destroy(&blockMutex);
+		pthread_cond_destroy(&blockReady);
+	}
+
+	//
+	// Standard input and compressed files are streamed; other files are
+	// read by FASTAReader and FASTQReader.
+	//
+	static bool IsStreamFileName(string &name) {
+		if (name == "-" or name == "/dev/stdin") {
+			return true;
+		}
+		return (name.size() > 3 and name.compare(name.size() - 3, 3, ".gz") == 0);
+	}
+
+	void SetToUpper() {
+		convMat = AllToUpper;
+	}
+
+	int Init(string &fileNameP) {
+		Close();
+		fileName = fileNameP;
+		if (fileName == "-" or fileName == "/dev/stdin") {
+			fileDes = dup(0);
+		}
+		else {
+			fileDes = open(fileName.c_str(), O_RDONLY);
+		}
+		if (fileDes == -1) {
+			cout << "Could not open " << fileName << endl;
+			exit(1);
+		}
+		started  = false;
+		bufStart = bufEnd = 0;
+		bufferHasAllInput = false;
+		recordStart = 0;
+		return 1;
+	}
+
+	int GetNext(FASTASequence &seq) {
+		return ParseNext(seq, NULL);
+	}
+
+	int GetNext(FASTQSequence &seq) {
+		return ParseNext(seq, &seq);
+	}
+
+	//
+	// Skip nSteps records.  Returns 1 if a record follows them.
+	//
+	int Advance(int nSteps) {
+		int i;
+		for (i = 0; i < nSteps; i++) {
+			if (SkipToRecord() == false) {
+				return 0;
+			}
+			vector<long> lineEnds(4, 0);
+			bufStart = FindRecordEnd(lineEnds);
+		}
+		return SkipToRecord();
+	}
+
+	void Close() {
+		if (fileDes == -1) {
+			return;
+		}
+		if (started) {
+			pthread_mutex_lock(&blockMutex);
+			stopInflating = true;
+			pthread_cond_broadcast(&blockReady);
+			pthread_mutex_unlock(&blockMutex);
+			pthread_join(inflateThread, NULL);
+			while (filledBlocks.size() > 0) {
+				delete filledBlocks.front();
+				filledBlocks.pop_front();
+			}
+			while (emptyBlocks.size() > 0) {
+				delete emptyBlocks.front();
+				emptyBlocks.pop_front();
+			}
+			// gzclose also closes fileDes.
+			gzclose(gzIn);
+			gzIn = NULL;
+		}
+		else {
+			close(fileDes);
+		}
+		fileDes = -1;
+		started = false;
+		vector<char>().swap(buffer);
+		bufStart = bufEnd = 0;
+	}
+};
+
+#endif
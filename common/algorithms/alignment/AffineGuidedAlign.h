@@ -35,8 +35,8 @@ template<typename QSequence, typename TSequence, typename T_ScoreFn>
                         Alignment &alignment,
                         vector<int>    &scoreMat,
                         vector<Arrow>  &pathMat,
-                        vector<double> &probMat,
-                        vector<double> &optPathProbMat,
+                        vector<float>  &probMat,
+                        vector<float>  &optPathProbMat,
                         vector<float>  &lnSubPValueVect,
                         vector<float>  &lnInsPValueVect,
                         vector<float>  &lnDelPValueVect,
@@ -588,8 +588,8 @@ template<typename QSequence, typename TSequence, typename T_ScoreFn>
   //  Make synonyms for members of the buffers class for easier typing.
   vector<int>    scoreMat;
   vector<Arrow>  pathMat;
-  vector<double> probMat;
-  vector<double> optPathProbMat;
+  vector<float>  probMat;
+  vector<float>  optPathProbMat;
   vector<float>  lnSubPValueVect;
   vector<float>  lnInsPValueVect;
   vector<float>  lnDelPValueVect;
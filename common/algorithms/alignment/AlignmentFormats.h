@@ -2,6 +2,6 @@
 #define ALGORITHMS_ALIGNMENT_ALIGNMENT_FORMATS_H_
 
 
-enum AlignmentPrintFormat { StickPrint, SummaryPrint, CompareXML, Vulgar, Interval, CompareSequencesParsable, SAM, NOFORMAT};
+enum AlignmentPrintFormat { StickPrint, SummaryPrint, CompareXML, Vulgar, Interval, CompareSequencesParsable, SAM, CompactBinary, NOFORMAT};
 
 #endif
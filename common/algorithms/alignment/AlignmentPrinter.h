@@ -7,6 +7,7 @@
 #include "printers/VulgarAlignmentPrinter.h"
 #include "printers/CompareSequencesAlignmentPrinter.h"
 #include "printers/IntervalAlignmentPrinter.h"
+#include "printers/BinaryAlignmentPrinter.h"
 #include "printers/SummaryAlignmentPrinter.h"
 #include "printers/SAMPrinter.h"
 #endif
@@ -4,11 +4,21 @@
 #include "../../datastructures/matrix/Matrix.h"
 #include "../../FASTQSequence.h"
 #include "../../FASTASequence.h"
+#include "../../utils/LogUtils.h"
 
+//
+// The log probability of aligning query to target, summed over all
+// alignments with the forward algorithm.  The QV accessors of the
+// sequences must return error probabilities rather than phred values.
+// Cells are summed in float with LogSumTable, which adds at most about
+// 1e-5 to the log probability per cell on a path; testing/alignment/
+// TestFullQVAlign checks this against the same sum in double.  Nothing
+// in blasr calls this at the moment.
+//
 template<typename T_Query, typename T_Reference>
 double FullQVAlign(T_Query       &query,
 									T_Reference   &target,
-									Matrix<double> &alignProb) {
+									Matrix<float> &alignProb) {
 	
 	alignProb.Resize(query.length + 1, target.length + 1);
 	alignProb.Initialize(0);
@@ -61,7 +71,6 @@ double FullQVAlign(T_Query       &query,
 					((1-query.GetSubstitutionQV(q-1)))*(target.GetSubstitutionQV(t-1)/3.0);
 			}
 
-			matchedPulseProb = exp(alignProb[q-1][t-1])*matchedPulseProb;
 			// 
 			// An insertion in the query can be either a normal extra base
 			// in the query, or a deletion in the reference.
@@ -84,18 +93,17 @@ double FullQVAlign(T_Query       &query,
 				if (q > 1) {
 					insertedPulseProb = 
 						(target.GetPreBaseDeletionQV(t-1, query.seq[q-2]) *target.GetDeletionQV(t-1)
-						 + query.GetInsertionQV(q-1)) 
-						* exp(alignProb[q-1][t]);
+						 + query.GetInsertionQV(q-1));
 				}
 				else {
 					//
 					// There can be no pre-base deletion tag here (could probably be an assert statement).
 					//
-					insertedPulseProb = query.GetInsertionQV(q-1)  * exp(alignProb[q-1][t]);
+					insertedPulseProb = query.GetInsertionQV(q-1);
 				}
 			}
 			else {
-				insertedPulseProb = (query.GetInsertionQV(q-1) + target.GetDeletionQV(t-1))*exp(alignProb[q-1][t]);
+				insertedPulseProb = (query.GetInsertionQV(q-1) + target.GetDeletionQV(t-1));
 			}
 			
 			//
@@ -106,24 +114,30 @@ double FullQVAlign(T_Query       &query,
 			if (query.GetDeletionTag(q-1) != 'N') {
 				if (t > 1) {
 					deletedPulseProb = (query.GetPreBaseDeletionQV(q-1, target.seq[t-2]) * query.GetDeletionQV(q-1) 
-															+ target.GetInsertionQV(t-1))*exp(alignProb[q][t-1]);
+															+ target.GetInsertionQV(t-1));
 				}
 				else {
 					// There was a dropped pulse before this position, but nothing to align it to.  
-					deletedPulseProb = target.GetInsertionQV(t-1) * exp(alignProb[q][t-1]);
+					deletedPulseProb = target.GetInsertionQV(t-1);
 				}
 			}
 			else {
-				deletedPulseProb =  (target.GetInsertionQV(t-1) + query.GetDeletionQV(q-1)) *exp(alignProb[q][t-1]);
+				deletedPulseProb =  (target.GetInsertionQV(t-1) + query.GetDeletionQV(q-1));
 			}
 
 			// Determine the total probability of reaching this position.
+			// The sum is in log space so that the probabilities of long
+			// alignments do not underflow.
+			//
+			logMatchedPulseProb  = log(matchedPulseProb)  + alignProb[q-1][t-1];
+			logInsertedPulseProb = log(insertedPulseProb) + alignProb[q-1][t];
+			logDeletedPulseProb  = log(deletedPulseProb)  + alignProb[q][t-1];
 			/*			cout << "align prob " << q << " " << t << " " <<  logMatchedPulseProb << " " 
 							<<  logInsertedPulseProb << " " <<  logDeletedPulseProb << endl;*/
-			alignProb[q][t] = log(matchedPulseProb + insertedPulseProb + deletedPulseProb);
+			alignProb[q][t] = NaturalLogSumOfThree(logMatchedPulseProb, logInsertedPulseProb, logDeletedPulseProb);
 		}
 	}
-	double fullAlignProb = alignProb[numRows-1][numCols-1];
+	float fullAlignProb = alignProb[numRows-1][numCols-1];
 	alignProb.Free();
 	return fullAlignProb;
 };
@@ -281,8 +281,8 @@ template<typename QSequence, typename TSequence, typename T_ScoreFn>
                   Alignment &alignment,
                   vector<int>    &scoreMat,
                   vector<Arrow>  &pathMat,
-                  vector<double> &probMat,
-                  vector<double> &optPathProbMat,
+                  vector<float>  &probMat,
+                  vector<float>  &optPathProbMat,
                   vector<float>  &lnSubPValueVect,
                   vector<float>  &lnInsPValueVect,
                   vector<float>  &lnDelPValueVect,
@@ -469,6 +469,18 @@ template<typename QSequence, typename TSequence, typename T_ScoreFn>
 	}
 
 	int matchScore, insScore, delScore;
+
+  //
+  // The probability of reaching a cell is the sum over the match,
+  // insertion, and deletion moves into it.  The match and insertion
+  // moves come from the previous row, so they are summed over all cells
+  // of a row at once after the scores of the row are computed, and the
+  // deletion moves, which come from the cell to the left, are added in
+  // a second pass along the row.
+  //
+  const LogSumTable &logSum = LogSumTable::Get();
+  vector<int>   rowProbIndex, rowProbDelIndex;
+  vector<float> rowProbMatch, rowProbIns, rowProbDel, rowProbMatchIns;
 	
 	for (q = qStart; q < qEnd; q++) {
 		int qi = q - qStart + 1;
@@ -488,6 +500,11 @@ template<typename QSequence, typename TSequence, typename T_ScoreFn>
       //
       prevRowTEnd = guide[qi-1].t + guide[qi-1].tPost;
     }    
+    rowProbIndex.clear();
+    rowProbDelIndex.clear();
+    rowProbMatch.clear();
+    rowProbIns.clear();
+    rowProbDel.clear();
     
 		for (t = tp - guide[qi].tPre ; t < guide[qi].t + guide[qi].tPost +1; t++) {
 
@@ -583,44 +600,37 @@ template<typename QSequence, typename TSequence, typename T_ScoreFn>
           }
 
           if (qSeq.qual.Empty() == false) {
-            if (matchScore != INF_INT and delScore != INF_INT and insScore != INF_INT) {
-              probMat[curIndex] = LogSumOfThree(probMat[matchIndex] + pMisMatch,
-                                                probMat[delIndex] + pDel,
-                                                probMat[insIndex] + pIns);
-            }
-            else if (matchScore != INF_INT and delScore != INF_INT) {
-              probMat[curIndex] = LogSumOfTwo(probMat[matchIndex] + pMisMatch,
-                                              probMat[delIndex] + pDel);
-            }
-            else if (matchScore != INF_INT and insScore != INF_INT) {
-              probMat[curIndex] = LogSumOfTwo(probMat[matchIndex] + pMisMatch,
-                                              probMat[insIndex] + pIns);					
-            }
-            else if (insScore != INF_INT and delScore != INF_INT) {
-              probMat[curIndex] = LogSumOfTwo(probMat[delIndex] + pDel,
-                                              probMat[insIndex] + pIns);
-            }
-            else if (matchScore != INF_INT) {
-              probMat[curIndex] = probMat[matchIndex] + pMisMatch;
-            }
-            else if (delScore != INF_INT) {
-              probMat[curIndex] = probMat[delIndex] + pDel;
-            }
-            else if (insScore != INF_INT) {
-              probMat[curIndex] = probMat[insIndex] + pIns;
-            }
-            //
-            // Not normalizing probabilities, but using value as if it
-            // was a probability later on, so cap at 0 (= log 1).
-            //
-            if (probMat[curIndex] > 0) {
-              probMat[curIndex] = 0;
-            }
-            assert(!isnan(probMat[curIndex]));
+            rowProbIndex.push_back(curIndex);
+            rowProbMatch.push_back(matchScore != INF_INT ? probMat[matchIndex] + pMisMatch : LOWEST_LOG_SUM_VALUE);
+            rowProbIns.push_back(insScore != INF_INT ? probMat[insIndex] + pIns : LOWEST_LOG_SUM_VALUE);
+            rowProbDelIndex.push_back(delScore != INF_INT ? delIndex : -1);
+            rowProbDel.push_back(pDel);
 					}
 				}
 			}
 		}
+
+    if (rowProbIndex.size() > 0) {
+      int nRowProb = rowProbIndex.size();
+      rowProbMatchIns.resize(nRowProb);
+      logSum.Sum(&rowProbMatch[0], &rowProbIns[0], &rowProbMatchIns[0], nRowProb);
+      int r;
+      for (r = 0; r < nRowProb; r++) {
+        float prob = rowProbMatchIns[r];
+        if (rowProbDelIndex[r] >= 0) {
+          prob = logSum.Sum(prob, probMat[rowProbDelIndex[r]] + rowProbDel[r]);
+        }
+        //
+        // Not normalizing probabilities, but using value as if it
+        // was a probability later on, so cap at 0 (= log 1).
+        //
+        if (prob > 0) {
+          prob = 0;
+        }
+        assert(!isnan(prob));
+        probMat[rowProbIndex[r]] = prob;
+      }
+    }
 	}		
 	// Ok, for now just trace back from qend/tend
 	q = qEnd-1;
@@ -795,8 +805,8 @@ int GuidedAlign(QSequence &origQSeq, TSequence &origTSeq,  Alignment &guideAlign
   //  Make synonyms for members of the buffers class for easier typing.
   vector<int>    scoreMat;
   vector<Arrow>  pathMat;
-  vector<double> probMat;
-  vector<double> optPathProbMat;
+  vector<float>  probMat;
+  vector<float>  optPathProbMat;
   vector<float>  lnSubPValueVect;
   vector<float>  lnInsPValueVect;
   vector<float>  lnDelPValueVect;
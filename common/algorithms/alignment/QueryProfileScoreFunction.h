@@ -0,0 +1,132 @@
+#ifndef ALGORITHMS_ALIGNMENT_QUERY_PROFILE_SCORE_FUNCTION_H_
+#define ALGORITHMS_ALIGNMENT_QUERY_PROFILE_SCORE_FUNCTION_H_
+
+#include <vector>
+#include "BaseScoreFunction.h"
+#include "../../DNASequence.h"
+#include "../../NucConversion.h"
+
+using namespace std;
+
+//
+// The match, insertion, and deletion costs of a score function that
+// depends on the quality values of the query (IDSScoreFunction,
+// QualityValueScoreFunction), precomputed for every query position
+// and reference base.  Looking up a cost in the profile replaces
+// reading several quality value arrays and branching on the tags for
+// every cell of the alignment matrix, so the profile is built once
+// per read, and shared by every alignment of the read.
+//
+// The insertion cost of a score function must not depend on the
+// reference base.  Reference bases other than A,C,G,T are scored as
+// N.
+//
+class QueryScoreProfile {
+ public:
+	enum { NColumns = 5 };
+	vector<int> match;
+	vector<int> deletion;
+	vector<int> insertion;
+	DNALength length;
+
+	QueryScoreProfile() {
+		length = 0;
+	}
+
+	static int Column(Nucleotide refNuc) {
+		int column = ThreeBit[refNuc];
+		return (column < NColumns ? column : NColumns - 1);
+	}
+
+	template<typename T_ScoreFn, typename T_QuerySequence>
+	void Build(T_ScoreFn &scoreFn, T_QuerySequence &query) {
+		length = query.length;
+		match.resize(length * NColumns);
+		deletion.resize(length * NColumns);
+		insertion.resize(length);
+
+		//
+		// The score functions look up reference bases by position, so
+		// give them a reference with one of each base.
+		//
+		Nucleotide bases[NColumns] = {'A', 'C', 'G', 'T', 'N'};
+		DNASequence ref;
+		ref.seq    = bases;
+		ref.length = NColumns;
+		DNALength q;
+		int b;
+		for (q = 0; q < length; q++) {
+			for (b = 0; b < NColumns; b++) {
+				match[q * NColumns + b]    = scoreFn.Match(ref, (DNALength) b, query, q);
+				deletion[q * NColumns + b] = scoreFn.Deletion(ref, (DNALength) b, query, q);
+			}
+			insertion[q] = scoreFn.Insertion(ref, (DNALength) 0, query, q);
+		}
+		ref.seq = NULL;
+	}
+
+	void Free() {
+		match.clear();
+		deletion.clear();
+		insertion.clear();
+		length = 0;
+	}
+};
+
+//
+// A score function that reads costs from a query profile.  The query
+// passed to the aligner may be a substring of the read the profile
+// was built from, starting at queryOffset.  Normalized costs, only
+// needed when computing alignment probabilities, are passed through to
+// the original score function.
+//
+template<typename T_RefSequence, typename T_QuerySequence, typename T_ScoreFn>
+class QueryProfileScoreFunction : public BaseScoreFunction {
+ public:
+	T_ScoreFn *scoreFn;
+	int *matchProfile;
+	int *deletionProfile;
+	int *insertionProfile;
+
+	QueryProfileScoreFunction(T_ScoreFn &scoreFnP, QueryScoreProfile &profile, DNALength queryOffset) :
+	BaseScoreFunction(scoreFnP.ins, scoreFnP.del, scoreFnP.substitutionPrior,
+										scoreFnP.globalDeletionPrior, scoreFnP.affineExtend) {
+		scoreFn          = &scoreFnP;
+		matchProfile     = deletionProfile = insertionProfile = NULL;
+		if (profile.length > 0) {
+			matchProfile     = &profile.match[queryOffset * QueryScoreProfile::NColumns];
+			deletionProfile  = &profile.deletion[queryOffset * QueryScoreProfile::NColumns];
+			insertionProfile = &profile.insertion[queryOffset];
+		}
+	}
+
+	int Match(T_RefSequence &ref, DNALength refPos, T_QuerySequence &query, DNALength queryPos) {
+		return matchProfile[queryPos * QueryScoreProfile::NColumns + QueryScoreProfile::Column(ref.seq[refPos])];
+	}
+
+	int Deletion(T_RefSequence &ref, DNALength refPos, T_QuerySequence &query, DNALength queryPos) {
+		return deletionProfile[queryPos * QueryScoreProfile::NColumns + QueryScoreProfile::Column(ref.seq[refPos])];
+	}
+
+	int Insertion(T_RefSequence &ref, DNALength refPos, T_QuerySequence &query, DNALength queryPos) {
+		return insertionProfile[queryPos];
+	}
+
+	int Insertion(T_QuerySequence &query, DNALength queryPos) {
+		return insertionProfile[queryPos];
+	}
+
+	float NormalizedMatch(T_RefSequence &ref, DNALength refPos, T_QuerySequence &query, DNALength queryPos) {
+		return scoreFn->NormalizedMatch(ref, refPos, query, queryPos);
+	}
+
+	float NormalizedInsertion(T_RefSequence &ref, DNALength refPos, T_QuerySequence &query, DNALength queryPos) {
+		return scoreFn->NormalizedInsertion(ref, refPos, query, queryPos);
+	}
+
+	float NormalizedDeletion(T_RefSequence &ref, DNALength refPos, T_QuerySequence &query, DNALength queryPos) {
+		return scoreFn->NormalizedDeletion(ref, refPos, query, queryPos);
+	}
+};
+
+#endif
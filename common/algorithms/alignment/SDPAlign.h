@@ -7,6 +7,8 @@
 #include "DistanceMatrixScoreFunction.h"
 #include "sdp/SparseDynamicProgramming.h"
 #include "sdp/SDPFragment.h"
+#include "sdp/VariableLengthSDPFragment.h"
+#include "sdp/SDPBand.h"
 #include "../../tuples/TupleList.h"
 #include "../../tuples/DNATuple.h"
 #include "../../tuples/TupleMatching.h"
@@ -60,7 +62,8 @@ int SDPAlign(T_QuerySequence &query, T_TargetSequence &target,
 						 AlignmentType alignType=Global,
 						 bool detailedAlignment=true,
 						 bool extendFrontByLocalAlignment=true, 
-             int  noRecurseUnder = 10000) {
+             int  noRecurseUnder = 10000,
+             SDPBand *band = NULL) {
 
   return SDPAlign(query, target, scoreFn, wordSize, 
                   sdpIns, sdpDel, indelRate,
@@ -72,7 +75,7 @@ int SDPAlign(T_QuerySequence &query, T_TargetSequence &target,
                   buffers.sdpCachedTargetPrefixTupleList,
                   buffers.sdpCachedTargetSuffixTupleList,
                   buffers.sdpCachedMaxFragmentChain,
-                  alignType, detailedAlignment, extendFrontByLocalAlignment, noRecurseUnder);
+                  alignType, detailedAlignment, extendFrontByLocalAlignment, noRecurseUnder, band);
 }
 
 template<typename T_QuerySequence, typename T_TargetSequence, typename T_ScoreFn, typename T_TupleList>
@@ -92,7 +95,8 @@ int SDPAlign(T_QuerySequence &query, T_TargetSequence &target,
 						 AlignmentType alignType=Global,
 						 bool detailedAlignment=true,
 						 bool extendFrontByLocalAlignment=true, 
-             int  noRecurseUnder=10000) {
+             int  noRecurseUnder=10000,
+             SDPBand *band=NULL) {
 
   fragmentSet.clear();
   prefixFragmentSet.clear();
@@ -154,11 +158,19 @@ int SDPAlign(T_QuerySequence &query, T_TargetSequence &target,
 
   //
   // Store in fragmentSet the tuples that match between the target
-  // and query.
+  // and query.  When a band is given, only the matches that are
+  // close to the diagonals of the anchors are stored.
   //
-  StoreMatchingPositions(query, tmSmall, targetPrefixTupleList, prefixFragmentSet);
-  StoreMatchingPositions(query, tmSmall, targetSuffixTupleList, suffixFragmentSet);
-	StoreMatchingPositions(query, tm, targetTupleList, fragmentSet); 
+  if (band != NULL) {
+    StoreMatchingPositionsInBand(query, tmSmall, targetPrefixTupleList, *band, 0, prefixFragmentSet);
+    StoreMatchingPositionsInBand(query, tmSmall, targetSuffixTupleList, *band, suffixPos, suffixFragmentSet);
+    StoreMatchingPositionsInBand(query, tm, targetTupleList, *band, middlePos, fragmentSet); 
+  }
+  else {
+    StoreMatchingPositions(query, tmSmall, targetPrefixTupleList, prefixFragmentSet);
+    StoreMatchingPositions(query, tmSmall, targetSuffixTupleList, suffixFragmentSet);
+    StoreMatchingPositions(query, tm, targetTupleList, fragmentSet); 
+  }
 
   
   // 
@@ -204,10 +216,19 @@ int SDPAlign(T_QuerySequence &query, T_TargetSequence &target,
 	}
 
   //
-  // Find the longest chain of anchors.
+  // Find the longest chain of anchors.  In a banded alignment, the
+  // runs of matches along a diagonal are merged into single
+  // fragments first, which bounds the number of fragments in
+  // repetitive sequence by the number of runs rather than the number
+  // of matches.
   //
-  
-	SDPLongestCommonSubsequence(query.length, fragmentSet, tm.tupleSize, sdpIns, sdpDel, scoreFn.scoreMatrix[0][0], maxFragmentChain, alignType);
+  if (band != NULL) {
+    MergeCoDiagonalFragments(fragmentSet);
+    SDPVariableLengthFragmentChain(fragmentSet, sdpIns, sdpDel, maxFragmentChain, alignType);
+  }
+  else {
+    SDPLongestCommonSubsequence(query.length, fragmentSet, tm.tupleSize, sdpIns, sdpDel, scoreFn.scoreMatrix[0][0], maxFragmentChain, alignType);
+  }
 
 	//
 	// Now turn the max fragment chain into real a real alignment.
@@ -444,12 +465,16 @@ int SDPAlign(T_QuerySequence &query, T_TargetSequence &target,
           StickPrintAlignment(fragAlignment, qFragment, tFragment, cout);
         }
         */
+				//
+				// A recursive local alignment may not start at the
+				// beginning of the gap, and its blocks are relative to
+				// where it starts.
+				//
+				int qOffset = chainAlignment.blocks[b].qPos + chainAlignment.blocks[b].length + fragAlignment.qPos;
+				int tOffset = chainAlignment.blocks[b].tPos + chainAlignment.blocks[b].length + fragAlignment.tPos;
 				fragAlignment.qPos = 0;
 				fragAlignment.tPos = 0;
 
-				int qOffset = chainAlignment.blocks[b].qPos + chainAlignment.blocks[b].length;
-				int tOffset = chainAlignment.blocks[b].tPos + chainAlignment.blocks[b].length;
-
 				for (fb = 0; fb < fragAlignment.blocks.size(); fb++) {
 					fragAlignment.blocks[fb].qPos += qOffset;
 					fragAlignment.blocks[fb].tPos += tOffset;
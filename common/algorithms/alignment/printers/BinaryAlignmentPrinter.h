@@ -0,0 +1,72 @@
+#ifndef BINARY_ALIGNMENT_PRINTER_H_
+#define BINARY_ALIGNMENT_PRINTER_H_
+
+#include <vector>
+#include "../../../datastructures/alignment/AlignmentCandidate.h"
+#include "../../../datastructures/alignment/BinaryAlignmentRecord.h"
+#include "../../../FASTQSequence.h"
+
+class BinaryAlignmentPrinter {
+ public:
+  //
+  // Write one record.  The quality values of the aligned query are
+  // written only if printQVs is true and the query has them.
+  //
+  static void Print(AlignmentCandidate<DNASequence,FASTQSequence> &alignment, ostream &outFile, bool printQVs=false) {
+    BinaryAlignmentRecordHeader header;
+    header.qNameLength    = alignment.qName.size();
+    header.tNameLength    = alignment.tName.size();
+    header.nBlocks        = alignment.blocks.size();
+    header.nQVs           = ((printQVs and alignment.qAlignedSeq.qual.data != NULL) ? alignment.qAlignedSeq.length : 0);
+    header.recordLength   = BinaryAlignmentRecord::RecordLength(header.nBlocks, header.qNameLength,
+                                                                header.tNameLength, header.nQVs);
+    header.readIndex      = alignment.readIndex;
+    header.tIndex         = alignment.tIndex;
+    header.qLength        = alignment.qLength;
+    header.tLength        = alignment.tLength;
+    header.qAlignedSeqPos = alignment.qAlignedSeqPos;
+    header.tAlignedSeqPos = alignment.tAlignedSeqPos;
+    header.qPos           = alignment.qPos;
+    header.tPos           = alignment.tPos;
+    header.score          = alignment.score;
+    header.pctSimilarity  = alignment.pctSimilarity;
+    header.nMatch         = alignment.nMatch;
+    header.nMismatch      = alignment.nMismatch;
+    header.nIns           = alignment.nIns;
+    header.nDel           = alignment.nDel;
+    header.qStrand        = alignment.qStrand;
+    header.tStrand        = alignment.tStrand;
+    header.mapQV          = (alignment.mapQV < 0 ? 0 : (alignment.mapQV > 255 ? 255 : alignment.mapQV));
+    header.flags          = 0;
+
+    //
+    // Build the record in one buffer so that it is one write to the
+    // (possibly shared) output.
+    //
+    vector<char> record(header.recordLength, 0);
+    char *p = &record[0];
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    if (header.nBlocks > 0) {
+      memcpy(p, &alignment.blocks[0], header.nBlocks * sizeof(Block));
+      p += header.nBlocks * sizeof(Block);
+    }
+    memcpy(p, alignment.qName.c_str(), header.qNameLength);
+    p += header.qNameLength;
+    memcpy(p, alignment.tName.c_str(), header.tNameLength);
+    p += header.tNameLength;
+    if (header.nQVs > 0) {
+      memcpy(p, alignment.qAlignedSeq.qual.data, header.nQVs);
+    }
+    outFile.write(&record[0], header.recordLength);
+  }
+
+  static void PrintHeader(ostream &out) {
+    BinaryAlignmentFileHeader fileHeader;
+    fileHeader.Initialize();
+    out.write((char*) &fileHeader, sizeof(fileHeader));
+  }
+};
+
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef ALGORITHMS_ALIGNMENT_READERS_BINARY_ALIGNMENT_READER_H_
+#define ALGORITHMS_ALIGNMENT_READERS_BINARY_ALIGNMENT_READER_H_
+
+#include <stdint.h>
+#include <unistd.h>
+#include <iostream>
+#include <string>
+
+#include "sys/mman.h"
+#include "sys/fcntl.h"
+#include "../../../datastructures/alignment/BinaryAlignmentRecord.h"
+
+using namespace std;
+
+//
+// Reads the records of a binary alignment file (blasr -m 7) in place
+// from a memory map of the file.  GetNext(BinaryAlignmentRecord&)
+// copies nothing; GetNext on an alignment candidate copies the names
+// and blocks into it.
+//
+class BinaryAlignmentReader {
+	int      fileDes;
+	char    *filePtr;
+	uint64_t fileSize;
+	uint64_t curPos;
+	uint64_t dataStart;
+ public:
+	string fileName;
+
+	BinaryAlignmentReader() {
+		fileDes  = -1;
+		filePtr  = NULL;
+		fileSize = curPos = dataStart = 0;
+	}
+
+	~BinaryAlignmentReader() {
+		Close();
+	}
+
+	int Initialize(string &fileNameP) {
+		fileName = fileNameP;
+		fileDes  = open(fileName.c_str(), O_RDONLY);
+		if (fileDes == -1) {
+			cout << "ERROR, could not open alignment file " << fileName << endl;
+			return 0;
+		}
+		fileSize = lseek(fileDes, 0, SEEK_END);
+		lseek(fileDes, 0, SEEK_SET);
+		BinaryAlignmentFileHeader *fileHeader;
+		if (fileSize < sizeof(BinaryAlignmentFileHeader) or
+				(filePtr = (char*) mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fileDes, 0)) == MAP_FAILED) {
+			cout << "ERROR, " << fileName << " is not a binary alignment file." << endl;
+			filePtr = NULL;
+			Close();
+			return 0;
+		}
+		madvise(filePtr, fileSize, MADV_SEQUENTIAL);
+		fileHeader = (BinaryAlignmentFileHeader*) filePtr;
+		if (fileHeader->IsValid() == false or fileHeader->headerLength > fileSize or
+				fileHeader->headerLength % 4 != 0) {
+			cout << "ERROR, " << fileName << " is not a binary alignment file, or is from an "
+					 << "incompatible version." << endl;
+			Close();
+			return 0;
+		}
+		dataStart = curPos = fileHeader->headerLength;
+		return 1;
+	}
+
+	void Rewind() {
+		curPos = dataStart;
+	}
+
+	//
+	// Returns 0 at the end of the file.  A record that is cut off, as
+	// the last record of a file that is still being written may be, is
+	// treated as the end of the file.
+	//
+	int GetNext(BinaryAlignmentRecord &record) {
+		if (filePtr == NULL or curPos >= fileSize) {
+			return 0;
+		}
+		if (record.Set(&filePtr[curPos], fileSize - curPos) == false) {
+			curPos = fileSize;
+			return 0;
+		}
+		curPos += record.header->recordLength;
+		return 1;
+	}
+
+	template<typename T_AlignmentCandidate>
+	int GetNext(T_AlignmentCandidate &alignment) {
+		BinaryAlignmentRecord record;
+		if (GetNext(record) == 0) {
+			return 0;
+		}
+		record.StoreAlignmentCandidate(alignment);
+		return 1;
+	}
+
+	void Close() {
+		if (filePtr != NULL) {
+			munmap(filePtr, fileSize);
+			filePtr = NULL;
+		}
+		if (fileDes != -1) {
+			close(fileDes);
+			fileDes = -1;
+		}
+	}
+};
+
+#endif
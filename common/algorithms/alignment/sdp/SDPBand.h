@@ -0,0 +1,74 @@
+#ifndef SDP_BAND_H_
+#define SDP_BAND_H_
+
+#include <vector>
+#include <algorithm>
+#include "../../../DNASequence.h"
+
+using namespace std;
+
+/*
+ * A band of diagonals (t - q) that sdp fragments are restricted to,
+ * derived from the anchors that placed a read in a window.  Between
+ * two consecutive anchors the band spans the diagonals of both
+ * anchors, widened by 'width' on either side.  Before the first and
+ * after the last anchor it is centered on the diagonal of the nearest
+ * anchor.
+ *
+ * Anchors must be added in increasing order of query position, which
+ * is the order they come out of the LIS chaining.
+ */
+
+class SDPBand {
+ public:
+	vector<DNALength> anchorQ;
+	vector<int>       anchorDiag;
+	int width;
+
+	SDPBand() {
+		width = 0;
+	}
+
+	void Initialize(int _width) {
+		width = _width;
+		anchorQ.clear();
+		anchorDiag.clear();
+	}
+
+	void AddAnchor(DNALength q, DNALength t) {
+		anchorQ.push_back(q);
+		anchorDiag.push_back(((int) t) - ((int) q));
+	}
+
+	int size() {
+		return anchorQ.size();
+	}
+
+	//
+	// Compute the range of diagonals [minDiag, maxDiag] that a
+	// fragment starting at query position q may lie on.  Returns 0
+	// when there are no anchors, in which case every diagonal is
+	// allowed.
+	//
+	int GetDiagonalRange(DNALength q, int &minDiag, int &maxDiag) const {
+		if (anchorQ.size() == 0) {
+			return 0;
+		}
+		int next = upper_bound(anchorQ.begin(), anchorQ.end(), q) - anchorQ.begin();
+		if (next == 0) {
+			minDiag = maxDiag = anchorDiag[0];
+		}
+		else if (next == anchorQ.size()) {
+			minDiag = maxDiag = anchorDiag[next-1];
+		}
+		else {
+			minDiag = min(anchorDiag[next-1], anchorDiag[next]);
+			maxDiag = max(anchorDiag[next-1], anchorDiag[next]);
+		}
+		minDiag -= width;
+		maxDiag += width;
+		return 1;
+	}
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <set>
+#include <map>
 #include <limits.h>
 #include "SDPSet.h"
 #include "SDPFragment.h"
@@ -288,4 +289,178 @@ int SDPLongestCommonSubsequence(DNALength queryLength,
 	return maxFragmentChain.size();
 }
 
+
+/*******************************************************************************
+ *  Chain fragments of variable length, such as the co-diagonal runs
+ *  produced by MergeCoDiagonalFragments.
+ *
+ *  The cost of a chain is the indel penalty for the drift between
+ *  consecutive fragments minus the number of matched bases.  A
+ *  fragment may follow any fragment that starts before it on both
+ *  sequences, and the chain of minimal cost is returned in
+ *  maxFragmentChain.
+ *
+ *  Fragments are swept by their start row.  Fragments that end before
+ *  the sweep row are closed, and only the last closed fragment on
+ *  each diagonal is kept: it may be chained after any earlier
+ *  fragment on its diagonal at no indel cost, so it is never more
+ *  expensive to follow.  The closed diagonals are searched outwards
+ *  from the diagonal of the fragment until the indel penalty alone
+ *  rules out an improvement.  Fragments that are still open overlap
+ *  the start of the fragment and are searched directly, trimming the
+ *  overlap from the fragment weight.  Since co-diagonal fragments are
+ *  merged, there is at most one open fragment per diagonal.
+ ******************************************************************************/
+
+//
+// Fragments that have just closed are kept open for a few more rows
+// since they may still overlap the start of a fragment on the other
+// sequence, as happens when two runs are separated by an indel in a
+// homopolymer.
+//
+#define SDP_MAX_OVERLAP_TRIM 20
+
+template<typename T_Fragment>
+int SDPVariableLengthFragmentChain(vector<T_Fragment> &fragmentSet, 
+                                   int insertion, int deletion,
+                                   vector<int> &maxFragmentChain, AlignmentType alignType=Global) {
+	maxFragmentChain.clear();
+
+	if (fragmentSet.size() < 1)
+		return 0;
+
+	std::sort(fragmentSet.begin(), fragmentSet.end(), LexicographicFragmentSort<T_Fragment>());
+
+	VectorIndex fi;
+	vector<pair<unsigned int, int> > fragmentEnds;
+	fragmentEnds.resize(fragmentSet.size());
+	for (fi = 0; fi < fragmentSet.size(); fi++) {
+		fragmentSet[fi].index = fi;
+		fragmentEnds[fi].first  = fragmentSet[fi].x + fragmentSet[fi].GetLength();
+		fragmentEnds[fi].second = fi;
+	}
+	std::sort(fragmentEnds.begin(), fragmentEnds.end());
+
+	map<int, int> closedDiagonals;
+	map<int, int>::iterator diagIt;
+	vector<int> openFragments;
+	VectorIndex fEnd = 0;
+	int minClosedCost    = INF_INT;
+	int minFragmentCost  = INF_INT;
+	int minFragmentIndex = -1;
+
+	for (fi = 0; fi < fragmentSet.size(); fi++) {
+		T_Fragment &frag = fragmentSet[fi];
+		int fragDiag = ((int) frag.y) - ((int) frag.x);
+
+		//
+		// Close the fragments that end at or before the start of this one.
+		//
+		while (fEnd < fragmentEnds.size() and fragmentEnds[fEnd].first <= frag.x) {
+			T_Fragment &closed = fragmentSet[fragmentEnds[fEnd].second];
+			closedDiagonals[((int) closed.y) - ((int) closed.x)] = fragmentEnds[fEnd].second;
+			minClosedCost = min(minClosedCost, closed.cost);
+			++fEnd;
+		}
+
+		VectorIndex o, nOpen = 0;
+		for (o = 0; o < openFragments.size(); o++) {
+			if (fragmentSet[openFragments[o]].x + fragmentSet[openFragments[o]].GetLength() + SDP_MAX_OVERLAP_TRIM > frag.x) {
+				openFragments[nOpen++] = openFragments[o];
+			}
+		}
+		openFragments.resize(nOpen);
+
+		int minCost  = INF_INT;
+		int minPrev  = -1;
+
+		//
+		// Search closed fragments on diagonals at and above this one,
+		// then below it.
+		//
+		map<int, int>::iterator startIt = closedDiagonals.lower_bound(fragDiag);
+		for (diagIt = startIt; diagIt != closedDiagonals.end(); ++diagIt) {
+			T_Fragment &pred = fragmentSet[diagIt->second];
+			int penalty = IndelPenalty(frag.x, frag.y, pred.x, pred.y, insertion, deletion);
+			if (minClosedCost + penalty >= minCost) break;
+			if (pred.y + pred.GetLength() <= frag.y and pred.cost + penalty < minCost) {
+				minCost = pred.cost + penalty;
+				minPrev = diagIt->second;
+			}
+		}
+		for (diagIt = startIt; diagIt != closedDiagonals.begin(); ) {
+			--diagIt;
+			T_Fragment &pred = fragmentSet[diagIt->second];
+			int penalty = IndelPenalty(frag.x, frag.y, pred.x, pred.y, insertion, deletion);
+			if (minClosedCost + penalty >= minCost) break;
+			if (pred.cost + penalty < minCost) {
+				minCost = pred.cost + penalty;
+				minPrev = diagIt->second;
+			}
+		}
+
+		//
+		// Search open fragments, which overlap this one.
+		//
+		for (o = 0; o < openFragments.size(); o++) {
+			T_Fragment &pred = fragmentSet[openFragments[o]];
+			if (pred.x >= frag.x or pred.y >= frag.y) {
+				continue;
+			}
+			unsigned int xOverlap = 0, yOverlap = 0;
+			if (pred.x + pred.GetLength() > frag.x) {
+				xOverlap = pred.x + pred.GetLength() - frag.x;
+			}
+			if (pred.y + pred.GetLength() > frag.y) {
+				yOverlap = pred.y + pred.GetLength() - frag.y;
+			}
+			int trim = max(xOverlap, yOverlap);
+			if (trim >= frag.weight) {
+				continue;
+			}
+			int cost = pred.cost + trim + IndelPenalty(frag.x, frag.y, pred.x, pred.y, insertion, deletion);
+			if (cost < minCost) {
+				minCost = cost;
+				minPrev = openFragments[o];
+			}
+		}
+
+		//
+		//  If doing a global alignment, chain is always extended.  If
+		//  local, the chain is only extended when that is better than
+		//  starting a new one.
+		//
+		if (minPrev != -1 and 
+				(alignType == Global or
+				 (alignType == Local and minCost < 0))) {
+			frag.cost = minCost - frag.weight;
+			frag.chainPrev = minPrev;
+			frag.chainLength = fragmentSet[minPrev].chainLength + 1;
+		}
+		else {
+			frag.chainPrev = -1;
+			frag.chainLength = 1;
+			if (alignType == Global) {
+				frag.cost = (frag.x + frag.y) * deletion - frag.weight;
+			}
+			else {
+				frag.cost = -((int) frag.weight);
+			}
+		}
+		if (minFragmentCost > frag.cost) {
+			minFragmentCost  = frag.cost;
+			minFragmentIndex = fi;
+		}
+		openFragments.push_back(fi);
+	}
+
+	int chainFragment = minFragmentIndex;
+	while (chainFragment != -1) {
+		maxFragmentChain.push_back(chainFragment);
+		chainFragment = fragmentSet[chainFragment].chainPrev;
+	}
+	std::reverse(maxFragmentChain.begin(), maxFragmentChain.end());
+	return maxFragmentChain.size();
+}
+
 #endif
@@ -1,6 +1,11 @@
 #ifndef VARIABLE_LENGTH_SDP_FRAGMENT_H_
 #define VARIABLE_LENGTH_SDP_FRAGMENT_H_
+#include <vector>
+#include <algorithm>
 #include "SDPFragment.h"
+#include "../../../Types.h"
+
+using namespace std;
 
 class ChainedFragment : public Fragment {
 	int score;
@@ -44,4 +49,46 @@ class ChainedFragment : public Fragment {
 };
 
 
+
+//
+// Merge fragments that lie on the same diagonal and overlap or abut
+// into single fragments whose length is the span of the run.  Since
+// each input fragment is an exact match of length 'weight', a run of
+// them is an exact match as well, so the merged fragment is weighted
+// by its full length.  In repetitive sequence this collapses the
+// O(length) tuple matches along a diagonal into one fragment.
+//
+template<typename T_Fragment>
+int MergeCoDiagonalFragments(vector<T_Fragment> &fragmentSet) {
+	if (fragmentSet.size() == 0) {
+		return 0;
+	}
+	// Fragment::operator< orders by diagonal, then by x.
+	std::sort(fragmentSet.begin(), fragmentSet.end());
+	VectorIndex f, cur = 0;
+	fragmentSet[0].SetLength(fragmentSet[0].weight);
+	for (f = 1; f < fragmentSet.size(); f++) {
+		int curDiag = ((int) fragmentSet[cur].y) - ((int) fragmentSet[cur].x);
+		int fDiag   = ((int) fragmentSet[f].y)   - ((int) fragmentSet[f].x);
+		unsigned int curEnd = fragmentSet[cur].x + fragmentSet[cur].GetLength();
+		if (fDiag == curDiag and fragmentSet[f].x <= curEnd) {
+			unsigned int fEnd = fragmentSet[f].x + fragmentSet[f].weight;
+			if (fEnd > curEnd) {
+				fragmentSet[cur].SetLength(fEnd - fragmentSet[cur].x);
+			}
+		}
+		else {
+			++cur;
+			fragmentSet[cur] = fragmentSet[f];
+			fragmentSet[cur].SetLength(fragmentSet[cur].weight);
+		}
+	}
+	fragmentSet.resize(cur+1);
+	for (f = 0; f < fragmentSet.size(); f++) {
+		fragmentSet[f].weight = fragmentSet[f].GetLength();
+	}
+	return fragmentSet.size();
+}
+
+
 #endif
@@ -0,0 +1,106 @@
+#ifndef ALGORITHMS_ANCHORING_ADAPTIVE_SEEDING_H_
+#define ALGORITHMS_ANCHORING_ADAPTIVE_SEEDING_H_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "../../DNASequence.h"
+#include "../../NucConversion.h"
+#include "../../datastructures/anchoring/AnchorParameters.h"
+#include "../../statistics/LookupAnchorDistribution.h"
+
+using namespace std;
+
+//
+// Choosing the seeding parameters of a read before searching for
+// anchors, rather than searching with fixed parameters and searching
+// again with a larger expand when nothing is found.
+//
+// The number of copies of a read in the genome is estimated from the
+// tuple count table of the genome: the median over all k-mers of the
+// read of the number of times the k-mer or its reverse complement
+// occur in the genome, less the number of times a random k-mer is
+// expected to occur.  The estimate is about 1 for reads from unique
+// sequence, but is coarse when the k of the table is small compared
+// to the genome (8 for the default table of a 3Gb genome), so a
+// larger -ctab is better for big genomes.  k-mers that do not occur
+// at all are sequencing errors, and are not counted.
+//
+
+template<typename T_Sequence, typename T_TupleCountTable>
+float MedianTupleCopyNumber(T_Sequence &read, DNALength start, DNALength end,
+                            T_TupleCountTable &ct, vector<int> &counts) {
+  counts.clear();
+  int k = ct.tm.tupleSize;
+  if (ct.countTable == NULL or ct.nTuples == 0 or k <= 0 or end < start + k) {
+    return 0;
+  }
+  ULong mask = (k < 32 ? (((ULong) 1) << (2 * k)) - 1 : ~((ULong) 0));
+  ULong forTuple = 0, rcTuple = 0;
+  int nValid = 0;
+  DNALength i;
+  for (i = start; i < end; i++) {
+    if (ThreeBit[read.seq[i]] > 3) {
+      nValid = 0;
+      continue;
+    }
+    ULong nuc = TwoBit[read.seq[i]];
+    forTuple = ((forTuple << 2) | nuc) & mask;
+    rcTuple  = (rcTuple >> 2) | ((3 - nuc) << (2 * (k - 1)));
+    if (++nValid >= k) {
+      int count = ct.countTable[forTuple];
+      if (rcTuple != forTuple) {
+        count += ct.countTable[rcTuple];
+      }
+      if (count > 0) {
+        counts.push_back(count);
+      }
+    }
+  }
+  if (counts.size() == 0) {
+    return 0;
+  }
+  nth_element(counts.begin(), counts.begin() + counts.size() / 2, counts.end());
+  float expectedCount = 2.0 * ct.nTuples / ct.countTableLength;
+  return max(counts[counts.size() / 2] - expectedCount, 1.0f);
+}
+
+//
+// Lengthen the seeds of a repetitive read by one base for every
+// factor of four in its number of copies, for as long
+// as the anchor distribution tables expect a true alignment of a read
+// of its length at 'accuracy' to have at least one anchor (the mean
+// less two standard deviations).  Positions are not allowed to match
+// more than a few times the number of copies of the read, and a
+// repetitive read is searched once with the maximum expand, a unique
+// read once with the minimum.
+//
+inline void SelectSeedParameters(float copyNumber, int readLength,
+                                 AnchorParameters &defaultParams, int minExpand, int maxExpand,
+                                 AnchorParameters &readParams, int &expand,
+                                 int accuracy=80, int anchorsPerCopy=4, int minAnchorsPerPosition=100) {
+  readParams = defaultParams;
+  expand     = minExpand;
+  if (copyNumber <= 2) {
+    return;
+  }
+  expand = maxExpand;
+  int nExtraBases = (int) floor(log(copyNumber) / log(4.0));
+  int k;
+  for (k = 0; k < nExtraBases; k++) {
+    float meanAnchors, sdAnchors, meanAnchorBases, sdAnchorBases;
+    LookupAnchorDistribution(readLength, readParams.minMatchLength + 1, accuracy,
+                             meanAnchors, sdAnchors, meanAnchorBases, sdAnchorBases);
+    if (meanAnchors - 2 * sdAnchors < 1) {
+      break;
+    }
+    readParams.minMatchLength++;
+  }
+  int repeatCap = max((int) (anchorsPerCopy * copyNumber), minAnchorsPerPosition);
+  if (repeatCap < readParams.maxAnchorsPerPosition) {
+    readParams.maxAnchorsPerPosition = repeatCap;
+  }
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "../../datastructures/bwt/BWT.h"
 #include "../../FASTASequence.h"
+#include "../../datastructures/suffixarray/TupleRepeatMask.h"
 
 
 
@@ -21,6 +22,17 @@ int MapReadToGenome(BWT &bwt,
 		DNALength p;
 		prefix.seq = seq.seq;
 		for (p = subreadStart + params.minMatchLength; p < subreadEnd; p++) {
+      //
+      // Matches end at p, so skip positions that end in a high copy
+      // repeat, as long as the shortest anchors are no longer than the
+      // masked k-mers (see LocateAnchorBoundsInSuffixArray).
+      //
+      if (params.repeatMaskPtr != NULL and 
+          params.repeatMaskPtr->tupleSize >= params.minMatchLength and
+          p >= subreadStart + params.repeatMaskPtr->tupleSize and
+          params.repeatMaskPtr->IsMasked(&seq.seq[p - params.repeatMaskPtr->tupleSize])) {
+        continue;
+      }
       // 
       // Try reusing the vectors between calls - not thread safe,
       // replace function call with one that has access to a buffer
@@ -2,11 +2,30 @@
 #define MAP_BY_SUFFIX_ARRAY_H_
 
 #include "datastructures/suffixarray/SuffixArray.h"
+#include "datastructures/suffixarray/TupleRepeatMask.h"
+#include "datastructures/sequence/PackedReferenceSequence.h"
 #include "datastructures/anchoring/MatchPos.h"
 #include "datastructures/anchoring/AnchorParameters.h"
 #include "algorithms/alignment/SWAlign.h"
 #include "algorithms/alignment/ScoreMatrices.h"
 
+//
+// The number of bases the reference starting at refPos and query have
+// in common, up to maxLength.
+//
+template<typename T_RefSequence>
+DNALength LengthOfExactMatch(T_RefSequence &reference, DNALength refPos, Nucleotide *query, DNALength maxLength) {
+  DNALength m = 0;
+  while (m < maxLength and reference.seq[refPos + m] == query[m]) {
+    m++;
+  }
+  return m;
+}
+
+DNALength LengthOfExactMatch(PackedReferenceSequence &reference, DNALength refPos, Nucleotide *query, DNALength maxLength) {
+  return reference.LengthOfMatch(refPos, query, maxLength);
+}
+
 /*
  * Parameters:
  * Eventually this should be strongly typed, since this is specific to
@@ -57,6 +76,23 @@ int LocateAnchorBoundsInSuffixArray(T_RefSequence &reference,
 
 	for (m = 0, p = read.subreadStart; p < matchEnd; p++, m++) {
 		DNALength lcpLow, lcpHigh, lcpLength;
+    //
+    // Positions in high copy repeats are left without a match.  The
+    // shortest anchors from p are then prefixes of a high copy k-mer,
+    // and so high copy themselves, as long as k-mers are at least as
+    // long as the shortest anchor.  Adaptive seeding may lengthen it
+    // for a read, and then the mask is not used.  The -lcpBounds line
+    // of a masked position is left empty.
+    //
+    if (params.repeatMaskPtr != NULL and 
+        params.repeatMaskPtr->tupleSize >= params.minMatchLength and
+        p + params.repeatMaskPtr->tupleSize <= read.subreadEnd and
+        params.repeatMaskPtr->IsMasked(&read.seq[p])) {
+      if (params.lcpBoundsOutPtr != NULL) {
+        *params.lcpBoundsOutPtr << endl;
+      }
+      continue;
+    }
 		lowMatchBound.clear(); highMatchBound.clear();
 		lcpLow = 0;
 		lcpHigh = 0;
@@ -137,14 +173,14 @@ int LocateAnchorBoundsInSuffixArray(T_RefSequence &reference,
         long queryPos  = p + lcpLength;
         bool extensionWasPossible = false;
 
-        while (refPos + 1 < reference.length and
-               queryPos + 1 < read.length and
-               reference.seq[refPos + 1] == read.seq[queryPos + 1] and 
-               (params.maxLCPLength == 0 or lcpLength < params.maxLCPLength)) {
-          refPos++;
-          queryPos++;
-          lcpLength++;
-          extensionWasPossible = true;
+        long maxExtension = min((long) reference.length - refPos - 1, (long) read.length - queryPos - 1);
+        if (params.maxLCPLength != 0) {
+          maxExtension = min(maxExtension, (long) params.maxLCPLength - (long) lcpLength);
+        }
+        if (maxExtension > 0) {
+          DNALength extension = LengthOfExactMatch(reference, refPos + 1, &read.seq[queryPos + 1], maxExtension);
+          lcpLength += extension;
+          extensionWasPossible = (extension > 0);
         }
 
         if (extensionWasPossible) {
@@ -6,12 +6,30 @@
 #include "../../tuples/TupleMetrics.h"
 #include "../../statistics/cdfs.h"
 #include "../../statistics/pdfs.h"
+#include "../../datastructures/sequence/PackedReferenceSequence.h"
 
+//
+// Read the tuple starting at pos of a sequence.  A packed reference
+// has no bytes to point into, so the tuple is decoded first.
+//
+template<typename TSequence, typename T_Tuple>
+int TupleFromSequence(TSequence &seq, DNALength pos, TupleMetrics &tm, T_Tuple &tuple) {
+	return tuple.FromStringLR(&seq.seq[pos], tm);
+}
+
+template<typename T_Tuple>
+int TupleFromSequence(PackedReferenceSequence &seq, DNALength pos, TupleMetrics &tm, T_Tuple &tuple) {
+	Nucleotide window[PackedReferenceText::NucsPerWord];
+	DNALength n = min((DNALength) tm.tupleSize, seq.length - pos);
+	seq.Decode(pos, n, window);
+	fill(window + n, window + tm.tupleSize, 'N');
+	return tuple.FromStringLR(window, tm);
+}
 
 template<typename TSequence, typename T_Tuple>
 int GetTupleCount(TSequence &seq, DNALength startPos, TupleMetrics &tm, TupleCountTable<TSequence, T_Tuple> &ct, int &count) {
 	T_Tuple tuple;
-	if (tuple.FromStringLR(&seq.seq[startPos], tm)) {
+	if (TupleFromSequence(seq, startPos, tm, tuple)) {
 		count = ct.countTable[tuple.ToLongIndex()];
 		return 1;
 	}
@@ -40,7 +58,7 @@ int PMatch(TSequence &seq, DNALength startPos, DNALength length, TupleMetrics &t
 		// Compute the frequency of the following tuple, and compare this
 		// to the frequencies of all 4 possible tuples that are next.
 		//		
-		curTuple.FromStringLR(&seq.seq[startPos], tm);
+		TupleFromSequence(seq, startPos, tm, curTuple);
 	  if (length < tm.tupleSize)  {
 			// the match is shorter than the tuples used to model the
 			// genome sequence composition.  Don't try and compute a p-value 
@@ -53,7 +71,7 @@ int PMatch(TSequence &seq, DNALength startPos, DNALength length, TupleMetrics &t
 			// 
 			// now add on the log counts for the transitions.
 			//
-			if (tuple.FromStringLR(&seq.seq[i+startPos], tm) == 0) {
+			if (TupleFromSequence(seq, i+startPos, tm, tuple) == 0) {
 			  return 0;
 		  }
 			int nextTupleCount = 0;
@@ -155,7 +173,7 @@ int ComputeTotalTupleCount(TupleMetrics &tm,
 	T_Tuple tuple;
 	int i;
 	for (i = 0; i < nTuples; i++) {
-		tuple.FromStringLR(&seq.seq[i], tm);
+		TupleFromSequence(seq, i, tm, tuple);
 		totalCount += ct.countTable[tuple.ToLongIndex()];
 	}
 	return totalCount;
@@ -0,0 +1,161 @@
+#ifndef ALGORITHMS_ANCHORING_SKETCH_PREFILTER_H_
+#define ALGORITHMS_ANCHORING_SKETCH_PREFILTER_H_
+
+#include <vector>
+#include <algorithm>
+
+#include "../../DNASequence.h"
+#include "../../datastructures/anchoring/MatchPos.h"
+#include "../../datastructures/anchoring/MinimizerIndex.h"
+
+using namespace std;
+
+//
+// A coarse first pass of mapping.  The minimizers of both strands of
+// a read are looked up in a minimizer index of the genome, and the
+// matches are binned by diagonal (reference minus read position).
+// When some window of diagonals has enough matches, the read is taken
+// to map near its matches, and the anchors of the read are made by
+// extending every minimizer match into a maximal exact match instead
+// of searching the suffix array or BWT for them.  Every locus with a
+// minimizer match gives anchors, so a read of a repeat is still
+// aligned to each copy.  A window is a quarter of the read long,
+// which allows for the drift in diagonal of a read with many indels.
+//
+
+class SketchHit {
+ public:
+	int strand;
+	long diagonal;
+	DNALength readPos, refPos;
+	int multiplicity;
+	SketchHit(int strandP, long diagonalP, DNALength readPosP, DNALength refPosP, int multiplicityP) {
+		strand   = strandP;
+		diagonal = diagonalP;
+		readPos  = readPosP;
+		refPos   = refPosP;
+		multiplicity = multiplicityP;
+	}
+};
+
+class SketchHitLessThan {
+ public:
+	bool operator()(const SketchHit &a, const SketchHit &b) const {
+		if (a.strand != b.strand) {
+			return a.strand < b.strand;
+		}
+		if (a.diagonal != b.diagonal) {
+			return a.diagonal < b.diagonal;
+		}
+		return a.readPos < b.readPos;
+	}
+};
+
+//
+// Returns true if the read has a locus with at least minHits matches
+// in one window.  Minimizers that occur more than maxOccurrences
+// times in the genome are ignored.  'hits' holds the matches, sorted
+// by strand, diagonal and read position.
+//
+template<typename T_Sequence>
+bool SketchShortlist(MinimizerIndex &index, T_Sequence &read, T_Sequence &readRC, bool forwardOnly,
+                     int maxOccurrences, int minHits,
+                     vector<Minimizer> &readMinimizers, vector<SketchHit> &hits) {
+	hits.clear();
+	int strand;
+	for (strand = 0; strand < (forwardOnly ? 1 : 2); strand++) {
+		T_Sequence &seq = (strand == 0 ? read : readRC);
+		readMinimizers.clear();
+		FindMinimizers(seq, 0, seq.length, index.tm, index.window, readMinimizers);
+		VectorIndex m;
+		for (m = 0; m < readMinimizers.size(); m++) {
+			VectorIndex begin, end, i;
+			index.Lookup(readMinimizers[m].hash, begin, end);
+			if (end - begin > maxOccurrences) {
+				continue;
+			}
+			for (i = begin; i < end; i++) {
+				DNALength refPos = index.minimizers[i].pos;
+				hits.push_back(SketchHit(strand, (long) refPos - (long) readMinimizers[m].pos,
+				                         readMinimizers[m].pos, refPos, end - begin));
+			}
+		}
+	}
+	if (minHits <= 0 or hits.size() < (VectorIndex) minHits) {
+		return false;
+	}
+	sort(hits.begin(), hits.end(), SketchHitLessThan());
+
+	//
+	// Count the matches in the window of diagonals starting at every
+	// match.
+	//
+	long windowSize = max((long) 256, (long) read.length / 4);
+	VectorIndex i, j = 0;
+	VectorIndex bestCount = 0;
+	for (i = 0; i < hits.size(); i++) {
+		if (j < i) {
+			j = i;
+		}
+		while (j < hits.size() and hits[j].strand == hits[i].strand and
+		       hits[j].diagonal < hits[i].diagonal + windowSize) {
+			j++;
+		}
+		bestCount = max(bestCount, j - i);
+	}
+	return bestCount >= (VectorIndex) minHits;
+}
+
+//
+// Extend the matches of SketchShortlist on each strand into maximal
+// exact matches of the read and genome, and store those of at least
+// minMatchLength bases as anchors.  A match inside the exact match of
+// an earlier one on its diagonal adds nothing, and is skipped.  The
+// multiplicity of an anchor is the number of times its minimizer
+// occurs in the genome.
+//
+template<typename T_Sequence, typename T_RefSequence>
+void SketchAnchors(T_RefSequence &genome, T_Sequence &read, T_Sequence &readRC,
+                   vector<SketchHit> &hits, int k, DNALength minMatchLength,
+                   vector<ChainedMatchPos> &matchPosList, vector<ChainedMatchPos> &rcMatchPosList) {
+	matchPosList.clear();
+	rcMatchPosList.clear();
+	VectorIndex i;
+	int  lastStrand = -1;
+	long lastDiagonal = 0;
+	DNALength lastEnd = 0;
+	for (i = 0; i < hits.size(); i++) {
+		T_Sequence &seq = (hits[i].strand == 0 ? read : readRC);
+		if (hits[i].strand == lastStrand and hits[i].diagonal == lastDiagonal and
+		    hits[i].readPos + k <= lastEnd) {
+			continue;
+		}
+		DNALength q = hits[i].readPos, t = hits[i].refPos;
+		DNALength qEnd = q, tEnd = t;
+		while (qEnd < seq.length and tEnd < genome.length and
+		       ThreeBit[seq.seq[qEnd]] < 4 and
+		       ThreeBit[seq.seq[qEnd]] == ThreeBit[genome.GetNuc(tEnd)]) {
+			qEnd++;
+			tEnd++;
+		}
+		if (qEnd - q < (DNALength) k) {
+			continue;
+		}
+		while (q > 0 and t > 0 and
+		       ThreeBit[seq.seq[q-1]] < 4 and
+		       ThreeBit[seq.seq[q-1]] == ThreeBit[genome.GetNuc(t-1)]) {
+			q--;
+			t--;
+		}
+		lastStrand   = hits[i].strand;
+		lastDiagonal = hits[i].diagonal;
+		lastEnd      = qEnd;
+		if (qEnd - q < minMatchLength) {
+			continue;
+		}
+		vector<ChainedMatchPos> &anchors = (hits[i].strand == 0 ? matchPosList : rcMatchPosList);
+		anchors.push_back(ChainedMatchPos(t, q, qEnd - q, hits[i].multiplicity));
+	}
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "../../statistics/statutils.h"
 
 #include <vector>
+#include <algorithm>
 
 template<typename T_Sequence>
 void FindRandomPos(vector<T_Sequence> &sequences, DNALength &seqIndex, DNALength &seqPos, DNALength seqLength=0 ) {
@@ -67,4 +68,55 @@ void FindRandomPos(vector<T_Sequence> &sequences, DNALength &seqIndex, DNALength
 }
 
 
+template<typename T_Sequence>
+void ComputeCumulativeLengths(vector<T_Sequence> &sequences, vector<UInt> &cumulativeLengths) {
+	cumulativeLengths.resize(sequences.size());
+	DNALength cumulativeLength = 0;
+	int i;
+	for (i = 0; i < sequences.size(); i++) {
+		cumulativeLengths[i] = cumulativeLength = cumulativeLength + sequences[i].length;
+	}
+}
+
+//
+// The same as above, drawing from the random stream 'randomStream',
+// with the cumulative lengths computed once ahead of time so that
+// many threads may draw positions at once.
+//
+template<typename T_Sequence, typename T_Random>
+void FindRandomPos(vector<T_Sequence> &sequences, vector<UInt> &cumulativeLengths, 
+                   DNALength &seqIndex, DNALength &seqPos, DNALength seqLength,
+                   T_Random &randomStream) {
+	if (sequences.size() == 0) {
+		return;
+	}
+	DNALength cumulativeLength = cumulativeLengths[cumulativeLengths.size()-1];
+	int iter = 0;
+	int max_iter = 100000;
+	bool validPosFound = false;
+	while (validPosFound == false and seqLength <= cumulativeLength and iter < max_iter) {
+		++iter;
+		DNALength pos = randomStream.RandomUnsignedInt(cumulativeLength - seqLength);
+		seqIndex = upper_bound(cumulativeLengths.begin(), cumulativeLengths.end(), pos) - cumulativeLengths.begin();
+		if (cumulativeLengths[seqIndex] - pos < seqLength) {
+			continue;
+		}
+		seqPos = (seqIndex == 0 ? pos : pos - cumulativeLengths[seqIndex-1]);
+		UInt pi;
+		validPosFound = true;
+		for (pi = seqPos; pi < seqPos + seqLength; pi++) {
+			if (toupper(sequences[seqIndex].seq[pi]) == 'N') {
+				validPosFound = false;
+				break;
+			}
+		}
+	}
+	if (validPosFound == false) {
+		cout << "ERROR! Unable to generate a random seq/pos pair!, maybe length " << seqLength << endl
+         << " is too high, or there are too many N's in the references." << endl;
+		exit(1);
+	}
+}
+
+
 #endif
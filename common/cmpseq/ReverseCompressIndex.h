@@ -2,6 +2,34 @@
 #define CMPSEQ_REVERSE_COMPRESS_INDEX_H_
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include "../DNASequence.h"
+
+using namespace std;
+
+//
+// Condense each run of one nucleotide in seq to a single base, in the
+// same way as CompressedSequence::CondenseHomopolymers, writing the
+// result to dest (which may be seq).  When runStart is given, the
+// position in seq of every condensed base is stored there.
+//
+template<typename T_Nucleotide>
+DNALength CondenseHomopolymers(T_Nucleotide *seq, DNALength length, T_Nucleotide *dest,
+                               vector<DNALength> *runStart=NULL) {
+	DNALength i, c;
+	if (runStart != NULL) {
+		runStart->clear();
+	}
+	for (i = 0, c = 0; i < length; c++, i++) {
+		if (runStart != NULL) {
+			runStart->push_back(i);
+		}
+		T_Nucleotide nuc = seq[i];
+		while (i < length - 1 and ThreeBit[seq[i]] == ThreeBit[seq[i+1]]) i++;
+		dest[c] = nuc;
+	}
+	return c;
+}
 
 class ReverseCompressIndex {
  public:
@@ -31,6 +59,52 @@ class ReverseCompressIndex {
 		in.read((char*) index, sizeof(int) *indexLength);
 	} 
 	
+	//
+	// Store the start of every binSize'th homopolymer run of seq, so
+	// that a position in the condensed copy of seq may be mapped back
+	// to seq by walking over fewer than binSize runs.
+	//
+	void Build(Nucleotide *seq, DNALength length, int binSizeP) {
+		binSize = binSizeP;
+		maxRun  = 0;
+		DNALength i, nRuns = 0;
+		for (i = 0; i < length; i++) {
+			if (i == 0 or ThreeBit[seq[i]] != ThreeBit[seq[i-1]]) {
+				++nRuns;
+			}
+		}
+		if (index != NULL) {
+			delete[] index;
+		}
+		indexLength = nRuns / binSize + 1;
+		index = new int[indexLength];
+		DNALength run = 0;
+		for (i = 0; i < length; i++) {
+			if (i == 0 or ThreeBit[seq[i]] != ThreeBit[seq[i-1]]) {
+				if (run % binSize == 0) {
+					index[run / binSize] = i;
+				}
+				++run;
+			}
+		}
+	}
+
+	//
+	// The text may be a Nucleotide* or anything else with operator[].
+	//
+	template<typename T_Text>
+	DNALength Lookup(T_Text seq, DNALength length, DNALength cmpPos) {
+		DNALength pos = index[cmpPos / binSize];
+		DNALength run;
+		for (run = (cmpPos / binSize) * binSize; run < cmpPos and pos < length; run++) {
+			++pos;
+			while (pos < length and ThreeBit[seq[pos]] == ThreeBit[seq[pos-1]]) {
+				++pos;
+			}
+		}
+		return pos;
+	}
+
 	void ShallowCopy(ReverseCompressIndex &rhs) {
 		index = rhs.index;
 		indexLength = rhs.indexLength;
@@ -75,6 +75,14 @@ class BufferedHDFArray : public HDFData, public HDFWriteBuffer<T> {
 	}
   
   void SetBufferSize(int _bufferSize) {
+		//
+		// Write out anything in the old buffer before replacing it.
+		//
+		if (this->isInitialized) {
+			Flush();
+		}
+		this->Free();
+		this->bufferIndex = 0;
 		this->InitializeBuffer(_bufferSize);
   }
 
@@ -19,6 +19,7 @@
 #include "SMRTSequence.h"
 #include "Enumerations.h"
 #include "utils/ChangeListID.h"
+#include "utils/RegionUtils.h"
 using namespace H5;
 using namespace std;
 
@@ -107,6 +108,18 @@ class T_HDFBasReader : public DatasetCollection, public HDFPulseDataFile {
 	bool useQuality;
   bool readBasesFromCCS;
   QVScale qvScale;
+  //
+  // When set, only the bases in the HQ region of each read in this
+  // table are read from the file.  The rest of the bases, or all of
+  // them when a read has no HQ region, are N, as MaskRead would leave
+  // them.  Quality values and the other per-base fields are still
+  // read in full.  Every ZMW is still returned in order, so this does
+  // not change the position of the reader.
+  // readRangeStart/End is the part of the current read that is read
+  // from the file.
+  //
+  RegionTable *hqRegionTable;
+  DNALength readRangeStart, readRangeEnd;
 
  public:
 	PlatformId GetPlatform() {
@@ -147,6 +160,8 @@ class T_HDFBasReader : public DatasetCollection, public HDFPulseDataFile {
     nBases       = 0;
     preparedForRandomAccess = false;
     readBasesFromCCS = false;
+    hqRegionTable  = NULL;
+    readRangeStart = readRangeEnd = 0;
 		baseCallsGroupName = "BaseCalls";
 		qualityFieldsAreCritical = true;
 		useZmwReader = false;
@@ -227,6 +242,63 @@ class T_HDFBasReader : public DatasetCollection, public HDFPulseDataFile {
     InitializeDefaultCCSIncludeFields();
     readBasesFromCCS = true;
   }
+
+  void SetHQRegionTable(RegionTable *regionTable) {
+    hqRegionTable = regionTable;
+  }
+
+  //
+  // Move forward to read 'readIndex' reading only the lengths of the
+  // reads in between, a block at a time.  This is used to resume
+  // mapping part way through a file.  A read past the end, as when the
+  // last read of a -stride partition was done, leaves the reader at
+  // the end.
+  //
+  int SkipTo(int readIndex) {
+    if (readIndex < curRead) {
+      return 0;
+    }
+    readIndex = min(readIndex, (int) nReads);
+    vector<int> seqLengths;
+    while (curRead < readIndex) {
+      int nSkip = min(readIndex - curRead, 65536);
+      seqLengths.resize(nSkip);
+      zmwReader.numEventArray.Read(curRead, curRead + nSkip, &seqLengths[0]);
+      int i;
+      for (i = 0; i < nSkip; i++) {
+        curBasePos += seqLengths[i];
+      }
+      curRead += nSkip;
+      zmwReader.Advance(nSkip);
+    }
+    return 1;
+  }
+
+  void SetReadRange(unsigned int holeNumber, int seqLength) {
+    readRangeStart = 0;
+    readRangeEnd   = seqLength;
+    if (hqRegionTable != NULL) {
+      int hqStart, hqEnd, hqScore;
+      LookupHQRegion(holeNumber, *hqRegionTable, hqStart, hqEnd, hqScore);
+      readRangeStart = min(max(hqStart, 0), seqLength);
+      readRangeEnd   = max((int) readRangeStart, min(hqEnd, seqLength));
+    }
+  }
+
+  //
+  // Read the values of a field for the current read that are inside
+  // the read range, and fill in the rest.  Only used for the bases.
+  //
+  template<typename T_Value>
+  void ReadFieldInRange(HDFArray<T_Value> &array, T_Value *dest, DNALength length, T_Value fillValue) {
+    DNALength rangeStart = min(readRangeStart, length);
+    DNALength rangeEnd   = min(readRangeEnd, length);
+    std::fill(dest, dest + rangeStart, fillValue);
+    if (rangeEnd > rangeStart) {
+      array.Read(curBasePos + rangeStart, curBasePos + rangeEnd, dest + rangeStart);
+    }
+    std::fill(dest + rangeEnd, dest + length, fillValue);
+  }
   
   void GetChangeListID(string &changeListID) {
     if (changeListIDAtom.initialized) {
@@ -672,17 +744,19 @@ class T_HDFBasReader : public DatasetCollection, public HDFPulseDataFile {
 		seq.length = 0;
 		seq.seq = NULL;
 
+		unsigned int holeNumber;
+		zmwReader.holeNumberArray.Read(curRead, curRead+1, &holeNumber);
+		SetReadRange(holeNumber, seqLength);
+
 		if (includedFields["Basecall"]) {
 			if (seqLength > 0) {
 				ResizeSequence(seq, seqLength);
-				baseArray.Read(curBasePos, curBasePos + seqLength, (unsigned char*) seq.seq);
+				ReadFieldInRange(baseArray, (unsigned char*) seq.seq, seqLength, (unsigned char) 'N');
 			}
 		}
 
 		string readTitle;
-		unsigned int holeNumber;
     unsigned char holeStatus;
-		zmwReader.holeNumberArray.Read(curRead, curRead+1, &holeNumber);
 		seq.StoreHoleNumber(holeNumber);
 		seq.StoreHoleStatus(holeStatus);
 
@@ -138,6 +138,32 @@ class HDFBasWriter : public DatasetCollection {
 			simulatedSequenceIndexArray.Flush();
 	}
 
+	//
+	// Set the number of elements buffered per dataset before a write
+	// to the file.  The default (1024) makes for many small writes
+	// when writing millions of reads.
+	//
+	void SetBufferSize(int size) {
+		nElemArray.SetBufferSize(size);
+		zmwXCoordArray.SetBufferSize(size);
+		zmwYCoordArray.SetBufferSize(size);
+		baseArray.SetBufferSize(size);
+		qualArray.SetBufferSize(size);
+		simulatedCoordinateArray.SetBufferSize(size);
+		simulatedSequenceIndexArray.SetBufferSize(size);
+		holeNumberArray.SetBufferSize(size);
+		holeStatusArray.SetBufferSize(size);
+		deletionQVArray.SetBufferSize(size);
+		deletionTagArray.SetBufferSize(size);
+		insertionQVArray.SetBufferSize(size);
+		substitutionTagArray.SetBufferSize(size);
+		substitutionQVArray.SetBufferSize(size);
+		mergeQVArray.SetBufferSize(size);
+		preBaseFramesArray.SetBufferSize(size);
+		widthInFramesArray.SetBufferSize(size);
+		pulseIndexArray.SetBufferSize(size);
+	}
+
 	HDFBasWriter() {
 		/*
 		 * Default to astro for now.  This may need to change to a NO_ID
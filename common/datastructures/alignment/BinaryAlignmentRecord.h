@@ -0,0 +1,157 @@
+#ifndef DATASTRUCTURES_ALIGNMENT_BINARY_ALIGNMENT_RECORD_H_
+#define DATASTRUCTURES_ALIGNMENT_BINARY_ALIGNMENT_RECORD_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+#include "AlignmentBlock.h"
+
+using namespace std;
+
+//
+// A compact binary alignment format, written by blasr -m 7, so that
+// tools that only need the coordinates and blocks of alignments do
+// not parse text.  A file is a BinaryAlignmentFileHeader followed by
+// records, each of which is:
+//
+//   BinaryAlignmentRecordHeader
+//   nBlocks blocks, as Block (qPos, tPos, length; 32 bits each)
+//   qName, qNameLength characters, not null terminated
+//   tName, tNameLength characters
+//   nQVs quality values of the aligned query, one byte each
+//   padding to a multiple of 4 bytes
+//
+// Every field is at least 4-byte aligned in a file that is mapped at a
+// page boundary, so records are read in place.  Coordinates follow
+// the alignment candidates of blasr (as in -m 4 and -m 5): when
+// tStrand is 1, target coordinates are on the reverse complement of
+// the target, and block coordinates are relative to
+// (qAlignedSeqPos + qPos, tAlignedSeqPos + tPos).  Values are written
+// in the byte order of the machine that wrote them.
+//
+
+class BinaryAlignmentFileHeader {
+ public:
+	char     magic[8];
+	uint32_t version;
+	uint32_t headerLength;
+
+	static const char *MagicString() {
+		return "BLASRALN";
+	}
+
+	enum { CurrentVersion = 1 };
+
+	void Initialize() {
+		memcpy(magic, MagicString(), 8);
+		version      = CurrentVersion;
+		headerLength = sizeof(BinaryAlignmentFileHeader);
+	}
+
+	bool IsValid() const {
+		return (memcmp(magic, MagicString(), 8) == 0 and version == CurrentVersion);
+	}
+};
+
+class BinaryAlignmentRecordHeader {
+ public:
+	uint32_t recordLength;
+	uint32_t qNameLength, tNameLength;
+	uint32_t nBlocks, nQVs;
+	uint32_t readIndex;
+	int32_t  tIndex;
+	uint32_t qLength, tLength;
+	uint32_t qAlignedSeqPos, tAlignedSeqPos;
+	uint32_t qPos, tPos;
+	int32_t  score;
+	float    pctSimilarity;
+	uint32_t nMatch, nMismatch, nIns, nDel;
+	uint8_t  qStrand, tStrand, mapQV, flags;
+};
+
+//
+// The record layout depends on these sizes.
+//
+typedef char BinaryAlignmentRecordHeaderSizeCheck[(sizeof(BinaryAlignmentRecordHeader) == 80) ? 1 : -1];
+typedef char BinaryAlignmentBlockSizeCheck[(sizeof(Block) == 12) ? 1 : -1];
+
+//
+// A record in place in a buffer: the fields point into the buffer.
+//
+class BinaryAlignmentRecord {
+ public:
+	BinaryAlignmentRecordHeader *header;
+	Block         *blocks;
+	char          *qName, *tName;
+	unsigned char *qvs;
+
+	BinaryAlignmentRecord() {
+		header = NULL;
+		blocks = NULL;
+		qName  = tName = NULL;
+		qvs    = NULL;
+	}
+
+	static uint32_t RecordLength(uint32_t nBlocks, uint32_t qNameLength, uint32_t tNameLength, uint32_t nQVs) {
+		uint32_t length = sizeof(BinaryAlignmentRecordHeader) + nBlocks * sizeof(Block) +
+			qNameLength + tNameLength + nQVs;
+		return (length + 3) & ~((uint32_t) 3);
+	}
+
+	//
+	// Point the record at the bytes starting at recordPtr, of which
+	// there are at most maxLength.  Returns false if the bytes do not
+	// hold a whole record.
+	//
+	bool Set(char *recordPtr, uint64_t maxLength) {
+		if (maxLength < sizeof(BinaryAlignmentRecordHeader)) {
+			return false;
+		}
+		header = (BinaryAlignmentRecordHeader*) recordPtr;
+		if (header->recordLength > maxLength or
+				header->recordLength != RecordLength(header->nBlocks, header->qNameLength,
+																						 header->tNameLength, header->nQVs)) {
+			return false;
+		}
+		char *p = recordPtr + sizeof(BinaryAlignmentRecordHeader);
+		blocks = (Block*) p;
+		p += header->nBlocks * sizeof(Block);
+		qName = p;
+		p += header->qNameLength;
+		tName = p;
+		p += header->tNameLength;
+		qvs = (header->nQVs > 0 ? (unsigned char*) p : NULL);
+		return true;
+	}
+
+	//
+	// Copy the record into an alignment candidate.  The aligned
+	// sequences are not stored, so they are left unset.
+	//
+	template<typename T_AlignmentCandidate>
+	void StoreAlignmentCandidate(T_AlignmentCandidate &alignment) {
+		alignment.qName.assign(qName, header->qNameLength);
+		alignment.tName.assign(tName, header->tNameLength);
+		alignment.readIndex      = header->readIndex;
+		alignment.tIndex         = header->tIndex;
+		alignment.qLength        = header->qLength;
+		alignment.tLength        = header->tLength;
+		alignment.qAlignedSeqPos = header->qAlignedSeqPos;
+		alignment.tAlignedSeqPos = header->tAlignedSeqPos;
+		alignment.qPos           = header->qPos;
+		alignment.tPos           = header->tPos;
+		alignment.qStrand        = header->qStrand;
+		alignment.tStrand        = header->tStrand;
+		alignment.score          = header->score;
+		alignment.pctSimilarity  = header->pctSimilarity;
+		alignment.mapQV          = header->mapQV;
+		alignment.nMatch         = header->nMatch;
+		alignment.nMismatch      = header->nMismatch;
+		alignment.nIns           = header->nIns;
+		alignment.nDel           = header->nDel;
+		alignment.blocks.assign(blocks, blocks + header->nBlocks);
+	}
+};
+
+#endif
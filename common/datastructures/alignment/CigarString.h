@@ -18,6 +18,7 @@ class CigarString : public string {
         operations.push_back(o);
       }
     }
+    return lengths.size();
   }
 };
 
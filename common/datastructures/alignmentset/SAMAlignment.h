@@ -159,6 +159,7 @@ class SAMAlignment {
         cout <<"ERROR.  Could not parse typed keyword value " << typedKVPair << endl;
       }
     }
+    return true;
   }
 };
 
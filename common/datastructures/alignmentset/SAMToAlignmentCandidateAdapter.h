@@ -234,9 +234,12 @@ void ReverseAlignmentOperations(vector<int> &lengths, vector<char> &ops) {
   reverse(ops.begin(), ops.end());
 }
 
+//
+// Split a SAM line into candidates against its reference, which the
+// caller has already looked up.
+//
 void SAMAlignmentsToCandidates(SAMAlignment &sam,
-                               vector<FASTASequence> &referenceSequences,
-                               map<string,int> &refIDToListIndex,
+                               FASTASequence &referenceSequence,
                                vector<AlignmentCandidate<> > &candidates, 
                                bool parseSmrtTitle = false,
                                bool keepRefAsForward = true) {
@@ -405,16 +408,7 @@ void SAMAlignmentsToCandidates(SAMAlignment &sam,
       continue;
     }
     else {
-      int refIndex;
-      int s = refIDToListIndex.size();
-      if (refIDToListIndex.find(sam.rName) == refIDToListIndex.end()) {
-        cout <<" ERROR.  SAM Reference " << sam.rName << " is not found in the list of reference contigs." << endl;
-        exit(1);
-      }
-      
-      refIndex = refIDToListIndex[sam.rName];
-     
-      alignment.tLength = referenceSequences[refIndex].length;
+      alignment.tLength = referenceSequence.length;
       alignment.qLength = sam.seq.size(); 
       alignment.qName = sam.qName;
       alignment.tName = sam.rName;
@@ -428,20 +422,20 @@ void SAMAlignmentsToCandidates(SAMAlignment &sam,
         // proper printing.
         //
         alignment.tAlignedSeqPos = samTStart + (samTEnd - tAlignStart - alignment.tAlignedSeqLength);
-		if (alignment.tAlignedSeqLength > referenceSequences[refIndex].length ||
-			alignment.tAlignedSeqPos    > referenceSequences[refIndex].length ||
-			alignment.tAlignedSeqLength + alignment.tAlignedSeqPos > referenceSequences[refIndex].length + 2) {
+		if (alignment.tAlignedSeqLength > referenceSequence.length ||
+			alignment.tAlignedSeqPos    > referenceSequence.length ||
+			alignment.tAlignedSeqLength + alignment.tAlignedSeqPos > referenceSequence.length + 2) {
             //alignment.tAlignedSeqPos is 1 based and unsigned.
 			cout << "WARNING. The mapping of read " << alignment.qName  
 				 << " to reference "      << alignment.tName 
                  << " is out of bounds."  << endl
                  << "         StartPos (" << alignment.tAlignedSeqPos  
                  << ") + AlnLength (" << alignment.tAlignedSeqLength 
-                 << ") > RefLength (" << referenceSequences[refIndex].length
+                 << ") > RefLength (" << referenceSequence.length
                  << ") + 2 "          << endl;
             continue;
 		}
-        ((DNASequence*)&alignment.tAlignedSeq)->Copy(referenceSequences[refIndex], alignment.tAlignedSeqPos, alignment.tAlignedSeqLength);             
+        ((DNASequence*)&alignment.tAlignedSeq)->Copy(referenceSequence, alignment.tAlignedSeqPos, alignment.tAlignedSeqLength);             
         alignment.tAlignedSeq.ReverseComplementSelf();
         // either ref or read is defined as being in the forward
         // orientation.  Here, since refAsForward is false, the read
@@ -453,20 +447,20 @@ void SAMAlignmentsToCandidates(SAMAlignment &sam,
         alignment.qStrand = 0;
       }
       else {
-        if (alignment.tAlignedSeqLength > referenceSequences[refIndex].length ||
-			alignment.tAlignedSeqPos    > referenceSequences[refIndex].length ||
-			alignment.tAlignedSeqLength + alignment.tAlignedSeqPos > referenceSequences[refIndex].length + 2) {
+        if (alignment.tAlignedSeqLength > referenceSequence.length ||
+			alignment.tAlignedSeqPos    > referenceSequence.length ||
+			alignment.tAlignedSeqLength + alignment.tAlignedSeqPos > referenceSequence.length + 2) {
             //alignment.tAlignedSeqPos is 1 based and unsigned. 
 			cout << "WARNING. The mapping of read " << alignment.qName  
 				 << " to reference "      << alignment.tName 
                  << " is out of bounds."  << endl
                  << "         StartPos (" << alignment.tAlignedSeqPos  
                  << ") + AlnLength (" << alignment.tAlignedSeqLength 
-                 << ") > RefLength (" << referenceSequences[refIndex].length
+                 << ") > RefLength (" << referenceSequence.length
                  << ") + 2 "          << endl;
             continue;
 		}
-        ((DNASequence*)&alignment.tAlignedSeq)->Copy(referenceSequences[refIndex], 
+        ((DNASequence*)&alignment.tAlignedSeq)->Copy(referenceSequence, 
                                                      alignment.tAlignedSeqPos, 
                                                      alignment.tAlignedSeqLength);
       }
@@ -482,5 +476,26 @@ void SAMAlignmentsToCandidates(SAMAlignment &sam,
   querySeq.Free();
 }
 
+void SAMAlignmentsToCandidates(SAMAlignment &sam,
+                               vector<FASTASequence> &referenceSequences,
+                               map<string,int> &refIDToListIndex,
+                               vector<AlignmentCandidate<> > &candidates, 
+                               bool parseSmrtTitle = false,
+                               bool keepRefAsForward = true) {
+  if (sam.rName == "*") {
+    //
+    // No reference, so there are no candidates.
+    //
+    return;
+  }
+  map<string,int>::iterator refIt = refIDToListIndex.find(sam.rName);
+  if (refIt == refIDToListIndex.end()) {
+    cout <<" ERROR.  SAM Reference " << sam.rName << " is not found in the list of reference contigs." << endl;
+    exit(1);
+  }
+  SAMAlignmentsToCandidates(sam, referenceSequences[refIt->second], candidates,
+                            parseSmrtTitle, keepRefAsForward);
+}
+
 
 #endif
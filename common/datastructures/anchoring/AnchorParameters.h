@@ -6,6 +6,8 @@
 #include "../../qvs/QualityValue.h"
 #include "../../DNASequence.h"
 
+class TupleRepeatMask;
+
 class AnchorParameters {
  public:
 	 QualityValue branchQualityThreshold;
@@ -23,6 +25,11 @@ class AnchorParameters {
 	 bool removeEncompassedMatches;
    ostream *lcpBoundsOutPtr;
    int branchExpand;
+   //
+   // Read positions starting with a tuple in this mask are not
+   // searched.
+   //
+   TupleRepeatMask *repeatMaskPtr;
 
 	 AnchorParameters() {
 		 branchQualityThreshold = 0;
@@ -40,6 +47,7 @@ class AnchorParameters {
 		 verbosity              = 0;
      lcpBoundsOutPtr        = NULL;
      branchExpand           = 0;
+     repeatMaskPtr          = NULL;
 	 }
 
 	 AnchorParameters &Assign(const AnchorParameters &rhs) {
@@ -60,6 +68,7 @@ class AnchorParameters {
 		 verbosity              = rhs.verbosity;
 		 removeEncompassedMatches= rhs.removeEncompassedMatches;
      branchExpand           = rhs.branchExpand;
+     repeatMaskPtr          = rhs.repeatMaskPtr;
      return *this;
 	 }
 
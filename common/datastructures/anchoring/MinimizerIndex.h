@@ -0,0 +1,147 @@
+#ifndef DATASTRUCTURES_ANCHORING_MINIMIZER_INDEX_H_
+#define DATASTRUCTURES_ANCHORING_MINIMIZER_INDEX_H_
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include "../../Types.h"
+#include "../../DNASequence.h"
+#include "../../NucConversion.h"
+#include "../../tuples/TupleMetrics.h"
+
+using namespace std;
+
+//
+// A (w,k) minimizer of a sequence is the k-mer with the smallest
+// hash among w consecutive k-mers.  Two sequences that share a
+// stretch of w+k-1 bases share the minimizer of that stretch, so the
+// minimizers of a read that also appear in the genome point to where
+// the read maps, while only keeping about 2/(w+1) of the positions.
+// k-mers are hashed so that minimizers are not biased toward poly-A.
+// k is at most 16, so that a hash and position take 8 bytes.
+//
+class Minimizer {
+ public:
+	enum { MaxTupleSize = 16 };
+	UInt hash;
+	DNALength pos;
+	Minimizer(UInt hashP=0, DNALength posP=0) {
+		hash = hashP;
+		pos  = posP;
+	}
+};
+
+//
+// An invertible hash of the 2k bit integers.
+//
+inline ULong HashTuple(ULong key, ULong mask) {
+	key = (~key + (key << 21)) & mask;
+	key = key ^ (key >> 24);
+	key = ((key + (key << 3)) + (key << 8)) & mask;
+	key = key ^ (key >> 14);
+	key = ((key + (key << 2)) + (key << 4)) & mask;
+	key = key ^ (key >> 28);
+	key = (key + (key << 31)) & mask;
+	return key;
+}
+
+//
+// Append the minimizers of seq[start,end) to minimizers.  k-mers that
+// contain a base other than A,C,G,T are skipped.
+//
+template<typename T_Sequence>
+void FindMinimizers(T_Sequence &seq, DNALength start, DNALength end, TupleMetrics &tm, int window,
+										vector<Minimizer> &minimizers) {
+	int k = tm.tupleSize;
+	ULong mask = (((ULong) 1) << (2 * k)) - 1;
+	ULong tuple = 0;
+	int nValid = 0;
+	//
+	// The k-mers of the current window in order of position with
+	// increasing hashes, so the minimizer is always the front.
+	//
+	deque<Minimizer> candidates;
+	bool haveLast = false;
+	DNALength lastPos = 0;
+	DNALength p;
+	for (p = start; p < end; p++) {
+		Nucleotide nuc = seq.seq[p];
+		if (ThreeBit[nuc] > 3) {
+			nValid = 0;
+			candidates.clear();
+			continue;
+		}
+		tuple = ((tuple << 2) | TwoBit[nuc]) & mask;
+		if (++nValid < k) {
+			continue;
+		}
+		DNALength tuplePos = p + 1 - k;
+		Minimizer m(HashTuple(tuple, mask), tuplePos);
+		while (candidates.size() > 0 and candidates.back().hash >= m.hash) {
+			candidates.pop_back();
+		}
+		candidates.push_back(m);
+		while (candidates.front().pos + window <= tuplePos) {
+			candidates.pop_front();
+		}
+		if (nValid >= k + window - 1) {
+			if (haveLast == false or candidates.front().pos != lastPos) {
+				minimizers.push_back(candidates.front());
+				lastPos  = candidates.front().pos;
+				haveLast = true;
+			}
+		}
+	}
+}
+
+class MinimizerLessThan {
+ public:
+	bool operator()(const Minimizer &a, const Minimizer &b) const {
+		if (a.hash != b.hash) {
+			return a.hash < b.hash;
+		}
+		return a.pos < b.pos;
+	}
+};
+
+//
+// The minimizers of a genome, sorted by hash so that the positions of
+// a minimizer of a read are found with a binary search.
+//
+class MinimizerIndex {
+ public:
+	TupleMetrics tm;
+	int window;
+	vector<Minimizer> minimizers;
+
+	MinimizerIndex() {
+		window = 0;
+	}
+
+	template<typename T_Sequence>
+	void Build(T_Sequence &genome, int k, int windowP) {
+		tm.Initialize(k);
+		window = windowP;
+		minimizers.clear();
+		FindMinimizers(genome, 0, genome.length, tm, window, minimizers);
+		sort(minimizers.begin(), minimizers.end(), MinimizerLessThan());
+	}
+
+	//
+	// The range [begin,end) of minimizers with the given hash.
+	//
+	void Lookup(UInt hash, VectorIndex &begin, VectorIndex &end) {
+		vector<Minimizer>::iterator lb, ub;
+		lb = lower_bound(minimizers.begin(), minimizers.end(), Minimizer(hash, 0), MinimizerLessThan());
+		ub = upper_bound(lb, minimizers.end(), Minimizer(hash, (DNALength) -1), MinimizerLessThan());
+		begin = lb - minimizers.begin();
+		end   = ub - minimizers.begin();
+	}
+
+	long GetStorageSize() {
+		return minimizers.size() * sizeof(Minimizer);
+	}
+};
+
+#endif
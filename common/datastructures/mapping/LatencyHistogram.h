@@ -0,0 +1,192 @@
+#ifndef DATASTRUCTURES_MAPPING_LATENCY_HISTOGRAM_H_
+#define DATASTRUCTURES_MAPPING_LATENCY_HISTOGRAM_H_
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+//
+// A log-linear histogram in the style of HdrHistogram.  Values below
+// 2^subBucketBits are counted exactly.  Above that, every power of
+// two range is split into 2^(subBucketBits-1) equal width buckets, so
+// the relative error of any reported value is bounded by
+// 1/2^(subBucketBits-1) regardless of magnitude.  This keeps a
+// histogram of microsecond latencies ranging from a few usec to days
+// in a few hundred counters, and two histograms may be merged by
+// adding counters.
+//
+class LatencyHistogram {
+ public:
+  static const int subBucketBits  = 5;
+  static const int subBucketCount = 1 << subBucketBits;
+  static const int subBucketHalf  = subBucketCount / 2;
+  static const int maxValueBits   = 48;
+
+  vector<long long> counts;
+  long long nSamples;
+  long long sum;
+  long long minValue, maxValue;
+
+  LatencyHistogram() {
+    Reset();
+  }
+
+  void Reset() {
+    counts.clear();
+    nSamples = 0;
+    sum      = 0;
+    minValue = 0;
+    maxValue = 0;
+  }
+
+  static int NumBuckets() {
+    return subBucketCount + (maxValueBits - subBucketBits) * subBucketHalf;
+  }
+
+  static int MostSignificantBit(long long value) {
+    int msb = 0;
+    while (value >>= 1) {
+      ++msb;
+    }
+    return msb;
+  }
+
+  static int ValueToBucket(long long value) {
+    if (value < 0) {
+      value = 0;
+    }
+    if (value < subBucketCount) {
+      return value;
+    }
+    int msb = MostSignificantBit(value);
+    if (msb >= maxValueBits) {
+      return NumBuckets() - 1;
+    }
+    int shift = msb - subBucketBits + 1;
+    return subBucketCount + (msb - subBucketBits) * subBucketHalf +
+      (int) ((value >> shift) - subBucketHalf);
+  }
+
+  static long long BucketLowerBound(int bucket) {
+    if (bucket < subBucketCount) {
+      return bucket;
+    }
+    int magnitude = (bucket - subBucketCount) / subBucketHalf;
+    int offset    = (bucket - subBucketCount) % subBucketHalf;
+    int shift     = magnitude + 1;
+    return ((long long) (offset + subBucketHalf)) << shift;
+  }
+
+  static long long BucketUpperBound(int bucket) {
+    if (bucket < subBucketCount) {
+      return bucket;
+    }
+    int magnitude = (bucket - subBucketCount) / subBucketHalf;
+    return BucketLowerBound(bucket) + (1LL << (magnitude + 1)) - 1;
+  }
+
+  void Add(long long value, long long count=1) {
+    if (counts.size() == 0) {
+      counts.resize(NumBuckets(), 0);
+    }
+    if (value < 0) {
+      value = 0;
+    }
+    if (nSamples == 0) {
+      minValue = maxValue = value;
+    }
+    else {
+      minValue = min(minValue, value);
+      maxValue = max(maxValue, value);
+    }
+    counts[ValueToBucket(value)] += count;
+    nSamples += count;
+    sum      += value * count;
+  }
+
+  void Merge(const LatencyHistogram &rhs) {
+    if (rhs.nSamples == 0) {
+      return;
+    }
+    if (counts.size() == 0) {
+      counts.resize(NumBuckets(), 0);
+    }
+    int b;
+    for (b = 0; b < rhs.counts.size(); b++) {
+      counts[b] += rhs.counts[b];
+    }
+    if (nSamples == 0) {
+      minValue = rhs.minValue;
+      maxValue = rhs.maxValue;
+    }
+    else {
+      minValue = min(minValue, rhs.minValue);
+      maxValue = max(maxValue, rhs.maxValue);
+    }
+    nSamples += rhs.nSamples;
+    sum      += rhs.sum;
+  }
+
+  long long GetCount() const {
+    return nSamples;
+  }
+
+  float GetMean() const {
+    if (nSamples == 0) {
+      return 0;
+    }
+    return ((float) sum) / nSamples;
+  }
+
+  //
+  // Return the (upper bound of the bucket containing the) value
+  // below which 'pct' percent of the samples fall.
+  //
+  long long GetPercentile(float pct) const {
+    if (nSamples == 0) {
+      return 0;
+    }
+    long long rank = (long long) ((pct / 100.0) * nSamples + 0.5);
+    if (rank < 1) {
+      rank = 1;
+    }
+    long long seen = 0;
+    int b;
+    for (b = 0; b < counts.size(); b++) {
+      seen += counts[b];
+      if (seen >= rank) {
+        return min(BucketUpperBound(b), maxValue);
+      }
+    }
+    return maxValue;
+  }
+
+  void PrintJSON(ostream &out) const {
+    out << "{\"count\": " << nSamples
+        << ", \"min\": "  << minValue
+        << ", \"mean\": " << GetMean()
+        << ", \"p50\": "  << GetPercentile(50)
+        << ", \"p90\": "  << GetPercentile(90)
+        << ", \"p99\": "  << GetPercentile(99)
+        << ", \"p999\": " << GetPercentile(99.9)
+        << ", \"max\": "  << maxValue
+        << ", \"buckets\": [";
+    //
+    // Only print occupied buckets as [lower, upper, count] triples to
+    // keep the dump small.
+    //
+    int b;
+    bool first = true;
+    for (b = 0; b < counts.size(); b++) {
+      if (counts[b] == 0) { continue; }
+      if (!first) { out << ", "; }
+      out << "[" << BucketLowerBound(b) << ", " << BucketUpperBound(b) << ", " << counts[b] << "]";
+      first = false;
+    }
+    out << "]}";
+  }
+};
+
+#endif
@@ -4,6 +4,9 @@
 #include <iostream>
 #include <time.h>
 #include <map>
+#include <vector>
+#include <string>
+#include "LatencyHistogram.h"
 #ifdef __APPLE__
 #pragma weak clock_gettime
 #include <mach/mach.h>
@@ -73,10 +76,114 @@ int clock_gettime(clockid_t clk_id, struct timespec *tp) {
 }
 #endif // __APPLE__
 
+long long TimespecToUsec(const timespec &t) {
+  return ((long long) t.tv_sec) * 1000000 + t.tv_nsec / 1000;
+}
+
+long long WallClockUsec() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return TimespecToUsec(now);
+}
+
+//
+// One complete span in a Chrome trace ("ph":"X" event).
+//
+class TraceEvent {
+ public:
+  string name;
+  string readName;
+  long long startUsec;
+  long long durationUsec;
+  int threadIndex;
+
+  void PrintChromeTraceEvent(ostream &out) const {
+    out << "{\"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << threadIndex 
+        << ", \"ts\": " << startUsec << ", \"dur\": " << durationUsec;
+    if (readName != "") {
+      out << ", \"args\": {\"read\": \"" << readName << "\"}";
+    }
+    out << "}";
+  }
+};
+
+//
+// Collect wall clock spans of the mapping stages of a read.  Spans are
+// buffered for every read while tracing is on, and are kept only for
+// every sampleEvery'th read, or for reads that take longer than
+// minReadUsec to map, so that long-tail reads are always visible.
+//
+class ReadTrace {
+ public:
+  bool enabled;
+  int  threadIndex;
+  int  sampleEvery;
+  long long minReadUsec;
+  long long readCounter;
+  long long readStartUsec;
+  string readName;
+  vector<TraceEvent> pending;
+  vector<TraceEvent> events;
+
+  ReadTrace() {
+    enabled       = false;
+    threadIndex   = 0;
+    sampleEvery   = 100;
+    minReadUsec   = 0;
+    readCounter   = 0;
+    readStartUsec = 0;
+  }
+
+  void StartRead(const char *title) {
+    if (!enabled) { return; }
+    pending.clear();
+    readName      = (title != NULL) ? title : "";
+    readStartUsec = WallClockUsec();
+  }
+
+  void AddSpan(const string &name, long long startUsec, long long endUsec) {
+    if (!enabled) { return; }
+    TraceEvent event;
+    event.name         = name;
+    event.startUsec    = startUsec;
+    event.durationUsec = endUsec - startUsec;
+    event.threadIndex  = threadIndex;
+    pending.push_back(event);
+  }
+
+  void EndRead() {
+    if (!enabled) { return; }
+    long long endUsec = WallClockUsec();
+    bool keep = (sampleEvery > 0 and readCounter % sampleEvery == 0) or 
+      (minReadUsec > 0 and endUsec - readStartUsec >= minReadUsec);
+    ++readCounter;
+    if (keep) {
+      TraceEvent readEvent;
+      readEvent.name         = "MapRead";
+      readEvent.readName     = readName;
+      readEvent.startUsec    = readStartUsec;
+      readEvent.durationUsec = endUsec - readStartUsec;
+      readEvent.threadIndex  = threadIndex;
+      events.push_back(readEvent);
+      events.insert(events.end(), pending.begin(), pending.end());
+    }
+    pending.clear();
+  }
+};
+
 class Timer {
  public:
 	bool keepHistogram, keepList;
 	timespec cpuclock[2];
+  timespec wallclock[2];
+  //
+  // Per-read accounting.  The time spent in a stage is summed over
+  // all Tick/Tock pairs while mapping one read, and added to
+  // readHistogram when the read is finished.
+  //
+  long long readElapsedUsec;
+  LatencyHistogram readHistogram;
+  ReadTrace *trace;
 	int elapsedClockMsec;
 	float   elapsedTime;
 	map<int,int> histogram;
@@ -92,6 +199,8 @@ class Timer {
     header        = _header;
     elapsedClockMsec = 0;
     elapsedTime   = 0.0;
+    readElapsedUsec = 0;
+    trace         = NULL;
 	}
 
   int ListSize() {
@@ -111,6 +220,9 @@ class Timer {
   }
 	void Tick() {
 		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuclock[0]);
+    if (trace != NULL and trace->enabled) {
+      clock_gettime(CLOCK_MONOTONIC, &wallclock[0]);
+    }
 	}
 
   void SetStoreElapsedTime(bool value) {
@@ -126,6 +238,11 @@ class Timer {
 		elapsedClockMsec   = (cpuclock[1].tv_nsec - cpuclock[0].tv_nsec)/1000;
 		totalElapsedClock += elapsedClockMsec;
 		elapsedTime  = ((1.0)*elapsedClockMsec);
+    readElapsedUsec   += TimespecToUsec(cpuclock[1]) - TimespecToUsec(cpuclock[0]);
+    if (trace != NULL and trace->enabled) {
+      clock_gettime(CLOCK_MONOTONIC, &wallclock[1]);
+      trace->AddSpan(header, TimespecToUsec(wallclock[0]), TimespecToUsec(wallclock[1]));
+    }
 		if (keepHistogram) {
 			// keep a histogram in number of milliseconds per operation
 			if (histogram.find(elapsedClockMsec) == histogram.end()) {
@@ -145,8 +262,22 @@ class Timer {
 		elapsedTime  += rhs.elapsedTime;
 		totalElapsedClock += rhs.totalElapsedClock;
     msecList.insert(msecList.end(), rhs.msecList.begin(), rhs.msecList.end());
+    readHistogram.Merge(rhs.readHistogram);
 	}
 
+  void StartRead() {
+    readElapsedUsec = 0;
+  }
+
+  void RecordRead() {
+    readHistogram.Add(readElapsedUsec);
+    readElapsedUsec = 0;
+  }
+
+  void PublishRead(Timer &published) {
+    published.readHistogram.Add(readElapsedUsec);
+  }
+
   void SetHeader(string _header) {
     header = _header;
   }
@@ -221,6 +352,65 @@ class MappingClocks {
     alignIntervals.SetStoreElapsedTime(value);
   }
 
+  void StartRead() {
+    total.StartRead();
+    findAnchors.StartRead();
+    mapToGenome.StartRead();
+    sortMatchPosList.StartRead();
+    findMaxIncreasingInterval.StartRead();
+    alignIntervals.StartRead();
+  }
+
+  void RecordRead() {
+    total.RecordRead();
+    findAnchors.RecordRead();
+    mapToGenome.RecordRead();
+    sortMatchPosList.RecordRead();
+    findMaxIncreasingInterval.RecordRead();
+    alignIntervals.RecordRead();
+  }
+
+  void PublishRead(MappingClocks &published) {
+    total.PublishRead(published.total);
+    findAnchors.PublishRead(published.findAnchors);
+    mapToGenome.PublishRead(published.mapToGenome);
+    sortMatchPosList.PublishRead(published.sortMatchPosList);
+    findMaxIncreasingInterval.PublishRead(published.findMaxIncreasingInterval);
+    alignIntervals.PublishRead(published.alignIntervals);
+  }
+
+  void SetTrace(ReadTrace *trace) {
+    total.trace = trace;
+    findAnchors.trace = trace;
+    mapToGenome.trace = trace;
+    sortMatchPosList.trace = trace;
+    findMaxIncreasingInterval.trace = trace;
+    alignIntervals.trace = trace;
+  }
+
+  void CollectHistograms(const MappingClocks &rhs) {
+    total.readHistogram.Merge(rhs.total.readHistogram);
+    findAnchors.readHistogram.Merge(rhs.findAnchors.readHistogram);
+    mapToGenome.readHistogram.Merge(rhs.mapToGenome.readHistogram);
+    sortMatchPosList.readHistogram.Merge(rhs.sortMatchPosList.readHistogram);
+    findMaxIncreasingInterval.readHistogram.Merge(rhs.findMaxIncreasingInterval.readHistogram);
+    alignIntervals.readHistogram.Merge(rhs.alignIntervals.readHistogram);
+  }
+
+  void PrintHistogramsJSON(ostream &out) {
+    out << "{\"" << total.header << "\": ";
+    total.readHistogram.PrintJSON(out);
+    out << ", \"" << mapToGenome.header << "\": ";
+    mapToGenome.readHistogram.PrintJSON(out);
+    out << ", \"" << sortMatchPosList.header << "\": ";
+    sortMatchPosList.readHistogram.PrintJSON(out);
+    out << ", \"" << findMaxIncreasingInterval.header << "\": ";
+    findMaxIncreasingInterval.readHistogram.PrintJSON(out);
+    out << ", \"" << alignIntervals.header << "\": ";
+    alignIntervals.readHistogram.PrintJSON(out);
+    out << "}";
+  }
+
 	void AddClockTime(const MappingClocks &rhs) {
 		total.Add(rhs.total);
 		findAnchors.Add(rhs.findAnchors);
@@ -245,8 +435,37 @@ class MappingMetrics {
 	long totalAnchors;
 	int anchorsPerRead;
 	long totalAnchorsForMappedReads;
+  //
+  // Counters and per-read latency distributions that may be
+  // snapshotted while mapping is in progress.  Queue waits are
+  // wall-clock times spent blocked on the reader and writer
+  // semaphores, summed per read.
+  //
+  long long totalCandidates;
+  long long prunedCandidates;
+  long long totalCells;
+  long long bytesRead;
+  long long bytesWritten;
+  long long readerWaitUsec, writerWaitUsec;
+  //
+  // Reads given to the sketch prefilter, and those of them that were
+  // mapped with anchors made from their minimizer matches, without
+  // searching the suffix array or BWT.
+  //
+  long long sketchQueries, sketchShortCircuits;
+  LatencyHistogram readerWait, writerWait;
+  ReadTrace trace;
 	
 	MappingMetrics() {
+    totalCandidates = 0;
+    prunedCandidates = 0;
+    totalCells      = 0;
+    bytesRead       = 0;
+    bytesWritten    = 0;
+    readerWaitUsec  = 0;
+    writerWaitUsec  = 0;
+    sketchQueries   = 0;
+    sketchShortCircuits = 0;
 		numReads = 0;
 		numMappedReads = 0;
     numMappedBases = 0;
@@ -280,7 +499,115 @@ class MappingMetrics {
     cellsPerAlignment.push_back(nCells);
   }
 
+  void StartRead(const char *title) {
+    clocks.StartRead();
+    trace.StartRead(title);
+    clocks.SetTrace(&trace);
+  }
+
+  void AddReaderWait(long long usec) {
+    readerWaitUsec += usec;
+  }
+
+  void AddWriterWait(long long usec) {
+    writerWaitUsec += usec;
+  }
+
+  //
+  // Move the per-read accumulators into the histograms.  Waiting for
+  // the next read happens before StartRead, so the reader wait of a
+  // read is recorded along with it.
+  //
+  // When 'published' is given, the latencies of the read and the
+  // running counters are also copied there.  The metrics that are
+  // updated while mapping are only ever touched by the thread that
+  // owns them; 'published' is what other threads may read, under a
+  // lock held by the caller.
+  //
+  void RecordRead(MappingMetrics *published=NULL) {
+    if (published != NULL) {
+      clocks.PublishRead(published->clocks);
+      published->readerWait.Add(readerWaitUsec);
+      published->writerWait.Add(writerWaitUsec);
+      published->totalAnchors     = totalAnchors;
+      published->numReads         = numReads;
+      published->numMappedReads   = numMappedReads;
+      published->totalCandidates  = totalCandidates;
+      published->prunedCandidates = prunedCandidates;
+      published->totalCells       = totalCells;
+      published->bytesRead        = bytesRead;
+      published->bytesWritten     = bytesWritten;
+      published->sketchQueries    = sketchQueries;
+      published->sketchShortCircuits = sketchShortCircuits;
+    }
+    clocks.RecordRead();
+    trace.EndRead();
+    readerWait.Add(readerWaitUsec);
+    writerWait.Add(writerWaitUsec);
+    readerWaitUsec = writerWaitUsec = 0;
+  }
+
+  //
+  // Add only the counters and histograms, not the per-read lists.
+  // This is cheap enough to use when periodically reporting progress.
+  //
+  void CollectHistograms(const MappingMetrics &rhs) {
+    clocks.CollectHistograms(rhs.clocks);
+    readerWait.Merge(rhs.readerWait);
+    writerWait.Merge(rhs.writerWait);
+    totalAnchors    += rhs.totalAnchors;
+    numReads        += rhs.numReads;
+    numMappedReads  += rhs.numMappedReads;
+    totalCandidates += rhs.totalCandidates;
+    prunedCandidates += rhs.prunedCandidates;
+    totalCells      += rhs.totalCells;
+    bytesRead       += rhs.bytesRead;
+    bytesWritten    += rhs.bytesWritten;
+    sketchQueries   += rhs.sketchQueries;
+    sketchShortCircuits += rhs.sketchShortCircuits;
+  }
+
+  void PrintCountersJSON(ostream &out) {
+    out << "{\"reads\": " << numReads
+        << ", \"mappedReads\": " << numMappedReads
+        << ", \"anchors\": " << totalAnchors
+        << ", \"candidates\": " << totalCandidates
+        << ", \"prunedCandidates\": " << prunedCandidates
+        << ", \"dpCells\": " << totalCells
+        << ", \"bytesRead\": " << bytesRead
+        << ", \"bytesWritten\": " << bytesWritten
+        << ", \"sketchQueries\": " << sketchQueries
+        << ", \"sketchShortCircuits\": " << sketchShortCircuits << "}";
+  }
+
+  void PrintWaitsJSON(ostream &out) {
+    out << "{\"readerWait\": ";
+    readerWait.PrintJSON(out);
+    out << ", \"writerWait\": ";
+    writerWait.PrintJSON(out);
+    out << "}";
+  }
+
+  void PrintJSON(ostream &out) {
+    out << "{\"counters\": ";
+    PrintCountersJSON(out);
+    out << ", \"stages\": ";
+    clocks.PrintHistogramsJSON(out);
+    out << ", \"queueWaits\": ";
+    PrintWaitsJSON(out);
+    out << "}";
+  }
+
 	void Collect(MappingMetrics &rhs) {
+    readerWait.Merge(rhs.readerWait);
+    writerWait.Merge(rhs.writerWait);
+    totalCandidates += rhs.totalCandidates;
+    prunedCandidates += rhs.prunedCandidates;
+    totalCells      += rhs.totalCells;
+    bytesRead       += rhs.bytesRead;
+    bytesWritten    += rhs.bytesWritten;
+    sketchQueries   += rhs.sketchQueries;
+    sketchShortCircuits += rhs.sketchShortCircuits;
 		clocks.AddClockTime(rhs.clocks);
 		totalAnchors += rhs.totalAnchors;
 		numReads += rhs.numReads;
@@ -347,6 +674,13 @@ class MappingMetrics {
 		out << "   Anchors per read: " << (1.0*totalAnchors) / numReads << endl;
 		out << "Total mapped: " << totalAnchorsForMappedReads << endl;
 		out << "   Anchors per mapped read: " << (1.0*totalAnchorsForMappedReads) / numMappedReads << endl;
+		out << "Candidates aligned: " << totalCandidates - prunedCandidates << " of " << totalCandidates
+        << " (" << prunedCandidates << " pruned by score estimate)" << endl;
+    if (sketchQueries > 0) {
+      out << "Mapped from sketch anchors without an index search: " << sketchShortCircuits << " of " << sketchQueries << " (";
+      PrintFraction(out, (1.0*sketchShortCircuits) / sketchQueries);
+      out << ")" << endl;
+    }
 	}
 	
 	void AddClock(MappingClocks &clocks) {
@@ -0,0 +1,332 @@
+#ifndef DATASTRUCTURES_SEQUENCE_PACKED_REFERENCE_SEQUENCE_H_
+#define DATASTRUCTURES_SEQUENCE_PACKED_REFERENCE_SEQUENCE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include "../../DNASequence.h"
+#include "../../FASTASequence.h"
+#include "../../NucConversion.h"
+
+using namespace std;
+
+/*
+ * A reference sequence stored at two bits per base, for mapping to
+ * references that do not fit in memory at a byte per base.  A,C,G,T
+ * are packed 32 to a word.  Every other character (N, IUPAC codes)
+ * is stored as 'A' in the packed words, and read back as 'N' through
+ * a sparse table of runs, so the table is only large when the
+ * reference has many short stretches of ambiguous bases.  One bit for
+ * every 64 bases flags the blocks that overlap a run, so that reading
+ * a base away from N's does not search the table.
+ *
+ * PackedReferenceText is the read-only view of the bases.  It is what
+ * PackedReferenceSequence::seq holds, so code that reads
+ * reference.seq[pos] works on both a FASTASequence and a packed
+ * reference.  It only holds pointers, and may be copied freely.
+ */
+
+typedef uint64_t PackedReferenceWord;
+
+class PackedReferenceText {
+ public:
+	enum { NucsPerWord = 32, NBlockShift = 6 };
+
+	PackedReferenceWord *words;
+	PackedReferenceWord *nBlocks;
+	DNALength *nRunStart, *nRunEnd;
+	DNALength nNRuns;
+
+	PackedReferenceText() {
+		words     = NULL;
+		nBlocks   = NULL;
+		nRunStart = nRunEnd = NULL;
+		nNRuns    = 0;
+	}
+
+	bool InNRun(DNALength pos) const {
+		DNALength block = pos >> NBlockShift;
+		if (((nBlocks[block / 64] >> (block % 64)) & 1) == 0) {
+			return false;
+		}
+		DNALength *run = upper_bound(nRunStart, nRunStart + nNRuns, pos);
+		return (run != nRunStart and pos < nRunEnd[run - nRunStart - 1]);
+	}
+
+	//
+	// Return the start of the first run of N's that ends after pos, or
+	// 'end' if there is none before it.
+	//
+	DNALength NextNRun(DNALength pos, DNALength end) const {
+		DNALength *run = upper_bound(nRunEnd, nRunEnd + nNRuns, pos);
+		if (run == nRunEnd + nNRuns) {
+			return end;
+		}
+		return min(end, max(pos, nRunStart[run - nRunEnd]));
+	}
+
+	Nucleotide Get(DNALength pos) const {
+		if (InNRun(pos)) {
+			return 'N';
+		}
+		return TwoBitToAscii[(words[pos / NucsPerWord] >> (2 * (pos % NucsPerWord))) & 3];
+	}
+
+	Nucleotide operator[](DNALength pos) const {
+		return Get(pos);
+	}
+
+	//
+	// The two bit codes of the NucsPerWord bases starting at pos,
+	// with the base at pos in the low bits.  The packed array has one
+	// word of padding, so this may read past the last base.
+	//
+	PackedReferenceWord GetWord(DNALength pos) const {
+		DNALength wordIndex = pos / NucsPerWord;
+		DNALength offset    = 2 * (pos % NucsPerWord);
+		PackedReferenceWord word = words[wordIndex] >> offset;
+		if (offset != 0) {
+			word |= words[wordIndex + 1] << (64 - offset);
+		}
+		return word;
+	}
+};
+
+class PackedReferenceSequence {
+ public:
+	PackedReferenceText seq;
+	DNALength length;
+	char *title;
+	int titleLength;
+	bool deleteOnExit;
+	DNALength nWords, nBlockWords;
+
+	PackedReferenceSequence() {
+		length       = 0;
+		title        = NULL;
+		titleLength  = 0;
+		deleteOnExit = false;
+		nWords       = nBlockWords = 0;
+	}
+
+	//
+	// Pack a sequence.  The title is referenced, not copied.
+	//
+	void Create(FASTASequence &rhs) {
+		Free();
+		length      = rhs.length;
+		title       = rhs.title;
+		titleLength = rhs.titleLength;
+		nWords      = length / PackedReferenceText::NucsPerWord + 2;
+		nBlockWords = (length >> PackedReferenceText::NBlockShift) / 64 + 1;
+		seq.words   = new PackedReferenceWord[nWords];
+		seq.nBlocks = new PackedReferenceWord[nBlockWords];
+		fill(seq.words, seq.words + nWords, 0);
+		fill(seq.nBlocks, seq.nBlocks + nBlockWords, 0);
+
+		vector<DNALength> runStarts, runEnds;
+		DNALength pos;
+		for (pos = 0; pos < length; pos++) {
+			int nuc = TwoBit[rhs.seq[pos]];
+			if (nuc > 3 or ThreeBit[rhs.seq[pos]] > 3) {
+				if (runEnds.size() > 0 and runEnds.back() == pos) {
+					runEnds.back() = pos + 1;
+				}
+				else {
+					runStarts.push_back(pos);
+					runEnds.push_back(pos + 1);
+				}
+				DNALength block = pos >> PackedReferenceText::NBlockShift;
+				seq.nBlocks[block / 64] |= ((PackedReferenceWord) 1) << (block % 64);
+			}
+			else {
+				seq.words[pos / PackedReferenceText::NucsPerWord] |=
+					((PackedReferenceWord) nuc) << (2 * (pos % PackedReferenceText::NucsPerWord));
+			}
+		}
+		seq.nNRuns    = runStarts.size();
+		seq.nRunStart = new DNALength[seq.nNRuns + 1];
+		seq.nRunEnd   = new DNALength[seq.nNRuns + 1];
+		copy(runStarts.begin(), runStarts.end(), seq.nRunStart);
+		copy(runEnds.begin(), runEnds.end(), seq.nRunEnd);
+		deleteOnExit = true;
+	}
+
+	void ShallowCopy(const PackedReferenceSequence &rhs) {
+		seq          = rhs.seq;
+		length       = rhs.length;
+		title        = rhs.title;
+		titleLength  = rhs.titleLength;
+		nWords       = rhs.nWords;
+		nBlockWords  = rhs.nBlockWords;
+		deleteOnExit = false;
+	}
+
+	void Free() {
+		if (deleteOnExit) {
+			delete[] seq.words;
+			delete[] seq.nBlocks;
+			delete[] seq.nRunStart;
+			delete[] seq.nRunEnd;
+		}
+		seq = PackedReferenceText();
+		length = 0;
+		deleteOnExit = false;
+	}
+
+	long GetStorageSize() {
+		return (nWords + nBlockWords) * sizeof(PackedReferenceWord) +
+			2 * seq.nNRuns * sizeof(DNALength);
+	}
+
+	char *GetName() {
+		return title;
+	}
+
+	Nucleotide GetNuc(DNALength pos) {
+		return seq.Get(pos);
+	}
+
+	DNALength MakeRCCoordinate(DNALength forPos) {
+		return length - forPos - 1;
+	}
+
+	//
+	// Write the bases [pos, pos+windowLength) as ascii to dest.
+	//
+	void Decode(DNALength pos, DNALength windowLength, Nucleotide *dest) {
+		DNALength i = 0;
+		while (i < windowLength) {
+			PackedReferenceWord word = seq.GetWord(pos + i);
+			DNALength n = min(windowLength - i, (DNALength) PackedReferenceText::NucsPerWord);
+			DNALength j;
+			for (j = 0; j < n; j++) {
+				dest[i + j] = TwoBitToAscii[word & 3];
+				word >>= 2;
+			}
+			i += n;
+		}
+		DNALength *run = upper_bound(seq.nRunEnd, seq.nRunEnd + seq.nNRuns, pos);
+		for (; run < seq.nRunEnd + seq.nNRuns and seq.nRunStart[run - seq.nRunEnd] < pos + windowLength; ++run) {
+			DNALength runStart = max(pos, seq.nRunStart[run - seq.nRunEnd]);
+			DNALength runEnd   = min(pos + windowLength, *run);
+			fill(dest + (runStart - pos), dest + (runEnd - pos), 'N');
+		}
+	}
+
+	//
+	// Materialize a window of the reference, with the same arguments
+	// as DNASequence::Copy.
+	//
+	void CopyWindow(DNASequence &dest, DNALength pos=0, DNALength windowLength=0) {
+		if (windowLength == 0) {
+			windowLength = length - pos;
+		}
+		if (dest.deleteOnExit and dest.seq != NULL) {
+			delete[] dest.seq;
+		}
+		dest.seq = NULL;
+		if (windowLength > 0) {
+			dest.seq = new Nucleotide[windowLength];
+			Decode(pos, windowLength, dest.seq);
+		}
+		dest.length = windowLength;
+		dest.deleteOnExit = true;
+	}
+
+	//
+	// Same as DNASequence::MakeRC: the reverse complement of the
+	// forward strand window [pos, pos+rcLength).
+	//
+	void MakeRC(DNASequence &rc, DNALength pos=0, DNALength rcLength=0) {
+		if (rcLength == 0) {
+			rcLength = length - pos;
+		}
+		CopyWindow(rc, pos, rcLength);
+		DNALength i;
+		for (i = 0; i < rcLength / 2; i++) {
+			Nucleotide front = rc.seq[i];
+			rc.seq[i] = ReverseComplementNuc[rc.seq[rcLength - i - 1]];
+			rc.seq[rcLength - i - 1] = ReverseComplementNuc[front];
+		}
+		if (rcLength % 2 == 1) {
+			rc.seq[i] = ReverseComplementNuc[rc.seq[i]];
+		}
+	}
+
+	//
+	// Same as DNASequence::CopyAsRC: pos is on the reverse strand.
+	//
+	void CopyAsRC(DNASequence &rc, DNALength pos=0, DNALength rcLength=0) {
+		if (rcLength == 0) {
+			rcLength = length - pos;
+		}
+		MakeRC(rc, length - (pos + rcLength), rcLength);
+	}
+
+	//
+	// The length of the exact match between the reference at pos and
+	// query, up to maxLength.  Whole words of the reference are
+	// compared at once with the query packed on the fly.  N's do not
+	// match anything.
+	//
+	DNALength LengthOfMatch(DNALength pos, Nucleotide *query, DNALength maxLength) {
+		maxLength = min(maxLength, length - pos);
+		DNALength m = 0;
+		while (m < maxLength) {
+			DNALength n = min(maxLength - m, (DNALength) PackedReferenceText::NucsPerWord);
+			PackedReferenceWord queryWord = 0;
+			DNALength j;
+			for (j = 0; j < n; j++) {
+				int nuc = TwoBit[query[m + j]];
+				if (nuc > 3 or ThreeBit[query[m + j]] > 3) {
+					break;
+				}
+				queryWord |= ((PackedReferenceWord) nuc) << (2 * j);
+			}
+			PackedReferenceWord diff = seq.GetWord(pos + m) ^ queryWord;
+			if (j < PackedReferenceText::NucsPerWord) {
+				diff &= (((PackedReferenceWord) 1) << (2 * j)) - 1;
+			}
+			if (diff != 0) {
+				m += __builtin_ctzll(diff) / 2;
+				break;
+			}
+			m += j;
+			if (j < n) {
+				break;
+			}
+		}
+		return seq.NextNRun(pos, pos + m) - pos;
+	}
+};
+
+//
+// Copy a window of a reference into a sequence, whether the reference
+// is stored a byte per base or packed.
+//
+template<typename T_Sequence>
+void CopyReferenceWindow(DNASequence &reference, T_Sequence &dest, DNALength pos, DNALength windowLength) {
+	dest.Copy(reference, pos, windowLength);
+}
+
+template<typename T_Sequence>
+void CopyReferenceWindow(PackedReferenceSequence &reference, T_Sequence &dest, DNALength pos, DNALength windowLength) {
+	reference.CopyWindow(dest, pos, windowLength);
+}
+
+//
+// The reverse complement of the forward strand window [pos,
+// pos+windowLength) of a reference.
+//
+inline void MakeReferenceWindowRC(DNASequence &reference, DNASequence &dest, DNALength pos, DNALength windowLength) {
+	reference.MakeRC(dest, pos, windowLength);
+}
+
+inline void MakeReferenceWindowRC(PackedReferenceSequence &reference, DNASequence &dest, DNALength pos, DNALength windowLength) {
+	reference.MakeRC(dest, pos, windowLength);
+}
+
+#endif
@@ -3,6 +3,9 @@
 
 
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <pthread.h>
 
 using namespace std;
 template <typename T>
@@ -180,4 +183,100 @@ class LCPTable {
 
 };
 
+
+//
+// Compute the permuted LCP array: plcp[p] is the length of the
+// longest common prefix of the suffix at p and the suffix preceding
+// it in the suffix array 'index' (0 for the first suffix).  This uses
+// the Phi algorithm of Karkkainen, Manzini and Puglisi, which visits
+// suffixes in text order and so may be split into contiguous blocks
+// of text that are computed in parallel.  Each block only loses the
+// lcp carried over from the previous block.
+//
+// Comparisons stop at 'terminator', so that a common prefix never
+// spans a contig boundary (or run of N's) in a concatenated genome.
+//
+template<typename T>
+class PermutedLCPBlock {
+ public:
+	T *data;
+	unsigned int length;
+	unsigned int *phi;
+	unsigned int *plcp;
+	unsigned int start, end;
+	T terminator;
+};
+
+template<typename T>
+void *ComputePermutedLCPBlock(void *blockPtr) {
+	PermutedLCPBlock<T> *block = (PermutedLCPBlock<T>*) blockPtr;
+	T *data = block->data;
+	unsigned int n = block->length;
+	unsigned int p, h = 0;
+	for (p = block->start; p < block->end; p++) {
+		unsigned int q = block->phi[p];
+		if (q == n) {
+			block->plcp[p] = 0;
+			h = 0;
+			continue;
+		}
+		while (p + h < n and q + h < n and 
+					 data[p+h] == data[q+h] and 
+					 data[p+h] != block->terminator) {
+			h++;
+		}
+		block->plcp[p] = h;
+		if (h > 0) {
+			h--;
+		}
+	}
+	return NULL;
+}
+
+template<typename T>
+void ComputePermutedLCP(T *data, unsigned int length, unsigned int *index, 
+												unsigned int *plcp, int nProc=1, T terminator='N') {
+	if (length == 0) {
+		return;
+	}
+	if (nProc < 1) {
+		nProc = 1;
+	}
+	//
+	// phi[p] is the suffix preceding p in the suffix array.  
+	//
+	unsigned int *phi = new unsigned int[length];
+	unsigned int i;
+	phi[index[0]] = length;
+	for (i = 1; i < length; i++) {
+		phi[index[i]] = index[i-1];
+	}
+
+	vector<PermutedLCPBlock<T> > blocks(nProc);
+	vector<pthread_t> threads(nProc);
+	unsigned int blockSize = length / nProc + 1;
+	int b;
+	for (b = 0; b < nProc; b++) {
+		blocks[b].data       = data;
+		blocks[b].length     = length;
+		blocks[b].phi        = phi;
+		blocks[b].plcp       = plcp;
+		blocks[b].terminator = terminator;
+		blocks[b].start      = min(length, b * blockSize);
+		blocks[b].end        = min(length, (b + 1) * blockSize);
+	}
+	if (nProc == 1) {
+		ComputePermutedLCPBlock<T>(&blocks[0]);
+	}
+	else {
+		for (b = 0; b < nProc; b++) {
+			pthread_create(&threads[b], NULL, ComputePermutedLCPBlock<T>, &blocks[b]);
+		}
+		for (b = 0; b < nProc; b++) {
+			pthread_join(threads[b], NULL);
+		}
+	}
+	delete[] phi;
+}
+
 #endif
@@ -0,0 +1,235 @@
+#ifndef DATASTRUCTURES_SUFFIXARRAY_MAPABILITY_TRACK_H_
+#define DATASTRUCTURES_SUFFIXARRAY_MAPABILITY_TRACK_H_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <pthread.h>
+
+#include "LCPTable.h"
+#include "SuffixArray.h"
+#include "../metagenome/SequenceIndexDatabase.h"
+#include "../../FASTASequence.h"
+#include "../../Types.h"
+
+using namespace std;
+
+//
+// Per-base mapability of a genome, computed in one pass over the
+// LCP array of its suffix array.  For each position p,
+// minUniqueLength[p] is the length of the shortest substring starting
+// at p that occurs nowhere else in the (forward strand of the)
+// genome.  A substring that is unique stays unique when it is
+// extended, so the k-mer at p is unique exactly when
+// minUniqueLength[p] <= k, and an exact read of length L starting at p
+// maps uniquely exactly when minUniqueLength[p] <= L.  One track
+// therefore answers uniqueness for every k and L.
+//
+// Positions that have no unique substring before the next N (contig
+// boundary) or whose shortest unique substring does not fit in 16
+// bits are stored as NotUnique.
+//
+class MapabilityTrack {
+ public:
+	typedef unsigned short UniqueLength;
+	static const UniqueLength NotUnique = 0xFFFF;
+	static const int magicNumber = 0x4d415042;
+
+	vector<UniqueLength> minUniqueLength;
+
+	DNALength size() const {
+		return minUniqueLength.size();
+	}
+
+	UniqueLength Get(DNALength pos) const {
+		return minUniqueLength[pos];
+	}
+
+	bool IsUnique(DNALength pos, int length) const {
+		return minUniqueLength[pos] != NotUnique and minUniqueLength[pos] <= length;
+	}
+
+	class SuffixBlock {
+	 public:
+		SAIndex *index;
+		unsigned int *plcp;
+		UniqueLength *minUniqueLength;
+		DNALength length;
+		DNALength start, end;
+	};
+
+	//
+	// The shortest unique substring at index[i] is one longer than
+	// its longest common prefix with either neighbor in the suffix
+	// array.  Blocks of the suffix array write to distinct positions.
+	//
+	static void *ComputeSuffixBlock(void *blockPtr) {
+		SuffixBlock *block = (SuffixBlock*) blockPtr;
+		DNALength i;
+		for (i = block->start; i < block->end; i++) {
+			unsigned int lcp = block->plcp[block->index[i]];
+			if (i + 1 < block->length) {
+				lcp = max(lcp, block->plcp[block->index[i+1]]);
+			}
+			if (lcp + 1 >= NotUnique) {
+				block->minUniqueLength[block->index[i]] = NotUnique;
+			}
+			else {
+				block->minUniqueLength[block->index[i]] = lcp + 1;
+			}
+		}
+		return NULL;
+	}
+
+	template<typename T_Sequence>
+	void Compute(T_Sequence &genome, SAIndex *index, int nProc=1) {
+		DNALength n = genome.length;
+		minUniqueLength.resize(n);
+		if (n == 0) {
+			return;
+		}
+		if (nProc < 1) {
+			nProc = 1;
+		}
+		unsigned int *plcp = new unsigned int[n];
+		ComputePermutedLCP(genome.seq, n, index, plcp, nProc, (Nucleotide) 'N');
+
+		vector<SuffixBlock> blocks(nProc);
+		vector<pthread_t> threads(nProc);
+		DNALength blockSize = n / nProc + 1;
+		int b;
+		for (b = 0; b < nProc; b++) {
+			blocks[b].index           = index;
+			blocks[b].plcp            = plcp;
+			blocks[b].minUniqueLength = &minUniqueLength[0];
+			blocks[b].length          = n;
+			blocks[b].start           = min(n, b * blockSize);
+			blocks[b].end             = min(n, (b + 1) * blockSize);
+		}
+		if (nProc == 1) {
+			ComputeSuffixBlock(&blocks[0]);
+		}
+		else {
+			for (b = 0; b < nProc; b++) {
+				pthread_create(&threads[b], NULL, ComputeSuffixBlock, &blocks[b]);
+			}
+			for (b = 0; b < nProc; b++) {
+				pthread_join(threads[b], NULL);
+			}
+		}
+		delete[] plcp;
+
+		//
+		// Comparisons stopped at N, so a substring that reaches an N
+		// (or the end of the genome) only looks unique.
+		//
+		DNALength p = n;
+		DNALength nextN = n;
+		while (p > 0) {
+			--p;
+			if (genome.seq[p] == 'N') {
+				nextN = p;
+				minUniqueLength[p] = NotUnique;
+			}
+			else if (minUniqueLength[p] != NotUnique and p + minUniqueLength[p] > nextN) {
+				minUniqueLength[p] = NotUnique;
+			}
+		}
+	}
+
+	//
+	// The fraction of positions (not counting N's) where the k-mer
+	// starting at the position is unique.
+	//
+	template<typename T_Sequence>
+	float FractionUnique(T_Sequence &genome, int k) {
+		DNALength p, nUnique = 0, nBases = 0;
+		for (p = 0; p < minUniqueLength.size(); p++) {
+			if (genome.seq[p] == 'N') {
+				continue;
+			}
+			++nBases;
+			if (IsUnique(p, k)) {
+				++nUnique;
+			}
+		}
+		if (nBases == 0) {
+			return 0;
+		}
+		return ((float) nUnique) / nBases;
+	}
+
+	//
+	// Returns false if the file could not be opened or written in full.
+	//
+	bool Write(string &fileName) {
+		ofstream out;
+		out.open(fileName.c_str(), ios::binary);
+		if (!out.good()) {
+			return false;
+		}
+		int magic = magicNumber;
+		out.write((char*) &magic, sizeof(int));
+		DNALength length = minUniqueLength.size();
+		out.write((char*) &length, sizeof(DNALength));
+		if (length > 0) {
+			out.write((char*) &minUniqueLength[0], sizeof(UniqueLength) * length);
+		}
+		out.close();
+		return !out.fail();
+	}
+
+	bool Read(string &fileName) {
+		ifstream in;
+		in.open(fileName.c_str(), ios::binary);
+		if (!in.good()) {
+			return false;
+		}
+		int ckMagicNumber;
+		in.read((char*) &ckMagicNumber, sizeof(int));
+		if (ckMagicNumber != magicNumber) {
+			return false;
+		}
+		DNALength length;
+		in.read((char*) &length, sizeof(DNALength));
+		minUniqueLength.resize(length);
+		if (length > 0) {
+			in.read((char*) &minUniqueLength[0], sizeof(UniqueLength) * length);
+		}
+		bool readAll = in.good();
+		in.close();
+		return readAll;
+	}
+
+	//
+	// Write runs of equal minimum unique length as a bedGraph, one
+	// contig at a time.  Positions that are not unique are written
+	// with a value of 0.  Returns false if writing failed.
+	//
+	bool WriteBedGraph(ostream &out, SequenceIndexDatabase<FASTASequence> &seqdb) {
+		int s;
+		for (s = 0; s < seqdb.nSeqPos - 1; s++) {
+			string name = seqdb.GetSpaceDelimitedName(s);
+			DNALength contigStart = seqdb.seqStartPos[s];
+			DNALength contigEnd   = contigStart + seqdb.GetLengthOfSeq(s);
+			DNALength runStart = contigStart;
+			while (runStart < contigEnd) {
+				DNALength runEnd = runStart + 1;
+				while (runEnd < contigEnd and minUniqueLength[runEnd] == minUniqueLength[runStart]) {
+					runEnd++;
+				}
+				int value = (minUniqueLength[runStart] == NotUnique ? 0 : minUniqueLength[runStart]);
+				out << name << "\t" << runStart - contigStart << "\t" << runEnd - contigStart << "\t" << value << endl;
+				runStart = runEnd;
+			}
+			if (!out.good()) {
+				return false;
+			}
+		}
+		return out.good();
+	}
+};
+
+#endif
@@ -725,7 +725,13 @@ void WriteComponentList(ofstream &out) {
  }
 
 
- long SearchLeftBound(T* target, long targetLength, DNALength targetOffset,  T queryChar, long l, long r) {
+ //
+ // The text searched by SearchLeftBound, SearchRightBound and
+ // StoreLCPBounds is only indexed, so it may be a T* or a packed
+ // text with an operator[] (PackedReferenceText).
+ //
+ template<typename T_Text>
+ long SearchLeftBound(T_Text target, long targetLength, DNALength targetOffset,  T queryChar, long l, long r) {
 	 long ll, lr;
 	 ll = l;
 	 lr = r;
@@ -774,7 +780,8 @@ void WriteComponentList(ofstream &out) {
 	 return ll;
  }
 
- long SearchRightBound(T* target, long targetLength, DNALength targetOffset, 
+ template<typename T_Text>
+ long SearchRightBound(T_Text target, long targetLength, DNALength targetOffset, 
                        T queryChar, long l, long r) {
 	 long rl, rr;
 	 rl = l;
@@ -924,7 +931,8 @@ void WriteComponentList(ofstream &out) {
  }
 
 
- int StoreLCPBounds(T *target, long targetLength, // The string which the suffix array is built on.
+ template<typename T_Text>
+ int StoreLCPBounds(T_Text target, long targetLength, // The string which the suffix array is built on.
 										T *query, DNALength queryLength, // The query string. search starts at pos 0 in this string
 										bool useLookupTable,  // Should the indices of the first k bases be determined by a lookup table?
 										int  maxMatchLength,  // Stop extending match at lcp length = maxMatchLength,
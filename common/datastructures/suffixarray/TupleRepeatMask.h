@@ -0,0 +1,148 @@
+#ifndef DATASTRUCTURES_SUFFIXARRAY_TUPLE_REPEAT_MASK_H_
+#define DATASTRUCTURES_SUFFIXARRAY_TUPLE_REPEAT_MASK_H_
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "LCPTable.h"
+#include "SuffixArray.h"
+#include "../../NucConversion.h"
+#include "../../Types.h"
+
+using namespace std;
+
+//
+// The tuples (k-mers) of a genome that occur more than maxCount
+// times, such as the units of satellite and rDNA arrays, as one bit
+// per possible tuple.  Suffixes that start with the same tuple are
+// adjacent in the suffix array, so the count of every tuple is the
+// length of a run of adjacent suffixes with an LCP of at least
+// tupleSize, and the mask is computed in one pass over the LCP array.
+//
+// A read position that starts with a masked tuple would only find
+// anchors in more places than are kept, so searches of the suffix
+// array or BWT skip these positions rather than discarding their
+// anchors after the search.  Because the mask is over tuples rather
+// than positions, it is looked up from the read alone, and is the
+// same for any index of the genome.  The mask takes 4^tupleSize bits
+// (32 MB for 14-mers).
+//
+class TupleRepeatMask {
+ public:
+	enum { MaxTupleSize = 16 };
+	static const int magicNumber = 0x52505431;
+	int tupleSize;
+	int maxCount;
+	vector<uint64_t> bits;
+
+	TupleRepeatMask() {
+		tupleSize = 0;
+		maxCount  = 0;
+	}
+
+	//
+	// The index of the tuple starting at s, or -1 if it has a base
+	// other than A,C,G,T.
+	//
+	long TupleIndex(Nucleotide *s) const {
+		long index = 0;
+		int i;
+		for (i = 0; i < tupleSize; i++) {
+			if (ThreeBit[s[i]] > 3) {
+				return -1;
+			}
+			index = (index << 2) + TwoBit[s[i]];
+		}
+		return index;
+	}
+
+	bool IsMasked(Nucleotide *s) const {
+		long index = TupleIndex(s);
+		return (index >= 0 and ((bits[index / 64] >> (index % 64)) & 1));
+	}
+
+	void Initialize(int tupleSizeP, int maxCountP) {
+		tupleSize = tupleSizeP;
+		maxCount  = maxCountP;
+		bits.resize(((((uint64_t) 1) << (2 * tupleSize)) + 63) / 64);
+		fill(bits.begin(), bits.end(), 0);
+	}
+
+	//
+	// genome is in ascii, and index is its suffix array.
+	//
+	template<typename T_Sequence>
+	void Compute(T_Sequence &genome, SAIndex *index, int tupleSizeP, int maxCountP, int nProc=1) {
+		Initialize(tupleSizeP, maxCountP);
+		DNALength n = genome.length;
+		if (n == 0) {
+			return;
+		}
+		unsigned int *plcp = new unsigned int[n];
+		ComputePermutedLCP(genome.seq, n, index, plcp, nProc, (Nucleotide) 'N');
+		DNALength runStart = 0, i;
+		for (i = 1; i <= n; i++) {
+			if (i < n and plcp[index[i]] >= tupleSize) {
+				continue;
+			}
+			if (i - runStart > maxCount) {
+				long tupleIndex = TupleIndex(&genome.seq[index[runStart]]);
+				if (tupleIndex >= 0) {
+					bits[tupleIndex / 64] |= ((uint64_t) 1) << (tupleIndex % 64);
+				}
+			}
+			runStart = i;
+		}
+		delete[] plcp;
+	}
+
+	long NumMasked() const {
+		long nMasked = 0;
+		VectorIndex w;
+		for (w = 0; w < bits.size(); w++) {
+			nMasked += __builtin_popcountll(bits[w]);
+		}
+		return nMasked;
+	}
+
+	void Write(string &fileName) {
+		ofstream out;
+		out.open(fileName.c_str(), ios::binary);
+		int magic = magicNumber;
+		out.write((char*) &magic, sizeof(int));
+		out.write((char*) &tupleSize, sizeof(int));
+		out.write((char*) &maxCount, sizeof(int));
+		out.write((char*) &bits[0], sizeof(uint64_t) * bits.size());
+		out.close();
+	}
+
+	bool Read(string &fileName) {
+		ifstream in;
+		in.open(fileName.c_str(), ios::binary);
+		if (!in.good()) {
+			return false;
+		}
+		int ckMagicNumber;
+		in.read((char*) &ckMagicNumber, sizeof(int));
+		if (ckMagicNumber != magicNumber) {
+			return false;
+		}
+		int tupleSizeP, maxCountP;
+		in.read((char*) &tupleSizeP, sizeof(int));
+		in.read((char*) &maxCountP, sizeof(int));
+		if (tupleSizeP < 1 or tupleSizeP > MaxTupleSize) {
+			return false;
+		}
+		Initialize(tupleSizeP, maxCountP);
+		in.read((char*) &bits[0], sizeof(uint64_t) * bits.size());
+		bool readAll = in.good();
+		in.close();
+		return readAll;
+	}
+};
+
+#endif
@@ -0,0 +1,411 @@
+#ifndef PARTITIONED_TUPLE_COUNTER_H_
+#define PARTITIONED_TUPLE_COUNTER_H_
+
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "../../tuples/TupleMetrics.h"
+#include "../../NucConversion.h"
+#include "../../DNASequence.h"
+#include "../../Types.h"
+
+using namespace std;
+
+/*
+ * Records buffered by the PartitionedTupleCounter: just the tuple
+ * when only counts are needed, or the tuple and the position it
+ * starts at when the positions are written out as well.
+ */
+class TupleRecord {
+ public:
+	ULong tuple;
+	void Set(ULong _tuple, DNALength _pos) {
+		tuple = _tuple;
+	}
+	int operator<(const TupleRecord &rhs) const {
+		return tuple < rhs.tuple;
+	}
+};
+
+class TuplePosRecord {
+ public:
+	ULong tuple;
+	DNALength pos;
+	void Set(ULong _tuple, DNALength _pos) {
+		tuple = _tuple;
+		pos   = _pos;
+	}
+	int operator<(const TuplePosRecord &rhs) const {
+		return (tuple < rhs.tuple or (tuple == rhs.tuple and pos < rhs.pos));
+	}
+};
+
+/*
+ * Count the k-mers of a set of sequences on several threads with
+ * bounded memory.
+ *
+ * Tuples are radix-partitioned by their top 'partitionBits' bits.
+ * Sequences are cut into blocks, and each thread extracts the tuples
+ * of one block into its own set of partition buffers, so no locking
+ * is needed.  The buffers are then appended to the partitions.  Once
+ * more than 'maxBufferedRecords' are held in memory, every partition
+ * is appended to a spill file named spillPrefix.<partition> and
+ * cleared.
+ *
+ * When all sequences have been added, ProcessPartitions loads nProc
+ * partitions at a time, one per thread, with their spilled records,
+ * optionally sorts them, and hands each to the consumer:
+ *
+ *   consumer.ProcessPartition(p, records) is called on a worker
+ *   thread, concurrently for different partitions.
+ *
+ *   consumer.FinishPartition(p) is then called on the calling
+ *   thread, in increasing order of p, which is where output is
+ *   written.
+ *
+ * Since partitions are ranges of tuple values, concatenating the
+ * sorted partitions gives all tuples in sorted order, and a dense
+ * table indexed by tuple is split into disjoint slices.
+ *
+ * Tuples are encoded the same way as DNATuple::FromStringLR
+ * (leftToRight) or DNATuple::FromStringRL, and those containing a
+ * base other than ACGT are skipped.
+ */
+
+template<typename T_Record>
+class PartitionedTupleCounter {
+ public:
+	TupleMetrics tm;
+	ULong        tupleMask;
+	bool         leftToRight;
+	int          nProc;
+	int          nPartitions;
+	int          partitionShift;
+	bool         sortPartitions;
+	long         maxBufferedRecords;
+	long         nBuffered;
+	long         nRecords;
+	string       spillPrefix;
+	vector<vector<T_Record> > partitions;
+	vector<long> nSpilled;
+
+	//
+	// Short sequences, such as reads, are concatenated into a pending
+	// block separated by N so that each block is worth starting
+	// threads for.
+	//
+	vector<Nucleotide> pending;
+	vector<DNALength>  pendingStarts;
+	vector<DNALength>  pendingOffsets;
+
+	PartitionedTupleCounter() {
+		nProc = 1;
+		nPartitions = 1;
+		partitionShift = 0;
+		leftToRight = true;
+		sortPartitions = true;
+		maxBufferedRecords = 0;
+		nBuffered = nRecords = 0;
+		tupleMask = 0;
+	}
+
+	~PartitionedTupleCounter() {
+		RemoveSpillFiles();
+	}
+
+	//
+	// Set up the counter for tuples of size tm.tupleSize.  At most
+	// 2^partitionBits partitions are used; maxBufferedRecords of 0
+	// keeps everything in memory.
+	//
+	void Initialize(TupleMetrics &_tm, bool _leftToRight, int _nProc,
+	                int partitionBits=8, long _maxBufferedRecords=0,
+	                string _spillPrefix="") {
+		tm = _tm;
+		assert(tm.tupleSize > 0 and tm.tupleSize <= 32);
+		tupleMask = (tm.tupleSize == 32 ? ~((ULong)0) : (((ULong)1) << (2*tm.tupleSize)) - 1);
+		leftToRight = _leftToRight;
+		nProc = max(_nProc, 1);
+		partitionBits = min(partitionBits, 2*tm.tupleSize);
+		nPartitions = 1 << partitionBits;
+		partitionShift = 2*tm.tupleSize - partitionBits;
+		maxBufferedRecords = _maxBufferedRecords;
+		spillPrefix = _spillPrefix;
+		if (spillPrefix == "") {
+			stringstream prefixStrm;
+			prefixStrm << "tuples." << getpid();
+			spillPrefix = prefixStrm.str();
+		}
+		nBuffered = nRecords = 0;
+		partitions.clear();
+		partitions.resize(nPartitions);
+		nSpilled.clear();
+		nSpilled.resize(nPartitions, 0);
+		pending.clear();
+		pendingStarts.clear();
+		pendingOffsets.clear();
+	}
+
+	int GetPartition(ULong tuple) {
+		return (int) (tuple >> partitionShift);
+	}
+
+	string SpillFileName(int p) {
+		stringstream nameStrm;
+		nameStrm << spillPrefix << "." << p;
+		return nameStrm.str();
+	}
+
+	//
+	// Add all tuples of seq.  Tuple positions are reported relative
+	// to 'offset'.
+	//
+	template<typename T_Sequence>
+	void AddSequence(T_Sequence &seq, DNALength offset=0) {
+		long blockSize = max(maxBufferedRecords, (long) 1<<22);
+		if (seq.length >= blockSize) {
+			Flush();
+			vector<DNALength> starts(1, 0), offsets(1, offset);
+			AddBlock(seq.seq, seq.length, starts, offsets);
+			return;
+		}
+		if (seq.length < tm.tupleSize) {
+			return;
+		}
+		pendingStarts.push_back(pending.size());
+		pendingOffsets.push_back(offset);
+		pending.insert(pending.end(), &seq.seq[0], &seq.seq[seq.length]);
+		pending.push_back('N');
+		if ((long) pending.size() >= blockSize) {
+			Flush();
+		}
+	}
+
+	void Flush() {
+		if (pending.size() > 0) {
+			AddBlock(&pending[0], pending.size(), pendingStarts, pendingOffsets);
+		}
+		pending.clear();
+		pendingStarts.clear();
+		pendingOffsets.clear();
+	}
+
+	class ExtractionBlock {
+	 public:
+		PartitionedTupleCounter<T_Record> *counter;
+		Nucleotide *seq;
+		DNALength   start, end;
+		vector<DNALength> *starts, *offsets;
+		vector<vector<T_Record> > partitions;
+	};
+
+	//
+	// Extract the tuples that start in [start, end) of one block.
+	//
+	static void* ExtractTuples(void *data) {
+		ExtractionBlock *block = (ExtractionBlock*) data;
+		PartitionedTupleCounter<T_Record> *counter = block->counter;
+		int k = counter->tm.tupleSize;
+		int highShift = 2*(k-1);
+		block->partitions.resize(counter->nPartitions);
+		vector<DNALength> &starts  = *block->starts;
+		vector<DNALength> &offsets = *block->offsets;
+		int s = upper_bound(starts.begin(), starts.end(), block->start) - starts.begin() - 1;
+		ULong tuple = 0;
+		int runLength = 0;
+		DNALength i;
+		T_Record record;
+		for (i = block->start; i < block->end + k - 1; i++) {
+			Nucleotide nuc = block->seq[i];
+			if (ThreeBit[nuc] > 3) {
+				runLength = 0;
+				continue;
+			}
+			if (counter->leftToRight) {
+				tuple = ((tuple << 2) + TwoBit[nuc]) & counter->tupleMask;
+			}
+			else {
+				tuple = (tuple >> 2) + (((ULong) TwoBit[nuc]) << highShift);
+			}
+			if (++runLength >= k) {
+				DNALength tupleStart = i - k + 1;
+				while (s + 1 < starts.size() and starts[s+1] <= tupleStart) {
+					++s;
+				}
+				record.Set(tuple, offsets[s] + tupleStart - starts[s]);
+				block->partitions[counter->GetPartition(tuple)].push_back(record);
+			}
+		}
+		return NULL;
+	}
+
+	void AddBlock(Nucleotide *seq, DNALength length,
+	              vector<DNALength> &starts, vector<DNALength> &offsets) {
+		if (length < tm.tupleSize) {
+			return;
+		}
+		DNALength nTuples = length - tm.tupleSize + 1;
+		//
+		// Bound the memory held by the thread buffers by extracting at
+		// most maxBufferedRecords tuples at once.
+		//
+		DNALength sliceSize = nTuples;
+		if (maxBufferedRecords > 0 and maxBufferedRecords < sliceSize) {
+			sliceSize = maxBufferedRecords;
+		}
+		DNALength sliceStart;
+		for (sliceStart = 0; sliceStart < nTuples; sliceStart += sliceSize) {
+			DNALength sliceEnd = min(nTuples, sliceStart + sliceSize);
+			DNALength blockSize = (sliceEnd - sliceStart) / nProc + 1;
+			vector<ExtractionBlock> blocks(nProc);
+			vector<pthread_t> threads(nProc);
+			int b;
+			for (b = 0; b < nProc; b++) {
+				blocks[b].counter = this;
+				blocks[b].seq     = seq;
+				blocks[b].start   = min(sliceEnd, sliceStart + b * blockSize);
+				blocks[b].end     = min(sliceEnd, sliceStart + (b + 1) * blockSize);
+				blocks[b].starts  = &starts;
+				blocks[b].offsets = &offsets;
+			}
+			if (nProc == 1) {
+				ExtractTuples(&blocks[0]);
+			}
+			else {
+				for (b = 0; b < nProc; b++) {
+					pthread_create(&threads[b], NULL, ExtractTuples, &blocks[b]);
+				}
+				for (b = 0; b < nProc; b++) {
+					pthread_join(threads[b], NULL);
+				}
+			}
+			int p;
+			for (b = 0; b < nProc; b++) {
+				for (p = 0; p < nPartitions; p++) {
+					vector<T_Record> &part = blocks[b].partitions[p];
+					partitions[p].insert(partitions[p].end(), part.begin(), part.end());
+					nBuffered += part.size();
+					nRecords  += part.size();
+					vector<T_Record>().swap(part);
+				}
+			}
+			if (maxBufferedRecords > 0 and nBuffered > maxBufferedRecords) {
+				Spill();
+			}
+		}
+	}
+
+	void Spill() {
+		int p;
+		for (p = 0; p < nPartitions; p++) {
+			if (partitions[p].size() == 0) {
+				continue;
+			}
+			string fileName = SpillFileName(p);
+			FILE *spillOut = fopen(fileName.c_str(), "ab");
+			if (spillOut == NULL or
+			    fwrite(&partitions[p][0], sizeof(T_Record), partitions[p].size(), spillOut) != partitions[p].size()) {
+				cout << "ERROR. Could not write tuples to " << fileName << endl;
+				exit(1);
+			}
+			fclose(spillOut);
+			nSpilled[p] += partitions[p].size();
+			vector<T_Record>().swap(partitions[p]);
+		}
+		nBuffered = 0;
+	}
+
+	//
+	// Move all records of partition p, spilled or not, into records.
+	//
+	void LoadPartition(int p, vector<T_Record> &records) {
+		records.clear();
+		records.swap(partitions[p]);
+		if (nSpilled[p] > 0) {
+			DNALength nInMemory = records.size();
+			records.resize(nInMemory + nSpilled[p]);
+			string fileName = SpillFileName(p);
+			FILE *spillIn = fopen(fileName.c_str(), "rb");
+			if (spillIn == NULL or
+			    fread(&records[nInMemory], sizeof(T_Record), nSpilled[p], spillIn) != nSpilled[p]) {
+				cout << "ERROR. Could not read tuples from " << fileName << endl;
+				exit(1);
+			}
+			fclose(spillIn);
+			unlink(fileName.c_str());
+			nSpilled[p] = 0;
+		}
+	}
+
+	void RemoveSpillFiles() {
+		int p;
+		for (p = 0; p < nSpilled.size(); p++) {
+			if (nSpilled[p] > 0) {
+				unlink(SpillFileName(p).c_str());
+				nSpilled[p] = 0;
+			}
+		}
+	}
+
+	template<typename T_Consumer>
+	class PartitionBlock {
+	 public:
+		PartitionedTupleCounter<T_Record> *counter;
+		T_Consumer *consumer;
+		int partition;
+	};
+
+	template<typename T_Consumer>
+	static void* ProcessPartitionBlock(void *data) {
+		PartitionBlock<T_Consumer> *block = (PartitionBlock<T_Consumer>*) data;
+		vector<T_Record> records;
+		block->counter->LoadPartition(block->partition, records);
+		if (block->counter->sortPartitions) {
+			std::sort(records.begin(), records.end());
+		}
+		block->consumer->ProcessPartition(block->partition, records);
+		return NULL;
+	}
+
+	template<typename T_Consumer>
+	void ProcessPartitions(T_Consumer &consumer) {
+		Flush();
+		vector<PartitionBlock<T_Consumer> > blocks(nProc);
+		vector<pthread_t> threads(nProc);
+		int roundStart, b;
+		for (roundStart = 0; roundStart < nPartitions; roundStart += nProc) {
+			int nBlocks = min(nProc, nPartitions - roundStart);
+			for (b = 0; b < nBlocks; b++) {
+				blocks[b].counter   = this;
+				blocks[b].consumer  = &consumer;
+				blocks[b].partition = roundStart + b;
+			}
+			if (nBlocks == 1) {
+				ProcessPartitionBlock<T_Consumer>(&blocks[0]);
+			}
+			else {
+				for (b = 0; b < nBlocks; b++) {
+					pthread_create(&threads[b], NULL, ProcessPartitionBlock<T_Consumer>, &blocks[b]);
+				}
+				for (b = 0; b < nBlocks; b++) {
+					pthread_join(threads[b], NULL);
+				}
+			}
+			for (b = 0; b < nBlocks; b++) {
+				consumer.FinishPartition(roundStart + b);
+			}
+		}
+		nBuffered = 0;
+	}
+};
+
+
+#endif
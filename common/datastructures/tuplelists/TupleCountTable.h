@@ -5,6 +5,8 @@
 #include <fstream>
 #include <iostream>
 #include <assert.h>
+#include <pthread.h>
+#include <vector>
 #include "../../tuples/TupleMetrics.h"
 using namespace std;
 
@@ -60,7 +62,12 @@ class TupleCountTable {
 		++nTuples;
 	}
 
-	void AddSequenceTupleCountsLR(TSequence &seq) {
+	//
+	// The counted sequence need not be a TSequence, so that the table
+	// of a packed reference may be counted from the unpacked bases.
+	//
+	template<typename T_CountedSequence>
+	void AddSequenceTupleCountsLR(T_CountedSequence &seq) {
 		VectorIndex i;
 		TTuple tuple;
 		if (seq.length>= tm.tupleSize) {
@@ -72,6 +79,82 @@ class TupleCountTable {
 		}
 	}
 
+	//
+	// The same as above on nProc threads.  Each thread counts the
+	// tuples that start in its own slice of seq straight into the
+	// table, so nothing is buffered.  The same tuple may occur in
+	// several slices, so counts are incremented atomically.  Tuples
+	// are encoded as plain ACGT, so this is only for tables of DNATuple.
+	//
+	class CountBlock {
+	 public:
+		TupleCountTable<TSequence, TTuple> *table;
+		Nucleotide *seq;
+		DNALength   start, end;
+		int         nTuples;
+	};
+
+	//
+	// Count the tuples that start in [start, end) of one block.
+	//
+	static void* CountBlockTuples(void *data) {
+		CountBlock *block = (CountBlock*) data;
+		TupleCountTable<TSequence, TTuple> *table = block->table;
+		int k = table->tm.tupleSize;
+		ULong tupleMask = (((ULong)1) << (2*k)) - 1;
+		ULong tuple = 0;
+		int runLength = 0;
+		DNALength i;
+		block->nTuples = 0;
+		for (i = block->start; i < block->end + k - 1; i++) {
+			Nucleotide nuc = block->seq[i];
+			if (ThreeBit[nuc] > 3) {
+				runLength = 0;
+				continue;
+			}
+			tuple = ((tuple << 2) + TwoBit[nuc]) & tupleMask;
+			if (++runLength >= k) {
+				assert(tuple < (ULong) table->countTableLength);
+				__sync_fetch_and_add(&table->countTable[tuple], 1);
+				++block->nTuples;
+			}
+		}
+		return NULL;
+	}
+
+	template<typename T_CountedSequence>
+	void AddSequenceTupleCountsLR(T_CountedSequence &seq, int nProc) {
+		if (seq.length < tm.tupleSize) {
+			return;
+		}
+		nProc = max(nProc, 1);
+		DNALength nTuplePositions = seq.length - tm.tupleSize + 1;
+		DNALength blockSize = nTuplePositions / nProc + 1;
+		vector<CountBlock> blocks(nProc);
+		vector<pthread_t> threads(nProc);
+		int b;
+		for (b = 0; b < nProc; b++) {
+			blocks[b].table = this;
+			blocks[b].seq   = (Nucleotide*) &seq.seq[0];
+			blocks[b].start = min(nTuplePositions, b * blockSize);
+			blocks[b].end   = min(nTuplePositions, (b + 1) * blockSize);
+		}
+		if (nProc == 1) {
+			CountBlockTuples(&blocks[0]);
+		}
+		else {
+			for (b = 0; b < nProc; b++) {
+				pthread_create(&threads[b], NULL, CountBlockTuples, &blocks[b]);
+			}
+			for (b = 0; b < nProc; b++) {
+				pthread_join(threads[b], NULL);
+			}
+		}
+		for (b = 0; b < nProc; b++) {
+			nTuples += blocks[b].nTuples;
+		}
+	}
+
 	void Write(ofstream &out) {
 		out.write((char*) &countTableLength, sizeof(int));
 		out.write((char*) &nTuples, sizeof(int));
@@ -23,10 +23,28 @@ class BaseSequenceIO {
 	}
 
 	static int DetermineFileTypeByExtension(string &fileName, FileType &type, bool exitOnFailure=true) {
+		//
+		// Standard input is read as FASTQ, and the reader takes the
+		// actual format (FASTA or FASTQ) from the first record.
+		//
+		if (fileName == "-" or fileName == "/dev/stdin") {
+			type = Fastq;
+			return 1;
+		}
 		string::size_type dotPos = fileName.rfind(".");
 		if (dotPos != string::npos) {
 			string extension;
 			extension.assign(fileName, dotPos+1, fileName.size() - (dotPos+1));
+			//
+			// Compressed FASTA and FASTQ are typed by the extension before
+			// the ".gz".
+			//
+			if (extension == "gz" and dotPos > 0) {
+				string::size_type gzDotPos = fileName.rfind(".", dotPos-1);
+				if (gzDotPos != string::npos) {
+					extension.assign(fileName, gzDotPos+1, dotPos - (gzDotPos+1));
+				}
+			}
 			if (extension == "fasta" or
 					extension == "fa" or
 					extension == "fas" or
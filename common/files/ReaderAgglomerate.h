@@ -7,6 +7,7 @@
 
 #include "../FASTAReader.h"
 #include "../FASTQReader.h"
+#include "../FASTXStreamReader.h"
 #include "../CCSSequence.h"
 #include "../SMRTSequence.h"
 #include "../Enumerations.h"
@@ -17,6 +18,8 @@
 class ReaderAgglomerate : public BaseSequenceIO {
 	FASTAReader fastaReader;
 	FASTQReader fastqReader;
+	FASTXStreamReader streamReader;
+	bool streamInput;
 	int readQuality;
 	int stride;
 	int start;
@@ -36,6 +39,7 @@ class ReaderAgglomerate : public BaseSequenceIO {
 
   void SetToUpper() {
     fastaReader.SetToUpper();
+    streamReader.SetToUpper();
   }
 	void InitializeParameters() {
 		start  = 0;
@@ -44,6 +48,7 @@ class ReaderAgglomerate : public BaseSequenceIO {
 		readQuality = 1;
 		useRegionTable = true;
 		ignoreCCS = true;
+		streamInput = false;
 	}
 
 	ReaderAgglomerate() {
@@ -92,6 +97,40 @@ class ReaderAgglomerate : public BaseSequenceIO {
     hdfBasReader.SetReadBasesFromCCS();
 	}
 
+	//
+	// Read only the bases in the HQ region in 'regionTable' of each
+	// read, or none of the bases of a read without an HQ region; the
+	// rest are N.  Quality values are read in full.
+	// Reads are still returned one per ZMW.  NULL reads whole reads
+	// again.  This applies to raw bas/pls reads; CCS reads are
+	// unchanged.
+	//
+	void UseHQRegionTable(RegionTable *regionTable) {
+		if (fileType == HDFPulse || fileType == HDFBase) {
+			hdfBasReader.SetHQRegionTable(regionTable);
+		}
+	}
+
+	//
+	// The index of the next read in a bas/pls file, and a way to
+	// return to it without reading the reads before it.  Other file
+	// types are not indexed, so have no position.
+	//
+	bool HasReadPosition() {
+		return (fileType == HDFPulse || fileType == HDFBase);
+	}
+
+	int GetReadPosition() {
+		return hdfBasReader.curRead;
+	}
+
+	int SkipToReadPosition(int readPosition) {
+		if (HasReadPosition() == false) {
+			return 0;
+		}
+		return hdfBasReader.SkipTo(readPosition);
+	}
+
 	int Initialize(string &pFileName) {
 		if (DetermineFileTypeByExtension(pFileName, fileType)) {
 			fileName = pFileName;
@@ -136,12 +175,13 @@ class ReaderAgglomerate : public BaseSequenceIO {
 		
 	int Initialize() {
 		int init = 1;
+		streamInput = FASTXStreamReader::IsStreamFileName(fileName);
 		switch(fileType) {
 		case Fasta:
-			init = fastaReader.Init(fileName);
+			init = (streamInput ? streamReader.Init(fileName) : fastaReader.Init(fileName));
 			break;
 		case Fastq:
-			init = fastqReader.Init(fileName);
+			init = (streamInput ? streamReader.Init(fileName) : fastqReader.Init(fileName));
 			break;
 		case HDFPulse:
 		case HDFBase:
@@ -199,10 +239,10 @@ class ReaderAgglomerate : public BaseSequenceIO {
 		}
 		switch(fileType) {
 		case Fasta:
-			numRecords = fastaReader.GetNext(seq);
+			numRecords = (streamInput ? streamReader.GetNext(seq) : fastaReader.GetNext(seq));
 			break;
 		case Fastq:
-			numRecords = fastqReader.GetNext(seq);
+			numRecords = (streamInput ? streamReader.GetNext(seq) : fastqReader.GetNext(seq));
 			break;
 		case HDFPulse:
     case HDFBase:
@@ -224,10 +264,10 @@ class ReaderAgglomerate : public BaseSequenceIO {
 		}
 		switch(fileType) {
 		case Fasta:
-			numRecords = fastaReader.GetNext(seq);
+			numRecords = (streamInput ? streamReader.GetNext(seq) : fastaReader.GetNext(seq));
 			break;
 		case Fastq:
-			numRecords = fastqReader.GetNext(seq);
+			numRecords = (streamInput ? streamReader.GetNext(seq) : fastqReader.GetNext(seq));
 			break;
 		case HDFPulse:
     case HDFBase:
@@ -251,10 +291,10 @@ class ReaderAgglomerate : public BaseSequenceIO {
 		}
 		switch(fileType) {
 		case Fasta:
-			numRecords = fastaReader.GetNext(seq);
+			numRecords = (streamInput ? streamReader.GetNext(seq) : fastaReader.GetNext(seq));
 			break;
 		case Fastq:
-			numRecords = fastqReader.GetNext(seq);
+			numRecords = (streamInput ? streamReader.GetNext(seq) : fastqReader.GetNext(seq));
 			break;
 		case HDFPulse:
     case HDFBase:
@@ -280,12 +320,12 @@ class ReaderAgglomerate : public BaseSequenceIO {
 		switch(fileType) {
 		case Fasta:
 			// This just reads in the fasta sequence as if it were a ccs sequence
-			numRecords = fastaReader.GetNext(seq);
+			numRecords = (streamInput ? streamReader.GetNext(seq) : fastaReader.GetNext(seq));
 			seq.subreadStart = 0;
 			seq.subreadEnd   = 0;
 			break;
 		case Fastq:
-			numRecords = fastqReader.GetNext(seq);
+			numRecords = (streamInput ? streamReader.GetNext(seq) : fastqReader.GetNext(seq));
 			seq.subreadStart = 0;
 			seq.subreadEnd   = 0;
 			break;
@@ -305,6 +345,9 @@ class ReaderAgglomerate : public BaseSequenceIO {
 
 	int Advance(int nSteps) {
     int i;
+		if (streamInput) {
+			return streamReader.Advance(nSteps);
+		}
 		switch(fileType) {
 		case Fasta:
 			return fastaReader.Advance(nSteps);
@@ -320,6 +363,10 @@ class ReaderAgglomerate : public BaseSequenceIO {
 	}
 	
 	void Close() {
+		if (streamInput) {
+			streamReader.Close();
+			return;
+		}
 		switch(fileType) {
 
 		case Fasta:
@@ -17,6 +17,15 @@ class CDFMap {
 		value = data[valueIndex];
 		return valueIndex;
 	}
+
+	template<typename T_Random>
+	int SelectRandomValue(T_Data &value, T_Random &randomStream) {
+		int randomIndex = randomStream.RandomInt(cdf[cdf.size()-1]);
+		int valueIndex = lower_bound(cdf.begin(), cdf.end(), randomIndex) - cdf.begin();
+		assert(valueIndex < cdf.size());
+		value = data[valueIndex];
+		return valueIndex;
+	}
 };
 		
 #endif
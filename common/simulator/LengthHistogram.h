@@ -39,6 +39,11 @@ class LengthHistogram {
 		lengthHistogram.SelectRandomValue(length);
 	}
 
+	template<typename T_Random>
+	void GetRandomLength(int &length, T_Random &randomStream) {
+		lengthHistogram.SelectRandomValue(length, randomStream);
+	}
+
   void BuildFromAlignmentLengths(vector<int> &lengths) {
     int i;
     sort(lengths.begin(), lengths.end());
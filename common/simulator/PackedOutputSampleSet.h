@@ -0,0 +1,108 @@
+#ifndef SIMULATOR_PACKED_OUTPUT_SAMPLE_SET_H_
+#define SIMULATOR_PACKED_OUTPUT_SAMPLE_SET_H_
+
+#include <vector>
+#include <iostream>
+#include "OutputSampleListSet.h"
+#include "../NucConversion.h"
+#include "../Types.h"
+
+using namespace std;
+
+//
+// One output sample of a context, stored in the flat arrays of a
+// PackedOutputSampleSet: nucleotides and qualities
+// [first, first + length).
+//
+class PackedOutputSample {
+ public:
+  OutputSample::Type type;
+  UInt first;
+  UInt length;
+};
+
+//
+// The samples of an OutputSampleListSet in flat arrays indexed by the
+// context packed two bits per base, so that sampling needs neither a
+// string nor a map lookup.  Lookups do not modify the set, so any
+// number of threads may sample from it at once.
+//
+class PackedOutputSampleSet {
+ public:
+  int keyLength;
+  // samples of context key k are samples[keyOffsets[k] .. keyOffsets[k+1])
+  vector<UInt> keyOffsets;
+  vector<PackedOutputSample> samples;
+  vector<Nucleotide> nucleotides;
+  vector<QualitySample> qualities;
+
+  //
+  // Returns false if the context has a base other than A, C, G, or T.
+  //
+  bool PackKey(const Nucleotide *context, UInt &key) {
+    key = 0;
+    int i;
+    for (i = 0; i < keyLength; i++) {
+      UInt twoBit = TwoBit[context[i]];
+      if (twoBit > 3) {
+        return false;
+      }
+      key = (key << 2) | twoBit;
+    }
+    return true;
+  }
+
+  void Initialize(OutputSampleListSet &sampleListSet) {
+    keyLength = sampleListSet.keyLength;
+    if (keyLength <= 0 or keyLength > 15) {
+      cout << "ERROR, the context length " << keyLength << " of the output model is not supported." << endl;
+      exit(1);
+    }
+    UInt nKeys = 1 << (2*keyLength);
+    vector<UInt> keyCounts(nKeys + 1, 0);
+    OutputSampleListMap::iterator mapIt;
+    UInt key;
+    for (mapIt = sampleListSet.listMap.begin(); mapIt != sampleListSet.listMap.end(); ++mapIt) {
+      if (mapIt->first.size() == keyLength and PackKey((const Nucleotide*) mapIt->first.c_str(), key)) {
+        keyCounts[key+1] = mapIt->second.size();
+      }
+    }
+    keyOffsets.resize(nKeys + 1);
+    keyOffsets[0] = 0;
+    for (key = 0; key < nKeys; key++) {
+      keyOffsets[key+1] = keyOffsets[key] + keyCounts[key+1];
+    }
+    samples.resize(keyOffsets[nKeys]);
+    nucleotides.clear();
+    qualities.clear();
+    for (mapIt = sampleListSet.listMap.begin(); mapIt != sampleListSet.listMap.end(); ++mapIt) {
+      if (mapIt->first.size() != keyLength or PackKey((const Nucleotide*) mapIt->first.c_str(), key) == false) {
+        continue;
+      }
+      OutputSampleList &sampleList = mapIt->second;
+      UInt i;
+      for (i = 0; i < sampleList.size(); i++) {
+        PackedOutputSample &packedSample = samples[keyOffsets[key] + i];
+        packedSample.type   = sampleList[i].type;
+        packedSample.first  = nucleotides.size();
+        packedSample.length = sampleList[i].nucleotides.size();
+        nucleotides.insert(nucleotides.end(), sampleList[i].nucleotides.begin(), sampleList[i].nucleotides.end());
+        qualities.insert(qualities.end(), sampleList[i].qualities.begin(), sampleList[i].qualities.end());
+      }
+    }
+  }
+
+  //
+  // Returns NULL if the context was never sampled.
+  //
+  template<typename T_Random>
+  const PackedOutputSample *SampleRandomSample(UInt key, T_Random &randomStream) {
+    UInt nSamples = keyOffsets[key+1] - keyOffsets[key];
+    if (nSamples == 0) {
+      return NULL;
+    }
+    return &samples[keyOffsets[key] + randomStream.RandomInt(nSamples)];
+  }
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef STATISTICS_RANDOM_STREAM_H_
+#define STATISTICS_RANDOM_STREAM_H_
+
+#include <stdint.h>
+#include <algorithm>
+
+//
+// A small random number generator (splitmix64) with its own state, so
+// that threads can each draw from a stream of their own, and the
+// numbers drawn from stream i of seed s are the same on every run no
+// matter which thread draws them.  The methods mirror the global
+// generators in statutils.h.
+//
+class RandomStream {
+ public:
+	uint64_t state;
+
+	RandomStream(uint64_t seed=0, uint64_t stream=0) {
+		Initialize(seed, stream);
+	}
+
+	static uint64_t Mix(uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	void Initialize(uint64_t seed, uint64_t stream) {
+		state = Mix(seed + 0x9e3779b97f4a7c15ULL) ^ Mix(stream * 0x9e3779b97f4a7c15ULL + 1);
+	}
+
+	uint64_t Next() {
+		state += 0x9e3779b97f4a7c15ULL;
+		return Mix(state);
+	}
+
+	//
+	// A value in [0, randMax), or 0 if randMax is 0.
+	//
+	unsigned int RandomUnsignedInt(unsigned int randMax) {
+		return (unsigned int) (((Next() >> 32) * randMax) >> 32);
+	}
+
+	unsigned int RandomInt(int randMax) {
+		if (randMax <= 0) {
+			return 0;
+		}
+		return RandomUnsignedInt(randMax);
+	}
+
+	unsigned int RandomInt(unsigned int min, unsigned int max) {
+		return RandomInt(max - min) + min;
+	}
+
+	float Random() {
+		return (Next() >> 40) * (1.0f / 16777216.0f);
+	}
+};
+
+#endif
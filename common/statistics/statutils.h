@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <assert.h>
+#include <time.h>
 static const long FactorialTableLength = 21;
 
 static const long long FactorialTable[] = {1L, //0
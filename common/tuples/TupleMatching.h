@@ -4,6 +4,8 @@
 #include <vector>
 #include <utility>
 #include <iostream>
+#include <algorithm>
+#include <limits.h>
 
 #include "TupleList.h"
 #include "TupleMetrics.h"
@@ -60,6 +62,65 @@ template<typename TSequence, typename TMatch, typename T_TupleList>
 }
 
 
+//
+// Order tuples that are equal by their position, to search within the
+// range of tuples returned by TupleList::FindAll.
+//
+template<typename T_Tuple>
+class TuplePosLessThan {
+ public:
+	int operator()(const T_Tuple &tuple, long pos) const {
+		return ((long) tuple.pos) < pos;
+	}
+};
+
+//
+// The same as StoreMatchingPositions, except only matches that lie
+// inside 'band' are stored.  The target tuple positions are relative
+// to 'targetOffset' in the sequence the band is defined on.  Because
+// equal tuples are sorted by position, only the matches inside the
+// band are visited, so the cost no longer scales with the number of
+// times a low-complexity tuple is repeated in the target.
+//
+template<typename TSequence, typename TMatch, typename T_TupleList, typename T_Band>
+	int StoreMatchingPositionsInBand(TSequence &querySeq, TupleMetrics &tm, T_TupleList &targetTupleList, 
+                                   T_Band &band, DNALength targetOffset, vector<TMatch> &matchSet) {
+	DNALength s;
+	typename T_TupleList::Tuple queryTuple;
+  queryTuple.pos = 0;
+	if (querySeq.length >= tm.tupleSize) {
+    int res = 0;
+		for (s = 0; s < querySeq.length - tm.tupleSize + 1; s++) {
+      if ((res and (res = queryTuple.ShiftAddRL(querySeq.seq[s+tm.tupleSize-1], tm))) or
+          (!res and (res = queryTuple.FromStringRL(&querySeq.seq[s], tm)))) {
+        typename vector<typename T_TupleList::Tuple>::const_iterator curIt, endIt;
+				targetTupleList.FindAll(queryTuple, curIt, endIt);
+        if (curIt == endIt) {
+          continue;
+        }
+        long minPos, maxPos;
+        int minDiag, maxDiag;
+        if (band.GetDiagonalRange(s, minDiag, maxDiag)) {
+          minPos = ((long) s) + minDiag - (long) targetOffset;
+          maxPos = ((long) s) + maxDiag - (long) targetOffset;
+          if (maxPos < 0) {
+            continue;
+          }
+          curIt = lower_bound(curIt, endIt, minPos, TuplePosLessThan<typename T_TupleList::Tuple>());
+        }
+        else {
+          maxPos = LONG_MAX;
+        }
+        for(; curIt != endIt and ((long) (*curIt).pos) <= maxPos; curIt++) {
+          matchSet.push_back(TMatch(s, (*curIt).pos));
+        }
+			}
+		}
+	}
+	return matchSet.size();
+}
+
+
 template<typename Sequence, typename Tuple>
 	int StoreUniqueTuplePosList(Sequence seq, TupleMetrics &tm, vector<int> &uniqueTuplePosList) {
 		//
@@ -61,5 +61,72 @@ double LogSumOfThree(double value1, double value2, double value3) {
   return LogSumOfTwo(maxValue, LogSumOfTwo(middleValue, minValue));
 }
 
+//
+// A faster LogSumOfTwo for the forward algorithm, which adds
+// probabilities once or twice per cell.  log10(10^a + 10^b) is
+// max(a,b) + log10(1 + 10^-|a-b|), and the second term is taken from
+// a table over |a-b| with linear interpolation (error < 2e-6), in
+// float.  Differences past the end of the table add nothing, so
+// LOWEST_LOG_SUM_VALUE may be summed in place of a missing term.
+// There are no branches, so loops over arrays of cells vectorize.
+//
+#define LOWEST_LOG_SUM_VALUE -1.0e30f
+
+class LogSumTable {
+ public:
+  enum { StepsPerUnit = 256, MaxDifference = 16, TableSize = StepsPerUnit * MaxDifference + 2 };
+  float table[TableSize];
+
+  LogSumTable() {
+    int i;
+    for (i = 0; i < StepsPerUnit * MaxDifference; i++) {
+      table[i] = log10(1 + pow(10.0, -((double) i) / StepsPerUnit));
+    }
+    table[TableSize-2] = table[TableSize-1] = 0;
+  }
+
+  //
+  // One table is shared by all threads, and is built on first use.
+  //
+  static const LogSumTable &Get() {
+    static LogSumTable logSumTable;
+    return logSumTable;
+  }
+
+  inline float Sum(float a, float b) const {
+    float maxValue   = (a > b ? a : b);
+    float difference = (a > b ? a - b : b - a) * StepsPerUnit;
+    difference = (difference < StepsPerUnit * MaxDifference ? difference : StepsPerUnit * MaxDifference);
+    int   i    = (int) difference;
+    float frac = difference - i;
+    return maxValue + table[i] + frac * (table[i+1] - table[i]);
+  }
+
+  inline float Sum(float a, float b, float c) const {
+    return Sum(Sum(a, b), c);
+  }
+
+  //
+  // sum[i] = Sum(a[i], b[i]) for i in [0,n).
+  //
+  void Sum(const float *a, const float *b, float *sum, int n) const {
+    int i;
+    for (i = 0; i < n; i++) {
+      sum[i] = Sum(a[i], b[i]);
+    }
+  }
+};
+
+//
+// log(e^a + e^b) with the same table.
+//
+inline float NaturalLogSumOfTwo(float a, float b) {
+  return LogSumTable::Get().Sum(a / LOG10, b / LOG10) * LOG10;
+}
+
+inline float NaturalLogSumOfThree(float a, float b, float c) {
+  return LogSumTable::Get().Sum(a / LOG10, b / LOG10, c / LOG10) * LOG10;
+}
+
 
 #endif
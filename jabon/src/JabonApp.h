@@ -24,6 +24,8 @@ class JabonApp
     bool shouldExit;
     string queryFile;
     string targetFile;
+    string indexFile;
+    string writeIndexFile;
 };
 
 #endif /*JABONAPP_H_*/
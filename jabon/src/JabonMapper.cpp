@@ -1,6 +1,7 @@
 #include "JabonMapper.h"
 
 void *t_SingleAlign(void *);
+void *t_LoadBatches(void *);
 
 extern Param param;
 
@@ -9,14 +10,14 @@ extern Param param;
 RefSeq          *g_ref;
 ReadClass       *g_read_a;
 ifstream        *g_fin_a;
-pthread_mutex_t g_mutex_fin=PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t g_mutex_fout=PTHREAD_MUTEX_INITIALIZER;
-// JMS
-ref_id_t        g_longReadUid = 0;
 bit32_t         *g_n_aligned;
+// batches loaded by the reader thread, and batches it may load into
+ReadBatchQueue  *g_full_batches;
+ReadBatchQueue  *g_empty_batches;
 
 JabonMapper::JabonMapper( const string& queryFile ) : queryFile(queryFile), ref(),
-  n_aligned(0)
+  n_aligned(0), indexLoaded(false)
 {
 }
 
@@ -37,9 +38,38 @@ void JabonMapper::initialize( const string& targetFile )
   cerr<<"Load in "<<ref.total_num<<" db seqs, total size "<<ref.sum_length<<" bp. "<<Cal_AllTime()<<" secs passed"<<endl;
 }
 
-void JabonMapper::run()
+//
+// Map an index written by writeIndex instead of reading the target
+// and building its seed index.
+//
+void JabonMapper::initializeFromIndex( const string& indexFile )
+{
+  Initial_Time();
+  
+  if ( !ref.LoadIndex( indexFile ) )
+  {
+    throw JabonException();
+  }
+  indexLoaded = true;
+  
+  cerr<<"Load in "<<ref.total_num<<" db seqs, total size "<<ref.sum_length<<" bp, from index. "<<Cal_AllTime()<<" secs passed"<<endl;
+}
+
+void JabonMapper::writeIndex( const string& indexFile )
 {
   Do_Formatdb();
+  if ( !ref.SaveIndex( indexFile ) )
+  {
+    throw JabonException();
+  }
+  cerr << "Wrote seed index to " << indexFile << ". " <<Cal_AllTime()<<" secs passed"<<endl;
+  ref.ReleaseIndex();
+}
+
+void JabonMapper::run()
+{
+  if ( !indexLoaded )
+    Do_Formatdb();
   RunProcess();
   ref.ReleaseIndex();
   // MEMLEAK valgrind doesn't really like ReleaseIndex (double frees?)
@@ -92,19 +122,119 @@ void JabonMapper::RunProcess()
 void JabonMapper::DoSingleAlign()
 {
   read_a.CheckFile(fin_a);
+  
+  // one thread reads batches while the workers map them; there are
+  // enough batches for the reader to stay a batch ahead of every worker
+  int nBatches = 2*param.num_procs;
+  ReadBatchQueue full_batches(nBatches);
+  ReadBatchQueue empty_batches(nBatches);
+  vector<ReadBatch*> batches(nBatches);
+  for(int i=0; i<nBatches; i++)
+  {
+    batches[i] = new ReadBatch();
+    empty_batches.push(batches[i]);
+  }
+  g_full_batches = &full_batches;
+  g_empty_batches = &empty_batches;
+  
+  pthread_t reader_id;
   vector<pthread_t> pthread_ids(param.num_procs);
     //create
+  pthread_create(&reader_id, NULL, t_LoadBatches, NULL);
   for(int i=0; i<param.num_procs; i++)
     pthread_create(&pthread_ids[i], NULL, t_SingleAlign, NULL);
   //join
+  pthread_join(reader_id, NULL);
   for (int i=0; i<param.num_procs; i++)
     pthread_join(pthread_ids[i], NULL);
+  
+  for(int i=0; i<nBatches; i++)
+    delete batches[i];
 }
 
 void *t_SingleAlign(void *)
 {
   JabonMapperWorker worker = JabonMapperWorker();
   worker.run();
+  return NULL;
+}
+
+//
+// Load batches of reads until the input is exhausted.  This is the only
+// thread that touches the input file.
+//
+void *t_LoadBatches(void *)
+{
+  ReadBatch *batch;
+  // JMS
+  ref_id_t longReadUid = 0;
+  int n;
+  while(1)
+  {
+    batch = g_empty_batches->pop();
+    if(!param.chopReads)
+        n = g_read_a->LoadBatchReads(*g_fin_a);
+    else
+    {
+        n = g_read_a->LoadBatchLongReads( *g_fin_a, longReadUid );
+        longReadUid += n;
+    }
+    if(!n)
+      break;
+    batch->num = g_read_a->num;
+    g_read_a->mreads.swap(batch->reads);
+    g_full_batches->push(batch);
+  }
+  g_full_batches->close();
+  return NULL;
+}
+
+ReadBatchQueue::ReadBatchQueue( int capacity ) : capacity(capacity), closed(false)
+{
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&notEmpty, NULL);
+  pthread_cond_init(&notFull, NULL);
+}
+
+ReadBatchQueue::~ReadBatchQueue()
+{
+  pthread_mutex_destroy(&mutex);
+  pthread_cond_destroy(&notEmpty);
+  pthread_cond_destroy(&notFull);
+}
+
+void ReadBatchQueue::push( ReadBatch *batch )
+{
+  pthread_mutex_lock(&mutex);
+  while(batches.size() >= capacity)
+    pthread_cond_wait(&notFull, &mutex);
+  batches.push_back(batch);
+  pthread_cond_signal(&notEmpty);
+  pthread_mutex_unlock(&mutex);
+}
+
+ReadBatch *ReadBatchQueue::pop()
+{
+  ReadBatch *batch = NULL;
+  pthread_mutex_lock(&mutex);
+  while(batches.empty() && !closed)
+    pthread_cond_wait(&notEmpty, &mutex);
+  if(!batches.empty())
+  {
+    batch = batches.front();
+    batches.pop_front();
+    pthread_cond_signal(&notFull);
+  }
+  pthread_mutex_unlock(&mutex);
+  return batch;
+}
+
+void ReadBatchQueue::close()
+{
+  pthread_mutex_lock(&mutex);
+  closed = true;
+  pthread_cond_broadcast(&notEmpty);
+  pthread_mutex_unlock(&mutex);
 }
 
 JabonMapperWorker::JabonMapperWorker()
@@ -114,38 +244,24 @@ JabonMapperWorker::JabonMapperWorker()
 
 void JabonMapperWorker::run()
 {
-  int n;
-  bit32_t cur_at;
+  ReadBatch *batch;
   a.ImportFileFormat(g_read_a->_file_format);
   a.SetFlag('a');
   // JMS
   a.short_format = param.short_format;
-  while(1)
+  a.store_hits = true;
+  while((batch = g_full_batches->pop()) != NULL)
   {
-    pthread_mutex_lock(&g_mutex_fin);
-    // JMS
-    if(!param.chopReads)
-        n = g_read_a->LoadBatchReads(*g_fin_a);
-    else
-    {
-        n = g_read_a->LoadBatchLongReads( *g_fin_a, g_longReadUid );
-        g_longReadUid += n;
-    }
-    cur_at=g_read_a->_index;
-    a.ImportBatchReads(g_read_a->num, g_read_a->mreads);
-    pthread_mutex_unlock(&g_mutex_fin);
-    if(!n)
-      break;
+    a.SwapBatchReads(batch->num, batch->reads);
         // cerr << "Before do batch\n";
     a.Do_Batch(*g_ref);
         //cerr << "After do batch\n";
     
     postProcessReads();
     
-    //pthread_mutex_lock(&g_mutex_fout);
-    //cout<<a._str_align;
-    //cerr<<cur_at<<" reads finished. "<<Cal_AllTime()<<" secs passed"<<endl;
-    //pthread_mutex_unlock(&g_mutex_fout);    
+    // give the reads back with the batch so the reader can reuse them
+    a.SwapBatchReads(0, batch->reads);
+    g_empty_batches->push(batch);
   }
   pthread_mutex_lock(&g_mutex_fout);
   *g_n_aligned+=a.n_aligned;
@@ -157,24 +273,17 @@ void JabonMapperWorker::run()
 //
 void JabonMapperWorker::postProcessReads()
 {
-   typedef boost::tokenizer< boost::char_separator<char> > tokenizer;
-   // given how complex the SOAP code is, the best way to get the
-   // reads out is to parse the string output
-   // really not too much of a performance hit
-   // (and the boost tokenizing is streaming, not in memory)
-   string& sHits = a._str_align;
-   boost::char_separator<char> newlineSep("\n");
-   tokenizer tok( sHits, newlineSep );
+   // the worker sets store_hits, so SOAP leaves the hits in _hits_align,
+   // in the order it would have written them to _str_align
+   vector<ReadHit>& readHits = a._hits_align;
    
    vector<SoapShortHit*> short_hits;
    
-   int number = 0;
    string currentName = "";
-   for( tokenizer::iterator i=tok.begin(); i!=tok.end(); ++i )
+   for( int i=0; i < readHits.size(); i++ )
    {
      // convert to SOAP hit. JabonMapper owns the SoapShortHit.
-     SoapShortHit * hit = SoapShortHit::parseLine( *i );
-     hit->full_query_length = g_read_a->id2length.find( hit->query_id )->second;
+     SoapShortHit * hit = toShortHit( readHits[i] );
      // group by read name
      // TODO it is not true that all read hits come out of soap simulataneously
      // I'm not sure what to do about this.
@@ -194,6 +303,33 @@ void JabonMapperWorker::postProcessReads()
    short_hits.clear();
 }
 
+//
+// The hit that SoapShortHit::parseLine would make of the line SOAP
+// writes for readHit in its short format.
+//
+SoapShortHit *JabonMapperWorker::toShortHit( const ReadHit& readHit )
+{
+  const ReadInf& read = a.mreads[readHit.read];
+  SoapShortHit *hit = new SoapShortHit();
+  // chopped reads are named start:name
+  int index = read.name.find( ':' );
+  if ( index>=0 )
+    hit->query_id = read.name.substr( index+1 );
+  else
+    hit->query_id = read.name;
+  hit->query_start = read.longReadStart;
+  hit->num_hits = readHit.n;
+  hit->query_length = read.seq.size();
+  hit->query_end = hit->query_start + hit->query_length;
+  hit->full_query_length = read.longReadLength;
+  hit->target_strand = readHit.chain ? '-' : '+';
+  hit->target_id = g_ref->title[readHit.chr].name;
+  hit->target_start = readHit.loc;
+  hit->target_end = hit->target_start + hit->query_length;
+  hit->target_length = g_ref->title[readHit.chr].size;
+  return hit;
+}
+
 struct strCmp {
 	bool operator()( const char* s1, const char* s2 ) const {
 	return strcmp( s1, s2 ) < 0;
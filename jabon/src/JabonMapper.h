@@ -7,8 +7,8 @@
 #include <fstream>
 #include <string>
 #include <map>
+#include <deque>
 #include <pthread.h>
-#include <boost/tokenizer.hpp>
 
 #include "reads.h"
 #include "dbseq.h"
@@ -27,6 +27,8 @@ class JabonMapper
     JabonMapper( const string& queryFile );
     ~JabonMapper();
     void initialize( const string& targetFile );
+    void initializeFromIndex( const string& indexFile );
+    void writeIndex( const string& indexFile );
     void run();
     
     
@@ -38,12 +40,49 @@ class JabonMapper
     ifstream fin_a;
     
     bit32_t n_aligned;   //number of reads aligned
+    bool indexLoaded;    //the seed index came from an index file
     
     void Do_Formatdb();
     void RunProcess();
     void DoSingleAlign();
 };
 
+//
+// A batch of reads, handed from the reader thread to a worker and back.
+// The reads are swapped, not copied, in and out of a batch so that their
+// storage is reused from batch to batch.
+//
+struct ReadBatch
+{
+  vector<ReadInf> reads;
+  bit32_t num;
+  
+  ReadBatch() : reads(BatchNum), num(0) {}
+};
+
+//
+// A bounded queue of read batches.  push blocks while the queue is full
+// and pop while it is empty; after close, pop returns NULL once the
+// queue is drained.
+//
+class ReadBatchQueue
+{
+  public:
+    ReadBatchQueue( int capacity );
+    ~ReadBatchQueue();
+    void push( ReadBatch *batch );
+    ReadBatch *pop();
+    void close();
+    
+  private:
+    deque<ReadBatch*> batches;
+    int capacity;
+    bool closed;
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+};
+
 class JabonMapperWorker
 {
   public:
@@ -55,7 +94,8 @@ class JabonMapperWorker
 
   private:
     SingleAlign a;
-
+    
+    SoapShortHit *toShortHit( const ReadHit& readHit );
 };
 
 #endif /*JABONMAPPER_H_*/
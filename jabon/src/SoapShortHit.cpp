@@ -92,6 +92,7 @@ bool SoapShortHit::append(SoapShortHit * otherHit)
 	this->query_length += otherHit->query_end - this->query_end;
 	this->query_end = otherHit->query_end;
 	this->target_end = otherHit->target_end;
+	return true;
 }
 
 void SoapShortHit::getPrefix( const string& s, char delim, string& prefix )
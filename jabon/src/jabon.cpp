@@ -41,6 +41,8 @@ void JabonApp::processOptions( int argc, char **argv )
     desc.add_options()
       ( "query,q", po::value<string>()->default_value(""), "Query file in FASTA format" )
       ( "target,t", po::value<string>()->default_value(""), "Target file in FASTA format" )
+      ( "index,x", po::value<string>()->default_value(""), "Seed index written by --writeIndex, used instead of --target" )
+      ( "writeIndex", po::value<string>()->default_value(""), "Write the seed index of the target to this file and exit" )
       ( "windowSize,w", po::value<int>()->default_value(25), "Window size for chopping reads" )
       ( "windowStep,d", po::value<int>()->default_value(1), "Window step for chopping reads" )
       ( "seed,s", po::value<int>()->default_value(10), "Seed size for SOAP algorithm" )
@@ -65,7 +67,11 @@ void JabonApp::processOptions( int argc, char **argv )
      
     debug = vm["debug"].as<bool>();
     
-    if ( vm.count( "query" )==0 || vm["query"].as<string>().length()==0 )
+    indexFile = vm["index"].as<string>();
+    writeIndexFile = vm["writeIndex"].as<string>();
+    
+    if ( writeIndexFile.length()==0 && 
+         ( vm.count( "query" )==0 || vm["query"].as<string>().length()==0 ) )
     {
       cerr << "!! No query file specified" << endl << endl;
       printUsage( desc );
@@ -77,7 +83,9 @@ void JabonApp::processOptions( int argc, char **argv )
       queryFile = vm["query"].as<string>();
     }
     
-    if ( vm.count( "target" )==0 || vm["target"].as<string>().length()==0 )
+    // an index replaces the target, except when writing one
+    if ( ( indexFile.length()==0 || writeIndexFile.length()>0 ) &&
+         ( vm.count( "target" )==0 || vm["target"].as<string>().length()==0 ) )
     {
       cerr << "!! No target file specified" << endl << endl;
       printUsage( desc );
@@ -146,7 +154,16 @@ int JabonApp::run()
   }
   
   JabonMapper mapper( queryFile );
-  mapper.initialize( targetFile );
+  if ( writeIndexFile.length()>0 )
+  {
+    mapper.initialize( targetFile );
+    mapper.writeIndex( writeIndexFile );
+    return 0;
+  }
+  if ( indexFile.length()>0 )
+    mapper.initializeFromIndex( indexFile );
+  else
+    mapper.initialize( targetFile );
   mapper.run();
   
   return 0;
@@ -216,6 +216,8 @@ SingleAlign::SingleAlign()
 
     short_format = false;
 
+    store_hits = false;
+
 }
 
 	
@@ -242,6 +244,20 @@ void SingleAlign::ImportBatchReads(bit32_t n, vector<ReadInf> &a)
 
 
 
+//as ImportBatchReads, but exchanges the reads with a instead of copying them
+
+void SingleAlign::SwapBatchReads(bit32_t n, vector<ReadInf> &a)
+
+{
+
+	num_reads=n;
+
+	mreads.swap(a);
+
+}
+
+
+
 int SingleAlign::CountNs()
 
 {
@@ -3608,6 +3624,8 @@ void SingleAlign::Do_Batch(RefSeq &ref)
 
 	_str_align.clear();
 
+	_hits_align.clear();
+
 	bit32_t tt;
 
 	//for mRNA tag alignment
@@ -4003,9 +4021,13 @@ void SingleAlign::StringAlign(RefSeq &ref, string &os)
 
 {
 
-	Reverse_Seq();
+	if(!store_hits) {
 
-	Reverse_Qual();
+		Reverse_Seq();
+
+		Reverse_Qual();
+
+	}
 
 	int ii, jj, sum, j;
 
@@ -4151,6 +4173,14 @@ void SingleAlign::s_OutHit(int chain, size_t n, bit8_t nsnps, Hit *hit, bool sig
 
 {
 
+	if(store_hits) {
+
+		StoreHit(chain, n, nsnps, hit);
+
+		return;
+
+	}
+
 	if(param.output_id)
 
 		sprintf(_ch, "%s\t", _pread->name.c_str());
@@ -4229,6 +4259,24 @@ void SingleAlign::s_OutGapHit(int chain, size_t n, bit8_t g, Hit *hit, RefSeq &r
 
 {
 
+	if(store_hits) {
+
+		if((hit->z <200)&&(hit->z>100))
+
+			StoreHit(chain, n, 100+g, hit);
+
+		else if(hit->z>200)
+
+			StoreHit(chain, n, 200+g, hit);
+
+		else
+
+			StoreHit(chain, n, 0, hit);
+
+		return;
+
+	}
+
 	if(param.output_id)
 
 		sprintf(_ch, "%s\t", _pread->name.c_str());
@@ -100,6 +100,20 @@ struct Hit
 
 
 
+// a hit as it would be written by s_OutHit/s_OutGapHit, kept for callers
+// that set store_hits and read _hits_align instead of parsing _str_align
+struct ReadHit
+{
+	bit32_t read;      //offset of the read in mreads
+	bit32_t n;         //No. of hits reported for the read
+	ref_id_t chr;
+	ref_loc_t loc;
+	bit8_t chain;      //0: +; 1: -
+	bit8_t z;          //No. of snps, or 100+g/200+g for gapped hits as in the text output
+};
+
+
+
 /*
 
 struct GapHit
@@ -129,6 +143,7 @@ public:
 	void ImportFileFormat(int format);
 
 	void ImportBatchReads(bit32_t n, vector<ReadInf> &a);
+	void SwapBatchReads(bit32_t n, vector<ReadInf> &a);
 
 	int CountNs();
 
@@ -199,6 +214,7 @@ public:
 	void s_OutHit(int chain, size_t n, bit8_t nspsn, Hit *hit, bool sig, RefSeq &ref, string &os);
 
 	void s_OutGapHit(int chain, size_t n, bit8_t g, Hit *hit, RefSeq &ref, string &os);
+	inline void StoreHit(int chain, size_t n, bit8_t z, Hit *hit);
 
 
 
@@ -331,6 +347,9 @@ public:
     // 04/08/08 JMS - whether or not to use an abbreviated output format
 
     bool short_format;
+	// store hits in _hits_align rather than formatting them into _str_align
+	bool store_hits;
+	vector<ReadHit> _hits_align;
 
 protected:
 
@@ -528,47 +547,91 @@ inline void SingleAlign::GenerateSeeds_3(int n)
 
 
 
-inline int SingleAlign::CountMismatch(bit24_t *q, bit24_t *r, bit24_t *s)
+//No. of set bits of x; the popcnt instruction when the build targets it
+
+inline int PopCount64(bit64_t x)
 
 {
 
-#ifdef READ_36
+#ifdef __POPCNT__
 
-//	cout<<q->a<<"  "<<s->a<<"  "<<r->a<<endl;
+	return __builtin_popcountll(x);
 
-//	cout<<(q+1)->a<<"  "<<(s+1)->a<<"  "<<(r+1)->a<<endl;
+#else
 
-//	cout<<(q+2)->a<<"  "<<(s+2)->a<<"  "<<(r+2)->a<<endl;
+	x=x-((x>>1)&0x5555555555555555ULL);
 
-//	cout<<(q+3)->a<<"  "<<(s+3)->a<<"  "<<(r+3)->a<<endl;
+	x=(x&0x3333333333333333ULL)+((x>>2)&0x3333333333333333ULL);
 
-	return param.num_mismatch[(q->a^s->a)&r->a]+param.num_mismatch[((q+1)->a^(s+1)->a)&(r+1)->a]
+	x=(x+(x>>4))&0x0f0f0f0f0f0f0f0fULL;
 
-		+param.num_mismatch[((q+2)->a^(s+2)->a)&(r+2)->a]+param.num_mismatch[((q+3)->a^(s+3)->a)&(r+3)->a];
+	return (x*0x0101010101010101ULL)>>56;
 
 #endif
 
-#ifdef READ_48
+}
 
-	return param.num_mismatch[(q->a^s->a)&r->a]+param.num_mismatch[((q+1)->a^(s+1)->a)&(r+1)->a]
 
-		+param.num_mismatch[((q+2)->a^(s+2)->a)&(r+2)->a]+param.num_mismatch[((q+3)->a^(s+3)->a)&(r+3)->a]
 
-		+param.num_mismatch[((q+4)->a^(s+4)->a)&(r+4)->a];
+//mismatches between query q and reference s where the query is unmasked (r).
 
-#endif
+//each element's xor is folded to one bit per base, and the folded elements
 
-#ifdef READ_60
+//are interleaved, two per 24 bits, into 64-bit words that are counted at once
 
-	return param.num_mismatch[(q->a^s->a)&r->a]+param.num_mismatch[((q+1)->a^(s+1)->a)&(r+1)->a]
+inline int SingleAlign::CountMismatch(bit24_t *q, bit24_t *r, bit24_t *s)
 
-		+param.num_mismatch[((q+2)->a^(s+2)->a)&(r+2)->a]+param.num_mismatch[((q+3)->a^(s+3)->a)&(r+3)->a]
+{
 
-		+param.num_mismatch[((q+4)->a^(s+4)->a)&(r+4)->a]+param.num_mismatch[((q+5)->a^(s+5)->a)&(r+5)->a];
+	bit32_t d;
+
+	bit64_t w=0;
+
+	int n=0;
+
+	for(int i=0; i<FIXELEMENT; i++) {
+
+		d=(q[i].a^s[i].a)&r[i].a;
+
+		w|=(bit64_t)((d|d>>1)&0x555555)<<((i&3)/2*24+(i&1));
+
+		if((i&3)==3 || i==FIXELEMENT-1) {
+
+			n+=PopCount64(w);
+
+			w=0;
+
+		}
+
+	}
+
+	return n;
+
+}
+
+inline void SingleAlign::StoreHit(int chain, size_t n, bit8_t z, Hit *hit)
+
+{
+
+	ReadHit h;
+
+	h.read=_pread-mreads.begin();
+
+	h.n=n;
+
+	h.chr=hit->chr;
+
+	h.loc=hit->loc;
+
+	h.chain=chain;
+
+	h.z=z;
+
+	_hits_align.push_back(h);
+
+}
 
-#endif
 
-}	
 
 inline void SingleAlign::Reverse_Seq()
 
@@ -1,5 +1,15 @@
 #include<iostream>
 
+#include<cstring>
+
+#include<sys/mman.h>
+
+#include<sys/stat.h>
+
+#include<fcntl.h>
+
+#include<unistd.h>
+
 #include "dbseq.h"
 
 
@@ -22,6 +32,10 @@ RefSeq::RefSeq()
 
 	total_kmers=0;
 
+	_map=NULL;
+
+	_map_size=0;
+
 }
 
 ref_loc_t RefSeq::LoadNextSeq(ifstream &fin)
@@ -533,6 +547,20 @@ void RefSeq::AllocIndex()
 void RefSeq::ReleaseIndex()
 
 {
+
+	if(_map) {  //loaded by LoadIndex
+
+		delete[] index;
+
+		munmap(_map, _map_size);
+
+		_map=NULL;
+
+		bfa.clear();
+
+		return;
+
+	}
 	for(bit32_t j=0; j<total_kmers; j++) {
 
 		delete index[j].id1;
@@ -791,3 +819,385 @@ void RefSeq::CreateIndex()
 
 }
 
+
+
+//pad the index file to a multiple of 8 bytes
+
+static void s_PadIndex(ofstream &fout)
+
+{
+
+	char zeros[8]={0, 0, 0, 0, 0, 0, 0, 0};
+
+	bit64_t pos=fout.tellp();
+
+	if(pos%8)
+
+		fout.write(zeros, 8-pos%8);
+
+}
+
+
+
+//write the binary reference and the seed tables, after CreateIndex
+
+bool RefSeq::SaveIndex(const string &file)
+
+{
+
+	ofstream fout(file.c_str(), ios::out|ios::binary);
+
+	if(!fout) {
+
+		cerr<<"fatal error: failed to open index file: "<<file<<endl;
+
+		return false;
+
+	}
+
+	IndexFileHeader h;
+
+	memset(&h, 0, sizeof(h));
+
+	strcpy(h.magic, "SOAPIDX");
+
+	h.version=IndexFileVersion;
+
+	h.seed_size=param.seed_size;
+
+	h.id_size=sizeof(ref_id_t);
+
+	h.loc_size=sizeof(ref_loc_t);
+
+	h.total_num=total_num;
+
+	h.total_kmers=total_kmers;
+
+	h.sum_length=sum_length;
+
+	KmerLoc *v;
+
+	bit32_t j;
+
+	for(v=index, j=0; j<total_kmers; v++,j++) {
+
+		h.num_locs[0]+=v->n1;
+
+		h.num_locs[1]+=v->n2;
+
+		h.num_locs[2]+=v->n3;
+
+	}
+
+	fout.write((char*)&h, sizeof(h));
+
+	int i;
+
+	for(i=0; i<total_num; i++) {
+
+		bit32_t len=title[i].name.size();
+
+		fout.write((char*)&title[i].size, sizeof(bit32_t));
+
+		fout.write((char*)&len, sizeof(bit32_t));
+
+		fout.write(title[i].name.c_str(), len);
+
+	}
+
+	s_PadIndex(fout);
+
+	for(i=0; i<total_num; i++)
+
+		fout.write((char*)&bfa[i].n, sizeof(bit32_t));
+
+	s_PadIndex(fout);
+
+	for(i=0; i<total_num; i++)
+
+		fout.write((char*)bfa[i].s, bfa[i].n*sizeof(bit24_t));
+
+	s_PadIndex(fout);
+
+	for(v=index, j=0; j<total_kmers; v++,j++) {
+
+		fout.write((char*)&v->n1, sizeof(bit32_t));
+
+		fout.write((char*)&v->n2, sizeof(bit32_t));
+
+		fout.write((char*)&v->n3, sizeof(bit32_t));
+
+	}
+
+	s_PadIndex(fout);
+
+	for(v=index, j=0; j<total_kmers; v++,j++)
+
+		if(v->n1>0) fout.write((char*)v->id1, v->n1*sizeof(ref_id_t));
+
+	s_PadIndex(fout);
+
+	for(v=index, j=0; j<total_kmers; v++,j++)
+
+		if(v->n1>0) fout.write((char*)v->loc1, v->n1*sizeof(ref_loc_t));
+
+	s_PadIndex(fout);
+
+	for(v=index, j=0; j<total_kmers; v++,j++)
+
+		if(v->n2>0) fout.write((char*)v->id2, v->n2*sizeof(ref_id_t));
+
+	s_PadIndex(fout);
+
+	for(v=index, j=0; j<total_kmers; v++,j++)
+
+		if(v->n2>0) fout.write((char*)v->loc2, v->n2*sizeof(ref_loc_t));
+
+	s_PadIndex(fout);
+
+	for(v=index, j=0; j<total_kmers; v++,j++)
+
+		if(v->n3>0) fout.write((char*)v->id3, v->n3*sizeof(ref_id_t));
+
+	s_PadIndex(fout);
+
+	for(v=index, j=0; j<total_kmers; v++,j++)
+
+		if(v->n3>0) fout.write((char*)v->loc3, v->n3*sizeof(ref_loc_t));
+
+	s_PadIndex(fout);
+
+	fout.close();
+
+	if(!fout) {
+
+		cerr<<"fatal error: failed to write index file: "<<file<<endl;
+
+		return false;
+
+	}
+
+	return true;
+
+}
+
+
+
+//map an index file written by SaveIndex read-only, in place of
+
+//Run_ConvertBinseq and CreateIndex. the sequences and the location lists
+
+//stay in the mapping, so processes that load the same file share them;
+
+//only the KmerLoc table that points into it is built here
+
+bool RefSeq::LoadIndex(const string &file)
+
+{
+
+	int fd=open(file.c_str(), O_RDONLY);
+
+	if(fd<0) {
+
+		cerr<<"fatal error: failed to open index file: "<<file<<endl;
+
+		return false;
+
+	}
+
+	struct stat st;
+
+	if(fstat(fd, &st)<0 || st.st_size<sizeof(IndexFileHeader)
+
+		|| (_map=(char*)mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0))==MAP_FAILED) {
+
+		cerr<<"fatal error: "<<file<<" is not an index file"<<endl;
+
+		close(fd);
+
+		_map=NULL;
+
+		return false;
+
+	}
+
+	close(fd);
+
+	_map_size=st.st_size;
+
+	IndexFileHeader *h=(IndexFileHeader*)_map;
+
+	if(strncmp(h->magic, "SOAPIDX", 8)!=0 || h->version!=IndexFileVersion
+
+		|| h->id_size!=sizeof(ref_id_t) || h->loc_size!=sizeof(ref_loc_t)) {
+
+		cerr<<"fatal error: "<<file<<" is not an index file, or is from an incompatible version"<<endl;
+
+		munmap(_map, _map_size);
+
+		_map=NULL;
+
+		return false;
+
+	}
+
+	if(h->seed_size!=param.seed_size) {
+
+		cerr<<"fatal error: "<<file<<" was built with seed size "<<h->seed_size<<endl;
+
+		munmap(_map, _map_size);
+
+		_map=NULL;
+
+		return false;
+
+	}
+
+	char *p=_map+sizeof(IndexFileHeader);
+
+	char *end=_map+_map_size;
+
+	int i;
+
+	total_num=h->total_num;
+
+	sum_length=h->sum_length;
+
+	title.resize(total_num);
+
+	for(i=0; i<total_num && p+2*sizeof(bit32_t)<=end; i++) {
+
+		bit32_t len;
+
+		title[i].size=*(bit32_t*)p;
+
+		len=*(bit32_t*)(p+sizeof(bit32_t));
+
+		p+=2*sizeof(bit32_t);
+
+		if(p+len>end)
+
+			break;
+
+		title[i].name.assign(p, len);
+
+		p+=len;
+
+	}
+
+	p+=(8-(p-_map)%8)%8;
+
+	bfa.resize(total_num);
+
+	bit32_t *n=(bit32_t*)p;
+
+	p+=(total_num*sizeof(bit32_t)+7)/8*8;
+
+	bit64_t total_n=0;
+
+	if(i==total_num && p<=end)
+
+		for(i=0; i<total_num; i++)
+
+			total_n+=n[i];
+
+	bit64_t num_locs=h->num_locs[0]+h->num_locs[1]+h->num_locs[2];
+
+	bit64_t size=(p-_map)+(total_n*sizeof(bit24_t)+7)/8*8+((bit64_t)h->total_kmers*3*sizeof(bit32_t)+7)/8*8;
+
+	for(int k=0; k<3; k++)
+
+		size+=(h->num_locs[k]*sizeof(ref_id_t)+7)/8*8+(h->num_locs[k]*sizeof(ref_loc_t)+7)/8*8;
+
+	if(i!=total_num || h->total_kmers!=(1U<<param.seed_size*2) || size>_map_size) {
+
+		cerr<<"fatal error: index file "<<file<<" is truncated"<<endl;
+
+		munmap(_map, _map_size);
+
+		_map=NULL;
+
+		return false;
+
+	}
+
+	for(i=0; i<total_num; i++) {
+
+		bfa[i].n=n[i];
+
+		bfa[i].s=(bit24_t*)p;
+
+		p+=n[i]*sizeof(bit24_t);
+
+	}
+
+	p+=(8-(p-_map)%8)%8;
+
+	bit32_t *counts=(bit32_t*)p;
+
+	p+=((bit64_t)h->total_kmers*3*sizeof(bit32_t)+7)/8*8;
+
+	ref_id_t *id[3];
+
+	ref_loc_t *loc[3];
+
+	for(int k=0; k<3; k++) {
+
+		id[k]=(ref_id_t*)p;
+
+		p+=(h->num_locs[k]*sizeof(ref_id_t)+7)/8*8;
+
+		loc[k]=(ref_loc_t*)p;
+
+		p+=(h->num_locs[k]*sizeof(ref_loc_t)+7)/8*8;
+
+	}
+
+	total_kmers=h->total_kmers;
+
+	cerr<<"total_kmers: "<<total_kmers<<endl;
+
+	index=new KmerLoc[total_kmers];
+
+	KmerLoc *v;
+
+	bit32_t j;
+
+	for(v=index, j=0; j<total_kmers; v++,j++,counts+=3) {
+
+		v->n1=counts[0];
+
+		v->id1=id[0];
+
+		v->loc1=loc[0];
+
+		id[0]+=v->n1;
+
+		loc[0]+=v->n1;
+
+		v->n2=counts[1];
+
+		v->id2=id[1];
+
+		v->loc2=loc[1];
+
+		id[1]+=v->n2;
+
+		loc[1]+=v->n2;
+
+		v->n3=counts[2];
+
+		v->id3=id[2];
+
+		v->loc3=loc[2];
+
+		id[2]+=v->n3;
+
+		loc[2]+=v->n3;
+
+	}
+
+	return true;
+
+}
+
@@ -64,6 +64,25 @@ struct KmerLoc
 
 
 
+//header of a seed index file written by RefSeq::SaveIndex. it is followed,
+//each part padded to 8 bytes, by the titles (size, length of name, name),
+//bfa[].n, the bfa sequences, n1/n2/n3 of every kmer, and the id and loc
+//lists of the ab, ac and ad seeds, in kmer order
+struct IndexFileHeader
+{
+	char magic[8];
+	bit32_t version;
+	bit32_t seed_size;
+	bit32_t id_size;   //sizeof(ref_id_t), which depends on DB_CHR etc.
+	bit32_t loc_size;  //sizeof(ref_loc_t)
+	bit32_t total_num;
+	bit32_t total_kmers;
+	bit64_t sum_length;
+	bit64_t num_locs[3];  //total No. of ab, ac, ad seed locations
+};
+
+const bit32_t IndexFileVersion=1;
+
 class RefSeq
 
 {
@@ -105,6 +124,8 @@ public:
 	void CreateIndex();
 
 	void ReleaseIndex();
+	bool SaveIndex(const string &file);
+	bool LoadIndex(const string &file);
 
 #ifdef THREAD
 
@@ -141,6 +162,9 @@ protected:
 	string _seq;
 
 	ref_loc_t _length;
+	//index file mapped by LoadIndex, which bfa and index point into
+	char *_map;
+	size_t _map_size;
 
 public:	
 
@@ -159,8 +159,6 @@ Param::Param()
   
   minChainLength = 1;
 
-  BuildMismatchTable();
-
 };
 
 
@@ -221,28 +219,6 @@ void Param::SetMrnaTag(int n)
 
 
 
-void Param::BuildMismatchTable()
-
-{
-
-	int n;
-
-	for(bit32_t i=0; i<0x1000000; i++) {
-
-		n=0;
-
-		for(int j=0; j<12; j++)
-
-			if((i>>j*2)&0x3)
-
-				n++;
-
-		num_mismatch[i]=n;
-
-	}
-
-}
-
 /*
 
 Aa=0
@@ -71,8 +71,6 @@ public:
 
 	void SetMrnaTag(int n);
 
-	void BuildMismatchTable();
-
 public:
 
 	int num_procs;  //number of parallel processors
@@ -195,10 +193,6 @@ public:
 
 	string nx_nt;
 
-	//mismatch table
-
-	bit8_t num_mismatch[0xffffff];
-
 };
 
 
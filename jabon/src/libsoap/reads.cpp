@@ -138,6 +138,10 @@ int ReadClass::LoadBatchReads(ifstream &fin)
 
 			p->qual=string(p->seq.size(), param.zero_qual+param.default_qual);
 
+		p->longReadStart=0;
+
+		p->longReadLength=p->seq.size();
+
 	}
 
 	return num;
@@ -309,6 +313,8 @@ int ReadClass::LoadBatchLongReads( ifstream &fin, ref_id_t longReadUid )
             p->qual = string(p->seq.size(), param.zero_qual+param.default_qual);
 
             p->longReadUid = luid;
+            p->longReadStart = start;
+            p->longReadLength = seqLen;
 
             start += windowStep;
 
@@ -39,6 +39,9 @@ struct ReadInf
 	string qual;
 
     ref_id_t longReadUid;
+    // offset of the read in its long read, and the long read's length
+    bit32_t longReadStart;
+    bit32_t longReadLength;
 
 };
 
@@ -17,6 +17,10 @@
 #include <string>
 #include <ext/hash_map>
 #include <map>
+#include <set>
+#include <sstream>
+#include <algorithm>
+#include <pthread.h>
 
 
 #include "InsertedString.h"
@@ -105,7 +109,7 @@ void PrintInsertions(InsertedStringList &insertions,
     }
     curOffset = (readStart + insertions[insIndex].pos) - curPos;
     int i;
-    if (onNewLine) { cout << insMarginStr; }
+    if (onNewLine) { out << insMarginStr; }
     onNewLine = false;
     //
     //  Print the insertion.
@@ -174,21 +178,28 @@ void SetRefString(DNASequence &genome, int pos, int width, string &refStr) {
   }
 }
 
-int FindPosition(vector<int> &posMap, int pos, int &index) {
+//
+// Look up the index in the alignment string of reference position
+// 'pos', using the inverse of the ref positions computed once per
+// alignment (see StoreRefPositionIndex).
+//
+int FindPosition(vector<int> &refPosToAlnIndex, int pos, int &index) {
   index = 0;
-  // 
-  // Handle some boundary conditions.
-  //
-  if (posMap.size() == 0) {
-    return 0;
-  }
-  if (pos < 0 or pos > posMap[posMap.size()-1]) {
+  if (pos < 0 or pos >= refPosToAlnIndex.size()) {
     return 0;
   }
-  for (index = 0; index < posMap.size(); index++) {
-    if (posMap[index] == pos) return 1;
+  index = refPosToAlnIndex[pos];
+  return 1;
+}
+
+void StoreRefPositionIndex(vector<int> &refPositions, vector<int> &refPosToAlnIndex) {
+  refPosToAlnIndex.clear();
+  int i;
+  for (i = 0; i < refPositions.size(); i++) {
+    if (refPositions[i] != -1) {
+      refPosToAlnIndex.push_back(i);
+    }
   }
-  return 0;
 }
 
 void CopyFieldString(ByteAlignment &aln, vector<char> &fieldChars, int begin, int end, string &fieldStr) {
@@ -287,6 +298,291 @@ int ComputeOffsetToRefPosition(ByteAlignment &aln, DNALength alnStartPos, DNALen
   }
 }
 
+//
+// The parts of an alignment that are needed to print it at any
+// position it covers: the byte alignment in the forward direction of
+// the reference, the ref/query coordinates of each column, and the
+// condensed quality values.  These are decoded once per alignment and
+// reused for every nearby position it is printed at.
+//
+class DecodedAlignment {
+ public:
+  bool isDecoded;
+  ByteAlignment byteAlignment;
+  vector<int> refPositions, queryPositions, refPosToAlnIndex;
+  vector<char> insQVChars, delQVChars, subQVChars, mergeQVChars;
+  DecodedAlignment() {
+    isDecoded = false;
+  }
+};
+
+typedef map<int, DecodedAlignment> DecodedAlignmentCache;
+
+//
+// Fetch a qv field without inserting it, so that alignments may be
+// decoded by several threads at once.
+//
+vector<UChar> &GetQVField(CmpAlignment &alignment, const char *fieldName, vector<UChar> &missingField) {
+  map<string, vector<UChar> >::iterator fieldIt = alignment.fields.find(fieldName);
+  if (fieldIt == alignment.fields.end()) {
+    return missingField;
+  }
+  return fieldIt->second;
+}
+
+void DecodeAlignment(CmpAlignment &alignment, int scale, DecodedAlignment &decoded) {
+  vector<UChar> missingField;
+  decoded.byteAlignment = alignment.alignmentArray;
+  CondenseCharacterVector(GetQVField(alignment, "InsertionQV", missingField),    decoded.insQVChars, scale);
+  CondenseCharacterVector(GetQVField(alignment, "DeletionQV", missingField),     decoded.delQVChars, scale);
+  CondenseCharacterVector(GetQVField(alignment, "SubstitutionQV", missingField), decoded.subQVChars, scale);
+  CondenseCharacterVector(GetQVField(alignment, "MergeQV", missingField),        decoded.mergeQVChars, scale);
+
+  if (alignment.GetRCRefStrand() == 1) {
+    ByteAlignment byteAlignmentRC;
+    byteAlignmentRC.resize(decoded.byteAlignment.size());
+    if (byteAlignmentRC.size() > 0) {
+      MakeReverseComplementByteAlignment(&decoded.byteAlignment[0], decoded.byteAlignment.size(), &byteAlignmentRC[0]);
+    }
+    decoded.byteAlignment.swap(byteAlignmentRC);
+    reverse(decoded.insQVChars.begin(), decoded.insQVChars.end());
+    reverse(decoded.delQVChars.begin(), decoded.delQVChars.end());
+    reverse(decoded.subQVChars.begin(), decoded.subQVChars.end());
+    reverse(decoded.mergeQVChars.begin(), decoded.mergeQVChars.end());
+  }
+  ComputeQueryPositions(decoded.byteAlignment, decoded.queryPositions);
+  ComputeRefPositions(decoded.byteAlignment,   decoded.refPositions);
+  StoreRefPositionIndex(decoded.refPositions, decoded.refPosToAlnIndex);
+  decoded.isDecoded = true;
+}
+
+class MSAPrintOptions {
+ public:
+  int  width;
+  int  scale;
+  bool printMSA;
+  bool showDeletionQV, showInsertionQV, showSubstitutionQV, showMergeQV;
+  bool insertionsOnly, hideInsertions, miscallView, printProfile;
+  bool printReads;
+  string alnStrMargin, insMargin, delQVMargin, subQVMargin, insQVMargin, mergeQVMargin;
+};
+
+//
+// Print the reads covering centerPos, in the order of their index in
+// the cmp file.  Alignments are taken from 'cache' when a previous
+// position already decoded them.
+//
+void PrintPosition(int centerPos, vector<int> &alignmentIndices, CmpFile &cmpFile, 
+                   FASTASequence &genome, vector<int> &alignmentReaderIndex,
+                   MSAPrintOptions &opts, DecodedAlignmentCache &cache, ostream &out) {
+  int width = opts.width;
+  out << "position " << centerPos << endl;
+  string refStr;
+  if (opts.printMSA) {
+    SetRefString(genome, centerPos, width, refStr);
+  }
+  out << opts.alnStrMargin << refStr << endl;
+  Profile profile(width*2+1);
+  int a;
+  for (a = 0; a < alignmentIndices.size(); a++) {
+    int alignmentIndex = alignmentIndices[a];
+    CmpAlignment &alignment = cmpFile.alnInfo.alignments[alignmentIndex];
+    int refStart   = alignment.GetRefStart();
+    int holeNumber = alignment.GetHoleNumber();
+    int movieId    = alignment.GetMovieId();
+    int refStrand  = alignment.GetRCRefStrand();
+
+    if (opts.printMSA) {
+      DecodedAlignment &decoded = cache[alignmentIndex];
+      if (decoded.isDecoded == false) {
+        DecodeAlignment(alignment, opts.scale, decoded);
+      }
+      ByteAlignment &byteAlignment = decoded.byteAlignment;
+
+      int readPos;
+      if (FindPosition(decoded.refPosToAlnIndex, centerPos - refStart, readPos)) {
+        string alnStr;
+        string alnPadding;
+        int alnBeginIndex = 0, alnEndIndex = 0;
+        SetAlignString(byteAlignment, decoded.refPositions, readPos, width, alnStr, alnBeginIndex, alnEndIndex, alnPadding);
+
+        MakeMismatchesLowerCase(refStr, alnStr);
+        if (opts.miscallView) {
+          MakeMatchesDot(refStr, alnStr);
+        }
+        if (!opts.insertionsOnly) {
+          out << opts.alnStrMargin << alnStr << " " << refStrand << " " << holeNumber << " " << movieId << endl;
+        }
+        InsertedStringList insertions;
+        if (!opts.hideInsertions or opts.printProfile) {
+          StoreInsertedStrings(byteAlignment, decoded.refPositions, decoded.queryPositions,
+                               insertions, alnBeginIndex, alnEndIndex);
+
+          if (opts.showInsertionQV) {
+            string insQVStr;
+            CopyFieldString(byteAlignment, decoded.insQVChars, alnBeginIndex, alnEndIndex, insQVStr);
+            out << opts.insQVMargin << alnPadding << insQVStr << endl;
+          }
+          if (opts.showDeletionQV) {
+            string delQVStr;
+            CopyFieldString(byteAlignment, decoded.delQVChars, alnBeginIndex, alnEndIndex, delQVStr);
+            out << opts.delQVMargin << alnPadding << delQVStr << endl;
+          }
+          if (opts.showSubstitutionQV) {
+            string subQVStr;
+            CopyFieldString(byteAlignment, decoded.subQVChars, alnBeginIndex, alnEndIndex, subQVStr);
+            out << opts.subQVMargin << alnPadding << subQVStr << endl;
+          }
+          if (opts.showMergeQV) {
+            string mergeQVStr;
+            CopyFieldString(byteAlignment, decoded.mergeQVChars, alnBeginIndex, alnEndIndex, mergeQVStr);
+            out << opts.mergeQVMargin << alnPadding << mergeQVStr << endl;
+          }
+          if (opts.showInsertionQV) {
+            StoreInsertionQVs(insertions, decoded.insQVChars);
+          }
+          if (!opts.hideInsertions) {
+            PrintInsertions(insertions, centerPos - width, 
+                            refStart, refStr.size(), opts.insMargin, opts.insQVMargin, opts.showInsertionQV, out);
+          }
+        }
+        if (opts.printProfile) {
+          profile.StoreProfile(alnStr, centerPos - width, refStart, insertions);
+        }
+      }
+    }
+    if (opts.printReads) {
+      out << "alignment index: " << alignmentIndex << " has hole number " << holeNumber << " and movie " << movieId 
+          << " with reader " << alignmentReaderIndex[alignmentIndex] << " zmw id " << holeNumber << endl;
+    }
+  }
+  if (opts.printProfile) {
+    profile.Print(opts.alnStrMargin.size(), out);
+  }
+
+  //
+  // Drop the alignments that do not cover this position.  When
+  // positions are printed in increasing order these will not be
+  // needed again.
+  //
+  DecodedAlignmentCache::iterator cacheIt = cache.begin();
+  while (cacheIt != cache.end()) {
+    if (binary_search(alignmentIndices.begin(), alignmentIndices.end(), cacheIt->first) == false) {
+      cache.erase(cacheIt++);
+    }
+    else {
+      ++cacheIt;
+    }
+  }
+}
+
+class PrintPositionsThreadData {
+ public:
+  vector<int>          *positions;
+  vector<vector<int> > *alignmentsByPosition;
+  vector<string>       *positionOutput;
+  int batchBegin, begin, end;
+  CmpFile              *cmpFile;
+  FASTASequence        *genome;
+  vector<int>          *alignmentReaderIndex;
+  MSAPrintOptions      *opts;
+};
+
+//
+// Order indices by the value they index.
+//
+class IndexValueLessThan {
+ public:
+  vector<int> *values;
+  IndexValueLessThan(vector<int> *_values) : values(_values) {}
+  bool operator()(int a, int b) const {
+    return (*values)[a] < (*values)[b];
+  }
+};
+
+//
+// Print a contiguous run of positions to their own output strings.
+// The run is visited in order of reference position so that
+// neighboring positions share decoded alignments even when positions
+// were not given in order.
+//
+void* PrintPositions(void *data) {
+  PrintPositionsThreadData *threadData = (PrintPositionsThreadData*) data;
+  DecodedAlignmentCache cache;
+  vector<int> positionOrder;
+  int p;
+  for (p = threadData->begin; p < threadData->end; p++) {
+    positionOrder.push_back(p);
+  }
+  sort(positionOrder.begin(), positionOrder.end(), IndexValueLessThan(threadData->positions));
+  int i;
+  for (i = 0; i < positionOrder.size(); i++) {
+    p = positionOrder[i];
+    stringstream positionOut;
+    PrintPosition((*threadData->positions)[p], (*threadData->alignmentsByPosition)[p], 
+                  *threadData->cmpFile, *threadData->genome, *threadData->alignmentReaderIndex,
+                  *threadData->opts, cache, positionOut);
+    (*threadData->positionOutput)[p - threadData->batchBegin] = positionOut.str();
+  }
+  return NULL;
+}
+
+//
+// Find the alignments covering each position by sweeping positions
+// and alignments in order of reference coordinate while keeping the
+// set of alignments that are open at the current position.  This
+// replaces a per-genome-position table of alignment indices.
+//
+void StoreAlignmentsByPosition(CmpFile &cmpFile, vector<int> &positions, vector<vector<int> > &alignmentsByPosition) {
+  int nAlignments = cmpFile.alnInfo.alignments.size();
+  vector<int> refStarts(nAlignments), refEnds(nAlignments);
+  vector<int> alignmentOrder(nAlignments), positionOrder(positions.size());
+  int i;
+  for (i = 0; i < nAlignments; i++) { 
+    refStarts[i] = cmpFile.alnInfo.alignments[i].GetRefStart();
+    refEnds[i]   = cmpFile.alnInfo.alignments[i].GetRefEnd();
+    alignmentOrder[i] = i; 
+  }
+  for (i = 0; i < positions.size(); i++) { positionOrder[i] = i; }
+  sort(alignmentOrder.begin(), alignmentOrder.end(), IndexValueLessThan(&refStarts));
+  sort(positionOrder.begin(), positionOrder.end(), IndexValueLessThan(&positions));
+
+  alignmentsByPosition.resize(positions.size());
+  vector<int> activeAlignments;
+  int nextAlignment = 0;
+  int p;
+  for (p = 0; p < positionOrder.size(); p++) {
+    int pos = positions[positionOrder[p]];
+    while (nextAlignment < nAlignments and refStarts[alignmentOrder[nextAlignment]] <= pos) {
+      activeAlignments.push_back(alignmentOrder[nextAlignment]);
+      nextAlignment++;
+    }
+    int a, nActive = 0;
+    for (a = 0; a < activeAlignments.size(); a++) {
+      if (refEnds[activeAlignments[a]] > pos) {
+        activeAlignments[nActive] = activeAlignments[a];
+        nActive++;
+      }
+    }
+    activeAlignments.resize(nActive);
+    alignmentsByPosition[positionOrder[p]] = activeAlignments;
+    sort(alignmentsByPosition[positionOrder[p]].begin(), alignmentsByPosition[positionOrder[p]].end());
+  }
+}
+
+class ReadRequest {
+ public:
+  int readerIndex;
+  int holeNumber;
+  int movieId;
+  bool operator<(const ReadRequest &rhs) const {
+    if (readerIndex != rhs.readerIndex) {
+      return readerIndex < rhs.readerIndex;
+    }
+    return holeNumber < rhs.holeNumber;
+  }
+};
+
 
 int main(int argc, char* argv[]) {
   CommandLineParser clp;
@@ -308,6 +604,7 @@ int main(int argc, char* argv[]) {
   bool printProfile   = false;
   int  scale = 5;
   int  marginSize = 5;
+  int  nProc = 1;
   string alnStrMargin, insMargin, delQVMargin, subQVMargin, insQVMargin, mergeQVMargin;
   stringstream verboseHelpStream, helpStream;
   verboseHelpStream << "printmsa is a utility to either view the msa centered at a position" << endl
@@ -333,6 +630,7 @@ int main(int argc, char* argv[]) {
   clp.RegisterFlagOption("miscallView",    &miscallView, "Show matches as '.'");
   clp.RegisterStringOption("readsFile",    &readsFileName, "Input reads file or fofn");
   clp.RegisterStringOption("baseFile",     &basH5OutFileName, "Print reads to file.");
+  clp.RegisterIntOption("nproc",           &nProc, "Number of threads to print positions with.", CommandLineParser::PositiveInteger);
 
   clp.ParseCommandLine(argc, argv);
   FormLabelMargin(marginSize, ' ', alnStrMargin);
@@ -341,7 +639,6 @@ int main(int argc, char* argv[]) {
   FormLabelMargin(marginSize, 'd', delQVMargin);
   FormLabelMargin(marginSize, 's', subQVMargin);
   FormLabelMargin(marginSize, 'm', mergeQVMargin);
-  vector<vector<int> > readsByPosition;
   
   vector<HDFBasReader > readers;
   vector<HDFRegionTableReader> regionTableReaders;
@@ -352,8 +649,6 @@ int main(int argc, char* argv[]) {
   reader.Initialize(genomeFileName);
   reader.GetNext(genome);
 
-  readsByPosition.resize(genome.length);
-
   if (posFileName != "") {
     ifstream posIn;
     CrucialOpen(posFileName, posIn, std::ios::in);
@@ -437,209 +732,143 @@ int main(int argc, char* argv[]) {
 	cmpReader.Read(cmpFile);
 
   cout << "Building alignment table." << endl;
-  int alignmentIndex;
-  for (alignmentIndex = 0; alignmentIndex < cmpFile.alnInfo.alignments.size(); alignmentIndex++) {
-    int refBegin = cmpFile.alnInfo.alignments[alignmentIndex].GetRefStart();
-    int refEnd   = cmpFile.alnInfo.alignments[alignmentIndex].GetRefEnd();
-
-    int genomePos;
-    int p;
-    for (p = 0; p < positions.size(); p++) {
-      if (refBegin <= positions[p] and refEnd > positions[p]) {
-        for (genomePos = refBegin; genomePos < refEnd; genomePos++) {
-          readsByPosition[genomePos].push_back(alignmentIndex);
-        }
-        break;
-      }
-    }
-  }
+  vector<vector<int> > alignmentsByPosition;
+  StoreAlignmentsByPosition(cmpFile, positions, alignmentsByPosition);
+
+  MSAPrintOptions opts;
+  opts.width              = width;
+  opts.scale              = scale;
+  opts.printMSA           = printMSA;
+  opts.showDeletionQV     = showDeletionQV;
+  opts.showInsertionQV    = showInsertionQV;
+  opts.showSubstitutionQV = showSubstitutionQV;
+  opts.showMergeQV        = showMergeQV;
+  opts.insertionsOnly     = insertionsOnly;
+  opts.hideInsertions     = hideInsertions;
+  opts.miscallView        = miscallView;
+  opts.printProfile       = printProfile;
+  opts.printReads         = (readsFileName != "");
+  opts.alnStrMargin       = alnStrMargin;
+  opts.insMargin          = insMargin;
+  opts.delQVMargin        = delQVMargin;
+  opts.subQVMargin        = subQVMargin;
+  opts.insQVMargin        = insQVMargin;
+  opts.mergeQVMargin      = mergeQVMargin;
 
+  //
+  // Positions are printed in batches so that the output held in
+  // memory is bounded.  Each thread prints a contiguous run of the
+  // batch, and the output is written in the original position order.
+  //
+  const int positionsPerThread = 256;
+  int batchSize = positionsPerThread * nProc;
+  vector<int> alignmentReaderIndex(cmpFile.alnInfo.alignments.size(), -1);
+  vector<string> positionOutput;
+  vector<PrintPositionsThreadData> threadData(nProc);
+  vector<pthread_t> threads(nProc);
   SMRTSequence read;
 
-  int p;
-  for (p = 0; p < positions.size(); p++) {
-    int a;
-    int centerPos = positions[p];
-    cout << "position " << centerPos << endl;
-    string refStr;
-    if (printMSA) {
-      SetRefString(genome, centerPos, width, refStr);
-    }
-    cout << alnStrMargin << refStr << endl;
-    Profile profile(width*2+1);
-    for (a = 0; a < readsByPosition[positions[p]].size(); a++) {
-      alignmentIndex = readsByPosition[positions[p]][a];
-      int readStart, readEnd, refStart, refEnd;
-      readStart = cmpFile.alnInfo.alignments[alignmentIndex].GetQueryStart();
-      readEnd   = cmpFile.alnInfo.alignments[alignmentIndex].GetQueryEnd();
-      refStart  = cmpFile.alnInfo.alignments[alignmentIndex].GetRefStart();
-      refEnd    = cmpFile.alnInfo.alignments[alignmentIndex].GetRefEnd();
-      int holeNumber = cmpFile.alnInfo.alignments[alignmentIndex].GetHoleNumber();
-      int movieId    = cmpFile.alnInfo.alignments[alignmentIndex].GetMovieId();
-			int refGroupId = cmpFile.alnInfo.alignments[alignmentIndex].GetRefGroupId();
-			int refGroupIndex = cmpReader.refGroupIdToArrayIndex[refGroupId];
-            int alnGroupId = cmpFile.alnInfo.alignments[alignmentIndex].GetAlnGroupId();
-            string readGroupName = cmpReader.alnGroupIdToReadGroupName[alnGroupId];
-            int readGroupIndex   = cmpReader.refAlignGroups[refGroupIndex]->experimentNameToIndex[readGroupName];
-      int refStrand      = cmpFile.alnInfo.alignments[alignmentIndex].GetRCRefStrand();
-
-
-      if (printMSA) {
-			//
-			// Read the alignment string.  All alignments 
-			//
-        int offsetBegin = cmpFile.alnInfo.alignments[alignmentIndex].GetOffsetBegin();
-        int offsetEnd   = cmpFile.alnInfo.alignments[alignmentIndex].GetOffsetEnd();
-		
-        int alignedSequenceLength = offsetEnd - offsetBegin;
-        string   alignedSequence;
-        ByteAlignment byteAlignment, byteAlignmentRC;
-        vector<char> insQVChars, delQVChars, subQVChars, mergeQVChars;
-
-        if (alignedSequenceLength >= 0) {
-          alignedSequence.resize(alignedSequenceLength);
-          byteAlignment.resize(alignedSequenceLength);
-        }
-        byteAlignment = cmpFile.alnInfo.alignments[alignmentIndex].alignmentArray;
-
-        CondenseCharacterVector(cmpFile.alnInfo.alignments[alignmentIndex].fields["InsertionQV"],    insQVChars, scale);
-        CondenseCharacterVector(cmpFile.alnInfo.alignments[alignmentIndex].fields["DeletionQV"],     delQVChars, scale);
-        CondenseCharacterVector(cmpFile.alnInfo.alignments[alignmentIndex].fields["SubstitutionQV"], subQVChars, scale);
-        CondenseCharacterVector(cmpFile.alnInfo.alignments[alignmentIndex].fields["MergeQV"], mergeQVChars, scale);
-
-        if (refStrand == 1) {
-          byteAlignmentRC.resize(byteAlignment.size());
-          MakeReverseComplementByteAlignment(&byteAlignment[0], byteAlignment.size(), &byteAlignmentRC[0]);
-          byteAlignment = byteAlignmentRC;
-          reverse(insQVChars.begin(), insQVChars.end());
-          reverse(delQVChars.begin(), delQVChars.end());
-          reverse(subQVChars.begin(), subQVChars.end());
-          reverse(mergeQVChars.begin(), mergeQVChars.end());
-        }
+  int batchBegin, batchEnd;
+  for (batchBegin = 0; batchBegin < positions.size(); batchBegin = batchEnd) {
+    batchEnd = min((int) positions.size(), batchBegin + batchSize);
+    int p, a;
 
-        string queryAlnString, refAlnString;
-        queryAlnString.resize(byteAlignment.size());
-        refAlnString.resize(byteAlignment.size());
-        ByteAlignmentToRefString(&byteAlignment[0], byteAlignment.size(), &refAlnString[0]);
-        ByteAlignmentToQueryString(&byteAlignment[0], byteAlignment.size(), &queryAlnString[0]); 
-        
-        vector<int> refPositions, queryPositions;
-        ComputeQueryPositions(byteAlignment, queryPositions);
-        ComputeRefPositions(byteAlignment,   refPositions);
-
-        //
-        // Look backwards to see when the alignment should begin.
-        //
-        int start = refStart;
-        int nb = 0;
-
-        
-        int readPos;
-        int readSubstringStart = 0, readSubstringEnd = 0;
-        if (FindPosition(refPositions, centerPos - refStart, readPos)) {
-
-          string alnStr;
-          string alnPadding;
-          int alnBeginIndex = 0, alnEndIndex = 0;
-          SetAlignString(byteAlignment, refPositions, readPos, width, alnStr, alnBeginIndex, alnEndIndex, alnPadding);
-          
-
-          MakeMismatchesLowerCase(refStr, alnStr);
-          if (miscallView) {
-            MakeMatchesDot(refStr, alnStr);
-          }
-          if (!insertionsOnly) {
-            cout << alnStrMargin << alnStr << " " << refStrand << " " << holeNumber << " " << movieId << endl;
-          }
-          InsertedStringList insertions, insertionQVs;
-          if (!hideInsertions or printProfile) {
-            StoreInsertedStrings(byteAlignment, refPositions, queryPositions,
-                                 insertions, alnBeginIndex, alnEndIndex);
-
-            if (showInsertionQV) {
-              string insQVStr;
-              CopyFieldString(byteAlignment, insQVChars, alnBeginIndex, alnEndIndex, insQVStr);
-              cout << insQVMargin << alnPadding << insQVStr << endl;
-            }
-
-            if (showDeletionQV) {
-              string delQVStr;
-              CopyFieldString(byteAlignment, delQVChars, alnBeginIndex, alnEndIndex, delQVStr);
-              cout << delQVMargin << alnPadding << delQVStr << endl;
-            }
-            if (showSubstitutionQV) {
-              string subQVStr;
-              CopyFieldString(byteAlignment, subQVChars, alnBeginIndex, alnEndIndex, subQVStr);
-              cout << subQVMargin << alnPadding << subQVStr << endl;
-            }
-            if (showMergeQV) {
-              string mergeQVStr;
-              CopyFieldString(byteAlignment, mergeQVChars, alnBeginIndex, alnEndIndex, mergeQVStr);
-              cout << mergeQVMargin << alnPadding << mergeQVStr << endl;
-            }
-
-            if (showInsertionQV) {
-              StoreInsertionQVs(insertions, insQVChars);
+    //
+    // Resolve the reader of every alignment that will be printed
+    // before starting the threads so that missing movies are reported
+    // from here.
+    //
+    vector<ReadRequest> readRequests;
+    if (readsFileName != "") {
+      for (p = batchBegin; p < batchEnd; p++) {
+        for (a = 0; a < alignmentsByPosition[p].size(); a++) {
+          int alignmentIndex = alignmentsByPosition[p][a];
+          int movieId        = cmpFile.alnInfo.alignments[alignmentIndex].GetMovieId();
+          if (alignmentReaderIndex[alignmentIndex] == -1) {
+            MovieNameToArrayIndex::iterator movieNameIt;
+            string movieName;
+            if (cmpFile.movieInfo.FindMovie(movieId, movieName) == 0) {
+              cout << "ERROR in alignment string.  The movie index: " << movieId << " was specified in alignment "
+                   << alignmentIndex << " but does not exist in the movie info dataset." << endl;
+              exit(1);
             }
-
-            if (!hideInsertions) {
-              PrintInsertions(insertions, centerPos - width, 
-                              refStart, refStr.size(), insMargin, insQVMargin, showInsertionQV, cout);
+            movieNameIt = movieNameToReaderIndex.find(movieName);
+            if (movieNameIt == movieNameToReaderIndex.end()) {
+              cout << "Error, an alignment from movie " << movieName << " was specified, but no movie with " << endl
+                   << " this name exists in " << readsFileName << endl;
+              exit(1);
             }
+            alignmentReaderIndex[alignmentIndex] = movieNameIt->second;
           }
-          if (printProfile) {
-            profile.StoreProfile(alnStr, centerPos - width, refStart, insertions);
+          ReadRequest request;
+          request.readerIndex = alignmentReaderIndex[alignmentIndex];
+          request.holeNumber  = cmpFile.alnInfo.alignments[alignmentIndex].GetHoleNumber();
+          request.movieId     = movieId;
+          if (printedRegionsByHoleNumber[request.readerIndex].find(request.holeNumber) ==
+              printedRegionsByHoleNumber[request.readerIndex].end()) {
+            printedRegionsByHoleNumber[request.readerIndex].insert(request.holeNumber);
+            readRequests.push_back(request);
           }
         }
       }
+    }
 
-      if (readsFileName != "") {
-        // 
-        // Look to see if the reads will be printed.
-        //
-        MovieNameToArrayIndex::iterator movieNameIt;
-        string movieName;
-        if (cmpFile.movieInfo.FindMovie(movieId, movieName) == 0) {
-          cout << "ERROR in alignment string.  The movie index: " << movieId << " was specified in alignment "
-               << alignmentIndex << " but does not exist in the movie info dataset." << endl;
-          exit(1);
-        }
-        
-        movieNameIt = movieNameToReaderIndex.find(movieName);
-        if (movieNameIt == movieNameToReaderIndex.end()) {
-          cout << "Error, an alignment from movie " << movieName << " was specified, but no movie with " << endl
-               << " this name exists in " << readsFileName << endl;
-          exit(1);
-        }
-        
-        int readerIndex = movieNameIt->second;
-
-        readers[readerIndex].GetReadAt(holeNumber, read);
-        read.zmwData.holeNumber = holeNumber;
-        
-        cout << "alignment index: " << alignmentIndex << " has hole number " << holeNumber << " and movie " << movieId << " with reader " << readerIndex << " zmw id " <<
-          read.zmwData.holeNumber << endl;
-        if (printedRegionsByHoleNumber[readerIndex].find(read.zmwData.holeNumber) ==
-            printedRegionsByHoleNumber[readerIndex].end()) {
-          int uniqueHoleNumber = holeNumber + movieId*100000;
-          read.zmwData.holeNumber = uniqueHoleNumber;
-          basWriter.Write(read);
-          read.zmwData.holeNumber = holeNumber;
-          int regionLowIndex, regionHighIndex, regionIndex;
-          FindRegionIndices(read, &regionTables[readerIndex], regionLowIndex, regionHighIndex);
-          for (regionIndex = regionLowIndex; regionIndex < regionHighIndex; regionIndex++) {
-            RegionAnnotation region;
-            region = regionTables[readerIndex].table[regionIndex];
-            region.row[0] = uniqueHoleNumber;
-            cout << "Writing row for " << region.row[0] << endl;
-            regionWriter.Write(region);
-          }
-          printedRegionsByHoleNumber[readerIndex].insert(read.zmwData.holeNumber);
-        }
+    positionOutput.resize(batchEnd - batchBegin);
+    int nThreads = min(nProc, batchEnd - batchBegin);
+    int positionsPerBatchThread = (batchEnd - batchBegin + nThreads - 1) / nThreads;
+    int t;
+    for (t = 0; t < nThreads; t++) {
+      threadData[t].positions            = &positions;
+      threadData[t].alignmentsByPosition = &alignmentsByPosition;
+      threadData[t].positionOutput       = &positionOutput;
+      threadData[t].batchBegin           = batchBegin;
+      threadData[t].begin                = min(batchEnd, batchBegin + positionsPerBatchThread * t);
+      threadData[t].end                  = min(batchEnd, batchBegin + positionsPerBatchThread * (t + 1));
+      threadData[t].cmpFile              = &cmpFile;
+      threadData[t].genome               = &genome;
+      threadData[t].alignmentReaderIndex = &alignmentReaderIndex;
+      threadData[t].opts                 = &opts;
+    }
+    if (nThreads == 1) {
+      PrintPositions(&threadData[0]);
+    }
+    else {
+      for (t = 0; t < nThreads; t++) {
+        pthread_create(&threads[t], NULL, PrintPositions, &threadData[t]);
       }
+      for (t = 0; t < nThreads; t++) {
+        pthread_join(threads[t], NULL);
+      }
+    }
+    for (p = 0; p < positionOutput.size(); p++) {
+      cout << positionOutput[p];
+      positionOutput[p] = "";
     }
-    if (printProfile) {
-      profile.Print(alnStrMargin.size());
+
+    //
+    // Fetch the reads of this batch one movie at a time, in order of
+    // hole number, rather than in the order they are printed.
+    //
+    sort(readRequests.begin(), readRequests.end());
+    int r;
+    for (r = 0; r < readRequests.size(); r++) {
+      int readerIndex = readRequests[r].readerIndex;
+      int holeNumber  = readRequests[r].holeNumber;
+      readers[readerIndex].GetReadAt(holeNumber, read);
+      read.zmwData.holeNumber = holeNumber;
+      int uniqueHoleNumber = holeNumber + readRequests[r].movieId*100000;
+      read.zmwData.holeNumber = uniqueHoleNumber;
+      basWriter.Write(read);
+      read.zmwData.holeNumber = holeNumber;
+      int regionLowIndex, regionHighIndex, regionIndex;
+      FindRegionIndices(read, &regionTables[readerIndex], regionLowIndex, regionHighIndex);
+      for (regionIndex = regionLowIndex; regionIndex < regionHighIndex; regionIndex++) {
+        RegionAnnotation region;
+        region = regionTables[readerIndex].table[regionIndex];
+        region.row[0] = uniqueHoleNumber;
+        cout << "Writing row for " << region.row[0] << endl;
+        regionWriter.Write(region);
+      }
     }
   }
   
@@ -49,20 +49,20 @@ public:
     }
   } 
 
-  void PrintRow(int rowIndex) {
+  void PrintRow(int rowIndex, ostream &out=cout) {
     int i;
     if (profileMatrix.GetNCols() == 0) {
       return;
     }
     for (i = 0; i + 1 < profileMatrix.GetNCols(); i++) {
-      cout.width(3);
-      cout << profileMatrix[rowIndex][i]<< ",";
+      out.width(3);
+      out << profileMatrix[rowIndex][i]<< ",";
     }
-    cout.width(3);
-    cout << profileMatrix[rowIndex][i] << endl;
+    out.width(3);
+    out << profileMatrix[rowIndex][i] << endl;
   }
 
-  void Print(int marginWidth) {
+  void Print(int marginWidth, ostream &out=cout) {
     string padding;
     if (marginWidth < 2) {
       cout << "margin width must be greater than 2" << endl;
@@ -70,24 +70,24 @@ public:
     }
     padding.resize(marginWidth - 2);
     fill(padding.begin(), padding.end(), ' ');
-    cout << " A" << padding;
-    PrintRow(0);
-    cout << " C" << padding;
-    PrintRow(1);
-    cout << " G" << padding;
-    PrintRow(2);
-    cout << " T" << padding;
-    PrintRow(3);
-    cout << " D" << padding;
-    PrintRow(4);
-    cout << "IA" << padding;
-    PrintRow(5);
-    cout << "IC" << padding;
-    PrintRow(6);
-    cout << "IG" << padding;
-    PrintRow(7);
-    cout << "IT" << padding;
-    PrintRow(8);
+    out << " A" << padding;
+    PrintRow(0, out);
+    out << " C" << padding;
+    PrintRow(1, out);
+    out << " G" << padding;
+    PrintRow(2, out);
+    out << " T" << padding;
+    PrintRow(3, out);
+    out << " D" << padding;
+    PrintRow(4, out);
+    out << "IA" << padding;
+    PrintRow(5, out);
+    out << "IC" << padding;
+    PrintRow(6, out);
+    out << "IG" << padding;
+    PrintRow(7, out);
+    out << "IT" << padding;
+    PrintRow(8, out);
   }
 };
 
@@ -70,12 +70,19 @@ int main(int argc, char* argv[]) {
 	}
 
 	if (doCondense) {
+		//
+		// Condense every sequence in the file, so that a multi-contig
+		// reference may be indexed for homopolymer compressed seeding
+		// (blasr -hpc).
+		//
 		FASTASequence fastaRead;
-		seq.CondenseHomopolymers();
-		fastaRead = seq;
 		ofstream outFile;
 		CrucialOpen(outFileName, outFile);
-		fastaRead.PrintSeq(outFile);
+		do {
+			seq.CondenseHomopolymers();
+			fastaRead = seq;
+			fastaRead.PrintSeq(outFile);
+		} while (!doBuildIndex and reader.GetNext(seq));
 	}
 
 	if (do4BitCompression) {
@@ -1,54 +1,76 @@
 #include <string>
-#include <string.h>
-#include <algorithm>
+#include <vector>
+#include <stdlib.h>
 #include "../common/FASTAReader.h"
 #include "../common/FASTASequence.h"
+#include "../common/tuples/TupleMetrics.h"
+#include "../common/datastructures/tuplelists/PartitionedTupleCounter.h"
 
-class KCompareFunctor {
-	
+//
+// Count the k-mers that occur exactly once in each sorted partition.
+//
+class UniqueKmerCounter {
 public:
-	Nucleotide *seq;
-	int k;
-	int operator()(unsigned int a, unsigned int b) {
-		return strncmp((const char*) &seq[a], (const char*) &seq[b], k) < 0;
+	vector<unsigned int> partitionUnique;
+	unsigned int nUnique;
+
+	UniqueKmerCounter(int nPartitions) {
+		partitionUnique.resize(nPartitions, 0);
+		nUnique = 0;
+	}
+
+	void ProcessPartition(int p, vector<TupleRecord> &kmers) {
+		unsigned int i, j;
+		for (i = 0; i < kmers.size(); i = j) {
+			j = i + 1;
+			while (j < kmers.size() and kmers[i].tuple == kmers[j].tuple) j++;
+			if (j == i + 1) {
+				partitionUnique[p]++;
+			}
+		}
+	}
+
+	void FinishPartition(int p) {
+		nUnique += partitionUnique[p];
 	}
 };
 
 
 int main(int argc, char* argv[]) {
 	if (argc < 3) {
-		cout << "usage: countKmer in.fa k" << endl;
+		cout << "usage: countKmer in.fa k [nproc]" << endl;
+		cout << "  Prints the number of k-mers that occur once, and the number of k-mers, " << endl
+		     << "  counting k-mers of ACGT in all sequences of in.fa." << endl;
 		exit(1);
 	}
 	string sequenceFileName = argv[1];
 	int k = atoi(argv[2]);
+	int nProc = 1;
+	if (argc > 3) {
+		nProc = atoi(argv[3]);
+	}
+	if (k < 1 or k > 32) {
+		cout << "ERROR. k must be between 1 and 32." << endl;
+		exit(1);
+	}
+
+	TupleMetrics tm;
+	tm.Initialize(k);
+	PartitionedTupleCounter<TupleRecord> counter;
+	counter.Initialize(tm, true, nProc, 8, 1 << 26);
 
-	unsigned int *indexArray;
-	
 	FASTAReader reader;
 	reader.Init(sequenceFileName);
 	FASTASequence seq;
-	reader.GetNext(seq);
-	seq.ToUpper();
-	unsigned int nKmers = seq.length - k + 1;
-	indexArray = new unsigned int[nKmers];
-	unsigned int i;
-	for (i = 0; i < nKmers; i++ ) {
-		indexArray[i] = i;
-	}
-	KCompareFunctor comp;
-	comp.k = k;
-	comp.seq = seq.seq;
-	std::sort(indexArray, indexArray + nKmers, comp);
-	unsigned int nUnique = 0;
-	for (i = 0; i < nKmers-1; ) {
-	  int j = i + 1;
-	  while (j < nKmers and strncmp((const char*) &seq.seq[indexArray[i]], (const char*) &seq.seq[indexArray[j]], k) == 0) j++;
-	  if (j == i + 1) {
-			nUnique++;
-		}
-	  i = j;
+	while (reader.GetNext(seq)) {
+		seq.ToUpper();
+		counter.AddSequence(seq);
+		seq.Free();
 	}
-	cout << nUnique << " " << nKmers << endl;
+	counter.Flush();
+	unsigned int nKmers = counter.nRecords;
+	UniqueKmerCounter uniqueCounter(counter.nPartitions);
+	counter.ProcessPartitions(uniqueCounter);
+	cout << uniqueCounter.nUnique << " " << nKmers << endl;
 	return 0;
 }
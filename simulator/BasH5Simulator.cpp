@@ -11,10 +11,15 @@
 #include "statistics/statutils.h"
 #include "simulator/LengthHistogram.h"
 #include "simulator/OutputSampleListSet.h"
+#include "simulator/PackedOutputSampleSet.h"
+#include "statistics/RandomStream.h"
 #include "data/hdf/HDFBasWriter.h"
 #include "data/hdf/HDFRegionTableWriter.h"
 #include "Enumerations.h"
 #include "datastructures/metagenome/TitleTable.h"
+#include <map>
+#include <pthread.h>
+#include <time.h>
 using namespace std;
 void PrintUsage() {
 
@@ -55,12 +60,361 @@ void PrintUsage() {
          << "  -printPercentRepeat" << endl
          << "            Add to the title table a field that has the percent " << endl
          << "            repeat content of the read shown by lower case in " << endl
-         << "            the reference." << endl << endl;
+         << "            the reference." << endl << endl
+         << "  -nproc N (1)" << endl
+         << "            Simulate reads on N threads.  The reads do not depend on N." << endl << endl
+         << "  -seed S" << endl
+         << "            Seed the random number generator with S rather than the time, so" << endl
+         << "            that the same reads are simulated on every run." << endl << endl
+         << "  -writeBufferSize N (4194304)" << endl
+         << "            Buffer N values of each bas.h5 dataset between writes." << endl << endl;
     
 }
 
 
 
+//
+// Reads are simulated in batches.  Batch b is simulated from random
+// stream b of the seed (or from the b'th group of source reads), so
+// the reads do not depend on how many threads simulate them nor on
+// which thread simulates which batch.  A batch holds its reads in
+// flat arrays: read i is [readStart[i], readStart[i+1]).
+//
+class SimulatedReadBatch {
+ public:
+  long index;
+  vector<Nucleotide> bases;
+  vector<unsigned char> qualityValue, deletionQV, insertionQV, substitutionQV, deletionTag, substitutionTag;
+  vector<HalfWord> preBaseFrames, widthInFrames;
+  vector<UInt> readStart;
+  vector<int> sampledLength;
+  vector<DNALength> seqIndex, seqPos;
+  vector<float> repeatFraction;
+
+  SimulatedReadBatch() {
+    readStart.push_back(0);
+  }
+
+  UInt NumReads() {
+    return readStart.size() - 1;
+  }
+
+  UInt ReadLength(UInt r) {
+    return readStart[r+1] - readStart[r];
+  }
+
+  //
+  // Drop everything after the last complete read.
+  //
+  void Truncate() {
+    UInt end = readStart[readStart.size() - 1];
+    bases.resize(end);
+    qualityValue.resize(end);
+    deletionQV.resize(end);
+    insertionQV.resize(end);
+    substitutionQV.resize(end);
+    deletionTag.resize(end);
+    substitutionTag.resize(end);
+    preBaseFrames.resize(end);
+    widthInFrames.resize(end);
+  }
+};
+
+class ReadSimulator {
+ public:
+  PackedOutputSampleSet outputModel;
+  LengthHistogram lengthHistogram;
+  bool useLengthModel;
+  int  fixedLength;
+  vector<FASTASequence> *reference;
+  vector<UInt> cumulativeLengths;
+  FASTAReader *sourceReader;
+  TitleTable *titleTable;
+  bool useTitleTable;
+  bool printPercentRepeat;
+  uint64_t seed;
+  int readsPerBatch;
+
+  //
+  // Shared state of the threads, guarded by queueLock.  Batches that
+  // are done wait in doneBatches until the writer takes them in order.
+  // Workers stay at most maxBatchesAhead batches ahead of the writer.
+  //
+  pthread_mutex_t queueLock;
+  pthread_cond_t  batchDone, writerAdvanced;
+  long nextBatch, nextBatchToWrite;
+  long maxBatchesAhead;
+  map<long, SimulatedReadBatch*> doneBatches;
+  bool sourceExhausted;
+  bool stopSimulating;
+
+  ReadSimulator() {
+    pthread_mutex_init(&queueLock, NULL);
+    pthread_cond_init(&batchDone, NULL);
+    pthread_cond_init(&writerAdvanced, NULL);
+    nextBatch = nextBatchToWrite = 0;
+    maxBatchesAhead = 4;
+    sourceExhausted = stopSimulating = false;
+    reference = NULL;
+    sourceReader = NULL;
+    titleTable = NULL;
+    useTitleTable = false;
+    printPercentRepeat = false;
+    readsPerBatch = 256;
+  }
+
+  ~ReadSimulator() {
+    map<long, SimulatedReadBatch*>::iterator batchIt;
+    for (batchIt = doneBatches.begin(); batchIt != doneBatches.end(); ++batchIt) {
+      delete batchIt->second;
+    }
+    pthread_mutex_destroy(&queueLock);
+    pthread_cond_destroy(&batchDone);
+    pthread_cond_destroy(&writerAdvanced);
+  }
+
+  //
+  // Simulate one read from the sample sequence by sampling an output
+  // for the context at each position.  Returns false if the read was
+  // not kept.
+  //
+  bool SimulateRead(Nucleotide *sampleSeq, DNALength sampleLength, int readLength,
+                    DNALength seqIndex, DNALength seqPos,
+                    RandomStream &randomStream, SimulatedReadBatch &batch) {
+    int contextLength = outputModel.keyLength;
+    int contextMiddle = contextLength / 2;
+    assert(sampleLength > contextMiddle + 1);
+    UInt readStart = batch.bases.size();
+    DNALength p;
+    bool containsN = false;
+    for (p = contextMiddle; p < sampleLength - contextMiddle - 1; p++) {
+      UInt key;
+      if (outputModel.PackKey(&sampleSeq[p-contextMiddle], key) == false) {
+        string refContext((const char*) &sampleSeq[p-contextMiddle], contextLength);
+        cout << "ERROR, " << refContext << " is not a sampled context." << endl;
+        int i;
+        for (i = 0; i < refContext.size(); i++) {
+          char c = toupper(refContext[i]);
+          if (c != 'A' and c != 'C' and c != 'G' and c != 'T') {
+            cout << "The nucleotide " << c << " is not supported." << endl;
+          }
+        }
+        exit(1);
+      }
+      const PackedOutputSample *sample = outputModel.SampleRandomSample(key, randomStream);
+      if (sample == NULL) {
+        string refContext((const char*) &sampleSeq[p-contextMiddle], contextLength);
+        cout << "ERROR, " << refContext << " is not a sampled context." << endl;
+        exit(1);
+      }
+      if (sample->type == OutputSample::Deletion) {
+        //
+        // There was a deletion.  Advance in reference, then output
+        // the base after the deletion.
+        //
+        p++;
+      }
+      //
+      // Add the sampled context, possibly multiple characters because of an insertion.
+      //
+      UInt i;
+      for (i = sample->first; i < sample->first + sample->length; i++) {
+        Nucleotide n = outputModel.nucleotides[i];
+        QualitySample &q = outputModel.qualities[i];
+        containsN |= (n == 'N' or n == 'n');
+        batch.bases.push_back(n);
+        batch.qualityValue.push_back(q.qv[0]);
+        batch.deletionQV.push_back(q.qv[1]);
+        batch.insertionQV.push_back(q.qv[2]);
+        batch.substitutionQV.push_back(q.qv[3]);
+        batch.deletionTag.push_back(q.tags[0]);
+        batch.substitutionTag.push_back(q.tags[1]);
+        batch.preBaseFrames.push_back(q.frameValues[1]);
+        batch.widthInFrames.push_back(q.frameValues[2]);
+      }
+    }
+    if (containsN) {
+      string outputString((const char*) &batch.bases[readStart], batch.bases.size() - readStart);
+      cout << "WARNING!  The sampled string " << endl << outputString << endl
+           << "should not contain N's, but it seems to.  This is being ignored "<<endl
+           << "for now so that simulation may continue, but this shouldn't happen"<<endl
+           << "and is really a bug." << endl;
+      batch.Truncate();
+      return false;
+    }
+    batch.readStart.push_back(batch.bases.size());
+    batch.sampledLength.push_back(readLength);
+    batch.seqIndex.push_back(seqIndex);
+    batch.seqPos.push_back(seqPos);
+    float repeatFraction = 0;
+    if (printPercentRepeat) {
+      DNALength i, nRepeat = 0;
+      for (i = 0; i < sampleLength; i++) {
+        if (tolower(sampleSeq[i]) == sampleSeq[i]) { nRepeat++; }
+      }
+      repeatFraction = nRepeat * 1.0 / sampleLength;
+    }
+    batch.repeatFraction.push_back(repeatFraction);
+    return true;
+  }
+
+  void SimulateFromGenome(SimulatedReadBatch &batch) {
+    RandomStream randomStream(seed, batch.index);
+    int r;
+    int keyLength = outputModel.keyLength;
+    for (r = 0; r < readsPerBatch; r++) {
+      int readLength = fixedLength;
+      if (useLengthModel) {
+        lengthHistogram.GetRandomLength(readLength, randomStream);
+      }
+      DNALength seqIndex, seqPos;
+      DNALength sampleLength = readLength + (keyLength - 1);
+      FindRandomPos(*reference, cumulativeLengths, seqIndex, seqPos, sampleLength, randomStream);
+      assert((*reference)[seqIndex].length >= sampleLength);
+      SimulateRead(&(*reference)[seqIndex].seq[seqPos], sampleLength, readLength, 
+                   seqIndex, seqPos, randomStream, batch);
+    }
+  }
+
+  void SimulateFromSourceReads(vector<FASTASequence> &sourceReads, SimulatedReadBatch &batch) {
+    RandomStream randomStream(seed, batch.index);
+    int keyLength = outputModel.keyLength;
+    int r;
+    for (r = 0; r < sourceReads.size(); r++) {
+      FASTASequence &sampleSeq = sourceReads[r];
+      if (sampleSeq.length < keyLength) {
+        continue;
+      }
+      int readLength;
+      if (useLengthModel) {
+        int tryNumber = 0;
+        readLength = 0;
+        int maxNTries = 1000;
+        int tryBuffer[5] = {-1,-1,-1,-1,-1};
+        while (tryNumber < maxNTries and readLength < keyLength) {
+          lengthHistogram.GetRandomLength(readLength, randomStream);
+          readLength = sampleSeq.length = min(sampleSeq.length, (unsigned int) readLength);
+          tryBuffer[tryNumber%5] = readLength;
+          tryNumber++;
+        }
+        if (tryNumber >= maxNTries) {
+          cout << "ERROR. Could not generate a read length greater than the " << keyLength << " requried " <<endl
+               << "minimum number of bases using the length model specified in the alchemy." <<endl
+               << "model.  Something is either wrong with the model or the context length is too large." <<endl;
+          cout << "The last few tries were: " << tryBuffer[0] << " " << tryBuffer[1] << " " << tryBuffer[2] << " " << tryBuffer[3] << " " << tryBuffer[4] << endl;
+          exit(1);
+        }
+      }
+      readLength = sampleSeq.length;
+      //
+      // Now attempt to parse the position from the fasta title.
+      //
+      DNALength seqIndex = 0, seqPos = 0;
+      vector<string> tokens;
+      Tokenize(sampleSeq.title, "|", tokens);
+      if (tokens.size() == 4) {
+        seqPos = atoi(tokens[2].c_str());
+        if (useTitleTable) {
+          int index;
+          titleTable->Lookup(tokens[1], index);
+          seqIndex = index;
+        }
+      }
+      SimulateRead(sampleSeq.seq, sampleSeq.length, readLength, seqIndex, seqPos, randomStream, batch);
+    }
+  }
+
+  //
+  // Take the next batch to simulate, and its source reads if reads
+  // are simulated from a file.  Returns false when there is nothing
+  // more to simulate.
+  //
+  bool TakeNextBatch(long &batchIndex, vector<FASTASequence> &sourceReads) {
+    pthread_mutex_lock(&queueLock);
+    while (stopSimulating == false and sourceExhausted == false and
+           nextBatch - nextBatchToWrite >= maxBatchesAhead) {
+      pthread_cond_wait(&writerAdvanced, &queueLock);
+    }
+    if (stopSimulating or sourceExhausted) {
+      pthread_mutex_unlock(&queueLock);
+      return false;
+    }
+    batchIndex = nextBatch++;
+    if (sourceReader != NULL) {
+      sourceReads.resize(readsPerBatch);
+      int r;
+      for (r = 0; r < readsPerBatch; r++) {
+        if (sourceReader->GetNext(sourceReads[r]) == false) {
+          sourceExhausted = true;
+          pthread_cond_broadcast(&batchDone);
+          break;
+        }
+      }
+      sourceReads.resize(r);
+    }
+    pthread_mutex_unlock(&queueLock);
+    return true;
+  }
+
+  void FinishBatch(SimulatedReadBatch *batch) {
+    pthread_mutex_lock(&queueLock);
+    doneBatches[batch->index] = batch;
+    pthread_cond_broadcast(&batchDone);
+    pthread_mutex_unlock(&queueLock);
+  }
+
+  //
+  // Called by the writer.  Returns the batches in order, or NULL
+  // once every batch of the source reads has been returned.
+  //
+  SimulatedReadBatch* GetNextBatch() {
+    SimulatedReadBatch *batch = NULL;
+    pthread_mutex_lock(&queueLock);
+    while (doneBatches.find(nextBatchToWrite) == doneBatches.end() and
+           (sourceExhausted == false or nextBatchToWrite < nextBatch)) {
+      pthread_cond_wait(&batchDone, &queueLock);
+    }
+    map<long, SimulatedReadBatch*>::iterator batchIt = doneBatches.find(nextBatchToWrite);
+    if (batchIt != doneBatches.end()) {
+      batch = batchIt->second;
+      doneBatches.erase(batchIt);
+      ++nextBatchToWrite;
+      pthread_cond_broadcast(&writerAdvanced);
+    }
+    pthread_mutex_unlock(&queueLock);
+    return batch;
+  }
+
+  void Stop() {
+    pthread_mutex_lock(&queueLock);
+    stopSimulating = true;
+    pthread_cond_broadcast(&writerAdvanced);
+    pthread_mutex_unlock(&queueLock);
+  }
+};
+
+void* SimulateReadBatches(void *simulatorPtr) {
+  ReadSimulator *simulator = (ReadSimulator*) simulatorPtr;
+  long batchIndex;
+  vector<FASTASequence> sourceReads;
+  while (simulator->TakeNextBatch(batchIndex, sourceReads)) {
+    SimulatedReadBatch *batch = new SimulatedReadBatch;
+    batch->index = batchIndex;
+    if (simulator->sourceReader != NULL) {
+      simulator->SimulateFromSourceReads(sourceReads, *batch);
+      int r;
+      for (r = 0; r < sourceReads.size(); r++) {
+        sourceReads[r].Free();
+      }
+    }
+    else {
+      simulator->SimulateFromGenome(*batch);
+    }
+    simulator->FinishBatch(batch);
+  }
+  return NULL;
+}
+
 int main(int argc, char* argv[]) {
 
 	string refGenomeFileName;
@@ -80,6 +434,10 @@ int main(int argc, char* argv[]) {
   bool useLengthModel = false;
   bool useFixedLength = false;
 	ofstream posMapFile;
+	int nProc = 1;
+	bool useSeed = false;
+	unsigned int seed = 1;
+	int writeBufferSize = 4194304;
 	if (argc < 2) {
 		PrintUsage();
 		exit(1);
@@ -137,6 +495,19 @@ int main(int argc, char* argv[]) {
 		else if (strcmp(argv[argi], "-titleTable") == 0) {
 			titleTableFileName = argv[++argi];
 		}
+		else if (strcmp(argv[argi], "-numBasesPerFile") == 0) {
+			numBasesPerFile = atoi(argv[++argi]);
+		}
+		else if (strcmp(argv[argi], "-nproc") == 0) {
+			nProc = atoi(argv[++argi]);
+		}
+		else if (strcmp(argv[argi], "-seed") == 0) {
+			seed = atoi(argv[++argi]);
+			useSeed = true;
+		}
+		else if (strcmp(argv[argi], "-writeBufferSize") == 0) {
+			writeBufferSize = atoi(argv[++argi]);
+		}
 		else {
 			PrintUsage();
 			cout << "ERROR, bad option: " << argv[argi]<< endl;
@@ -160,6 +531,17 @@ int main(int argc, char* argv[]) {
     exit(1);
   }
 
+  if (sourceReadsFileName == "" and numBasesPerFile == 0) {
+    cout << "ERROR! You must specify the number of bases per file (-numBasesPerFile) " << endl
+         << "when simulating reads from a genome." << endl;
+    exit(1);
+  }
+
+  if (nProc < 1 or writeBufferSize < 1) {
+    cout << "ERROR! -nproc and -writeBufferSize must be positive." << endl;
+    exit(1);
+  }
+
   if (fixedLength != 0 and refGenomeFileName == "") {
     cout << "ERROR! You must specify a genome file if using a fixed length." << endl;
     exit(1);
@@ -175,8 +557,9 @@ int main(int argc, char* argv[]) {
   OutputSampleListSet   outputModel(0);
   TitleTable titleTable;
 
-	if (doRandGenInit) {
-		InitializeRandomGeneratorWithTime();
+	if (useSeed == false and doRandGenInit) {
+		time_t t;
+		seed = (unsigned int) time(&t);
 	}
 	//
 	// Read models.
@@ -244,13 +627,40 @@ int main(int argc, char* argv[]) {
     seqReader.Init(sourceReadsFileName);
   }
 
-	ofstream readsFile;
+  //
+  // Set up the simulation threads.  They simulate batches of reads
+  // while this thread writes them out in order.
+  //
+  ReadSimulator simulator;
+  simulator.outputModel.Initialize(outputModel);
+  simulator.lengthHistogram = lengthHistogram;
+  simulator.useLengthModel  = useLengthModel;
+  simulator.fixedLength     = fixedLength;
+  simulator.printPercentRepeat = printPercentRepeat;
+  simulator.seed            = seed;
+  simulator.maxBatchesAhead = 2*nProc;
+  if (sourceReadsFileName != "") {
+    simulator.sourceReader  = &seqReader;
+    simulator.titleTable    = &titleTable;
+    simulator.useTitleTable = (titleTableFileName != "");
+  }
+  else {
+    simulator.reference = &reference;
+    ComputeCumulativeLengths(reference, simulator.cumulativeLengths);
+  }
+  vector<pthread_t> threads(nProc);
+  for (i = 0; i < nProc; i++) {
+    pthread_create(&threads[i], NULL, SimulateReadBatches, &simulator);
+  }
 
   //
   // Create and simulate bas.h5 files.
   //
 	int baseFileIndex;
   bool readsRemain = true;
+  SimulatedReadBatch *batch = NULL;
+  UInt batchRead = 0;
+  vector<int> pulseIndex;
 	for (baseFileIndex = 0; ((sourceReadsFileName == "" and baseFileIndex < nBasFiles)  // case 1 is reads are generated by file
                            or (sourceReadsFileName != "" and readsRemain)); // case 2 is reads are generated by an input file.
        baseFileIndex++) {
@@ -273,6 +683,7 @@ int main(int argc, char* argv[]) {
     regionTable.CreateDefaultAttributes();
 
     basWriter.SetPlatform(Springfield);
+    basWriter.SetBufferSize(writeBufferSize);
 		//
 		// Use a fixed set of fields for now.
 		//
@@ -289,9 +700,6 @@ int main(int argc, char* argv[]) {
 		basWriter.IncludeField("PreBaseFrames");
     basWriter.IncludeField("PulseIndex");
 
-    vector<unsigned char> qualityValue, substitutionQV, substitutionTag, insertionQV, deletionQV, deletionTag;
-    vector<HalfWord> widthInFrames, preBaseFrames, pulseIndex;
-
     // Just go from 0 .. hole Number
 		basWriter.IncludeField("HoleNumber");
     // Fixed to 0.
@@ -304,78 +712,18 @@ int main(int argc, char* argv[]) {
 
 
 		DNALength numSimulatedBases  = 0;
-		FASTASequence sampleSeq;
-		//sampleSeq.length = readLength;
-		int maxRetry = 10000000;
-		int retryNumber = 0;
 		int numReads = 0;
-		int readLength = 0;
 
 		while (numBasesPerFile == 0 or numSimulatedBases < numBasesPerFile) {
-			DNALength seqIndex, seqPos;
-      if (useLengthModel or fixedLength) {
-        if (useLengthModel) {
-          lengthHistogram.GetRandomLength(readLength);
-        }
-        else {
-          readLength = fixedLength;
-        }
-      }
-      if (refGenomeFileName != "") {
-        FindRandomPos(reference, seqIndex, seqPos, readLength + (outputModel.keyLength - 1));
-        sampleSeq.seq    = &reference[seqIndex].seq[seqPos];
-        sampleSeq.length = readLength + (outputModel.keyLength - 1);
-        assert(reference[seqIndex].length >= sampleSeq.length);
-      }
-      else if (sourceReadsFileName != "") {
-        if (seqReader.GetNext(sampleSeq) == false) {
+      if (batch == NULL or batchRead == batch->NumReads()) {
+        delete batch;
+        batch = simulator.GetNextBatch();
+        batchRead = 0;
+        if (batch == NULL) {
           readsRemain = false;
           break;
         }
-        if (sampleSeq.length < outputModel.keyLength) {
-          continue;
-        }
-        //
-        // Now attempt to parse the position from the fasta title.
-        //
-
-        if (useLengthModel) {
-          int tryNumber = 0;
-          readLength = 0;
-          int maxNTries = 1000;
-          int tryBuffer[5] = {-1,-1,-1,-1,-1};
-          while (tryNumber < maxNTries and readLength < outputModel.keyLength) {
-            lengthHistogram.GetRandomLength(readLength);
-            readLength = sampleSeq.length = min(sampleSeq.length, (unsigned int) readLength);
-            tryBuffer[tryNumber%5] = readLength;
-            tryNumber++;
-          }
-          if (tryNumber >= maxNTries) {
-            cout << "ERROR. Could not generate a read length greater than the " << outputModel.keyLength << " requried " <<endl
-                 << "minimum number of bases using the length model specified in the alchemy." <<endl
-                 << "model.  Something is either wrong with the model or the context length is too large." <<endl;
-            cout << "The last few tries were: " << tryBuffer[0] << " " << tryBuffer[1] << " " << tryBuffer[2] << " " << tryBuffer[3] << " " << tryBuffer[4] << endl;
-            exit(1);
-          }
-        }
-        
-        readLength = sampleSeq.length;
-        vector<string> tokens;
-        Tokenize(sampleSeq.title, "|", tokens);
-        if (tokens.size() == 4) {
-          seqPos = atoi(tokens[2].c_str());
-          if (titleTableFileName == "") {
-            seqIndex = 0;
-          }
-          else {
-            int index;
-            titleTable.Lookup(tokens[1], index);
-            seqIndex = index;
-          }
-        }
-        else {
-          seqPos   = 0;
-        }
+        continue;
       }
 
       //
@@ -386,106 +734,39 @@ int main(int argc, char* argv[]) {
         regionWriter.Initialize(basWriter.pulseDataGroup);
       }
 
-			numSimulatedBases += readLength;
-
-			int p;
-			// create the sample sequence
-			int contextLength = outputModel.keyLength;
-			int contextMiddle = contextLength / 2;
-			string outputString;
-
-			int nDel = 0;
-			int nIns = 0;
-
-			//
-			// Simulate to beyond the sample length.
-			//
-      qualityValue.clear(); 
-      substitutionQV.clear(); 
-      substitutionTag.clear(); 
-      insertionQV.clear(); 
-      deletionQV.clear(); 
-      deletionTag.clear();
-      pulseIndex.clear();
-      widthInFrames.clear();
-      preBaseFrames.clear();
-      assert(sampleSeq.length > contextMiddle + 1);
-			for (p = contextMiddle;
-					 p < sampleSeq.length - contextMiddle - 1; p++) {
-				string refContext;
-				refContext.assign((const char*) &sampleSeq.seq[p-contextMiddle], contextLength);
-				
-				string outputContext;
-				int    contextWasFound;
-        OutputSample sample;
-        int i;
-        for (i = 0; i < refContext.size(); i++) { refContext[i] = toupper(refContext[i]);}
-				outputModel.SampleRandomSample(refContext, sample);
-
-				if (sample.type == OutputSample::Deletion ) {
-					//
-					// There was a deletion.  Advance in reference, then output
-					// the base after the deletion.
-					//
-					p++;
-					++nDel;
-				}
-
-        int cp;
+			numSimulatedBases += batch->sampledLength[batchRead];
+
+      //
+      // The read points into the batch; it does not own its arrays.
+      //
+			SMRTSequence read;
+      UInt readStart = batch->readStart[batchRead];
+			read.length = batch->ReadLength(batchRead);
+      read.deleteOnExit = false;
+      if (read.length > 0) {
+        read.seq                 = &batch->bases[readStart];
+        read.qual.data           = &batch->qualityValue[readStart];
+        read.deletionQV.data     = &batch->deletionQV[readStart];
+        read.insertionQV.data    = &batch->insertionQV[readStart];
+        read.substitutionQV.data = &batch->substitutionQV[readStart];
+        read.deletionTag         = &batch->deletionTag[readStart];
+        read.substitutionTag     = &batch->substitutionTag[readStart];
+        read.preBaseFrames       = &batch->preBaseFrames[readStart];
+        read.widthInFrames       = &batch->widthInFrames[readStart];
         //
-        // Add the sampled context, possibly multiple characters because of an insertion.
+        // The pulse index for now is just fake data.
         //
-        for (i = 0; i < sample.nucleotides.size(); i++) {
-          outputString.push_back(sample.nucleotides[i]);
-          qualityValue.push_back(sample.qualities[i].qv[0]);
-          deletionQV.push_back(sample.qualities[i].qv[1]);
-          insertionQV.push_back(sample.qualities[i].qv[2]);
-          substitutionQV.push_back(sample.qualities[i].qv[3]);
-          deletionTag.push_back(sample.qualities[i].tags[0]);
-          substitutionTag.push_back(sample.qualities[i].tags[1]);
-          pulseIndex.push_back(sample.qualities[i].frameValues[0]);
-          preBaseFrames.push_back(sample.qualities[i].frameValues[1]);
-          widthInFrames.push_back(sample.qualities[i].frameValues[2]);
+        if (pulseIndex.size() < read.length) {
+          pulseIndex.resize(read.length, 1);
         }
-        nIns += sample.qualities.size() - 1;
-			}
-      if (outputString.find('N') != outputString.npos or
-          outputString.find('n') != outputString.npos) {
-        cout << "WARNING!  The sampled string " << endl << outputString << endl
-             << "should not contain N's, but it seems to.  This is being ignored "<<endl
-             << "for now so that simulation may continue, but this shouldn't happen"<<endl
-             << "and is really a bug." << endl;
-        numSimulatedBases -= readLength;
-        continue;
-      }
-			//
-			// Ok, done creating the read, now time to create some quality values!!!!!
-			//
-			SMRTSequence read;
-			read.length = outputString.size();
-			read.Allocate(read.length);
-			memcpy(read.seq, outputString.c_str(), read.length * sizeof(unsigned char));
-      assert(qualityValue.size() == read.length * sizeof(unsigned char));
-      memcpy(read.qual.data, &qualityValue[0], read.length * sizeof(unsigned char));
-      memcpy(read.deletionQV.data, &deletionQV[0], read.length * sizeof(unsigned char));
-      memcpy(read.insertionQV.data, &insertionQV[0], read.length * sizeof(unsigned char));
-      memcpy(read.substitutionQV.data, &substitutionQV[0], read.length * sizeof(unsigned char));
-      memcpy(read.deletionTag, &deletionTag[0], read.length * sizeof(unsigned char));
-      memcpy(read.substitutionTag, &substitutionTag[0], read.length * sizeof(unsigned char));
-      memcpy(read.pulseIndex, &pulseIndex[0], read.length * sizeof(int));
-      memcpy(read.preBaseFrames, &preBaseFrames[0], read.length * sizeof(HalfWord));
-      memcpy(read.widthInFrames, &widthInFrames[0], read.length * sizeof(HalfWord));
-      
-      //
-      // The pulse index for now is just fake data.
-      //
-      int i;
-      for (i = 0; i < read.length; i++) {
-        read.pulseIndex[i] = 1;
+        read.pulseIndex = &pulseIndex[0];
       }
+      DNALength seqIndex = batch->seqIndex[batchRead];
+      DNALength seqPos   = batch->seqPos[batchRead];
 			read.xy[0] = seqIndex;
 			read.xy[1] = seqPos;
 			read.zmwData.holeNumber = numReads;
+      read.zmwData.holeStatus = 0;
 
 			basWriter.Write(read);
 			// Record where this was simulated from.
@@ -496,8 +777,7 @@ int main(int argc, char* argv[]) {
 			else {
         posMapFile << fullMovieName << "/" << numReads << "/0_" << read.length << " " << seqIndex << " "<< seqPos;
         if (printPercentRepeat) {
-          DNALength nRepeat = sampleSeq.GetRepeatContent();
-          posMapFile << " " << nRepeat*1.0/sampleSeq.length;
+          posMapFile << " " << batch->repeatFraction[batchRead];
         }
         posMapFile << endl;
 			}
@@ -510,22 +790,25 @@ int main(int argc, char* argv[]) {
       regionWriter.Write(region);
       region.row[1] = 2; // Rewrite for hq region encompassing everything.
       regionWriter.Write(region);      
-      if (sourceReadsFileName != "") {
-        sampleSeq.Free();
-      }
-      read.Free();
 			++numReads;
+      ++batchRead;
 		}
-    regionWriter.Finalize(regionTable.columnNames, 
-                          regionTable.regionTypes,
-                          regionTable.regionDescriptions,
-                          regionTable.regionSources);
-		basWriter.Close();
-		numReads = 0;
+    if (numSimulatedBases > 0) {
+      regionWriter.Finalize(regionTable.columnNames, 
+                            regionTable.regionTypes,
+                            regionTable.regionDescriptions,
+                            regionTable.regionSources);
+      basWriter.Close();
+    }
 		//
 		// The bas writer should automatically flush on closing.
 		//
 	}
+  delete batch;
+  simulator.Stop();
+  for (i = 0; i < nProc; i++) {
+    pthread_join(threads[i], NULL);
+  }
 	if (usePosMap) {
 		posMapFile.close();
 	}
@@ -534,4 +817,3 @@ int main(int argc, char* argv[]) {
     reference[i].Free();
   }
 }
-
@@ -0,0 +1,200 @@
+#include "FASTQSequence.h"
+#include "datastructures/alignment/AlignmentCandidate.h"
+#include "algorithms/alignment/printers/BinaryAlignmentPrinter.h"
+#include "algorithms/alignment/readers/BinaryAlignmentReader.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+using namespace std;
+
+//
+// Write binary (-m 7) records on both strands, with and without
+// quality values, with zero to many blocks and long names of every
+// length mod 4, then read them back, in place and into alignment
+// candidates, and compare every field.  A file cut off inside its
+// last record reads as the records before it.
+//
+
+typedef AlignmentCandidate<DNASequence, FASTQSequence> Candidate;
+
+int nFailed = 0;
+
+void Check(bool condition, int r, const char *message) {
+  if (condition == false) {
+    cout << "FAILED: record " << r << ": " << message << endl;
+    ++nFailed;
+  }
+}
+
+bool HasQVs(int r) {
+  return r % 3 == 0;
+}
+
+//
+// Every record is made from its index, so that the records read back
+// can be compared with the same records made again.
+//
+void MakeAlignment(int r, Candidate &alignment) {
+  stringstream qName, tName;
+  qName << "m130101_000000_42161_c100000000000000000000000000000000_s1_p0/" << r << "/0_"
+        << string(r * 37 % 500 + r % 4, '9');
+  tName << "ref" << string(r % 4, 'x') << "|" << string(r * 11 % 300, 'c');
+  alignment.qName          = qName.str();
+  alignment.tName          = tName.str();
+  alignment.readIndex      = r * 1001;
+  alignment.tIndex         = (r % 5 == 0 ? -1 : r % 13);
+  alignment.qLength        = 20000 + r;
+  alignment.tLength        = 5000000 + r * 17;
+  alignment.qAlignedSeqPos = r * 3;
+  alignment.tAlignedSeqPos = 4000000 + r * 5;
+  alignment.qPos           = r % 7;
+  alignment.tPos           = r % 11;
+  alignment.qStrand        = r % 2;
+  alignment.tStrand        = (r / 2) % 2;
+  alignment.score          = -100 * r - 1;
+  alignment.pctSimilarity  = 70.125 + r * 0.25;
+  alignment.mapQV          = (r == 5 ? -3 : r * 13);
+  alignment.nMatch         = 900 + r;
+  alignment.nMismatch      = r;
+  alignment.nIns           = 2 * r;
+  alignment.nDel           = 3 * r;
+  alignment.blocks.clear();
+  int b, nBlocks = (r % 4 == 1 ? 0 : r % 9 + 1);
+  DNALength qPos = 0, tPos = 0;
+  for (b = 0; b < nBlocks; b++) {
+    Block block;
+    block.qPos   = qPos;
+    block.tPos   = tPos;
+    block.length = 10 + (r * 7 + b * 3) % 40;
+    alignment.blocks.push_back(block);
+    qPos += block.length + b % 3;
+    tPos += block.length + (b + 1) % 2;
+  }
+  if (HasQVs(r)) {
+    DNALength length = qPos + 1;
+    alignment.qAlignedSeq.Free();
+    ((DNASequence*)&alignment.qAlignedSeq)->Allocate(length);
+    alignment.qAlignedSeq.AllocateQualitySpace(length);
+    DNALength i;
+    for (i = 0; i < length; i++) {
+      alignment.qAlignedSeq.seq[i]       = 'A';
+      alignment.qAlignedSeq.qual.data[i] = (i * 7 + r) % 94;
+    }
+  }
+}
+
+void CompareRecord(int r, BinaryAlignmentRecord &record) {
+  Candidate expected;
+  MakeAlignment(r, expected);
+  BinaryAlignmentRecordHeader *h = record.header;
+  Check(string(record.qName, h->qNameLength) == expected.qName, r, "qName");
+  Check(string(record.tName, h->tNameLength) == expected.tName, r, "tName");
+  Check(h->nBlocks == expected.blocks.size(), r, "number of blocks");
+  Check(HasQVs(r) ? (h->nQVs == expected.qAlignedSeq.length and record.qvs != NULL and
+                     memcmp(record.qvs, expected.qAlignedSeq.qual.data, h->nQVs) == 0)
+                  : (h->nQVs == 0 and record.qvs == NULL), r, "quality values");
+  Check((int) h->mapQV == (r == 5 ? 0 : min(r * 13, 255)), r, "mapQV is clamped to a byte");
+}
+
+void CompareCandidate(int r, Candidate &alignment) {
+  Candidate expected;
+  MakeAlignment(r, expected);
+  Check(alignment.qName == expected.qName, r, "qName");
+  Check(alignment.tName == expected.tName, r, "tName");
+  Check(alignment.readIndex == expected.readIndex, r, "readIndex");
+  Check(alignment.tIndex == expected.tIndex, r, "tIndex");
+  Check(alignment.qLength == expected.qLength, r, "qLength");
+  Check(alignment.tLength == expected.tLength, r, "tLength");
+  Check(alignment.qAlignedSeqPos == expected.qAlignedSeqPos, r, "qAlignedSeqPos");
+  Check(alignment.tAlignedSeqPos == expected.tAlignedSeqPos, r, "tAlignedSeqPos");
+  Check(alignment.qPos == expected.qPos, r, "qPos");
+  Check(alignment.tPos == expected.tPos, r, "tPos");
+  Check(alignment.qStrand == expected.qStrand, r, "qStrand");
+  Check(alignment.tStrand == expected.tStrand, r, "tStrand");
+  Check(alignment.score == expected.score, r, "score");
+  Check(alignment.pctSimilarity == expected.pctSimilarity, r, "pctSimilarity");
+  Check(alignment.mapQV == (r == 5 ? 0 : min(r * 13, 255)), r, "mapQV");
+  Check(alignment.nMatch == expected.nMatch, r, "nMatch");
+  Check(alignment.nMismatch == expected.nMismatch, r, "nMismatch");
+  Check(alignment.nIns == expected.nIns, r, "nIns");
+  Check(alignment.nDel == expected.nDel, r, "nDel");
+  bool blocksMatch = (alignment.blocks.size() == expected.blocks.size());
+  int b;
+  for (b = 0; blocksMatch and b < alignment.blocks.size(); b++) {
+    blocksMatch = (alignment.blocks[b].qPos   == expected.blocks[b].qPos and
+                   alignment.blocks[b].tPos   == expected.blocks[b].tPos and
+                   alignment.blocks[b].length == expected.blocks[b].length);
+  }
+  Check(blocksMatch, r, "blocks");
+}
+
+int main(int argc, char* argv[]) {
+  string fileName = "bin/testBinaryAlignmentFormat.m7";
+  string cutFileName = "bin/testBinaryAlignmentFormat.cut.m7";
+  int nRecords = 40, r;
+
+  ofstream out(fileName.c_str(), std::ios::out | std::ios::binary);
+  BinaryAlignmentPrinter::PrintHeader(out);
+  for (r = 0; r < nRecords; r++) {
+    Candidate alignment;
+    MakeAlignment(r, alignment);
+    BinaryAlignmentPrinter::Print(alignment, out, true);
+  }
+  out.close();
+
+  BinaryAlignmentReader reader;
+  if (reader.Initialize(fileName) == 0) {
+    cout << "FAILED: could not read " << fileName << endl;
+    return 1;
+  }
+  BinaryAlignmentRecord record;
+  for (r = 0; reader.GetNext(record); r++) {
+    Check(r < nRecords, r, "there are no extra records");
+    if (r < nRecords) {
+      Check(((long) record.blocks) % 4 == 0, r, "blocks are aligned");
+      CompareRecord(r, record);
+    }
+  }
+  Check(r == nRecords, r, "every record is read in place");
+
+  reader.Rewind();
+  Candidate alignment;
+  for (r = 0; reader.GetNext(alignment); r++) {
+    if (r < nRecords) {
+      CompareCandidate(r, alignment);
+    }
+  }
+  Check(r == nRecords, r, "every record is read into a candidate");
+  reader.Close();
+
+  //
+  // Cut the file inside its last record.
+  //
+  ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+  string contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  in.close();
+  ofstream cutOut(cutFileName.c_str(), std::ios::out | std::ios::binary);
+  cutOut.write(contents.c_str(), contents.size() - 6);
+  cutOut.close();
+  BinaryAlignmentReader cutReader;
+  if (cutReader.Initialize(cutFileName) == 0) {
+    cout << "FAILED: could not read " << cutFileName << endl;
+    return 1;
+  }
+  for (r = 0; cutReader.GetNext(record); r++) {
+  }
+  Check(r == nRecords - 1, r, "a record that is cut off ends the file");
+  cutReader.Close();
+
+  remove(fileName.c_str());
+  remove(cutFileName.c_str());
+
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,99 @@
+#include "CheckpointJournal.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+using namespace std;
+
+//
+// Check that the journal writes the output of reads in the order they
+// were taken from the reader, even when they finish out of order, and
+// that the checkpoint holds the position after the last read written
+// and the sizes of the output files at that point.
+//
+
+string ReadFile(string fileName) {
+  ifstream in(fileName.c_str());
+  stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+int nFailed = 0;
+
+void Check(bool condition, string message) {
+  if (condition == false) {
+    cout << "FAILED: " << message << endl;
+    ++nFailed;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  string outFileName       = "bin/checkpoint.out";
+  string unalignedFileName = "bin/checkpoint.unaligned";
+  string clusterFileName   = "bin/checkpoint.clusters";
+  string journalFileName   = "bin/checkpoint.ckpt";
+  vector<string> readsFileNames;
+  readsFileNames.push_back("movie.bas.h5");
+  readsFileNames.push_back("genome.fasta");
+
+  ofstream out(outFileName.c_str()), unaligned(unalignedFileName.c_str()), clusters(clusterFileName.c_str());
+  CheckpointJournal journal;
+  journal.Initialize(journalFileName, 2, readsFileNames, 1);
+  journal.SetOutput(outFileName, &out, unalignedFileName, &unaligned, clusterFileName, &clusters);
+  journal.StartFile(0, 3);
+
+  //
+  // Reads 3, 6, 9 of a -start 3 -stride 3 run.  Each ticket carries the
+  // position the run continues from once its read is done.
+  //
+  long t0 = journal.Issue(6);
+  long t1 = journal.Issue(9);
+  long t2 = journal.Issue(12);
+  Check(t0 == 0 and t1 == 1 and t2 == 2, "tickets are issued in order");
+
+  journal.Complete(t1, "aln9\n", "", "c9\n");
+  Check(ReadFile(outFileName) == "", "a read is held until the reads before it are done");
+
+  journal.Complete(t0, "aln3\n", "un3\n", "c3\n");
+  Check(ReadFile(outFileName) == "aln3\naln9\n", "reads are written in ticket order");
+  Check(ReadFile(unalignedFileName) == "un3\n", "unaligned output follows the reads");
+  Check(ReadFile(clusterFileName) == "c3\nc9\n", "cluster output follows the reads");
+
+  CheckpointJournal resumed;
+  resumed.Initialize(journalFileName, 2, readsFileNames, 1);
+  Check(resumed.Read(), "the checkpoint is read back");
+  Check(resumed.files[0].position == 9, "the checkpoint continues after the last read written");
+  Check(resumed.files[0].done == false, "the file is not done");
+  Check(resumed.outFileSize == 10 and resumed.unalignedFileSize == 4 and resumed.clusterFileSize == 6,
+        "the checkpoint holds the output sizes");
+
+  //
+  // The last read is written, but no checkpoint is made, as if the run
+  // were killed.  Resuming truncates the output to the checkpoint.
+  //
+  journal.Complete(t2, "aln12\n", "", "c12\n");
+  out.flush();
+  clusters.flush();
+  Check(resumed.TruncateOutput(outFileName, resumed.outFileSize), "the output is truncated");
+  Check(resumed.TruncateOutput(clusterFileName, resumed.clusterFileSize), "the clusters are truncated");
+  Check(ReadFile(outFileName) == "aln3\naln9\n", "output past the checkpoint is dropped");
+  Check(ReadFile(clusterFileName) == "c3\nc9\n", "clusters past the checkpoint are dropped");
+
+  journal.FinishFile();
+  resumed.Read();
+  Check(resumed.files[0].done, "a finished file is marked done");
+
+  remove(outFileName.c_str());
+  remove(unalignedFileName.c_str());
+  remove(clusterFileName.c_str());
+  remove(journalFileName.c_str());
+
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,131 @@
+#include <cassert>
+#include "algorithms/alignment/FullQVAlign.h"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <iostream>
+using namespace std;
+
+//
+// FullQVAlign sums probabilities in float with the tabulated log-sum.
+// Compare its result with the same forward recurrence summed exactly
+// in double, on sequences with per-base error probabilities.
+//
+
+class ProbSequence {
+ public:
+  vector<Nucleotide> seqBuffer;
+  Nucleotide *seq;
+  DNALength length;
+  vector<double> insertion, deletion, substitution;
+
+  void Simulate(DNALength lengthP) {
+    const char nucs[] = "ACGT";
+    length = lengthP;
+    seqBuffer.resize(length);
+    insertion.resize(length);
+    deletion.resize(length);
+    substitution.resize(length);
+    DNALength i;
+    for (i = 0; i < length; i++) {
+      seqBuffer[i]    = nucs[rand() % 4];
+      insertion[i]    = 0.01 + 0.14 * rand() / RAND_MAX;
+      deletion[i]     = 0.01 + 0.09 * rand() / RAND_MAX;
+      substitution[i] = 0.001 + 0.05 * rand() / RAND_MAX;
+    }
+    seq = &seqBuffer[0];
+  }
+
+  //
+  // Copy the sequence with a change at about one base in ten.
+  //
+  void Mutate(ProbSequence &source) {
+    const char nucs[] = "ACGT";
+    *this = source;
+    seq = &seqBuffer[0];
+    DNALength i;
+    for (i = 0; i < length; i++) {
+      if (rand() % 10 == 0) {
+        seqBuffer[i] = nucs[rand() % 4];
+      }
+    }
+  }
+
+  double GetInsertionQV(DNALength pos)    { return insertion[pos]; }
+  double GetDeletionQV(DNALength pos)     { return deletion[pos]; }
+  double GetSubstitutionQV(DNALength pos) { return substitution[pos]; }
+  double GetPreBaseDeletionQV(DNALength pos, Nucleotide nuc) { return 0; }
+  Nucleotide GetDeletionTag(DNALength pos) { return 'N'; }
+};
+
+double LogSumExact(double a, double b, double c) {
+  double maxValue = max(a, max(b, c));
+  return maxValue + log(exp(a - maxValue) + exp(b - maxValue) + exp(c - maxValue));
+}
+
+double DoubleFullQVAlign(ProbSequence &query, ProbSequence &target) {
+  DNALength numRows = query.length + 1, numCols = target.length + 1;
+  vector<vector<double> > alignProb(numRows, vector<double>(numCols, 0));
+  DNALength q, t;
+  alignProb[0][0] = 1;
+  for (t = 1; t < numCols; t++) {
+    alignProb[0][t] = log(target.GetInsertionQV(t-1)) + alignProb[0][t-1];
+  }
+  for (q = 1; q < numRows; q++) {
+    alignProb[q][0] = log(query.GetInsertionQV(q-1)) + alignProb[q-1][0];
+  }
+  for (q = 1; q < numRows; q++) {
+    for (t = 1; t < numCols; t++) {
+      double matched;
+      if (query.seq[q-1] == target.seq[t-1]) {
+        matched = (1-query.GetSubstitutionQV(q-1)) * (1-target.GetSubstitutionQV(t-1));
+      }
+      else {
+        matched = (query.GetSubstitutionQV(q-1)/3.0)*(1-target.GetSubstitutionQV(t-1)) +
+          (1-query.GetSubstitutionQV(q-1))*(target.GetSubstitutionQV(t-1)/3.0);
+      }
+      double inserted = query.GetInsertionQV(q-1) + target.GetDeletionQV(t-1);
+      double deleted  = target.GetInsertionQV(t-1) + query.GetDeletionQV(q-1);
+      alignProb[q][t] = LogSumExact(log(matched)  + alignProb[q-1][t-1],
+                                    log(inserted) + alignProb[q-1][t],
+                                    log(deleted)  + alignProb[q][t-1]);
+    }
+  }
+  return alignProb[numRows-1][numCols-1];
+}
+
+int main(int argc, char* argv[]) {
+  //
+  // The table overestimates log10(1+10^-d) by at most 2e-6 per sum, and
+  // a cell sums three terms, so the error of a cell is at most 4e-6
+  // (in log10, times log(10) in natural log) more than the error of the
+  // cells it is summed from.  The error at the end is then bounded by
+  // the number of cells on a path, plus float rounding of the result.
+  //
+  double sumError = 2 * 2e-6 * log(10.0);
+  DNALength lengths[] = {50, 500, 2000};
+  int nFailed = 0;
+  srand(3);
+  int i;
+  for (i = 0; i < 3; i++) {
+    ProbSequence target, query;
+    target.Simulate(lengths[i]);
+    query.Mutate(target);
+    Matrix<float> alignProb;
+    double floatResult  = FullQVAlign(query, target, alignProb);
+    double doubleResult = DoubleFullQVAlign(query, target);
+    double error = fabs(floatResult - doubleResult);
+    cout << "length " << lengths[i] << " float " << floatResult << " double " << doubleResult
+         << " error " << error << endl;
+    double tolerance = (query.length + target.length) * sumError + 1e-6 * fabs(doubleResult);
+    if (!(error <= tolerance)) {
+      cout << "FAILED: error above " << tolerance << endl;
+      ++nFailed;
+    }
+  }
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
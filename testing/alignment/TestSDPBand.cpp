@@ -0,0 +1,113 @@
+#include <cassert>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include "FASTASequence.h"
+#include "algorithms/alignment.h"
+#include "algorithms/alignment/SDPAlign.h"
+using namespace std;
+
+//
+// Align a read with about 12% indel and substitution error to a long
+// window with and without -sdpBand, where the band comes from anchors
+// on the true path as blasr's LIS anchors would be.  The banded chain
+// must score about as well as the unbanded one.  Its chain is
+// sparser, so the gaps between chained fragments are often long
+// enough to be filled by a recursive sdp alignment.
+//
+
+int MatchedBases(Alignment &alignment) {
+  int b, nMatched = 0;
+  for (b = 0; b < alignment.blocks.size(); b++) {
+    nMatched += alignment.blocks[b].length;
+  }
+  return nMatched;
+}
+
+int main(int argc, char* argv[]) {
+  const char nucs[] = "ACGT";
+  DNALength targetLength = 20000;
+  vector<Nucleotide> targetBuffer(targetLength), queryBuffer;
+  vector<DNALength> anchorQ, anchorT;
+  srand(11);
+  DNALength t;
+  for (t = 0; t < targetLength; t++) {
+    targetBuffer[t] = nucs[rand() % 4];
+  }
+  for (t = 0; t < targetLength; t++) {
+    int r = rand() % 100;
+    if (r < 6) {
+      queryBuffer.push_back(nucs[rand() % 4]);
+      queryBuffer.push_back(targetBuffer[t]);
+    }
+    else if (r < 10) {
+      continue;
+    }
+    else if (r < 12) {
+      queryBuffer.push_back(nucs[(rand() % 3 + (targetBuffer[t] == 'A' ? 1 : 0)) % 4]);
+    }
+    else {
+      if (t % 1000 == 500) {
+        anchorQ.push_back(queryBuffer.size());
+        anchorT.push_back(t);
+      }
+      queryBuffer.push_back(targetBuffer[t]);
+    }
+  }
+  FASTASequence query, target;
+  query.seq     = &queryBuffer[0];
+  query.length  = queryBuffer.size();
+  target.seq    = &targetBuffer[0];
+  target.length = targetLength;
+
+  DistanceMatrixScoreFunction<DNASequence, DNASequence> distScoreFn;
+  distScoreFn.ins = 4;
+  distScoreFn.del = 5;
+  distScoreFn.InitializeScoreMatrix(SMRTDistanceMatrix);
+
+  vector<Fragment> fragmentSet, prefixFragmentSet, suffixFragmentSet;
+  TupleList<PositionDNATuple> targetTupleList, targetPrefixTupleList, targetSuffixTupleList;
+  vector<int> maxFragmentChain;
+
+  Alignment unbanded, banded;
+  int unbandedScore = SDPAlign(query, target, distScoreFn, 11, 5, 10, 0.3*3, unbanded,
+                               fragmentSet, prefixFragmentSet, suffixFragmentSet,
+                               targetTupleList, targetPrefixTupleList, targetSuffixTupleList,
+                               maxFragmentChain, Local, true, false);
+
+  SDPBand band;
+  band.Initialize(100);
+  int a;
+  for (a = 0; a < anchorQ.size(); a++) {
+    band.AddAnchor(anchorQ[a], anchorT[a]);
+  }
+  int bandedScore = SDPAlign(query, target, distScoreFn, 11, 5, 10, 0.3*3, banded,
+                             fragmentSet, prefixFragmentSet, suffixFragmentSet,
+                             targetTupleList, targetPrefixTupleList, targetSuffixTupleList,
+                             maxFragmentChain, Local, true, false, 10000, &band);
+
+  int unbandedMatched = MatchedBases(unbanded), bandedMatched = MatchedBases(banded);
+  cout << "query " << query.length << " target " << target.length << " anchors " << anchorQ.size() << endl
+       << "unbanded score " << unbandedScore << " matched " << unbandedMatched << endl
+       << "banded   score " << bandedScore << " matched " << bandedMatched << endl;
+
+  //
+  // Scores are negative, lower is better.  Allow the banded chain to
+  // be 1% worse than the unbanded one.
+  //
+  int nFailed = 0;
+  if (bandedScore > unbandedScore + 0.01 * abs(unbandedScore)) {
+    cout << "FAILED: the banded score is more than 1% worse than the unbanded score" << endl;
+    ++nFailed;
+  }
+  if (bandedMatched < 0.99 * unbandedMatched) {
+    cout << "FAILED: the banded alignment matches 1% fewer bases than the unbanded one" << endl;
+    ++nFailed;
+  }
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
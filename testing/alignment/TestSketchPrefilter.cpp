@@ -0,0 +1,128 @@
+#include "DNASequence.h"
+#include "algorithms/anchoring/SketchPrefilter.h"
+#include <cstdlib>
+#include <vector>
+#include <iostream>
+using namespace std;
+
+//
+// A read from one copy of a segment that is repeated, with changes,
+// elsewhere in the genome.  The second copy shares fewer minimizers
+// with the read than the first, but both copies must get anchors, and
+// the anchors must be the maximal exact matches around the minimizer
+// matches.
+//
+
+int nFailed = 0;
+
+void Check(bool condition, const char *message) {
+  if (condition == false) {
+    cout << "FAILED: " << message << endl;
+    ++nFailed;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const char nucs[] = "ACGT";
+  DNALength genomeLength = 60000, segmentStart = 10000, copyStart = 40000, segmentLength = 4000;
+  DNASequence genome;
+  genome.Allocate(genomeLength);
+  srand(7);
+  DNALength i;
+  for (i = 0; i < genomeLength; i++) {
+    genome.seq[i] = nucs[rand() % 4];
+  }
+  //
+  // The copy has a change every 25 bases, so that roughly half of its
+  // minimizers still match the read.
+  //
+  for (i = 0; i < segmentLength; i++) {
+    genome.seq[copyStart + i] = genome.seq[segmentStart + i];
+    if (i % 25 == 12) {
+      genome.seq[copyStart + i] = (genome.seq[copyStart + i] == 'A' ? 'C' : 'A');
+    }
+  }
+
+  DNASequence read, readRC;
+  read.Allocate(segmentLength);
+  for (i = 0; i < segmentLength; i++) {
+    read.seq[i] = genome.seq[segmentStart + i];
+  }
+  read.MakeRC(readRC);
+
+  MinimizerIndex index;
+  index.Build(genome, 15, 10);
+  vector<Minimizer> readMinimizers;
+  vector<SketchHit> hits;
+
+  Check(SketchShortlist(index, read, readRC, false, 100, 5, readMinimizers, hits),
+        "the read has a locus");
+
+  int nFirst = 0, nCopy = 0;
+  for (i = 0; i < hits.size(); i++) {
+    if (hits[i].strand == 0 and hits[i].diagonal == (long) segmentStart) {
+      ++nFirst;
+    }
+    if (hits[i].strand == 0 and hits[i].diagonal == (long) copyStart) {
+      ++nCopy;
+    }
+  }
+  Check(nCopy > 0 and nFirst > 2 * nCopy, "the copy has fewer than half the matches of the source");
+
+  vector<ChainedMatchPos> matchPosList, rcMatchPosList;
+  SketchAnchors(genome, read, readRC, hits, 15, 12, matchPosList, rcMatchPosList);
+
+  int nSource = 0, nCopyAnchors = 0, nOther = 0, nBadCopy = 0;
+  for (i = 0; i < matchPosList.size(); i++) {
+    ChainedMatchPos &a = matchPosList[i];
+    if (a.t == segmentStart and a.q == 0 and a.l == segmentLength) {
+      ++nSource;
+    }
+    else if (a.t - a.q == copyStart) {
+      ++nCopyAnchors;
+      //
+      // Anchors of the copy run between its changes.
+      //
+      if (a.l < 12 or a.l > 24 or
+          (a.q % 25 != 13 and a.q != 0) or
+          (a.q + a.l) % 25 != 12) {
+        ++nBadCopy;
+      }
+    }
+    else {
+      ++nOther;
+    }
+  }
+  Check(nSource == 1, "the source is one anchor spanning the read");
+  Check(nCopyAnchors > 0 and nBadCopy == 0,
+        "the minimizer matches of the copy are extended to the exact matches between changes");
+  //
+  // Minimizer matches in the same exact match give one anchor.
+  //
+  for (i = 1; i < matchPosList.size(); i++) {
+    Check(matchPosList[i].t != matchPosList[i-1].t or matchPosList[i].q != matchPosList[i-1].q,
+          "no anchor is stored twice");
+  }
+  Check(nOther + rcMatchPosList.size() <= 2, "there are few anchors away from the copies");
+  for (i = 0; i < rcMatchPosList.size(); i++) {
+    Check(rcMatchPosList[i].l >= 12, "anchors are at least the minimum match length");
+  }
+
+  //
+  // A read with no locus is searched as usual.
+  //
+  DNASequence randomRead, randomReadRC;
+  randomRead.Allocate(segmentLength);
+  for (i = 0; i < segmentLength; i++) {
+    randomRead.seq[i] = nucs[rand() % 4];
+  }
+  randomRead.MakeRC(randomReadRC);
+  Check(SketchShortlist(index, randomRead, randomReadRC, false, 100, 5, readMinimizers, hits) == false,
+        "a random read has no locus");
+
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
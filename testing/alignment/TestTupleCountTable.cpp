@@ -0,0 +1,86 @@
+#include <cstdlib>
+#include <vector>
+#include <iostream>
+#include "FASTASequence.h"
+#include "tuples/DNATuple.h"
+#include "tuples/TupleMetrics.h"
+#include "datastructures/tuplelists/TupleCountTable.h"
+using namespace std;
+
+//
+// Count the tuples of a sequence with runs of N on several threads
+// and check that the table matches the one counted serially.
+//
+
+typedef TupleCountTable<FASTASequence, DNATuple> CountTable;
+
+int main(int argc, char* argv[]) {
+  const char nucs[] = "ACGT";
+  DNALength seqLength = 300000;
+  vector<Nucleotide> seqBuffer(seqLength);
+  srand(7);
+  DNALength i;
+  for (i = 0; i < seqLength; i++) {
+    seqBuffer[i] = nucs[rand() % 4];
+    if (rand() % 5000 == 0) {
+      DNALength runEnd = min(seqLength, i + rand() % 20 + 1);
+      for (; i < runEnd; i++) {
+        seqBuffer[i] = 'N';
+      }
+    }
+  }
+  FASTASequence seq;
+  seq.seq    = &seqBuffer[0];
+  seq.length = seqLength;
+
+  int tupleSizes[] = {1, 8, 12};
+  int nProcs[]     = {1, 3, 8};
+  int nFailed = 0;
+  int t, p;
+  for (t = 0; t < 3; t++) {
+    TupleMetrics tm;
+    tm.Initialize(tupleSizes[t]);
+    CountTable serial;
+    serial.InitCountTable(tm);
+    serial.AddSequenceTupleCountsLR(seq);
+    for (p = 0; p < 3; p++) {
+      CountTable threaded;
+      threaded.InitCountTable(tm);
+      threaded.AddSequenceTupleCountsLR(seq, nProcs[p]);
+      int c, nDiff = 0;
+      for (c = 0; c < serial.countTableLength; c++) {
+        if (serial.countTable[c] != threaded.countTable[c]) {
+          ++nDiff;
+        }
+      }
+      if (nDiff > 0 or serial.nTuples != threaded.nTuples) {
+        cout << "FAILED: k=" << tupleSizes[t] << " nproc=" << nProcs[p] << " "
+             << nDiff << " counts differ, " << threaded.nTuples << " tuples instead of "
+             << serial.nTuples << endl;
+        ++nFailed;
+      }
+    }
+  }
+
+  //
+  // A sequence shorter than a tuple adds nothing.
+  //
+  FASTASequence shortSeq;
+  shortSeq.seq    = &seqBuffer[0];
+  shortSeq.length = 5;
+  TupleMetrics tm;
+  tm.Initialize(8);
+  CountTable shortTable;
+  shortTable.InitCountTable(tm);
+  shortTable.AddSequenceTupleCountsLR(shortSeq, 4);
+  if (shortTable.nTuples != 0) {
+    cout << "FAILED: counted " << shortTable.nTuples << " tuples in a sequence shorter than a tuple" << endl;
+    ++nFailed;
+  }
+
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
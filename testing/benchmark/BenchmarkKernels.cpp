@@ -0,0 +1,690 @@
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "SMRTSequence.h"
+#include "FASTASequence.h"
+#include "CommandLineParser.h"
+#include "utils.h"
+#include "tuples/DNATuple.h"
+#include "tuples/TupleMetrics.h"
+#include "algorithms/alignment.h"
+#include "algorithms/alignment/GuidedAlign.h"
+#include "algorithms/alignment/IDSScoreFunction.h"
+#include "algorithms/alignment/DistanceMatrixScoreFunction.h"
+#include "algorithms/alignment/printers/SAMPrinter.h"
+#include "algorithms/anchoring/LISPValue.h"
+#include "algorithms/anchoring/LISPValueWeightor.h"
+#include "algorithms/anchoring/LISSizeWeightor.h"
+#include "algorithms/anchoring/FindMaxInterval.h"
+#include "algorithms/anchoring/MapBySuffixArray.h"
+#include "datastructures/anchoring/ClusterList.h"
+#include "datastructures/anchoring/WeightedInterval.h"
+#include "datastructures/anchoring/AnchorParameters.h"
+#include "datastructures/alignment/AlignmentCandidate.h"
+#include "datastructures/alignment/AlignmentContext.h"
+#include "datastructures/metagenome/SequenceIndexDatabase.h"
+#include "datastructures/suffixarray/SuffixArrayTypes.h"
+#include "datastructures/tuplelists/TupleCountTable.h"
+#include "datastructures/bwt/BWT.h"
+#include "datastructures/mapping/MappingMetrics.h"
+#include "simulator/OutputSampleListSet.h"
+#include "statistics/VarianceAccumulator.h"
+#include "statistics/statutils.h"
+#include "../../alignment/components/MappingBuffers.h"
+
+using namespace std;
+
+//
+// Time blasr's hot kernels in isolation on a reproducible synthetic
+// reference and set of PacBio-like reads.  Every kernel is run over
+// the same reads, one call per read, and the result is written as a
+// single JSON object so that numbers may be compared between builds.
+//
+
+typedef LISPValueWeightor<FASTASequence, DNATuple, vector<ChainedMatchPos> > PValueWeightor;
+
+class BenchmarkParameters {
+ public:
+  int   seed;
+  int   genomeLength;
+  int   nReads;
+  int   readLength;
+  int   nRepeats;
+  int   repeatLength;
+  float insRate, delRate, subRate;
+  string modelFileName;
+  string outFileName;
+  int   minMatchLength;
+  int   lookupTableLength;
+  int   bwtKmerLength;
+  int   bwtStride;
+  int   maxAnchorsPerPosition;
+  int   nCandidates;
+  int   sdpTupleSize;
+  int   sdpIns, sdpDel;
+  float indelRate;
+  int   kbandSize;
+  int   guidedAlignBandSize;
+  int   insertion, deletion;
+  int   passes;
+
+  BenchmarkParameters() {
+    seed              = 1;
+    genomeLength      = 1000000;
+    nReads            = 200;
+    readLength        = 3000;
+    nRepeats          = 20;
+    repeatLength      = 2000;
+    insRate           = 0.10;
+    delRate           = 0.04;
+    subRate           = 0.01;
+    modelFileName     = "";
+    outFileName       = "";
+    minMatchLength    = 12;
+    lookupTableLength = 8;
+    bwtKmerLength     = 12;
+    bwtStride         = 1;
+    maxAnchorsPerPosition = 1000;
+    nCandidates       = 10;
+    sdpTupleSize      = 11;
+    sdpIns            = 5;
+    sdpDel            = 10;
+    indelRate         = 0.3;
+    kbandSize         = 0;
+    guidedAlignBandSize = 10;
+    insertion         = 4;
+    deletion          = 5;
+    passes            = 1;
+  }
+};
+
+long GetPeakRSSKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+class KernelResult {
+ public:
+  string name;
+  long long calls;
+  long long bases;
+  long long queries;
+  long long cells;
+  long long outputBytes;
+  long long elapsedUsec;
+  //
+  // The peak resident set size is the high-water mark of the whole
+  // process, so a kernel that runs after a larger one reports the
+  // same peak.  The growth of the peak while the kernel ran is kept
+  // as well; it is 0 when the kernel fit under an earlier peak.
+  //
+  long  startPeakRSSKb;
+  long  peakRSSKb;
+  LatencyHistogram latency;
+
+  KernelResult(string nameP) {
+    name        = nameP;
+    calls       = 0;
+    bases       = 0;
+    queries     = 0;
+    cells       = 0;
+    outputBytes = 0;
+    elapsedUsec = 0;
+    startPeakRSSKb = GetPeakRSSKb();
+    peakRSSKb   = 0;
+  }
+
+  void AddCall(long long usec, long long nBases, long long nQueries=0, long long nCells=0) {
+    calls++;
+    elapsedUsec += usec;
+    bases   += nBases;
+    queries += nQueries;
+    cells   += nCells;
+    latency.Add(usec);
+  }
+
+  static float PerSec(long long count, long long usec) {
+    if (usec == 0) {
+      return 0;
+    }
+    return ((double) count) / (usec / 1000000.0);
+  }
+
+  void PrintJSON(ostream &out) {
+    out << "{\"name\": \"" << name << "\""
+        << ", \"calls\": " << calls
+        << ", \"seconds\": " << elapsedUsec / 1000000.0
+        << ", \"callsPerSec\": " << PerSec(calls, elapsedUsec)
+        << ", \"bases\": " << bases
+        << ", \"basesPerSec\": " << PerSec(bases, elapsedUsec)
+        << ", \"queries\": " << queries
+        << ", \"queriesPerSec\": " << PerSec(queries, elapsedUsec)
+        << ", \"cells\": " << cells
+        << ", \"cellsPerSec\": " << PerSec(cells, elapsedUsec)
+        << ", \"outputBytes\": " << outputBytes
+        << ", \"processPeakRSSKb\": " << peakRSSKb
+        << ", \"peakRSSGrowthKb\": " << peakRSSKb - startPeakRSSKb
+        << ", \"latencyUsec\": ";
+    latency.PrintJSON(out);
+    out << "}";
+  }
+};
+
+Nucleotide RandomNuc() {
+  return "ACGT"[RandomInt(4)];
+}
+
+Nucleotide RandomOtherNuc(Nucleotide nuc) {
+  Nucleotide other;
+  do {
+    other = RandomNuc();
+  } while (other == nuc);
+  return other;
+}
+
+void SimulateReference(BenchmarkParameters &params, FASTASequence &genome) {
+  genome.Allocate(params.genomeLength);
+  DNALength i;
+  for (i = 0; i < genome.length; i++) {
+    genome.seq[i] = RandomNuc();
+  }
+  //
+  // Sprinkle in diverged copies of segments so that the anchoring
+  // kernels have to deal with multiple hits, as in a real genome.
+  //
+  int r;
+  for (r = 0; r < params.nRepeats and params.repeatLength < genome.length / 2; r++) {
+    DNALength src  = RandomInt(genome.length - params.repeatLength);
+    DNALength dest = RandomInt(genome.length - params.repeatLength);
+    for (i = 0; i < params.repeatLength; i++) {
+      genome.seq[dest + i] = (Random() < 0.02) ? RandomNuc() : genome.seq[src + i];
+    }
+  }
+  genome.CopyTitle("synthetic");
+}
+
+//
+// The built in model is a plain insertion/deletion/substitution
+// process with quality values that are lower at errors.  When an
+// alchemy output model (written by the simulator) is supplied, reads
+// are instead sampled by context exactly as the bas.h5 simulator
+// does.
+//
+class SimulatedRead {
+ public:
+  string seq;
+  vector<QualityValue> qual, insQV, delQV, subQV;
+  vector<Nucleotide>   delTag, subTag;
+
+  void PushBack(Nucleotide nuc, QualityValue qv, QualityValue iqv, QualityValue dqv,
+                QualityValue sqv, Nucleotide dtag, Nucleotide stag) {
+    seq.push_back(nuc);
+    qual.push_back(qv);
+    insQV.push_back(iqv);
+    delQV.push_back(dqv);
+    subQV.push_back(sqv);
+    delTag.push_back(dtag);
+    subTag.push_back(stag);
+  }
+
+  void ToSMRTSequence(SMRTSequence &read) {
+    read.length = seq.size();
+    read.Allocate(read.length);
+    memcpy(read.seq, seq.c_str(), seq.size());
+    DNALength i;
+    for (i = 0; i < seq.size(); i++) {
+      read.qual[i]           = qual[i];
+      read.insertionQV[i]    = insQV[i];
+      read.deletionQV[i]     = delQV[i];
+      read.substitutionQV[i] = subQV[i];
+      read.deletionTag[i]    = delTag[i];
+      read.substitutionTag[i]= subTag[i];
+      read.pulseIndex[i]     = i;
+      read.preBaseFrames[i]  = 0;
+      read.widthInFrames[i]  = 0;
+    }
+    read.subreadStart = 0;
+    read.subreadEnd   = read.length;
+  }
+};
+
+void SimulateReadWithBuiltinModel(BenchmarkParameters &params, FASTASequence &genome,
+                                  DNALength start, DNALength length, SimulatedRead &sim) {
+  DNALength p;
+  //
+  // Stop at the requested read length, since insertions add bases
+  // that do not consume the reference.
+  //
+  for (p = start; p < start + length and sim.seq.size() < length; p++) {
+    Nucleotide refNuc = genome.seq[p];
+    float r = Random();
+    if (r < params.delRate) {
+      //
+      // Skip the reference base, and tag the next output base.
+      //
+      if (p + 1 < start + length) {
+        sim.PushBack(genome.seq[p+1], 12, 14, 4, 16, refNuc, 'N');
+        p++;
+      }
+      continue;
+    }
+    r -= params.delRate;
+    if (r < params.insRate) {
+      Nucleotide insNuc = (Random() < 0.5) ? refNuc : RandomNuc();
+      sim.PushBack(insNuc, 8, 4, 14, 16, 'N', 'N');
+      if (sim.seq.size() >= length) {
+        break;
+      }
+      //
+      // Whether the base after the insertion is substituted is drawn
+      // on its own.
+      //
+      r = Random();
+    }
+    else {
+      r -= params.insRate;
+    }
+    if (r < params.subRate) {
+      sim.PushBack(RandomOtherNuc(refNuc), 6, 14, 14, 4, 'N', refNuc);
+    }
+    else {
+      sim.PushBack(refNuc, 16, 16, 16, 20, 'N', 'N');
+    }
+  }
+}
+
+void SimulateReadWithOutputModel(OutputSampleListSet &outputModel, FASTASequence &genome,
+                                 DNALength start, DNALength length, SimulatedRead &sim) {
+  int contextLength = outputModel.keyLength;
+  int contextMiddle = contextLength / 2;
+  DNALength p;
+  for (p = start + contextMiddle; p < start + length - contextMiddle - 1; p++) {
+    string refContext;
+    refContext.assign((const char*) &genome.seq[p - contextMiddle], contextLength);
+    OutputSample sample;
+    outputModel.SampleRandomSample(refContext, sample);
+    if (sample.type == OutputSample::Deletion) {
+      p++;
+    }
+    int i;
+    for (i = 0; i < sample.nucleotides.size(); i++) {
+      sim.PushBack(sample.nucleotides[i],
+                   sample.qualities[i].qv[0], sample.qualities[i].qv[2],
+                   sample.qualities[i].qv[1], sample.qualities[i].qv[3],
+                   sample.qualities[i].tags[0], sample.qualities[i].tags[1]);
+    }
+  }
+}
+
+void SimulateReads(BenchmarkParameters &params, FASTASequence &genome,
+                   OutputSampleListSet *outputModel,
+                   vector<SMRTSequence*> &reads, vector<DNALength> &origins) {
+  int r;
+  for (r = 0; r < params.nReads; r++) {
+    DNALength length = params.readLength / 2 + RandomInt(params.readLength);
+    if (length >= genome.length) {
+      length = genome.length - 1;
+    }
+    DNALength start = RandomInt(genome.length - length);
+    SimulatedRead sim;
+    if (outputModel != NULL) {
+      SimulateReadWithOutputModel(*outputModel, genome, start, length, sim);
+    }
+    else {
+      SimulateReadWithBuiltinModel(params, genome, start, length, sim);
+    }
+    SMRTSequence *read = new SMRTSequence;
+    sim.ToSMRTSequence(*read);
+    stringstream titleStrm;
+    titleStrm << "m000000_000000_00000_cBENCH_s1_p0/" << r << "/0_" << read->length;
+    read->CopyTitle(titleStrm.str());
+    reads.push_back(read);
+    origins.push_back(start);
+  }
+}
+
+//
+// The target window that a read is aligned against in the isolated
+// alignment kernels: the simulated origin padded by the indel rate.
+//
+void GetTargetWindow(BenchmarkParameters &params, FASTASequence &genome, SMRTSequence &read,
+                     DNALength origin, DNASequence &window, DNALength &windowStart) {
+  DNALength pad = read.length * params.indelRate / 2;
+  windowStart = (origin > pad) ? origin - pad : 0;
+  DNALength windowEnd = origin + read.length + pad;
+  if (windowEnd > genome.length) {
+    windowEnd = genome.length;
+  }
+  window.ReferenceSubstring(genome, windowStart, windowEnd - windowStart);
+}
+
+int main(int argc, char* argv[]) {
+  BenchmarkParameters params;
+  CommandLineParser clp;
+  clp.SetProgramName("benchmarkKernels");
+  clp.SetProgramSummary("Time blasr's alignment kernels on synthetic data and print the results as JSON.");
+  clp.RegisterIntOption("seed", &params.seed, "Random seed for the reference and reads.", CommandLineParser::NonNegativeInteger);
+  clp.RegisterIntOption("genomeLength", &params.genomeLength, "Length of the synthetic reference.", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("nReads", &params.nReads, "Number of reads to simulate.", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("readLength", &params.readLength, "Mean read length.", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("nRepeats", &params.nRepeats, "Number of diverged repeat copies in the reference.", CommandLineParser::NonNegativeInteger);
+  clp.RegisterIntOption("repeatLength", &params.repeatLength, "Length of each repeat copy.", CommandLineParser::PositiveInteger);
+  clp.RegisterFloatOption("insRate", &params.insRate, "Insertion rate of the built in error model.", CommandLineParser::NonNegativeFloat);
+  clp.RegisterFloatOption("delRate", &params.delRate, "Deletion rate of the built in error model.", CommandLineParser::NonNegativeFloat);
+  clp.RegisterFloatOption("subRate", &params.subRate, "Substitution rate of the built in error model.", CommandLineParser::NonNegativeFloat);
+  clp.RegisterStringOption("model", &params.modelFileName, "Sample reads using an alchemy output model rather than the built in error model.");
+  clp.RegisterStringOption("out", &params.outFileName, "Write results here rather than to stdout.");
+  clp.RegisterIntOption("minMatch", &params.minMatchLength, "Minimum anchor length.", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("bwtKmer", &params.bwtKmerLength, "Length of the k-mers counted in the BWT.", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("bwtStride", &params.bwtStride, "Distance between BWT k-mer queries in a read.", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("maxAnchorsPerPosition", &params.maxAnchorsPerPosition, "Do not locate k-mers with more hits than this.", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("bandSize", &params.kbandSize, "Band for k-band alignment (default: 10% of the read length).", CommandLineParser::NonNegativeInteger);
+  clp.RegisterIntOption("guidedAlignBandSize", &params.guidedAlignBandSize, "Band for guided alignment.", CommandLineParser::PositiveInteger);
+  clp.RegisterIntOption("passes", &params.passes, "Number of times each kernel is run over the reads.", CommandLineParser::PositiveInteger);
+  clp.ParseCommandLine(argc, argv);
+
+  ostream *outPtr = &cout;
+  ofstream outFile;
+  if (params.outFileName != "") {
+    CrucialOpen(params.outFileName, outFile, std::ios::out);
+    outPtr = &outFile;
+  }
+
+  InitializeRandomGenerator(params.seed);
+
+  FASTASequence genome;
+  SimulateReference(params, genome);
+
+  OutputSampleListSet outputModel(0);
+  OutputSampleListSet *outputModelPtr = NULL;
+  if (params.modelFileName != "") {
+    outputModel.Read(params.modelFileName);
+    outputModelPtr = &outputModel;
+  }
+  vector<SMRTSequence*> reads;
+  vector<DNALength> origins;
+  SimulateReads(params, genome, outputModelPtr, reads, origins);
+  long long totalReadBases = 0;
+  int r;
+  for (r = 0; r < reads.size(); r++) {
+    totalReadBases += reads[r]->length;
+  }
+
+  vector<KernelResult*> results;
+  long long startUsec;
+
+  //
+  // Index construction, the same way blasr does when no index is
+  // given on the command line.
+  //
+  DNASuffixArray sarray;
+  vector<int> alphabet;
+  KernelResult *saBuild = new KernelResult("SuffixArray::LarssonBuildSuffixArray");
+  startUsec = WallClockUsec();
+  sarray.InitThreeBitDNAAlphabet(alphabet);
+  sarray.LarssonBuildSuffixArray(genome.seq, genome.length, alphabet);
+  sarray.BuildLookupTable(genome.seq, genome.length, params.lookupTableLength);
+  saBuild->AddCall(WallClockUsec() - startUsec, genome.length);
+  saBuild->peakRSSKb = GetPeakRSSKb();
+  results.push_back(saBuild);
+
+  BWT bwt;
+  KernelResult *bwtBuild = new KernelResult("Bwt::InitializeFromSuffixArray");
+  startUsec = WallClockUsec();
+  bwt.InitializeFromSuffixArray(genome, sarray.index);
+  bwtBuild->AddCall(WallClockUsec() - startUsec, genome.length);
+  bwtBuild->peakRSSKb = GetPeakRSSKb();
+  results.push_back(bwtBuild);
+
+  TupleCountTable<FASTASequence, DNATuple> ct;
+  TupleMetrics tm;
+  tm.Initialize(params.lookupTableLength);
+  ct.InitCountTable(tm);
+  ct.AddSequenceTupleCountsLR(genome);
+
+  SequenceIndexDatabase<FASTASequence> seqdb;
+  seqdb.growableName.push_back(genome.title);
+  seqdb.growableSeqStartPos.push_back(genome.length);
+  seqdb.Finalize();
+  SeqBoundaryFtr<FASTASequence> seqBoundary(&seqdb);
+
+  AnchorParameters anchorParameters;
+  anchorParameters.minMatchLength        = params.minMatchLength;
+  anchorParameters.maxAnchorsPerPosition = params.maxAnchorsPerPosition;
+  anchorParameters.stopMappingOnceUnique = true;
+
+  MappingBuffers mappingBuffers;
+  int pass;
+
+  //
+  // Suffix array LCP search from every position of the read.  This
+  // is the search that LocateAnchorBoundsInSuffixArray runs.
+  //
+  KernelResult *lcpBounds = new KernelResult("SuffixArray::StoreLCPBounds");
+  vector<SAIndex> lowMatchBound, highMatchBound;
+  for (pass = 0; pass < params.passes; pass++) {
+    for (r = 0; r < reads.size(); r++) {
+      SMRTSequence &read = *reads[r];
+      long long nQueries = 0;
+      startUsec = WallClockUsec();
+      DNALength p;
+      for (p = 0; p + params.minMatchLength <= read.length; p++) {
+        lowMatchBound.clear(); highMatchBound.clear();
+        sarray.StoreLCPBounds(genome.seq, genome.length, &read.seq[p], read.length - p,
+                              anchorParameters.useLookupTable, anchorParameters.maxLCPLength,
+                              lowMatchBound, highMatchBound, anchorParameters.stopMappingOnceUnique);
+        ++nQueries;
+      }
+      lcpBounds->AddCall(WallClockUsec() - startUsec, read.length, nQueries);
+    }
+  }
+  lcpBounds->peakRSSKb = GetPeakRSSKb();
+  results.push_back(lcpBounds);
+
+  //
+  // Full suffix array anchoring.  The anchors are kept for the
+  // chaining benchmark below.
+  //
+  KernelResult *saAnchor = new KernelResult("MapReadToGenome.suffixArray");
+  vector<vector<ChainedMatchPos> > anchorLists(reads.size());
+  for (pass = 0; pass < params.passes; pass++) {
+    for (r = 0; r < reads.size(); r++) {
+      SMRTSequence &read = *reads[r];
+      anchorLists[r].clear();
+      startUsec = WallClockUsec();
+      MapReadToGenome(genome, sarray, read, params.lookupTableLength, anchorLists[r], anchorParameters);
+      saAnchor->AddCall(WallClockUsec() - startUsec, read.length, anchorLists[r].size());
+    }
+  }
+  saAnchor->peakRSSKb = GetPeakRSSKb();
+  results.push_back(saAnchor);
+
+  //
+  // BWT backward search of fixed length k-mers, and locating the
+  // k-mers that have a small enough number of hits.
+  //
+  KernelResult *bwtCount  = new KernelResult("Bwt::Count");
+  KernelResult *bwtLocate = new KernelResult("Bwt::Locate");
+  vector<DNALength> spList, epList, positions;
+  for (pass = 0; pass < params.passes; pass++) {
+    for (r = 0; r < reads.size(); r++) {
+      SMRTSequence &read = *reads[r];
+      spList.clear(); epList.clear();
+      FASTASequence kmer;
+      DNALength p;
+      startUsec = WallClockUsec();
+      for (p = 0; p + params.bwtKmerLength <= read.length; p += params.bwtStride) {
+        DNALength sp, ep;
+        kmer.ReferenceSubstring(read, p, params.bwtKmerLength);
+        bwt.Count(kmer, sp, ep);
+        spList.push_back(sp);
+        epList.push_back(ep);
+      }
+      bwtCount->AddCall(WallClockUsec() - startUsec, read.length, spList.size());
+
+      positions.clear();
+      int k;
+      startUsec = WallClockUsec();
+      for (k = 0; k < spList.size(); k++) {
+        bwt.Locate(spList[k], epList[k], positions, params.maxAnchorsPerPosition);
+      }
+      bwtLocate->AddCall(WallClockUsec() - startUsec, read.length, positions.size());
+    }
+  }
+  bwtCount->peakRSSKb = bwtLocate->peakRSSKb = GetPeakRSSKb();
+  results.push_back(bwtCount);
+  results.push_back(bwtLocate);
+
+  //
+  // Chaining of the suffix array anchors into candidate intervals.
+  //
+  KernelResult *chain = new KernelResult("FindMaxIncreasingInterval");
+  LISSizeWeightor<vector<ChainedMatchPos> > lisWeightFn;
+  IntervalSearchParameters intervalSearchParameters;
+  intervalSearchParameters.maxPValue           = log(0.5);
+  intervalSearchParameters.aboveCategoryPValue = -300;
+  vector<ChainedMatchPos> matchPosList;
+  for (pass = 0; pass < params.passes; pass++) {
+    for (r = 0; r < reads.size(); r++) {
+      SMRTSequence &read = *reads[r];
+      WeightedIntervalSet topIntervals(params.nCandidates);
+      PValueWeightor lisPValue(read, genome, ct.tm, &ct);
+      VarianceAccumulator<float> accumPValue, accumWeight, accumNBases;
+      matchPosList = anchorLists[r];
+      mappingBuffers.clusterList.Clear();
+      startUsec = WallClockUsec();
+      SortMatchPosList(matchPosList);
+      FindMaxIncreasingInterval(Forward, matchPosList,
+                                (DNALength) ((read.subreadEnd - read.subreadStart) * (1 + params.indelRate)),
+                                params.nCandidates, seqBoundary, lisPValue, lisWeightFn,
+                                topIntervals, genome, read, intervalSearchParameters,
+                                &mappingBuffers.globalChainEndpointBuffer,
+                                mappingBuffers.clusterList,
+                                accumPValue, accumWeight, accumNBases, read.title);
+      chain->AddCall(WallClockUsec() - startUsec, read.length, matchPosList.size());
+    }
+  }
+  chain->peakRSSKb = GetPeakRSSKb();
+  results.push_back(chain);
+
+  //
+  // Pairwise alignment of each read against the window it was
+  // simulated from: sparse dynamic programming, banded alignment,
+  // and alignment guided by the sparse alignment.
+  //
+  DistanceMatrixScoreFunction<DNASequence, FASTQSequence> distScoreFn(SMRTDistanceMatrix, params.insertion, params.deletion);
+  IDSScoreFunction<DNASequence, FASTQSequence> idsScoreFn;
+  idsScoreFn.ins = params.insertion;
+  idsScoreFn.del = params.deletion;
+  idsScoreFn.InitializeScoreMatrix(SMRTDistanceMatrix);
+
+  KernelResult *sdp    = new KernelResult("SDPAlign");
+  KernelResult *kband  = new KernelResult("KBandAlign");
+  KernelResult *guided = new KernelResult("GuidedAlign");
+  KernelResult *sam    = new KernelResult("SAMOutput::PrintAlignment");
+  AlignmentContext alignmentContext;
+  alignmentContext.readGroupId = "bench";
+  stringstream samOut;
+  for (pass = 0; pass < params.passes; pass++) {
+    for (r = 0; r < reads.size(); r++) {
+      SMRTSequence &read = *reads[r];
+      DNASequence window;
+      DNALength windowStart;
+      GetTargetWindow(params, genome, read, origins[r], window, windowStart);
+
+      Alignment sdpAlignment;
+      startUsec = WallClockUsec();
+      SDPAlign(read, window, distScoreFn, params.sdpTupleSize,
+               params.sdpIns, params.sdpDel, params.indelRate*2,
+               sdpAlignment, mappingBuffers, Local, false, false);
+      sdp->AddCall(WallClockUsec() - startUsec, read.length);
+
+      Alignment kbandAlignment;
+      int k = params.kbandSize;
+      if (k == 0) {
+        k = read.length / 10;
+      }
+      startUsec = WallClockUsec();
+      KBandAlign(read, window, SMRTDistanceMatrix, params.insertion + 2, params.deletion + 2, k,
+                 mappingBuffers.scoreMat, mappingBuffers.pathMat,
+                 kbandAlignment, idsScoreFn, Fit);
+      kband->AddCall(WallClockUsec() - startUsec, read.length, 0, ((long long) read.length + 1) * (2*k + 1));
+
+      if (sdpAlignment.blocks.size() == 0) {
+        continue;
+      }
+      Alignment refinedAlignment;
+      startUsec = WallClockUsec();
+      GuidedAlign(read, window, sdpAlignment, idsScoreFn, params.guidedAlignBandSize,
+                  mappingBuffers, refinedAlignment, Global, false);
+      guided->AddCall(WallClockUsec() - startUsec, read.length, 0, refinedAlignment.nCells);
+
+      if (refinedAlignment.blocks.size() == 0) {
+        continue;
+      }
+      T_AlignmentCandidate alignment;
+      (Alignment&) alignment = refinedAlignment;
+      alignment.qName  = read.title;
+      alignment.tName  = genome.title;
+      alignment.tLength = genome.length;
+      alignment.qLength = read.length;
+      alignment.tAlignedSeqPos = windowStart;
+      alignment.qAlignedSeqPos = 0;
+      alignment.tAlignedSeq.ReferenceSubstring(window);
+      alignment.qAlignedSeq.ReferenceSubstring(read);
+      alignment.qStrand = alignment.tStrand = 0;
+      samOut.str("");
+      startUsec = WallClockUsec();
+      SAMOutput::PrintAlignment(alignment, read, samOut, alignmentContext);
+      sam->AddCall(WallClockUsec() - startUsec, read.length);
+      sam->outputBytes += samOut.str().size();
+    }
+  }
+  sdp->peakRSSKb = kband->peakRSSKb = guided->peakRSSKb = sam->peakRSSKb = GetPeakRSSKb();
+  results.push_back(sdp);
+  results.push_back(kband);
+  results.push_back(guided);
+  results.push_back(sam);
+
+  ostream &out = *outPtr;
+  out << "{\"benchmark\": \"blasrKernels\""
+      << ", \"seed\": " << params.seed
+      << ", \"genomeLength\": " << genome.length
+      << ", \"nReads\": " << reads.size()
+      << ", \"readBases\": " << totalReadBases
+      << ", \"passes\": " << params.passes
+      << ", \"errorModel\": \"" << (params.modelFileName == "" ? "builtin" : params.modelFileName) << "\""
+      << ", \"indexBytes\": {\"suffixArray\": " << ((long long) sarray.length) * sizeof(SAIndex)
+      << ", \"lookupTable\": " << ((long long) sarray.lookupTableLength) * sizeof(SAIndex) * 2
+      << ", \"bwt\": " << (long long) bwt.bwtSequence.length / 2 << "}"
+      << ", \"peakRSSKb\": " << GetPeakRSSKb()
+      << ", \"kernels\": [";
+  int i;
+  for (i = 0; i < results.size(); i++) {
+    if (i > 0) {
+      out << ", ";
+    }
+    out << endl << "  ";
+    results[i]->PrintJSON(out);
+  }
+  out << "]}" << endl;
+
+  for (i = 0; i < results.size(); i++) {
+    delete results[i];
+  }
+  for (r = 0; r < reads.size(); r++) {
+    delete reads[r];
+  }
+  return 0;
+}
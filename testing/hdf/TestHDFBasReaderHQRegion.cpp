@@ -0,0 +1,127 @@
+#include "data/hdf/HDFBasReader.h"
+#include "data/hdf/HDFRegionTableReader.h"
+#include "datastructures/reads/RegionTable.h"
+#include "utils/RegionUtils.h"
+#include "SMRTSequence.h"
+#include <iostream>
+#include <string>
+#include <cstring>
+
+using namespace std;
+
+//
+// Read every read of a bas.h5 file twice: whole, and with only the
+// HQ bases read as blasr does when masking by the HQ region.  After
+// MaskRead, which blasr applies to both, the two reads must be
+// identical in every field that mapping uses, so that the mapping
+// output is unchanged.
+//
+
+int CompareQVs(QualityValueVector<QualityValue> &a, QualityValueVector<QualityValue> &b,
+               DNALength length, const char *name, string &title) {
+  if (a.Empty() != b.Empty()) {
+    cout << "FAILED: " << title << " " << name << " is read in only one of the two reads" << endl;
+    return 1;
+  }
+  if (a.Empty() == false and memcmp(a.data, b.data, length) != 0) {
+    cout << "FAILED: " << title << " " << name << " differs" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+template<typename T>
+int CompareField(T *a, T *b, DNALength length, const char *name, string &title) {
+  if ((a == NULL) != (b == NULL)) {
+    cout << "FAILED: " << title << " " << name << " is read in only one of the two reads" << endl;
+    return 1;
+  }
+  if (a != NULL and memcmp(a, b, length * sizeof(T)) != 0) {
+    cout << "FAILED: " << title << " " << name << " differs" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    cout << "usage: testHDFBasReaderHQRegion basFile [regionFile]" << endl;
+    exit(0);
+  }
+  string basFileName = argv[1];
+  string regionFileName = basFileName;
+  if (argc > 2) {
+    regionFileName = argv[2];
+  }
+
+  HDFRegionTableReader regionReader;
+  RegionTable regionTable;
+  if (regionReader.Initialize(regionFileName) == 0) {
+    cout << "FAILED: could not read a region table from " << regionFileName << endl;
+    return 1;
+  }
+  regionReader.ReadTable(regionTable);
+  regionReader.Close();
+  regionTable.SortTableByHoleNumber();
+
+  HDFBasReader wholeReader, hqReader;
+  wholeReader.InitializeDefaultIncludedFields();
+  hqReader.InitializeDefaultIncludedFields();
+  if (wholeReader.Initialize(basFileName) == 0 or hqReader.Initialize(basFileName) == 0) {
+    cout << "FAILED: could not open " << basFileName << endl;
+    return 1;
+  }
+  hqReader.SetHQRegionTable(&regionTable);
+
+  SMRTSequence wholeRead, hqRead;
+  int nReads = 0, nFailed = 0;
+  while (wholeReader.GetNext(wholeRead)) {
+    if (hqReader.GetNext(hqRead) == 0) {
+      cout << "FAILED: the HQ reader stopped after " << nReads << " reads" << endl;
+      return 1;
+    }
+    bool wholeHasGoodRegion = MaskRead(wholeRead, wholeRead.zmwData, regionTable);
+    bool hqHasGoodRegion    = MaskRead(hqRead, hqRead.zmwData, regionTable);
+    string title = wholeRead.GetTitle();
+    int nDiffer = 0;
+    if (wholeHasGoodRegion != hqHasGoodRegion or
+        wholeRead.zmwData.holeNumber != hqRead.zmwData.holeNumber or
+        wholeRead.length != hqRead.length or
+        title != hqRead.GetTitle()) {
+      cout << "FAILED: read " << nReads << " is not the same ZMW in both readers" << endl;
+      return 1;
+    }
+    DNALength length = wholeRead.length;
+    nDiffer += CompareField(wholeRead.seq, hqRead.seq, length, "bases", title);
+    nDiffer += CompareQVs(wholeRead.qual, hqRead.qual, length, "QualityValue", title);
+    nDiffer += CompareQVs(wholeRead.deletionQV, hqRead.deletionQV, length, "DeletionQV", title);
+    nDiffer += CompareQVs(wholeRead.insertionQV, hqRead.insertionQV, length, "InsertionQV", title);
+    nDiffer += CompareQVs(wholeRead.substitutionQV, hqRead.substitutionQV, length, "SubstitutionQV", title);
+    nDiffer += CompareQVs(wholeRead.mergeQV, hqRead.mergeQV, length, "MergeQV", title);
+    nDiffer += CompareField(wholeRead.deletionTag, hqRead.deletionTag, length, "DeletionTag", title);
+    nDiffer += CompareField(wholeRead.substitutionTag, hqRead.substitutionTag, length, "SubstitutionTag", title);
+    nDiffer += CompareField(wholeRead.widthInFrames, hqRead.widthInFrames, length, "WidthInFrames", title);
+    nDiffer += CompareField(wholeRead.preBaseFrames, hqRead.preBaseFrames, length, "PreBaseFrames", title);
+    nDiffer += CompareField(wholeRead.pulseIndex, hqRead.pulseIndex, length, "PulseIndex", title);
+    if (wholeRead.GetAverageQuality() != hqRead.GetAverageQuality()) {
+      cout << "FAILED: " << title << " has a different average quality" << endl;
+      ++nDiffer;
+    }
+    if (nDiffer > 0) {
+      ++nFailed;
+    }
+    wholeRead.Free();
+    hqRead.Free();
+    ++nReads;
+  }
+  if (hqReader.GetNext(hqRead)) {
+    cout << "FAILED: the HQ reader returned more reads than the whole reader" << endl;
+    return 1;
+  }
+  cout << "compared " << nReads << " reads" << endl;
+  if (nFailed == 0) {
+    cout << "PASSED" << endl;
+    return 0;
+  }
+  return 1;
+}
@@ -1,42 +1,90 @@
 #include "tuples/DNATuple.h"
 #include "tuples/TupleMetrics.h"
 #include "tuples/DNATupleList.h"
+#include "datastructures/tuplelists/PartitionedTupleCounter.h"
 #include "FASTAReader.h"
 #include "FASTASequence.h"
+#include "utils.h"
 
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <stdlib.h>
 
 
 using namespace std;
+
+//
+// Write the sorted partitions of tuples in the layout of
+// TupleList<PositionDNATuple>::WriteToFile.
+//
+class TuplePosListWriter {
+ public:
+	vector<vector<PositionDNATuple> > partitionTuples;
+	ofstream *outFile;
+
+	TuplePosListWriter(int nPartitions, ofstream &_outFile) {
+		partitionTuples.resize(nPartitions);
+		outFile = &_outFile;
+	}
+
+	void ProcessPartition(int p, vector<TuplePosRecord> &records) {
+		partitionTuples[p].resize(records.size());
+		VectorIndex i;
+		for (i = 0; i < records.size(); i++) {
+			partitionTuples[p][i].tuple = records[i].tuple;
+			partitionTuples[p][i].pos   = records[i].pos;
+		}
+	}
+
+	void FinishPartition(int p) {
+		if (partitionTuples[p].size() > 0) {
+			outFile->write((char*) &partitionTuples[p][0], sizeof(PositionDNATuple) * partitionTuples[p].size());
+		}
+		vector<PositionDNATuple>().swap(partitionTuples[p]);
+	}
+};
+
 int main(int argc, char* argv[]) {
 
 	string seqFileName;
 	TupleMetrics tm;
 	string outFileName;
-	if (argc < 3) {
-		cout << "usage: storeTuplePosList seqFile tupleSize outFile" << endl;
+	int nProc = 1;
+	if (argc < 4) {
+		cout << "usage: storeTuplePosList seqFile tupleSize outFile [nproc]" << endl;
 		return 0;
 	}
 	seqFileName = argv[1];
-	tm.tupleSize = atoi(argv[2]);
+	tm.Initialize(atoi(argv[2]));
 	outFileName = argv[3];
-	
-	ofstream outFile;
-	//	CrucialOpen(outFileName, outFile, std::ios::out| std::ios::binary);
+	if (argc > 4) {
+		nProc = atoi(argv[4]);
+	}
 
 	FASTAReader reader;
 	reader.Init(seqFileName);
 	FASTASequence seq;
 	reader.GetNext(seq);
-	//	vector<PositionDNATuple> 
-	TupleList<PositionDNATuple>tuplePosList;
-	tuplePosList.SetTupleMetrics(tm);
-	//	StoreTuplePosList(seq, tm, tuplePosList);
-	SequenceToTupleList(seq, tm, tuplePosList);
-	tuplePosList.Sort();
-	tuplePosList.WriteToFile(outFileName); //WriteTuplePosList(tuplePosList, tm.tupleSize, outFile);
+
+	//
+	// Sort the tuples in partitions rather than all at once, spilling
+	// them to disk next to the output when there are too many to hold
+	// in memory.
+	//
+	PartitionedTupleCounter<TuplePosRecord> counter;
+	counter.Initialize(tm, false, nProc, 8, 1 << 26, outFileName + ".tmp");
+	counter.AddSequence(seq);
+	counter.Flush();
+
+	ofstream outFile;
+	CrucialOpen(outFileName, outFile, std::ios::out| std::ios::binary);
+	int listLength = counter.nRecords;
+	cout << "writing tuple lis of length " << listLength << endl;
+	outFile.write((char*) &listLength, sizeof(int));
+	outFile.write((char*) &tm.tupleSize, sizeof(int));
+	TuplePosListWriter writer(counter.nPartitions, outFile);
+	counter.ProcessPartitions(writer);
 	outFile.close();
 	return 0;
 }